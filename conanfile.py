@@ -22,6 +22,7 @@ class QxConan(ConanFile):
         "fPIC": [True, False],
         "asan_enabled": [True, False],
         "build_python": [True, False],
+        "build_mpi": [True, False],
         "cpu_compatibility_mode": [True, False],
         "python_dir": [None, "ANY"],
         "python_ext": [None, "ANY"],
@@ -31,6 +32,7 @@ class QxConan(ConanFile):
         "fPIC": True,
         "asan_enabled": False,
         "build_python": False,
+        "build_mpi": False,
         "cpu_compatibility_mode": False,
         "python_dir": None,
         "python_ext": None
@@ -78,6 +80,7 @@ class QxConan(ConanFile):
         deps.generate()
         tc = CMakeToolchain(self)
         tc.variables["ASAN_ENABLED"] = self.options.asan_enabled
+        tc.variables["QX_BUILD_MPI"] = self.options.build_mpi
         tc.variables["QX_BUILD_PYTHON"] = self.options.build_python
         tc.variables["QX_BUILD_TESTS"] = self._should_build_test
         tc.variables["QX_CPU_COMPATIBILITY_MODE"] = self.options.cpu_compatibility_mode
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <bit>  // countr_zero
+#include <cassert>
+#include <compare>  // strong_ordering
+#include <cstdint>  // size_t, uint64_t
+#include <stdexcept>  // invalid_argument
+#include <string>
+
+namespace qx::core {
+
+// A basis vector of a quantum state, i.e., the index of one of its amplitudes
+//
+// Bit i holds the value of qubit i.
+// Bits are stored inline in a fixed number of machine words, so basis vectors are cheap to copy, compare, and hash.
+// Word w holds bits [64 * w, 64 * w + 64); basis vectors are ordered as the numbers they represent.
+template <std::size_t NumberOfWords>
+class BasicBasisVector {
+    static constexpr std::size_t BITS_PER_WORD = 64;
+
+    // A single word is indexed without any division, as for a plain 64-bit integer
+    [[nodiscard]] static constexpr std::size_t get_word_index(std::size_t index) {
+        return NumberOfWords == 1 ? 0 : index / BITS_PER_WORD;
+    }
+
+public:
+    static constexpr std::size_t MAX_NUMBER_OF_BITS = BITS_PER_WORD * NumberOfWords;
+
+    constexpr BasicBasisVector() = default;
+    constexpr explicit BasicBasisVector(std::uint64_t value)
+    : words_{ value } {}
+
+    // Notice the least significant bits go to the right, e.g., "01" sets bit 0
+    explicit BasicBasisVector(const std::string& s) {
+        if (s.size() > MAX_NUMBER_OF_BITS) {
+            throw std::invalid_argument{ "basis vector string is too long" };
+        }
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            auto c = s[s.size() - i - 1];
+            if (c != '0' && c != '1') {
+                throw std::invalid_argument{ "basis vector string contains characters other than 0 and 1" };
+            }
+            set(i, c == '1');
+        }
+    }
+
+    [[nodiscard]] constexpr bool test(std::size_t index) const {
+        return (words_[get_word_index(index)] >> (index % BITS_PER_WORD)) & 1;
+    }
+
+    constexpr BasicBasisVector& set(std::size_t index, bool bit = true) {
+        auto& word = words_[get_word_index(index)];
+        auto offset = index % BITS_PER_WORD;
+        word = (word & ~(std::uint64_t{ 1 } << offset)) | (static_cast<std::uint64_t>(bit) << offset);
+        return *this;
+    }
+
+    // Only valid if all the bits but the lowest 64 ones are 0
+    [[nodiscard]] constexpr std::uint64_t to_ulong() const {
+        for (std::size_t w = 1; w < NumberOfWords; ++w) {
+            assert(words_[w] == 0 && "Basis vector does not fit in 64 bits");
+        }
+        return words_[0];
+    }
+
+    [[nodiscard]] constexpr std::uint64_t get_word(std::size_t w) const {
+        return words_[w];
+    }
+
+    // Call f(i) for every bit i that is set, in increasing order of i
+    template <typename F>
+    constexpr void for_each_set_bit(F&& f) const {
+        for (std::size_t w = 0; w < NumberOfWords; ++w) {
+            for (auto bits = words_[w]; bits != 0; bits &= bits - 1) {
+                f(w * BITS_PER_WORD + static_cast<std::size_t>(std::countr_zero(bits)));
+            }
+        }
+    }
+
+    // Return the rightmost n bits
+    [[nodiscard]] std::string to_string(std::size_t n) const {
+        auto ret = std::string(n, '0');
+        for (std::size_t i = 0; i < n && i < MAX_NUMBER_OF_BITS; ++i) {
+            ret[n - i - 1] = test(i) ? '1' : '0';
+        }
+        return ret;
+    }
+
+    constexpr bool operator==(const BasicBasisVector& other) const = default;
+    constexpr std::strong_ordering operator<=>(const BasicBasisVector& other) const {
+        for (auto w = NumberOfWords; w-- > 0;) {
+            if (auto ret = words_[w] <=> other.words_[w]; ret != 0) {
+                return ret;
+            }
+        }
+        return std::strong_ordering::equal;
+    }
+
+    constexpr BasicBasisVector operator&(const BasicBasisVector& other) const {
+        return apply_to_words(other, [](auto lhs, auto rhs) { return lhs & rhs; });
+    }
+    constexpr BasicBasisVector operator|(const BasicBasisVector& other) const {
+        return apply_to_words(other, [](auto lhs, auto rhs) { return lhs | rhs; });
+    }
+    constexpr BasicBasisVector operator^(const BasicBasisVector& other) const {
+        return apply_to_words(other, [](auto lhs, auto rhs) { return lhs ^ rhs; });
+    }
+    constexpr BasicBasisVector operator~() const {
+        return apply_to_words(*this, [](auto lhs, auto) { return ~lhs; });
+    }
+
+private:
+    template <typename F>
+    constexpr BasicBasisVector apply_to_words(const BasicBasisVector& other, F&& f) const {
+        auto ret = BasicBasisVector{};
+        for (std::size_t w = 0; w < NumberOfWords; ++w) {
+            ret.words_[w] = f(words_[w], other.words_[w]);
+        }
+        return ret;
+    }
+
+    std::array<std::uint64_t, NumberOfWords> words_{};
+};
+
+// A quantum state picks, at run time, the narrowest of these basis vectors that can hold all its qubits
+using BasisVector = BasicBasisVector<1>;
+using BasisVector128 = BasicBasisVector<2>;
+using BasisVector256 = BasicBasisVector<4>;
+using BasisVector1024 = BasicBasisVector<16>;
+
+// Basis vectors tend to be small, consecutive, or to share long runs of zeros in their low bits,
+// so the value is spread over the whole word by a Fibonacci multiplication,
+// and the high bits, which are the well-mixed ones, are folded back into the low bits
+// Wider basis vectors go through the same multiplication once per word
+struct BasisVectorHash {
+    template <std::size_t NumberOfWords>
+    [[nodiscard]] constexpr std::size_t operator()(const BasicBasisVector<NumberOfWords>& basis_vector) const {
+        std::uint64_t h = 0;
+        for (std::size_t w = 0; w < NumberOfWords; ++w) {
+            h = (h ^ basis_vector.get_word(w)) * 0x9E37'79B9'7F4A'7C15ULL;
+        }
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+};
+
+}  // namespace qx::core
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>  // sort
+#include <complex>
+#include <cstdint>  // size_t
+#include <span>
+#include <vector>
+
+// Dense vectors indexed by bits, such as dense state vectors and density matrices,
+// whose elements are visited by groups of indices that only differ in some bits
+namespace qx::core {
+
+// Insert a 0 bit at each of the positions, which have to be sorted in increasing order
+[[nodiscard]] inline std::size_t deposit_zeros(std::size_t index, const std::vector<std::size_t>& sorted_positions) {
+    for (auto position : sorted_positions) {
+        auto low_bits = index & ((static_cast<std::size_t>(1) << position) - 1);
+        index = ((index >> position) << (position + 1)) | low_bits;
+    }
+    return index;
+}
+
+// Call f(base) for every index of a vector over number_of_bits bits whose bits at the given positions are all 0
+template <typename F>
+void for_each_group(std::size_t number_of_bits, std::vector<std::size_t> positions, F&& f) {
+    std::sort(positions.begin(), positions.end());
+    auto number_of_groups = static_cast<std::size_t>(1) << (number_of_bits - positions.size());
+    for (std::size_t i = 0; i < number_of_groups; ++i) {
+        f(deposit_zeros(i, positions));
+    }
+}
+
+// Multiply data, seen as a vector over number_of_bits bits, by a matrix acting on the bits at the given positions
+//
+// positions[k] is the position of bit k of the row and column indices of the matrix.
+// element(i, j) returns the matrix element at row i and column j.
+template <typename MatrixElement>
+void apply_to_bits(std::span<std::complex<double>> data, std::size_t number_of_bits,
+    const std::vector<std::size_t>& positions, MatrixElement&& element) {
+    const auto group_size = static_cast<std::size_t>(1) << positions.size();
+    auto offsets = std::vector<std::size_t>(group_size, 0);
+    for (std::size_t i = 0; i < group_size; ++i) {
+        for (std::size_t k = 0; k < positions.size(); ++k) {
+            offsets[i] |= ((i >> k) & 1) << positions[k];
+        }
+    }
+    auto input = std::vector<std::complex<double>>(group_size);
+    for_each_group(number_of_bits, positions, [&](std::size_t base) {
+        for (std::size_t j = 0; j < group_size; ++j) {
+            input[j] = data[base | offsets[j]];
+        }
+        for (std::size_t i = 0; i < group_size; ++i) {
+            std::complex<double> value = 0.;
+            for (std::size_t j = 0; j < group_size; ++j) {
+                value += element(i, j) * input[j];
+            }
+            data[base | offsets[i]] = value;
+        }
+    });
+}
+
+}  // namespace qx::core
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>  // uint64_t
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "qx/circuit.hpp"  // ExecutionCursor
+#include "qx/simulation_result.hpp"  // SimulationIterationAccumulator
+
+namespace qx {
+
+// The progress of a simulation executed shot by shot with the state_vector backend,
+// saved so that an interrupted simulation can be resumed
+//
+// A checkpoint holds the shots done so far, the state of the random number generator, and the shot in progress,
+// if any. Resuming from a checkpoint gives the same result, bit for bit, as going on from the state read back from it.
+struct Checkpoint {
+    // The number of shots and instructions of the simulation the checkpoint belongs to
+    std::uint64_t iterations = 0;
+    std::uint64_t number_of_instructions = 0;
+    SimulationIterationAccumulator accumulator;
+    std::string random_state;
+    std::optional<ExecutionCursor> cursor;
+
+    // Write the checkpoint in a binary format, in native byte order
+    void write(std::ostream& os);
+    // Read a checkpoint written by write
+    // Throw a SimulationError if the data is not a valid checkpoint
+    [[nodiscard]] static Checkpoint read(std::istream& is);
+    // Write the checkpoint to a temporary file, then rename it, so that the file at path is always a whole checkpoint
+    // Throw a SimulationError if the file can not be written
+    void save(const std::filesystem::path& path);
+    // Throw a SimulationError if the file can not be read, or is not a valid checkpoint
+    [[nodiscard]] static Checkpoint load(const std::filesystem::path& path);
+};
+
+}  // namespace qx
@@ -1,31 +1,168 @@
 #pragma once
 
+#include <functional>
 #include <memory>  // shared_ptr
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>  // pair
 #include <vector>
 
+#include "qx/circuit_optimizer.hpp"  // CircuitOptimization
+#include "qx/circuit_pruner.hpp"  // CircuitPruning
 #include "qx/core.hpp"  // BasisVector
 #include "qx/cqasm_v3x.hpp"
 #include "qx/error_models.hpp"
 #include "qx/instructions.hpp"
+#include "qx/simulation_options.hpp"
 #include "qx/simulation_result.hpp"
 
 namespace qx {
 
+// The outcome of executing a circuit with the density_matrix backend:
+// the branches at the end of the circuit, and the measures deferred to the end of the circuit,
+// whose qubit values have to be read from the final density matrix of each branch
+struct DensityMatrixExecution {
+    DensityMatrixBranches branches;
+    std::vector<std::pair<core::QubitIndex, core::BitIndex>> deferred_measures;
+};
+
+// The outcome of executing a circuit with the matrix_product_state backend:
+// the context at the end of the circuit, and the measures deferred to the end of the circuit,
+// whose qubit values have to be sampled from the final state
+struct MatrixProductStateExecution {
+    MatrixProductStateContext context;
+    std::vector<std::pair<core::QubitIndex, core::BitIndex>> deferred_measures;
+};
+
+// Same for the distributed_state_vector backend
+struct DistributedStateVectorExecution {
+    DistributedStateVectorContext context;
+    std::vector<std::pair<core::QubitIndex, core::BitIndex>> deferred_measures;
+};
+
+// Same for the paged_state_vector backend
+struct PagedStateVectorExecution {
+    PagedStateVectorContext context;
+    std::vector<std::pair<core::QubitIndex, core::BitIndex>> deferred_measures;
+};
+
+// Same for the factorized_state_vector backend
+struct FactorizedStateVectorExecution {
+    FactorizedStateVectorContext context;
+    std::vector<std::pair<core::QubitIndex, core::BitIndex>> deferred_measures;
+};
+
+// Where an execution of the circuit with the state_vector backend stands:
+// the context after the first next_instruction instructions,
+// and the index of the next instruction before which a depolarizing error is added
+struct ExecutionCursor {
+    SimulationIterationContext context;
+    std::size_t next_instruction = 0;
+    std::size_t next_error = 0;
+};
+
+// Where the state_vector backend stores the qubits from an instruction on:
+// qubit i at bit positions[i] of the basis vectors
+struct QubitPlacement {
+    std::size_t instruction;
+    std::vector<std::size_t> positions;
+};
+
 class Circuit {
-    static void add_error(SimulationIterationContext& context, const error_models::ErrorModel& error_model);
+    static void add_error(DensityMatrixBranches& branches, const error_models::ErrorModel& error_model,
+        const core::BasisVector& excluded_qubits);
+    static void add_error(SimulationIterationContext& context, const error_models::NoiseModel& noise_model,
+        const Instruction& instruction);
+    static void add_error(
+        DensityMatrixBranch& branch, const error_models::NoiseModel& noise_model, const Instruction& instruction);
+    [[nodiscard]] std::vector<bool> get_deferred_measures() const;
+    // Index of the next instruction, from the given one on, before which a depolarizing error is added
+    [[nodiscard]] std::size_t skip_error_free_instructions(
+        const error_models::DepolarizingChannel* depolarizing_channel, std::size_t from) const;
+    // Plan the bits where the state_vector backend stores the qubits along the circuit
+    // Only sorted_vector states use them, so they are planned by the first of their executions
+    void place_qubits() const;
+    // Move the qubits of a sorted_vector state to the positions planned before the instruction, if any
+    void move_qubits(core::QuantumState& state, std::size_t instruction) const;
+    // Execute the circuit once with a backend that does not support error models,
+    // on the context of the execution built from make_state(number_of_qubits)
+    // The measures deferred to the end of the circuit are not executed
+    // Throw a SimulationError if the options have an error model
+    template <typename Execution, typename MakeState>
+    [[nodiscard]] Execution execute_without_errors(
+        const SimulationOptions& options, std::string_view backend, MakeState&& make_state) const;
 
 public:
     Circuit(const TreeOne<CqasmV3xProgram>& program);
+    // A circuit of instructions built beforehand, e.g., read from a compiled circuit, without a program
+    // The register manager has to be created already
+    explicit Circuit(std::vector<std::shared_ptr<Instruction>> instructions);
     void add_instruction(std::shared_ptr<Instruction> instruction);
-    [[nodiscard]] SimulationIterationContext execute(const error_models::ErrorModel& error_model) const;
+    // Cancel and merge gates, as optimize_instructions does, before any execution
+    CircuitOptimization optimize();
+    // Remove the instructions outside the light cone of the measurements, and the qubits they leave unused,
+    // as prune_instructions does, before any execution
+    CircuitPruning prune();
+    // Number of qubits of the states the circuit is executed on,
+    // fewer than those of the qubit register once the circuit is pruned
+    [[nodiscard]] std::size_t get_number_of_qubits() const;
+    // Execute the unitary prefix of the circuit, i.e., the instructions before the first non-unitary one,
+    // without errors, and keep some of the states it goes through
+    // Later executions with the same sparse array layout, and without a noise model,
+    // resume from the latest kept state before their first error, instead of starting from |00...000>
+    void cache_noiseless_prefix(const SimulationOptions& options);
+    [[nodiscard]] SimulationIterationContext execute(
+        const error_models::ErrorModel& error_model, const SimulationOptions& options = {}) const;
+    // Start an execution, from a cached state of the unitary prefix if possible
+    [[nodiscard]] ExecutionCursor start_execution(
+        const error_models::ErrorModel& error_model, const SimulationOptions& options = {}) const;
+    // Execute the remaining instructions, calling after_instruction(cursor) after each of them
+    void resume_execution(ExecutionCursor& cursor, const error_models::ErrorModel& error_model,
+        const std::function<void(ExecutionCursor&)>& after_instruction = {}) const;
+    [[nodiscard]] std::size_t get_number_of_instructions() const;
+    [[nodiscard]] const std::vector<std::shared_ptr<Instruction>>& get_instructions() const;
+    // The placements of the qubits along the circuit, in instruction order, planned on the first call
+    [[nodiscard]] const std::vector<QubitPlacement>& get_qubit_placements() const;
+    // Execute the circuit once per distinct sequence of measurement outcomes
+    // Return std::nullopt as soon as there are more than max_branches of them
+    [[nodiscard]] std::optional<SimulationBranches> execute_branches(
+        const SimulationOptions& options, std::size_t max_branches) const;
+    // Execute the circuit once with the density_matrix backend
+    // Throw a SimulationError if there are more than options.max_branches branches
+    [[nodiscard]] DensityMatrixExecution execute_density_matrix(const SimulationOptions& options) const;
+    // Execute the circuit once with the matrix_product_state backend
+    // Throw a SimulationError if the options have an error model
+    [[nodiscard]] MatrixProductStateExecution execute_matrix_product_state(const SimulationOptions& options) const;
+    // Execute the circuit once with the distributed_state_vector backend, on the processes of the communicator
+    // Throw a SimulationError if the options have an error model
+    [[nodiscard]] DistributedStateVectorExecution execute_distributed_state_vector(
+        const SimulationOptions& options, core::Communicator& communicator) const;
+    // Execute the circuit once with the paged_state_vector backend
+    // Throw a SimulationError if the options have an error model
+    [[nodiscard]] PagedStateVectorExecution execute_paged_state_vector(const SimulationOptions& options) const;
+    // Execute the circuit once with the factorized_state_vector backend
+    // Throw a SimulationError if the options have an error model
+    [[nodiscard]] FactorizedStateVectorExecution execute_factorized_state_vector(
+        const SimulationOptions& options) const;
 
 public:
-    const TreeOne<CqasmV3xProgram>& program;
+    // Empty for circuits not built from a program
+    TreeOne<CqasmV3xProgram> program;
 
 private:
+    // The context after executing the first number_of_instructions instructions
+    struct PrefixCheckpoint {
+        std::size_t number_of_instructions;
+        SimulationIterationContext context;
+    };
+
+    std::size_t number_of_qubits_;
     std::vector<std::shared_ptr<Instruction>> instructions_;
+    mutable std::vector<QubitPlacement> qubit_placements_;
+    mutable bool are_qubits_placed_ = false;
+    std::vector<PrefixCheckpoint> prefix_checkpoints_;
+    core::SparseArrayLayout prefix_layout_ = core::SparseArrayLayout::hash_map;
 };
 
 }  // namespace qx
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <algorithm>  // for_each
+#include <array>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "qx/circuit.hpp"
+#include "qx/gates.hpp"  // default_gates
 #include "qx/operands_helper.hpp"
 #include "qx/simulation_error.hpp"
 
@@ -33,12 +36,20 @@ private:
     void visit_non_gate_instruction(CqasmV3xNonGateInstruction& non_gate_instruction) override;
 
     std::vector<std::shared_ptr<Unitary>> get_gates(const CqasmV3xGate& gate, const CqasmV3xOperands& operands);
-    std::vector<std::shared_ptr<Unitary>> get_modified_gates(
-        const CqasmV3xGate& gate, const CqasmV3xOperands& operands);
-    std::vector<std::shared_ptr<Unitary>> get_default_gates(const CqasmV3xGate& gate, const CqasmV3xOperands& operands);
+    // The matrix of a gate, shared by all the gates with the same name, parameters and modifiers
+    std::shared_ptr<core::matrix_t> get_matrix(const CqasmV3xGate& gate);
+    std::shared_ptr<core::matrix_t> get_modified_matrix(const CqasmV3xGate& gate);
+    std::shared_ptr<core::matrix_t> get_default_matrix(const CqasmV3xGate& gate);
 
 private:
     Circuit& circuit_;
+    // Intern table of the matrices of the gates built so far, keyed by get_matrix_key
+    // Unitaries never change their matrix in place, so they can all point to the same one, and the inverses,
+    // powers and controlled versions of a gate are only computed once
+    std::unordered_map<std::string, std::shared_ptr<core::matrix_t>> matrices_;
+    // Matrices of the default gates without parameters nor modifiers, the bulk of large programs,
+    // indexed by their gate identifiers, so that they are found without building a key
+    std::array<std::shared_ptr<core::matrix_t>, gates::default_gates.size()> default_matrices_;
 };
 
 }  // namespace qx
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <map>
+#include <memory>  // shared_ptr
+#include <string>
+#include <vector>
+
+namespace qx {
+
+struct Instruction;
+
+// The gates removed from a circuit by optimize_instructions
+struct CircuitOptimization {
+    // Gates removed because they cancelled out with an earlier gate, counting both gates of every pair
+    std::size_t number_of_cancelled_gates = 0;
+    // Gates removed because they were merged into an earlier gate on the same operands
+    std::size_t number_of_merged_gates = 0;
+    // How many gates of every name were removed, either way
+    std::map<std::string, std::size_t> removed_gates;
+
+    [[nodiscard]] std::size_t get_number_of_removed_gates() const;
+};
+
+// Peephole optimization of a list of instructions
+//
+// Every gate is moved back through the earlier instructions it commutes with, as long as it finds one of these:
+// - an instruction on other qubits,
+// - a gate that, on every qubit they share, is block diagonal with respect to that qubit in the same basis
+//   as the moved gate, either the Z basis, e.g., the control of a CNOT, a CZ, or an Rz,
+//   or the X basis, e.g., the target of a CNOT, or an Rx.
+// When it reaches an earlier gate on the same operands, in the same order, with which it commutes,
+// both are replaced by their product, e.g., Rx(a); Rx(b) by Rx(a + b), or removed if it is the identity,
+// e.g., H; H, CNOT; CNOT, or inv.T; T.
+// Gates are only compared to the previous config::PEEPHOLE_WINDOW instructions.
+// Non-unitary instructions, and bit-controlled ones, are never moved, and only commute with instructions
+// on other qubits.
+// The optimized instructions are equivalent to the original ones, up to floating-point rounding:
+// products are only kept as the identity if they are within config::EPSILON of it, global phase included.
+[[nodiscard]] CircuitOptimization optimize_instructions(std::vector<std::shared_ptr<Instruction>>& instructions);
+
+}  // namespace qx
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <memory>  // shared_ptr
+#include <vector>
+
+namespace qx {
+
+struct Instruction;
+
+// The instructions and qubits removed from a circuit by prune_instructions
+struct CircuitPruning {
+    std::size_t number_of_removed_instructions = 0;
+    // simulated_qubits[i] is the qubit of the register that is simulated as qubit i
+    std::vector<std::size_t> simulated_qubits;
+};
+
+// Backward light cone of the measurements of a list of instructions
+//
+// Going from the last instruction to the first, a qubit is in the light cone from the moment a later measurement
+// or reset uses it, or a later gate acts on it and on another qubit in the light cone.
+// Measurements and resets are always kept, and so are gates on a qubit in the light cone, bit-controlled or not.
+// Other gates can not change the outcome of any measurement, so they are removed.
+// Resets are kept, even on qubits that are not measured later, since they do not leave the state of the other
+// qubits as it was.
+// The qubits that are not used by any of the instructions left, nor control any of them, are dropped,
+// and the others are numbered again from 0, in the same order; at least one qubit is kept.
+// Control bits, which refer to the outcomes of measured qubits, are numbered again as well.
+// The measurements of the instructions left have the same probabilities as with the original ones,
+// but the final state is not the same.
+[[nodiscard]] CircuitPruning prune_instructions(
+    std::vector<std::shared_ptr<Instruction>>& instructions, std::size_t number_of_qubits);
+
+}  // namespace qx
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>  // byte, size_t
+#include <cstdint>  // uint64_t
+#include <functional>
+#include <memory>  // shared_ptr
+#include <span>
+#include <type_traits>  // is_trivially_copyable_v
+
+namespace qx::core {
+
+// The processes, or ranks, that share a distributed computation
+//
+// All the operations are collective: every rank has to call them, in the same order, with buffers of the same size.
+class Communicator {
+public:
+    virtual ~Communicator() = default;
+
+    [[nodiscard]] virtual std::size_t get_rank() const = 0;
+    [[nodiscard]] virtual std::size_t get_size() const = 0;
+
+    // Send a buffer to the partner rank, and receive the buffer the partner rank sends back
+    // Every rank has to be the partner of its partner
+    virtual void exchange(std::size_t partner, std::span<const std::byte> send, std::span<std::byte> receive) = 0;
+    // Overwrite the buffer of every rank with the buffer of the root rank
+    virtual void broadcast(std::span<std::byte> data, std::size_t root) = 0;
+    // Overwrite the values of every rank with their sum over all the ranks
+    virtual void all_reduce_sum(std::span<double> values) = 0;
+    virtual void all_reduce_sum(std::span<std::uint64_t> values) = 0;
+
+    template <typename T>
+    void exchange(std::size_t partner, std::span<const T> send, std::span<T> receive) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        exchange(partner, std::as_bytes(send), std::as_writable_bytes(receive));
+    }
+    template <typename T>
+    [[nodiscard]] T broadcast(T value, std::size_t root = 0) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        broadcast(std::as_writable_bytes(std::span{ &value, 1 }), root);
+        return value;
+    }
+};
+
+// Stand-in for MPI: a group of ranks running on threads of the current process
+//
+// Ranks post the addresses of their buffers to the group, and copy from the buffers of the other ranks
+// between two barriers, so a collective operation moves every byte once, as a message would.
+class LocalCommunicator : public Communicator {
+public:
+    // A group of a single rank
+    LocalCommunicator();
+
+    // Call f on number_of_ranks threads, each with the communicator of its rank, and wait for all of them
+    // Rethrow the first exception thrown by f
+    // Every rank has to make the same collective calls, including the ones thrown out of by an exception
+    static void run(std::size_t number_of_ranks, const std::function<void(Communicator&)>& f);
+
+    [[nodiscard]] std::size_t get_rank() const override;
+    [[nodiscard]] std::size_t get_size() const override;
+
+    void exchange(std::size_t partner, std::span<const std::byte> send, std::span<std::byte> receive) override;
+    void broadcast(std::span<std::byte> data, std::size_t root) override;
+    void all_reduce_sum(std::span<double> values) override;
+    void all_reduce_sum(std::span<std::uint64_t> values) override;
+
+private:
+    struct Group;
+
+    LocalCommunicator(std::shared_ptr<Group> group, std::size_t rank);
+
+    template <typename T>
+    void all_reduce_sum_impl(std::span<T> values);
+
+    std::shared_ptr<Group> group_;
+    std::size_t rank_;
+};
+
+}  // namespace qx::core
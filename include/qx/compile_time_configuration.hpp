@@ -16,7 +16,46 @@ static constexpr std::uint64_t ZERO_CYCLE_SIZE = 100;
 
 // Maximum number of qubits that can be used.
 // Maybe memory-saving as a multiple of 64.
-static constexpr std::size_t MAX_QUBIT_NUMBER = 64;
+static constexpr std::size_t MAX_QUBIT_NUMBER = 1024;
+
+// Maximum number of qubits of a state vector.
+// Basis vectors are stored in 1, 2, 4 or 16 64-bit words, the fewest that hold all the qubits.
+static constexpr std::size_t MAX_STATE_VECTOR_QUBIT_NUMBER = 1024;
+
+// Maximum number of qubits of a density matrix.
+// A density matrix of n qubits takes 16 * 4^n bytes, i.e., 4 GiB for 14 qubits.
+static constexpr std::size_t MAX_DENSITY_MATRIX_QUBIT_NUMBER = 14;
+
+// Maximum number of qubits of a distributed state vector.
+// A distributed state vector of n qubits takes 16 * 2^n bytes over all the processes, i.e., 1 TiB for 36 qubits.
+static constexpr std::size_t MAX_DISTRIBUTED_STATE_VECTOR_QUBIT_NUMBER = 48;
+
+// Maximum number of qubits of a paged state vector.
+// A paged state vector of n qubits takes 16 * 2^n bytes of storage, i.e., 4 TiB for 38 qubits.
+static constexpr std::size_t MAX_PAGED_STATE_VECTOR_QUBIT_NUMBER = 40;
+
+// Number of qubits of the blocks of amplitudes of a page to which a paged state vector applies its queued gates,
+// one block at a time: 2^14 amplitudes take 256 KiB, so a block stays in a typical L2 cache for all the gates.
+static constexpr std::size_t CACHE_BLOCK_QUBITS = 14;
+
+// Number of amplitudes compressed independently by a compressed page store: 64 KiB before compression.
+static constexpr std::size_t COMPRESSED_BLOCK_SIZE = 4096;
+
+// Number of instructions whose use of the qubits decides at which bits of the basis vectors they are stored.
+// The qubits used most by every window of that many instructions are moved to the lowest bits.
+static constexpr std::size_t QUBIT_PLACEMENT_WINDOW = 64;
+
+// Number of earlier instructions through which the circuit optimization moves a gate, looking for a gate
+// to merge it with or cancel it against.
+static constexpr std::size_t PEEPHOLE_WINDOW = 64;
+
+// Maximum number of noiseless states cached along the unitary prefix of a circuit.
+// Noisy shots resume from the latest of them before their first error.
+static constexpr std::size_t MAX_PREFIX_CHECKPOINTS = 16;
+
+// The noiseless states cached along the unitary prefix of a circuit take at most that many times
+// the memory of the state at the end of the prefix.
+static constexpr std::size_t PREFIX_CHECKPOINTS_MEMORY_FACTOR = 4;
 
 // Maximum number of bits that can be used.
 // Just for sanity, as we maintain vectors of the size of the number of used bits.
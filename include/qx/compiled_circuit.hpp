@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <istream>
+#include <ostream>
+
+#include "qx/circuit.hpp"
+
+namespace qx {
+
+// A circuit built from a cQASM program, saved so that it can be simulated again without the cQASM front-end,
+// e.g., by many short-lived processes running the same program
+//
+// A compiled circuit holds a flat stream of 32-bit words encoding the instructions, the layout of the qubit and bit
+// registers of the RegisterManager, the matrices of the gates, each written once however many gates share it,
+// and the names of the gates, also written once. Instructions refer to matrices and names by index.
+// The stream of words comes first, at an offset aligned on words, so that it is decoded in place from a mapped file.
+// It is written in native byte order, as checkpoints are, and a format version is checked when it is read.
+
+// Write a circuit, and the registers of the register manager it was built with, as a compiled circuit
+void write_compiled_circuit(std::ostream& os, const Circuit& circuit);
+// Read a compiled circuit written by write_compiled_circuit: create the register manager with its registers,
+// and return its circuit
+// Throw a SimulationError if the data is not a valid compiled circuit
+[[nodiscard]] Circuit read_compiled_circuit(std::istream& is);
+// Throw a SimulationError if the file can not be written
+void save_compiled_circuit(const std::filesystem::path& path, const Circuit& circuit);
+// Whether the file starts with the magic number of compiled circuits
+[[nodiscard]] bool is_compiled_circuit(const std::filesystem::path& path);
+// The file is memory-mapped, and its instructions decoded without copying it, where the platform supports it
+// Throw a SimulationError if the file can not be read, or is not a valid compiled circuit
+[[nodiscard]] Circuit load_compiled_circuit(const std::filesystem::path& path);
+
+}  // namespace qx
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>  // size_t, uint8_t, uint64_t
+#include <memory>  // unique_ptr
+#include <span>
+#include <vector>
+
+#include "qx/paged_state_vector.hpp"  // PageStore
+
+namespace qx::core {
+
+// Memory taken by the compressed pages of a state, and the error introduced by a lossy compression
+struct CompressionStatistics {
+    // Largest size of all the compressed pages at any time, not counting the pages in memory
+    std::uint64_t peak_bytes = 0;
+    // Upper bound to the distance between the state and the one that would have been computed without losses,
+    // i.e., the sum of the norms of the errors introduced by every compression,
+    // as long as the state is not renormalized after a measurement
+    double error = 0.;
+
+    // Upper bound to the infidelity of the state: the fidelity of two unit states at a distance d is at least
+    // (1 - d^2 / 2)^2
+    [[nodiscard]] double get_fidelity_loss() const;
+    // Keep the largest peak and error of both, e.g., of two executions of a circuit
+    CompressionStatistics& merge(const CompressionStatistics& other);
+};
+
+// Pages of a PagedStateVector kept compressed in memory
+//
+// A page is split into blocks of config::COMPRESSED_BLOCK_SIZE amplitudes, compressed independently,
+// and by several threads at once, started with the store and reused for every page.
+// Without tolerance, the compression is lossless: every real and imaginary part is stored as the bits that differ
+// from the same part of the previous amplitude, so that runs of equal amplitudes, and in particular of zeros,
+// take two bits each.
+// With a tolerance, the compression is lossy: real and imaginary parts are rounded to a multiple of
+// twice the tolerance, and stored as integers of the fewest bits that hold all the ones of a block.
+class CompressedPageStore : public PageStore {
+public:
+    // A number of threads of 0 stands for as many as the hardware can run concurrently
+    explicit CompressedPageStore(double tolerance = 0., std::size_t number_of_threads = 0);
+    CompressedPageStore(const CompressedPageStore&) = delete;
+    CompressedPageStore& operator=(const CompressedPageStore&) = delete;
+    ~CompressedPageStore() override;
+
+    void read(std::size_t page, std::span<std::complex<double>> amplitudes) override;
+    void write(std::size_t page, std::span<const std::complex<double>> amplitudes) override;
+    void discard(std::size_t page) override;
+
+    [[nodiscard]] const CompressionStatistics& get_compression_statistics() const;
+    // Current size of all the compressed pages
+    [[nodiscard]] std::uint64_t get_size() const;
+
+private:
+    using block_t = std::vector<std::uint8_t>;
+    class WorkerPool;
+
+    // Call f(block) for blocks 0 to number_of_blocks - 1, over the threads
+    // Rethrow on the calling thread the first exception thrown by f
+    template <typename F>
+    void for_each_block(std::size_t number_of_blocks, F&& f);
+
+    double tolerance_;
+    std::size_t number_of_threads_;
+    std::unique_ptr<WorkerPool> worker_pool_;
+    std::vector<std::vector<block_t>> pages_;
+    std::uint64_t size_ = 0;
+    CompressionStatistics compression_statistics_;
+};
+
+}  // namespace qx::core
@@ -8,6 +8,7 @@
 #include <cstdlib>  // abs
 #include <string>
 
+#include "qx/basis_vector.hpp"
 #include "qx/compile_time_configuration.hpp"  // EPSILON
 
 namespace qx::core {
@@ -30,7 +31,6 @@ struct Index {
 using BitIndex = Index;
 using QubitIndex = Index;
 
-using BasisVector = boost::dynamic_bitset<uint32_t>;
 using MeasurementRegister = boost::dynamic_bitset<uint32_t>;
 using BitMeasurementRegister = boost::dynamic_bitset<uint32_t>;
 using PairBasisVectorStringComplex = std::pair<std::string, std::complex<double>>;
@@ -56,6 +56,11 @@ using PairBasisVectorStringComplex = std::pair<std::string, std::complex<double>
     return ret.substr(ret.size() - n, ret.size());
 }
 
+template <std::size_t NumberOfWords>
+[[nodiscard]] std::string to_substring(const BasicBasisVector<NumberOfWords>& basis_vector, size_t n) {
+    return basis_vector.to_string(n);
+}
+
 }  // namespace qx::core
 
 template <>
@@ -18,6 +18,27 @@ namespace qx::core {
 using Row = std::vector<std::complex<double>>;
 using Matrix = std::vector<Row>;
 
+// Matrix of a size known at compile time, e.g., the matrix of a fixed gate, which can be a constant expression
+template <std::size_t N>
+using FixedMatrix = std::array<std::array<std::complex<double>, N>, N>;
+
+// Whether matrix * matrix^dagger is the identity, up to EPSILON, as DenseUnitaryMatrix checks it, at compile time
+template <std::size_t N>
+[[nodiscard]] constexpr bool is_unitary(const FixedMatrix<N>& matrix) {
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            auto product = std::complex<double>{};
+            for (std::size_t k = 0; k < N; ++k) {
+                product += matrix[i][k] * std::conj(matrix[j][k]);
+            }
+            if (not is_null(product - std::complex<double>{ i == j ? 1. : 0. })) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 class DenseUnitaryMatrix {
 public:
     ~DenseUnitaryMatrix() = default;
@@ -29,15 +50,24 @@ public:
 public:
     explicit DenseUnitaryMatrix(const Matrix& matrix, bool is_unitary_check = true);
     explicit DenseUnitaryMatrix(Matrix&& matrix, bool is_unitary_check = true);
+    // Not checked to be unitary: fixed matrices are checked with is_unitary at compile time
+    template <std::size_t M>
+    explicit DenseUnitaryMatrix(const FixedMatrix<M>& matrix)
+    : DenseUnitaryMatrix{ to_matrix(matrix), false } {}
 
-    [[nodiscard]] std::complex<double>& at(std::size_t i, std::size_t j);
     [[nodiscard]] const std::complex<double>& at(std::size_t i, std::size_t j) const;
+    // Number of rows, and of columns
+    [[nodiscard]] std::size_t size() const;
 
     bool operator==(const DenseUnitaryMatrix& other) const;
     DenseUnitaryMatrix operator*(const DenseUnitaryMatrix& other) const;
 
     static DenseUnitaryMatrix identity(size_t M);
 
+    // Whether the matrix is diagonal, with entries of modulus 1, i.e., it only changes the phases of amplitudes
+    // Worked out once, when the matrix is built, since states check it for every gate they apply
+    [[nodiscard]] bool is_phase_gate() const;
+
     [[nodiscard]] DenseUnitaryMatrix dagger() const;
     [[nodiscard]] DenseUnitaryMatrix inverse() const;
     [[nodiscard]] DenseUnitaryMatrix power(double exponent) const;
@@ -50,11 +80,23 @@ private:
     void check_is_unitary() const;
     void check_is_square() const;
 
+    template <std::size_t M>
+    [[nodiscard]] static Matrix to_matrix(const FixedMatrix<M>& matrix) {
+        auto ret = Matrix{};
+        ret.reserve(M);
+        for (const auto& row : matrix) {
+            ret.emplace_back(row.begin(), row.end());
+        }
+        return ret;
+    }
+
+    [[nodiscard]] bool has_phase_gate_entries() const;
     [[nodiscard]] Matrix from_eigen_matrix(const Eigen::MatrixXcd& eigen_matrix) const;
     [[nodiscard]] Eigen::MatrixXcd to_eigen_matrix(const Matrix& matrix) const;
 
     Matrix matrix_;
     size_t N;  // matrix size
+    bool is_phase_gate_ = false;
 };
 
 using matrix_t = core::DenseUnitaryMatrix;
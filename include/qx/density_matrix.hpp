@@ -0,0 +1,59 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>  // size_t
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <vector>
+
+#include "qx/core.hpp"  // BasisVector, QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // Matrix, matrix_t, operands_t
+
+namespace qx::core {
+
+struct DensityMatrixError : public std::runtime_error {
+    explicit DensityMatrixError(const std::string& message);
+};
+
+// Dense density matrix of a mixed quantum state
+//
+// Element (row, column) is stored at index (row << number_of_qubits) | column,
+// i.e., the density matrix is stored as a vector over 2 * number_of_qubits bits,
+// where the bits of the column are the lowest ones.
+// Operations on k qubits are applied to the row and column bits of those qubits,
+// one group of 2^k elements at a time, so they cost O(4^number_of_qubits * 2^k).
+class DensityMatrix {
+public:
+    // Start initialized in state |00...000><00...000|
+    explicit DensityMatrix(std::size_t number_of_qubits);
+
+    [[nodiscard]] std::size_t get_number_of_qubits() const;
+    [[nodiscard]] std::complex<double> at(const BasisVector& row, const BasisVector& column) const;
+    [[nodiscard]] double trace() const;
+    // Probabilities of all the basis vectors, indexed by basis vector
+    [[nodiscard]] std::vector<double> get_diagonal() const;
+
+    // rho -> U rho U^dagger
+    DensityMatrix& apply(const matrix_t& matrix, const operands_t& operands);
+    // rho -> sum_k K_k rho K_k^dagger
+    // The Kraus operators are not checked to be trace preserving, so that they can also describe projections
+    DensityMatrix& apply_channel(const std::vector<Matrix>& kraus_operators, const operands_t& operands);
+    // rho -> (1 - p) rho + p / n sum_q E_q(rho), where E_q is the single-qubit channel E applied to qubit q
+    // This is the exact counterpart of applying E, with probability p, to a qubit picked at random.
+    // Excluded qubits can still be picked, but E is not applied to them.
+    DensityMatrix& apply_channel_to_random_qubit(
+        double p, const std::vector<Matrix>& kraus_operators, const BasisVector& excluded_qubits = BasisVector{});
+
+    [[nodiscard]] double get_probability_of_measuring_one(QubitIndex qubit_index) const;
+    // Project onto the subspace where the qubit has the measured state, and renormalize
+    void update_data_after_measurement(
+        QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one);
+    // Move the population of state 1 of the qubit to state 0, discarding the coherences between both
+    void apply_reset(QubitIndex qubit_index);
+
+private:
+    std::size_t number_of_qubits_;
+    std::vector<std::complex<double>> data_;
+};
+
+}  // namespace qx::core
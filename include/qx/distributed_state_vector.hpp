@@ -0,0 +1,90 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>  // size_t, uint64_t
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <utility>  // move
+#include <vector>
+
+#include "qx/communicator.hpp"
+#include "qx/core.hpp"  // MeasurementRegister, QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // matrix_t, operands_t
+
+namespace qx::core {
+
+struct DistributedStateVectorError : public std::runtime_error {
+    explicit DistributedStateVectorError(const std::string& message);
+};
+
+// Dense state vector partitioned over the ranks of a communicator
+//
+// The number of ranks is a power of 2, 2^g, and every rank stores 2^(n - g) amplitudes of an n-qubit state.
+// The amplitudes are indexed by n physical bits: the lowest n - g, or local bits, index the amplitudes of a rank,
+// and the highest g, or global bits, are the bits of the rank.
+// Every qubit is stored at a physical bit; initially, qubit i is stored at bit i.
+//
+// A gate whose operands are all stored at local bits is applied by every rank on its own amplitudes.
+// Before that, every operand stored at a global bit is swapped with a local bit not used by the gate:
+// each rank exchanges half its amplitudes with the rank that differs in that global bit.
+// Swapped qubits are not moved back: the state keeps a permutation from qubits to physical bits instead,
+// so consecutive gates on the same qubits only communicate once.
+//
+// Probabilities and norms are summed over all the ranks, and random numbers are broadcast from rank 0,
+// so that all the ranks take the same measurement outcomes.
+// All the member functions but the getters are collective.
+class DistributedStateVector {
+public:
+    // Start initialized in state |00...000>
+    DistributedStateVector(std::size_t number_of_qubits, Communicator& communicator);
+
+    [[nodiscard]] std::size_t get_number_of_qubits() const;
+    [[nodiscard]] std::size_t get_number_of_local_qubits() const;
+    [[nodiscard]] Communicator& get_communicator() const;
+    // Amplitudes stored by this rank
+    [[nodiscard]] const std::vector<std::complex<double>>& get_local_amplitudes() const;
+    [[nodiscard]] std::complex<double> get_amplitude(const MeasurementRegister& basis_vector);
+    [[nodiscard]] double get_norm();
+
+    DistributedStateVector& apply(const matrix_t& matrix, const operands_t& operands);
+
+    [[nodiscard]] double get_probability_of_measuring_one(QubitIndex qubit_index);
+    // Project onto the subspace where the qubit has the measured state, and renormalize
+    void update_data_after_measurement(
+        QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one);
+    // Measure the qubit, using the random number of rank 0, and return the measured state
+    // random is a number in [0, 1)
+    bool measure(QubitIndex qubit_index, double random);
+    // Measure the qubit, and flip it if it was measured as one
+    void apply_reset(QubitIndex qubit_index, double random);
+    // Sample the values of all the qubits, shots times, without changing the state
+    // Only the random numbers of rank 0 are used; random_generator returns numbers in [0, 1)
+    // All the ranks return the same samples, in no particular order
+    template <typename F>
+    [[nodiscard]] std::vector<MeasurementRegister> sample(std::size_t shots, F&& random_generator) {
+        auto randoms = std::vector<double>(shots);
+        for (auto& random : randoms) {
+            random = random_generator();
+        }
+        return sample(std::move(randoms));
+    }
+
+private:
+    [[nodiscard]] std::vector<MeasurementRegister> sample(std::vector<double> randoms);
+    [[nodiscard]] std::uint64_t to_physical_index(const MeasurementRegister& basis_vector) const;
+    [[nodiscard]] MeasurementRegister to_basis_vector(std::uint64_t physical_index) const;
+    [[nodiscard]] bool is_local(std::size_t physical_bit) const;
+    // Swap a global bit with a local bit, exchanging half the amplitudes with the partner rank
+    void swap_bits(std::size_t global_bit, std::size_t local_bit);
+    // Apply a matrix on local bits: bit k of a row or column index of the matrix is the value of local_bits[k]
+    void apply_to_local_bits(const matrix_t& matrix, const std::vector<std::size_t>& local_bits);
+
+    std::size_t number_of_qubits_;
+    std::size_t number_of_local_qubits_;
+    Communicator* communicator_;
+    std::vector<std::complex<double>> local_amplitudes_;
+    std::vector<std::size_t> physical_bit_of_qubit_;
+    std::vector<std::size_t> qubit_at_physical_bit_;
+};
+
+}  // namespace qx::core
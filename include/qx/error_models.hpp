@@ -1,7 +1,16 @@
 #pragma once
 
+#include <array>
+#include <complex>
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
+#include "qx/core.hpp"  // QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // Matrix, matrix_t, operands_t
+#include "qx/density_matrix.hpp"
 #include "qx/quantum_state.hpp"
 
 namespace qx {
@@ -14,12 +23,109 @@ class DepolarizingChannel {
 public:
     explicit DepolarizingChannel(double p);
     void add_error(qx::core::QuantumState& quantum_state) const;
+    // Same as calling add_error before every instruction, but skipping ahead to the instructions that get an error:
+    // sample the number of instructions before the next error, then add that error with add_random_error
+    [[nodiscard]] std::size_t sample_number_of_error_free_instructions() const;
+    // X, Y, or Z, each with probability 1/3, on a qubit picked at random
+    void add_random_error(qx::core::QuantumState& quantum_state) const;
+    // Exact counterpart of the above: the average over all the errors that could have been added
+    // Errors on excluded qubits are left out, e.g., on qubits whose measured values are read at the end
+    void add_error(qx::core::DensityMatrix& density_matrix, const core::BasisVector& excluded_qubits = {}) const;
 
 private:
     double probability;
 };
 
-using ErrorModel = std::variant<DepolarizingChannel, std::monostate>;
+struct ErrorModelError : public std::runtime_error {
+    explicit ErrorModelError(const std::string& message);
+};
+
+//--------------//
+// KrausChannel //
+//--------------//
+
+// A single-qubit quantum channel, rho -> sum_k K_k rho K_k^dagger
+//
+// On a quantum state, the channel is applied as a quantum trajectory:
+// Kraus operator K_k is picked with probability p_k = <psi|K_k^dagger K_k|psi>, and the state becomes K_k|psi>,
+// renormalized.
+// The operators K_k^dagger K_k are precompiled. When they are all diagonal, as for the channels built below,
+// p_k only depends on the probability of measuring one, which the quantum state computes for all qubits at once.
+class KrausChannel {
+public:
+    // Throw an ErrorModelError if the Kraus operators are not 2x2, or do not preserve the trace
+    explicit KrausChannel(const std::vector<core::Matrix>& kraus_operators);
+
+    // |1> decays to |0> with probability gamma
+    [[nodiscard]] static KrausChannel amplitude_damping(double gamma);
+    // The coherences between |0> and |1> are multiplied by sqrt(1 - lambda)
+    [[nodiscard]] static KrausChannel phase_damping(double lambda);
+    // Relaxation during a gate of the given duration, for relaxation and dephasing times t1 and t2 <= 2 * t1,
+    // i.e., an amplitude damping with gamma = 1 - exp(-gate_time / t1),
+    // followed by the phase damping that makes the coherences decay as exp(-gate_time / t2)
+    [[nodiscard]] static KrausChannel thermal_relaxation(double t1, double t2, double gate_time);
+
+    [[nodiscard]] const std::vector<core::Matrix>& get_kraus_operators() const;
+
+    // random is a number in [0, 1) used to pick a Kraus operator
+    void apply(core::QuantumState& quantum_state, core::QubitIndex qubit_index, double random) const;
+    void apply(core::DensityMatrix& density_matrix, core::QubitIndex qubit_index) const;
+
+private:
+    [[nodiscard]] double get_probability(
+        std::size_t k, core::QuantumState& quantum_state, core::QubitIndex qubit_index) const;
+
+    std::vector<core::Matrix> kraus_operators_;
+    // K_k^dagger K_k, as { element (0, 0), element (1, 1), element (0, 1) }
+    std::vector<std::array<std::complex<double>, 3>> effects_;
+    bool has_diagonal_effects_ = true;
+};
+
+//--------------//
+// ReadoutError //
+//--------------//
+
+// Probabilities of reading out the opposite of the measured value
+struct ReadoutError {
+    double probability_of_reading_one_for_zero = 0.;
+    double probability_of_reading_zero_for_one = 0.;
+};
+
+//------------//
+// NoiseModel //
+//------------//
+
+// Noise of a device, made of Kraus channels attached to gates and qubits, and of readout errors
+//
+// After every gate, the channels attached to its gate name are applied to each of its operands,
+// and the channels attached to each of its operands are applied to that operand.
+// After every measurement, the readout error of the measured qubit may flip the measured value.
+// Gate names include their modifiers, e.g., "inv.X" or "ctrl.pow.Z".
+class NoiseModel {
+public:
+    NoiseModel& add_gate_error(const std::string& gate_name, KrausChannel channel);
+    NoiseModel& add_qubit_error(core::QubitIndex qubit_index, KrausChannel channel);
+    NoiseModel& add_readout_error(core::QubitIndex qubit_index, ReadoutError readout_error);
+
+    [[nodiscard]] bool has_readout_errors() const;
+
+    void add_gate_error(
+        core::QuantumState& quantum_state, const std::string& gate_name, const core::operands_t& operands) const;
+    void add_gate_error(
+        core::DensityMatrix& density_matrix, const std::string& gate_name, const core::operands_t& operands) const;
+    // Return the value read out for the measured value
+    [[nodiscard]] bool add_readout_error(core::QubitIndex qubit_index, bool measured_value) const;
+
+private:
+    template <typename F>
+    void for_each_channel(const std::string& gate_name, const core::operands_t& operands, F&& f) const;
+
+    std::unordered_map<std::string, std::vector<KrausChannel>> gate_errors_;
+    std::vector<std::vector<KrausChannel>> qubit_errors_;
+    std::vector<ReadoutError> readout_errors_;
+};
+
+using ErrorModel = std::variant<DepolarizingChannel, NoiseModel, std::monostate>;
 
 template <typename ErrorModelDef>
 ErrorModel get_error_model(ErrorModelDef error_model_def) {
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <complex>  // norm
+#include <cstdint>  // size_t
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <vector>
+
+#include "qx/core.hpp"  // MeasurementRegister, QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // matrix_t, operands_t
+#include "qx/quantum_state.hpp"
+#include "qx/sparse_array.hpp"  // SparseArrayLayout
+
+namespace qx::core {
+
+struct FactorizedStateVectorError : public std::runtime_error {
+    explicit FactorizedStateVectorError(const std::string& message);
+};
+
+// Pure state stored as a tensor product of independent factors
+//
+// Every qubit belongs to exactly one factor, a sparse state vector of the qubits of the factor.
+// Qubits start in a factor of their own, in |0>. A gate on qubits of several factors first merges them into one,
+// by their tensor product, and a measurement or a reset, which leave their qubit in a basis state, split the qubit
+// off its factor again. The memory taken is that of the largest group of qubits entangled with each other,
+// rather than that of the whole register, e.g., for circuits made of independent experiments on disjoint qubits.
+//
+// Factors are only split by measurements and resets: a gate that disentangles some qubits leaves them in the
+// same factor.
+class FactorizedStateVector {
+public:
+    // Start initialized in state |00...000>
+    FactorizedStateVector(std::size_t number_of_qubits, SparseArrayLayout layout = SparseArrayLayout::hash_map);
+
+    [[nodiscard]] std::size_t get_number_of_qubits() const;
+    [[nodiscard]] std::size_t get_number_of_factors() const;
+    // Number of qubits of the factor a qubit belongs to
+    [[nodiscard]] std::size_t get_factor_size(QubitIndex qubit_index) const;
+    // Largest number of qubits of a factor since the state was created
+    [[nodiscard]] std::size_t get_largest_factor_size() const;
+
+    FactorizedStateVector& apply(const matrix_t& matrix, const operands_t& operands);
+
+    [[nodiscard]] double get_probability_of_measuring_one(QubitIndex qubit_index);
+    // Project onto the subspace where the qubit has the measured state, renormalize, and split the qubit off
+    void update_data_after_measurement(
+        QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one);
+    // Measure the qubit, and flip it if it was measured as one
+    // As for MatrixProductState::apply_reset, this collapses the state of the qubits entangled with it
+    // random is a number in [0, 1)
+    void apply_reset(QubitIndex qubit_index, double random);
+    // Sample the values of all the qubits, factor by factor, without changing the state
+    // random_generator returns numbers in [0, 1)
+    template <typename F>
+    [[nodiscard]] MeasurementRegister sample(F&& random_generator) {
+        auto ret = MeasurementRegister{ number_of_qubits_ };
+        for (auto& factor : factors_) {
+            // The last element is picked if rounding leaves the sum of the probabilities below random
+            auto random = random_generator();
+            auto done = false;
+            factor.state.for_each([&factor, &ret, &random, &done](const auto& kv) {
+                if (done) {
+                    return;
+                }
+                for (std::size_t i = 0; i < factor.qubits.size(); ++i) {
+                    ret.set(factor.qubits[i], kv.first.test(i));
+                }
+                random -= std::norm(kv.second.value);
+                done = random < 0.;
+            });
+        }
+        return ret;
+    }
+
+private:
+    // The state of some qubits: qubits[i] is stored as qubit i of the state
+    struct Factor {
+        QuantumState state;
+        std::vector<std::size_t> qubits;
+    };
+
+    // Merge the factors of the operands into one, and return its index
+    std::size_t merge_factors(const operands_t& operands);
+    // Split a qubit in a basis state off its factor, into a factor of its own
+    void split_qubit(QubitIndex qubit_index, bool value);
+
+    std::size_t number_of_qubits_;
+    SparseArrayLayout layout_;
+    std::vector<Factor> factors_;
+    // factor_of_qubit_[i] is the index in factors_ of the factor of qubit i,
+    // and qubit_in_factor_[i] the index of qubit i in the state of that factor
+    std::vector<std::size_t> factor_of_qubit_;
+    std::vector<std::size_t> qubit_in_factor_;
+    std::size_t largest_factor_size_ = 1;
+};
+
+}  // namespace qx::core
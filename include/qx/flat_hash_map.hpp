@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>  // fill
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint8_t
+#include <functional>  // equal_to, hash
+#include <iterator>  // forward_iterator_tag
+#include <type_traits>  // conditional_t, is_trivially_destructible_v
+#include <utility>  // move, pair, swap
+#include <vector>
+
+namespace qx::core {
+
+// Open-addressing hash map with Robin Hood linear probing and backward-shift deletion
+//
+// Keys and values are stored inline in one contiguous array of slots.
+// A separate byte array keeps, for every slot, its distance to the slot the key hashes to, plus one,
+// 0 meaning the slot is empty.
+// Robin Hood insertion lets a key take the slot of a key that is closer to its own ideal slot,
+// which keeps all probe sequences short and of similar length.
+// A lookup can then stop as soon as it finds a slot closer to its ideal slot than the key being looked up.
+//
+// The ideal slot of a key is taken from the lowest bits of its hash, so Hash must return well-mixed bits.
+// Iterators are invalidated by any insertion or erasure.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using size_type = std::size_t;
+
+private:
+    using distance_t = std::uint8_t;
+
+    static constexpr size_type MIN_CAPACITY = 8;
+    static constexpr distance_t MAX_DISTANCE = 255;
+
+    template <bool IsConst>
+    class IteratorImpl {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        IteratorImpl() = default;
+        IteratorImpl(const distance_t* distance, const distance_t* distance_end, pointer slot)
+        : distance_{ distance }
+        , distance_end_{ distance_end }
+        , slot_{ slot } {
+            skip_empty_slots();
+        }
+        // Allow converting an iterator into a const iterator
+        template <bool WasConst>
+            requires(IsConst && !WasConst)
+        IteratorImpl(const IteratorImpl<WasConst>& other)  // NOLINT(google-explicit-constructor)
+        : distance_{ other.distance_ }
+        , distance_end_{ other.distance_end_ }
+        , slot_{ other.slot_ } {}
+
+        reference operator*() const { return *slot_; }
+        pointer operator->() const { return slot_; }
+        IteratorImpl& operator++() {
+            ++distance_;
+            ++slot_;
+            skip_empty_slots();
+            return *this;
+        }
+        IteratorImpl operator++(int) {
+            auto ret = *this;
+            ++*this;
+            return ret;
+        }
+        bool operator==(const IteratorImpl& other) const { return slot_ == other.slot_; }
+
+    private:
+        friend class IteratorImpl<!IsConst>;
+        void skip_empty_slots() {
+            while (distance_ != distance_end_ && *distance_ == 0) {
+                ++distance_;
+                ++slot_;
+            }
+        }
+
+        const distance_t* distance_ = nullptr;
+        const distance_t* distance_end_ = nullptr;
+        pointer slot_ = nullptr;
+    };
+
+public:
+    using iterator = IteratorImpl<false>;
+    using const_iterator = IteratorImpl<true>;
+
+    FlatHashMap() = default;
+
+    [[nodiscard]] iterator begin() { return iterator_at(0); }
+    [[nodiscard]] iterator end() { return iterator_at(capacity()); }
+    [[nodiscard]] const_iterator begin() const { return iterator_at(0); }
+    [[nodiscard]] const_iterator end() const { return iterator_at(capacity()); }
+    [[nodiscard]] const_iterator cbegin() const { return begin(); }
+    [[nodiscard]] const_iterator cend() const { return end(); }
+
+    [[nodiscard]] size_type size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] size_type capacity() const { return slots_.size(); }
+
+    // Remove all the elements but keep the allocated slots
+    void clear() {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_type index = 0; index < capacity(); ++index) {
+                if (distances_[index] != 0) {
+                    slots_[index] = value_type{};
+                }
+            }
+        }
+        std::fill(distances_.begin(), distances_.end(), distance_t{ 0 });
+        size_ = 0;
+    }
+
+    // Make room for at least n elements without having to grow
+    void reserve(size_type n) {
+        auto new_capacity = capacity() == 0 ? MIN_CAPACITY : capacity();
+        while (exceeds_max_load(n, new_capacity)) {
+            new_capacity *= 2;
+        }
+        if (new_capacity != capacity()) {
+            rehash(new_capacity);
+        }
+    }
+
+    void swap(FlatHashMap& other) noexcept {
+        std::swap(slots_, other.slots_);
+        std::swap(distances_, other.distances_);
+        std::swap(size_, other.size_);
+    }
+
+    [[nodiscard]] iterator find(const Key& key) { return iterator_at(find_index(key)); }
+    [[nodiscard]] const_iterator find(const Key& key) const { return iterator_at(find_index(key)); }
+    [[nodiscard]] bool contains(const Key& key) const { return find_index(key) != capacity(); }
+
+    // Insert a value constructed from args if key is not in the map
+    // Return an iterator to the element with that key, and whether the insertion took place
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        if (exceeds_max_load(size_ + 1, capacity())) {
+            grow();
+        }
+        for (;;) {
+            auto mask = capacity() - 1;
+            auto index = ideal_index(key);
+            for (distance_t distance = 1; distance != MAX_DISTANCE; ++distance, index = (index + 1) & mask) {
+                if (distances_[index] == 0) {
+                    distances_[index] = distance;
+                    slots_[index] = value_type{ key, Value(std::forward<Args>(args)...) };
+                    ++size_;
+                    return { iterator_at(index), true };
+                }
+                if (distances_[index] == distance && key_equal_(slots_[index].first, key)) {
+                    return { iterator_at(index), false };
+                }
+                if (distances_[index] < distance) {
+                    // Robin Hood invariant: had the key been in the map, it would have been found by now
+                    auto new_index =
+                        insert_at(index, distance, value_type{ key, Value(std::forward<Args>(args)...) });
+                    return { iterator_at(new_index), true };
+                }
+            }
+            // Probe sequence too long; only happens with very poorly distributed hashes
+            grow();
+        }
+    }
+
+    Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    // Erase all the elements for which pred returns true, and return the number of erased elements
+    template <typename Pred>
+    size_type erase_if(Pred&& pred) {
+        auto old_size = size_;
+        for (size_type index = 0; index < capacity();) {
+            // After erasing, the slot holds the element that was shifted back into it, so check it again
+            if (distances_[index] != 0 && pred(static_cast<const value_type&>(slots_[index]))) {
+                erase_at(index);
+            } else {
+                ++index;
+            }
+        }
+        return old_size - size_;
+    }
+
+    size_type erase(const Key& key) {
+        if (auto index = find_index(key); index != capacity()) {
+            erase_at(index);
+            return 1;
+        }
+        return 0;
+    }
+
+private:
+    [[nodiscard]] static bool exceeds_max_load(size_type n, size_type capacity) {
+        // Maximum load factor of 7/8
+        return n * 8 > capacity * 7;
+    }
+
+    [[nodiscard]] size_type ideal_index(const Key& key) const { return hash_(key) & (capacity() - 1); }
+
+    [[nodiscard]] iterator iterator_at(size_type index) {
+        return iterator{ distances_.data() + index, distances_.data() + capacity(), slots_.data() + index };
+    }
+    [[nodiscard]] const_iterator iterator_at(size_type index) const {
+        return const_iterator{ distances_.data() + index, distances_.data() + capacity(), slots_.data() + index };
+    }
+
+    // Return capacity() if key is not found
+    [[nodiscard]] size_type find_index(const Key& key) const {
+        if (size_ == 0) {
+            return capacity();
+        }
+        auto mask = capacity() - 1;
+        auto index = ideal_index(key);
+        for (distance_t distance = 1; distances_[index] >= distance; ++distance, index = (index + 1) & mask) {
+            if (distances_[index] == distance && key_equal_(slots_[index].first, key)) {
+                return index;
+            }
+        }
+        return capacity();
+    }
+
+    // Put element at index, which is at the given distance from its ideal slot,
+    // and push the elements that were there down their probe sequences
+    // Return the index where element ends up, which only differs from index if the map had to grow
+    size_type insert_at(size_type index, distance_t distance, value_type element) {
+        auto mask = capacity() - 1;
+        auto inserted_index = index;
+        std::swap(distances_[index], distance);
+        std::swap(slots_[index], element);
+        for (;;) {
+            index = (index + 1) & mask;
+            if (++distance == MAX_DISTANCE) {
+                auto key = slots_[inserted_index].first;
+                grow();
+                insert_unique(std::move(element));
+                return find_index(key);
+            }
+            if (distances_[index] == 0) {
+                distances_[index] = distance;
+                slots_[index] = std::move(element);
+                ++size_;
+                return inserted_index;
+            }
+            if (distances_[index] < distance) {
+                std::swap(distances_[index], distance);
+                std::swap(slots_[index], element);
+            }
+        }
+    }
+
+    // Insert an element whose key is known not to be in the map
+    void insert_unique(value_type element) {
+        for (;;) {
+            auto mask = capacity() - 1;
+            auto index = ideal_index(element.first);
+            for (distance_t distance = 1; distance != MAX_DISTANCE; ++distance, index = (index + 1) & mask) {
+                if (distances_[index] == 0) {
+                    distances_[index] = distance;
+                    slots_[index] = std::move(element);
+                    ++size_;
+                    return;
+                }
+                if (distances_[index] < distance) {
+                    std::swap(distances_[index], distance);
+                    std::swap(slots_[index], element);
+                }
+            }
+            grow();
+        }
+    }
+
+    // Shift back the elements following index in its cluster, until an empty slot or an element in its ideal slot
+    void erase_at(size_type index) {
+        auto mask = capacity() - 1;
+        for (auto next = (index + 1) & mask; distances_[next] > 1; index = next, next = (next + 1) & mask) {
+            slots_[index] = std::move(slots_[next]);
+            distances_[index] = static_cast<distance_t>(distances_[next] - 1);
+        }
+        distances_[index] = 0;
+        slots_[index] = value_type{};
+        --size_;
+    }
+
+    void grow() { rehash(capacity() == 0 ? MIN_CAPACITY : capacity() * 2); }
+
+    void rehash(size_type new_capacity) {
+        auto old_slots = std::move(slots_);
+        auto old_distances = std::move(distances_);
+        slots_ = std::vector<value_type>(new_capacity);
+        distances_ = std::vector<distance_t>(new_capacity, 0);
+        size_ = 0;
+        for (size_type index = 0; index < old_slots.size(); ++index) {
+            if (old_distances[index] != 0) {
+                insert_unique(std::move(old_slots[index]));
+            }
+        }
+    }
+
+    std::vector<value_type> slots_;
+    std::vector<distance_t> distances_;
+    size_type size_ = 0;
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] KeyEqual key_equal_;
+};
+
+}  // namespace qx::core
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <algorithm>  // find_if
+#include <array>
 #include <cmath>  // pow
-#include <functional>  // function
 #include <numbers>  // pi_v, sqrt2_v
-#include <unordered_map>
+#include <optional>
+#include <string_view>
 
 #include "qx/cqasm_v3x.hpp"
 #include "qx/dense_unitary_matrix.hpp"
@@ -12,6 +14,8 @@ namespace qx::gates {
 
 using Matrix = core::Matrix;
 using UnitaryMatrix = core::DenseUnitaryMatrix;
+template <std::size_t N>
+using FixedMatrix = core::FixedMatrix<N>;
 
 using namespace std::complex_literals;  // i
 
@@ -21,51 +25,147 @@ inline constexpr double PI = std::numbers::pi_v<double>;
 inline constexpr double SQRT_2 = std::numbers::sqrt2_v<double>;
 inline constexpr double SQRT_3 = std::numbers::sqrt3_v<double>;
 
-static UnitaryMatrix IDENTITY = UnitaryMatrix::identity(2);
+// Matrices of the fixed gates
+// They are built, and checked to be unitary, at compile time, so they cost nothing at load time
+namespace matrices {
 
-static UnitaryMatrix X{
-    Matrix{
-        { 0, 1 },
-        { 1, 0 }
-    },
-    false
-};
+inline constexpr FixedMatrix<2> IDENTITY{{
+    { 1, 0 },
+    { 0, 1 }
+}};
+static_assert(core::is_unitary(IDENTITY));
 
-static UnitaryMatrix Y{
-    Matrix{
-        {  0, -1i },
-        { 1i,   0 }
-    },
-    false
-};
+inline constexpr FixedMatrix<2> X{{
+    { 0, 1 },
+    { 1, 0 }
+}};
+static_assert(core::is_unitary(X));
 
-static UnitaryMatrix Z{
-    Matrix{
-        { 1,  0 },
-        { 0, -1 }
-    },
-    false
-};
+inline constexpr FixedMatrix<2> Y{{
+    {  0, -1i },
+    { 1i,   0 }
+}};
+static_assert(core::is_unitary(Y));
 
-static UnitaryMatrix S{
-    Matrix{
-        { 1,  0 },
-        { 0, 1i }
-    },
-    false
-};
+inline constexpr FixedMatrix<2> Z{{
+    { 1,  0 },
+    { 0, -1 }
+}};
+static_assert(core::is_unitary(Z));
 
-static UnitaryMatrix SDAG = S.dagger();
+inline constexpr FixedMatrix<2> S{{
+    { 1,  0 },
+    { 0, 1i }
+}};
+static_assert(core::is_unitary(S));
 
-static UnitaryMatrix T{
-    Matrix{
-        { 1,                        0 },
-        { 0, 1 / SQRT_2 + 1i / SQRT_2 }
-    },
-    false
-};
+inline constexpr FixedMatrix<2> SDAG{{
+    { 1,   0 },
+    { 0, -1i }
+}};
+static_assert(core::is_unitary(SDAG));
+
+inline constexpr FixedMatrix<2> T{{
+    { 1,                        0 },
+    { 0, 1 / SQRT_2 + 1i / SQRT_2 }
+}};
+static_assert(core::is_unitary(T));
+
+inline constexpr FixedMatrix<2> TDAG{{
+    { 1,                        0 },
+    { 0, 1 / SQRT_2 - 1i / SQRT_2 }
+}};
+static_assert(core::is_unitary(TDAG));
+
+inline constexpr FixedMatrix<2> X90{{
+    { 1/2. + 1i/2., 1/2. - 1i/2. },
+    { 1/2. - 1i/2., 1/2. + 1i/2. }
+}};
+static_assert(core::is_unitary(X90));
+
+inline constexpr FixedMatrix<2> MX90{{
+    { 1/2. - 1i/2., 1/2. + 1i/2. },
+    { 1/2. + 1i/2., 1/2. - 1i/2. }
+}};
+static_assert(core::is_unitary(MX90));
+
+inline constexpr FixedMatrix<2> Y90{{
+    { 1/2. + 1i/2., -1/2. - 1i/2. },
+    { 1/2. + 1i/2.,  1/2. + 1i/2. }
+}};
+static_assert(core::is_unitary(Y90));
 
-static UnitaryMatrix TDAG = T.dagger();
+inline constexpr FixedMatrix<2> MY90{{
+    {  1/2. - 1i/2., 1/2. - 1i/2. },
+    { -1/2. + 1i/2., 1/2. - 1i/2. }
+}};
+static_assert(core::is_unitary(MY90));
+
+inline constexpr FixedMatrix<2> H{{
+    { 1 / SQRT_2,  1 / SQRT_2 },
+    { 1 / SQRT_2, -1 / SQRT_2 }
+}};
+static_assert(core::is_unitary(H));
+
+inline constexpr FixedMatrix<4> CNOT{{
+    { 1, 0, 0, 0 },
+    { 0, 1, 0, 0 },
+    { 0, 0, 0, 1 },
+    { 0, 0, 1, 0 }
+}};
+static_assert(core::is_unitary(CNOT));
+
+inline constexpr FixedMatrix<4> SWAP{{
+    { 1, 0, 0, 0 },
+    { 0, 0, 1, 0 },
+    { 0, 1, 0, 0 },
+    { 0, 0, 0, 1 }
+}};
+static_assert(core::is_unitary(SWAP));
+
+inline constexpr FixedMatrix<4> CZ{{
+    { 1, 0, 0,  0 },
+    { 0, 1, 0,  0 },
+    { 0, 0, 1,  0 },
+    { 0, 0, 0, -1 }
+}};
+static_assert(core::is_unitary(CZ));
+
+inline constexpr FixedMatrix<8> TOFFOLI{{
+    { 1, 0, 0, 0, 0, 0, 0, 0 },
+    { 0, 1, 0, 0, 0, 0, 0, 0 },
+    { 0, 0, 1, 0, 0, 0, 0, 0 },
+    { 0, 0, 0, 1, 0, 0, 0, 0 },
+    { 0, 0, 0, 0, 1, 0, 0, 0 },
+    { 0, 0, 0, 0, 0, 1, 0, 0 },
+    { 0, 0, 0, 0, 0, 0, 0, 1 },
+    { 0, 0, 0, 0, 0, 0, 1, 0 }
+}};
+static_assert(core::is_unitary(TOFFOLI));
+
+}  // namespace matrices
+
+// The fixed gates are inline variables, so there is one of each in the whole program,
+// rather than one per translation unit including this header
+inline const UnitaryMatrix IDENTITY{ matrices::IDENTITY };
+inline const UnitaryMatrix X{ matrices::X };
+inline const UnitaryMatrix Y{ matrices::Y };
+inline const UnitaryMatrix Z{ matrices::Z };
+inline const UnitaryMatrix S{ matrices::S };
+inline const UnitaryMatrix SDAG{ matrices::SDAG };
+inline const UnitaryMatrix T{ matrices::T };
+inline const UnitaryMatrix TDAG{ matrices::TDAG };
+inline const UnitaryMatrix X90{ matrices::X90 };
+inline const UnitaryMatrix MX90{ matrices::MX90 };
+inline const UnitaryMatrix Y90{ matrices::Y90 };
+inline const UnitaryMatrix MY90{ matrices::MY90 };
+inline const UnitaryMatrix Z90{ matrices::S };
+inline const UnitaryMatrix MZ90{ matrices::SDAG };
+inline const UnitaryMatrix H{ matrices::H };
+inline const UnitaryMatrix CNOT{ matrices::CNOT };
+inline const UnitaryMatrix SWAP{ matrices::SWAP };
+inline const UnitaryMatrix CZ{ matrices::CZ };
+inline const UnitaryMatrix TOFFOLI{ matrices::TOFFOLI };
 
 inline UnitaryMatrix RX(double theta) {
     return UnitaryMatrix{
@@ -97,76 +197,6 @@ inline UnitaryMatrix RZ(double theta) {
     };
 }
 
-static UnitaryMatrix X90{
-    Matrix{
-        { 1/2. + 1i/2., 1/2. - 1i/2. },
-        { 1/2. - 1i/2., 1/2. + 1i/2. }
-    },
-    false
-};
-static UnitaryMatrix MX90{
-    Matrix{
-        { 1/2. - 1i/2., 1/2. + 1i/2. },
-        { 1/2. + 1i/2., 1/2. - 1i/2. }
-    },
-    false
-};
-static UnitaryMatrix Y90{
-    Matrix{
-        { 1/2. + 1i/2., -1/2. - 1i/2. },
-        { 1/2. + 1i/2.,  1/2. + 1i/2. }
-    },
-    false
-};
-static UnitaryMatrix MY90{
-    Matrix{
-        {  1/2. - 1i/2., 1/2. - 1i/2. },
-        { -1/2. + 1i/2., 1/2. - 1i/2. }
-    },
-    false
-};
-static UnitaryMatrix Z90 = S;
-static UnitaryMatrix MZ90 = SDAG;
-
-
-static UnitaryMatrix H{
-    Matrix{
-        { 1 / SQRT_2,  1 / SQRT_2 },
-        { 1 / SQRT_2, -1 / SQRT_2 }
-    },
-    false
-};
-
-static UnitaryMatrix CNOT{
-    Matrix{
-        { 1, 0, 0, 0 },
-        { 0, 1, 0, 0 },
-        { 0, 0, 0, 1 },
-        { 0, 0, 1, 0 }
-    },
-    false
-};
-
-static UnitaryMatrix SWAP{
-    Matrix{
-        { 1, 0, 0, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 1, 0, 0 },
-        { 0, 0, 0, 1 }
-    },
-    false
-};
-
-static UnitaryMatrix CZ{
-    Matrix{
-        { 1, 0, 0,  0 },
-        { 0, 1, 0,  0 },
-        { 0, 0, 1,  0 },
-        { 0, 0, 0, -1 }
-    },
-    false
-};
-
 inline UnitaryMatrix CR(double theta) {
     return UnitaryMatrix{
         Matrix{
@@ -179,50 +209,60 @@ inline UnitaryMatrix CR(double theta) {
     };
 }
 
-static UnitaryMatrix TOFFOLI{
-    Matrix{
-        { 1, 0, 0, 0, 0, 0, 0, 0 },
-        { 0, 1, 0, 0, 0, 0, 0, 0 },
-        { 0, 0, 1, 0, 0, 0, 0, 0 },
-        { 0, 0, 0, 1, 0, 0, 0, 0 },
-        { 0, 0, 0, 0, 1, 0, 0, 0 },
-        { 0, 0, 0, 0, 0, 1, 0, 0 },
-        { 0, 0, 0, 0, 0, 0, 0, 1 },
-        { 0, 0, 0, 0, 0, 0, 1, 0 }
-    },
-    false
-};
+using GateName = std::string_view;
+using UnitaryMatrixGenerator = UnitaryMatrix (*)(const CqasmV3xParameters&);
 
-using GateName = std::string;
-using UnitaryMatrixGenerator = std::function<gates::UnitaryMatrix(CqasmV3xParameters)>;
+struct DefaultGate {
+    GateName name;
+    UnitaryMatrixGenerator generator;
+};
 
-static std::unordered_map<GateName, UnitaryMatrixGenerator> default_gates = {
-    { "CNOT", [](const auto&) { return gates::CNOT; } },
-    { "CR", [](const auto& parameters) { return gates::CR(parameters[0]->as_const_float()->value); } },
+// Registry of the default gates
+// A constexpr array of plain function pointers, so it needs no initialization at load time
+inline constexpr auto default_gates = std::to_array<DefaultGate>({
+    { "CNOT", [](const auto&) { return CNOT; } },
+    { "CR", [](const auto& parameters) { return CR(parameters[0]->as_const_float()->value); } },
     { "CRk", [](const auto& parameters) {
-        return gates::CR(static_cast<double>(gates::PI) / std::pow(2, parameters[0]->as_const_int()->value - 1));
+        return CR(PI / std::pow(2, parameters[0]->as_const_int()->value - 1));
     } },
-    { "CZ", [](const auto&) { return gates::CZ; } },
-    { "H", [](const auto&) { return gates::H; } },
-    { "I", [](const auto&) { return gates::IDENTITY; } },
-    { "mX90", [](const auto&) { return gates::MX90; } },
-    { "mY90", [](const auto&) { return gates::MY90; } },
-    { "Rx", [](const auto& parameters) { return gates::RX(parameters[0]->as_const_float()->value); } },
-    { "Ry", [](const auto& parameters) { return gates::RY(parameters[0]->as_const_float()->value); } },
-    { "Rz", [](const auto& parameters) { return gates::RZ(parameters[0]->as_const_float()->value); } },
-    { "S", [](const auto&) { return gates::S; } },
-    { "Sdag", [](const auto&) { return gates::SDAG; } },
-    { "SWAP", [](const auto&) { return gates::SWAP; } },
-    { "T", [](const auto&) { return gates::T; } },
-    { "Tdag", [](const auto&) { return gates::TDAG; } },
-    { "TOFFOLI", [](const auto&) { return gates::TOFFOLI; } },
-    { "X", [](const auto&) { return gates::X; } },
-    { "X90", [](const auto&) { return gates::X90; } },
-    { "Y", [](const auto&) { return gates::Y; } },
-    { "Y90", [](const auto&) { return gates::Y90; } },
-    { "Z", [](const auto&) { return gates::Z; } }
-};
+    { "CZ", [](const auto&) { return CZ; } },
+    { "H", [](const auto&) { return H; } },
+    { "I", [](const auto&) { return IDENTITY; } },
+    { "mX90", [](const auto&) { return MX90; } },
+    { "mY90", [](const auto&) { return MY90; } },
+    { "Rx", [](const auto& parameters) { return RX(parameters[0]->as_const_float()->value); } },
+    { "Ry", [](const auto& parameters) { return RY(parameters[0]->as_const_float()->value); } },
+    { "Rz", [](const auto& parameters) { return RZ(parameters[0]->as_const_float()->value); } },
+    { "S", [](const auto&) { return S; } },
+    { "Sdag", [](const auto&) { return SDAG; } },
+    { "SWAP", [](const auto&) { return SWAP; } },
+    { "T", [](const auto&) { return T; } },
+    { "Tdag", [](const auto&) { return TDAG; } },
+    { "TOFFOLI", [](const auto&) { return TOFFOLI; } },
+    { "X", [](const auto&) { return X; } },
+    { "X90", [](const auto&) { return X90; } },
+    { "Y", [](const auto&) { return Y; } },
+    { "Y90", [](const auto&) { return Y90; } },
+    { "Z", [](const auto&) { return Z; } }
+});
 
 // clang-format on
 
+// Identifier of a default gate: its index in default_gates
+using DefaultGateId = std::size_t;
+
+// Identifier of the default gate with that name, if any
+[[nodiscard]] constexpr std::optional<DefaultGateId> find_default_gate_id(GateName name) {
+    const auto* it = std::find_if(
+        default_gates.begin(), default_gates.end(), [name](const auto& gate) { return gate.name == name; });
+    return it != default_gates.end() ? std::optional{ static_cast<DefaultGateId>(it - default_gates.begin()) }
+                                     : std::nullopt;
+}
+
+// Generator of the matrix of a default gate, or nullptr if there is no default gate with that name
+[[nodiscard]] constexpr UnitaryMatrixGenerator find_default_gate(GateName name) {
+    const auto id = find_default_gate_id(name);
+    return id ? default_gates[*id].generator : nullptr;
+}
+
 }  // namespace qx::gates
@@ -3,6 +3,7 @@
 #include <array>
 #include <cstddef>  // size_t
 #include <memory>  // shared_ptr
+#include <string>
 #include <vector>
 
 #include "qx/core.hpp"  // BasisVector, BitIndex, QubitIndex
@@ -19,6 +20,13 @@ using bit_indices_t = std::vector<core::BitIndex>;
 struct Instruction {
     virtual ~Instruction() = default;
     virtual void execute(SimulationIterationContext& context) = 0;
+    // Execute the instruction on every branch
+    // Instructions with a random outcome replace each branch with one branch per possible outcome
+    virtual void execute_branches(SimulationBranches& branches);
+    // Same for the density_matrix backend
+    virtual void execute_density_matrix_branches(DensityMatrixBranches& branches) = 0;
+    // Same for the backends of a BackendContext, which sample the outcomes of measurements and resets
+    virtual void execute_backend(BackendContextPtr context) = 0;
     [[nodiscard]] virtual qubit_indices_t get_qubit_indices() = 0;
     [[nodiscard]] virtual bit_indices_t get_bit_indices() = 0;
 };
@@ -29,7 +37,11 @@ struct BitControlledInstruction : public Instruction {
 
     ~BitControlledInstruction() override = default;
     BitControlledInstruction(ControlBits control_bits, std::shared_ptr<Instruction> instruction);
+    [[nodiscard]] bool are_all_control_bits_set(const core::MeasurementRegister& measurement_register) const;
     void execute(SimulationIterationContext& context) override;
+    void execute_branches(SimulationBranches& branches) override;
+    void execute_density_matrix_branches(DensityMatrixBranches& branches) override;
+    void execute_backend(BackendContextPtr context) override;
     [[nodiscard]] qubit_indices_t get_qubit_indices() override;
     [[nodiscard]] bit_indices_t get_bit_indices() override;
 };
@@ -37,10 +49,15 @@ struct BitControlledInstruction : public Instruction {
 struct Unitary : public Instruction {
     std::shared_ptr<core::matrix_t> matrix;
     std::shared_ptr<core::operands_t> operands;
+    // Name of the gate, preceded by its modifiers, e.g., "inv.X"
+    std::string name;
 
     ~Unitary() override = default;
-    Unitary(std::shared_ptr<core::matrix_t> matrix, std::shared_ptr<core::operands_t> operands);
+    Unitary(std::shared_ptr<core::matrix_t> matrix, std::shared_ptr<core::operands_t> operands,
+        std::string name = {});
     void execute(SimulationIterationContext& context) override;
+    void execute_density_matrix_branches(DensityMatrixBranches& branches) override;
+    void execute_backend(BackendContextPtr context) override;
     [[nodiscard]] std::shared_ptr<core::matrix_t> inverse() const;
     [[nodiscard]] std::shared_ptr<core::matrix_t> power(double exponent) const;
     [[nodiscard]] std::shared_ptr<core::matrix_t> control() const;
@@ -51,6 +68,8 @@ struct Unitary : public Instruction {
 struct NonUnitary : public Instruction {
     ~NonUnitary() override = default;
     void execute(SimulationIterationContext& context) override = 0;
+    void execute_density_matrix_branches(DensityMatrixBranches& branches) override = 0;
+    void execute_backend(BackendContextPtr context) override = 0;
     [[nodiscard]] qubit_indices_t get_qubit_indices() override = 0;
     [[nodiscard]] bit_indices_t get_bit_indices() override = 0;
 };
@@ -62,6 +81,9 @@ struct Measure : public NonUnitary {
     ~Measure() override = default;
     Measure(const core::QubitIndex& qubit_index, const core::BitIndex& bit_index);
     void execute(SimulationIterationContext& context) override;
+    void execute_branches(SimulationBranches& branches) override;
+    void execute_density_matrix_branches(DensityMatrixBranches& branches) override;
+    void execute_backend(BackendContextPtr context) override;
     [[nodiscard]] qubit_indices_t get_qubit_indices() override;
     [[nodiscard]] bit_indices_t get_bit_indices() override;
 };
@@ -72,6 +94,8 @@ struct Reset : public NonUnitary {
     ~Reset() override = default;
     explicit Reset(const core::QubitIndex& qubit_index);
     void execute(SimulationIterationContext& context) override;
+    void execute_density_matrix_branches(DensityMatrixBranches& branches) override;
+    void execute_backend(BackendContextPtr context) override;
     [[nodiscard]] qubit_indices_t get_qubit_indices() override;
     [[nodiscard]] bit_indices_t get_bit_indices() override;
 };
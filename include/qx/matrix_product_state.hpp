@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <array>
+#include <complex>
+#include <cstdint>  // size_t
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <vector>
+
+#include "qx/core.hpp"  // MeasurementRegister, QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // matrix_t, operands_t
+
+namespace qx::core {
+
+struct MatrixProductStateError : public std::runtime_error {
+    explicit MatrixProductStateError(const std::string& message);
+};
+
+// Pure state of a chain of qubits, stored as a matrix product state (MPS)
+//
+// Every site of the chain holds one qubit, and a pair of matrices, one per value of the qubit.
+// The amplitude of a basis vector is the product of the matrices picked by the value of every site.
+// The size of those matrices, or bond dimension, grows with the entanglement between both sides of the chain,
+// and is capped by max_bond_dimension.
+//
+// The state is kept in mixed canonical form around an orthogonality center, so that the norm of the state,
+// the probabilities of the qubit at the center, and the best truncation of a bond next to it, are all local.
+// A gate on k qubits first moves its operands next to each other with swaps, then contracts their k sites,
+// applies the gate, and splits them back with k - 1 singular value decompositions.
+// Swapped qubits are not moved back: the chain keeps a permutation from qubits to sites instead.
+//
+// Truncating a bond discards the smallest singular values, up to max_bond_dimension singular values kept,
+// and as long as the discarded weight, i.e., the sum of the squares of the discarded singular values,
+// stays below truncation_threshold. The state is then renormalized.
+// The truncation error is the sum of all the discarded weights, an upper bound to the infidelity of the state.
+class MatrixProductState {
+public:
+    // Start initialized in state |00...000>
+    MatrixProductState(std::size_t number_of_qubits, std::size_t max_bond_dimension, double truncation_threshold);
+
+    [[nodiscard]] std::size_t get_number_of_qubits() const;
+    // Largest bond dimension of the current state
+    [[nodiscard]] std::size_t get_bond_dimension() const;
+    [[nodiscard]] double get_truncation_error() const;
+    [[nodiscard]] std::complex<double> get_amplitude(const MeasurementRegister& basis_vector) const;
+
+    MatrixProductState& apply(const matrix_t& matrix, const operands_t& operands);
+
+    [[nodiscard]] double get_probability_of_measuring_one(QubitIndex qubit_index);
+    // Project onto the subspace where the qubit has the measured state, and renormalize
+    void update_data_after_measurement(
+        QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one);
+    // Measure the qubit, and flip it if it was measured as one
+    // Unlike QuantumState::apply_reset, this collapses the state of the qubits entangled with it
+    // random is a number in [0, 1)
+    void apply_reset(QubitIndex qubit_index, double random);
+    // Sample the values of all the qubits, without changing the state
+    // random_generator returns numbers in [0, 1)
+    template <typename F>
+    [[nodiscard]] MeasurementRegister sample(F&& random_generator) {
+        move_center_to(0);
+        auto ret = MeasurementRegister{ number_of_qubits_ };
+        // Left environment of the current site, i.e., the product of the matrices picked so far
+        Eigen::RowVectorXcd environment = Eigen::RowVectorXcd::Ones(1);
+        for (std::size_t site = 0; site < number_of_qubits_; ++site) {
+            Eigen::RowVectorXcd environment_of_one = environment * sites_[site][1];
+            auto probability_of_one = environment_of_one.squaredNorm() / environment.squaredNorm();
+            auto value = random_generator() < probability_of_one;
+            environment = value ? std::move(environment_of_one) : Eigen::RowVectorXcd{ environment * sites_[site][0] };
+            environment.normalize();
+            ret.set(qubit_at_site_[site], value);
+        }
+        return ret;
+    }
+
+private:
+    using Site = std::array<Eigen::MatrixXcd, 2>;
+
+    void move_center_to(std::size_t site);
+    void swap_sites(std::size_t site);
+    // Apply a matrix on the consecutive sites [first_site, first_site + number_of_sites)
+    // Bit k of a row or column index of the matrix is the value of site first_site + number_of_sites - k - 1
+    void apply_to_sites(std::size_t first_site, std::size_t number_of_sites, const matrix_t& matrix);
+    [[nodiscard]] Eigen::Index get_number_of_kept_singular_values(const Eigen::VectorXd& singular_values);
+
+    std::size_t number_of_qubits_;
+    std::size_t max_bond_dimension_;
+    double truncation_threshold_;
+    double truncation_error_ = 0.;
+    std::vector<Site> sites_;
+    std::vector<std::size_t> site_of_qubit_;
+    std::vector<std::size_t> qubit_at_site_;
+    std::size_t center_ = 0;
+};
+
+}  // namespace qx::core
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>  // byte, size_t
+#include <cstdint>  // uint64_t
+#include <span>
+#include <stdexcept>  // runtime_error
+#include <string>
+
+#include "qx/communicator.hpp"
+
+namespace qx::core {
+
+struct MpiError : public std::runtime_error {
+    explicit MpiError(const std::string& message);
+};
+
+// The processes of MPI_COMM_WORLD
+//
+// Only built with the QX_BUILD_MPI option, which defines QX_MPI.
+// The communicator initializes and finalizes MPI, unless MPI was already initialized, e.g., by the caller.
+class MpiCommunicator : public Communicator {
+public:
+    MpiCommunicator(int* argc, char*** argv);
+    ~MpiCommunicator() override;
+    MpiCommunicator(const MpiCommunicator&) = delete;
+    MpiCommunicator& operator=(const MpiCommunicator&) = delete;
+
+    [[nodiscard]] std::size_t get_rank() const override;
+    [[nodiscard]] std::size_t get_size() const override;
+
+    void exchange(std::size_t partner, std::span<const std::byte> send, std::span<std::byte> receive) override;
+    void broadcast(std::span<std::byte> data, std::size_t root) override;
+    void all_reduce_sum(std::span<double> values) override;
+    void all_reduce_sum(std::span<std::uint64_t> values) override;
+
+private:
+    bool has_initialized_ = false;
+    std::size_t rank_ = 0;
+    std::size_t size_ = 1;
+};
+
+}  // namespace qx::core
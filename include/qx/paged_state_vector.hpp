@@ -0,0 +1,163 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>  // size_t, uint64_t
+#include <filesystem>
+#include <memory>  // unique_ptr
+#include <optional>
+#include <span>
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <utility>  // move
+#include <vector>
+
+#include "qx/core.hpp"  // MeasurementRegister, QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // matrix_t, operands_t
+
+namespace qx::core {
+
+struct PagedStateVectorError : public std::runtime_error {
+    explicit PagedStateVectorError(const std::string& message);
+};
+
+// Data moved between memory and a page store, and the time spent moving it
+struct PagingStatistics {
+    std::uint64_t bytes_read = 0;
+    std::uint64_t bytes_written = 0;
+    double seconds = 0.;
+
+    // Bytes read and written per second
+    [[nodiscard]] double get_throughput() const;
+    PagingStatistics& operator+=(const PagingStatistics& other);
+};
+
+// Where a PagedStateVector keeps the pages that are not in memory
+class PageStore {
+public:
+    virtual ~PageStore() = default;
+    // Read back the amplitudes of a page written before
+    virtual void read(std::size_t page, std::span<std::complex<double>> amplitudes) = 0;
+    virtual void write(std::size_t page, std::span<const std::complex<double>> amplitudes) = 0;
+    // The page is zero from now on, and will not be read again before being written
+    virtual void discard(std::size_t /* page */) {}
+};
+
+// Dense state vector kept in a file, and paged in and out of memory one page at a time
+//
+// The 2^n amplitudes are split into 2^g pages of 2^p amplitudes: the lowest p physical bits, or page bits,
+// index the amplitudes of a page, and the highest g ones index the pages.
+// Every qubit is stored at a physical bit; initially, qubit i is stored at bit i.
+//
+// A gate whose operands are all stored at page bits is not applied right away, but queued.
+// The queue is applied before the state is read, in a single pass over the pages,
+// so that every page is read and written once per batch of gates.
+// Within a page, consecutive gates on the lowest c = min(config::CACHE_BLOCK_QUBITS, p) bits, or block bits,
+// are applied one block of 2^c amplitudes at a time, all of them while the block is in cache.
+// Before a gate on a qubit stored at a page-index bit, that qubit is swapped with the block bit not used by the gate
+// that was used least recently, in one pass that reads and writes pairs of pages.
+// A qubit stored at a page bit above the block bits is swapped likewise, by a swap queued as a gate on both bits.
+// As in DistributedStateVector, swapped qubits are not moved back: the state keeps a permutation instead.
+//
+// Pages never written, or projected out by a measurement, are known to be zero, and are neither read nor written.
+// The last page of a pass stays in memory, so a state of a single page is never written to the file.
+// Pages can also be kept in another PageStore than a file, e.g., compressed in memory.
+class PagedStateVector {
+public:
+    // Start initialized in state |00...000>
+    // The page file is created in directory, or in the temporary directory if empty, and removed with the state
+    PagedStateVector(
+        std::size_t number_of_qubits, std::size_t number_of_page_qubits, const std::filesystem::path& directory = {});
+    // Same, with the pages kept in page_store instead of a page file
+    PagedStateVector(
+        std::size_t number_of_qubits, std::size_t number_of_page_qubits, std::unique_ptr<PageStore> page_store);
+    ~PagedStateVector();
+    PagedStateVector(PagedStateVector&& other) noexcept;
+    PagedStateVector& operator=(PagedStateVector&& other) noexcept;
+    PagedStateVector(const PagedStateVector&) = delete;
+    PagedStateVector& operator=(const PagedStateVector&) = delete;
+
+    [[nodiscard]] std::size_t get_number_of_qubits() const;
+    [[nodiscard]] std::size_t get_number_of_pages() const;
+    [[nodiscard]] const PagingStatistics& get_paging_statistics() const;
+    [[nodiscard]] const PageStore* get_page_store() const;
+    [[nodiscard]] std::complex<double> get_amplitude(const MeasurementRegister& basis_vector);
+    [[nodiscard]] double get_norm();
+
+    PagedStateVector& apply(const matrix_t& matrix, const operands_t& operands);
+
+    [[nodiscard]] double get_probability_of_measuring_one(QubitIndex qubit_index);
+    // Project onto the subspace where the qubit has the measured state, and renormalize
+    void update_data_after_measurement(
+        QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one);
+    // Measure the qubit, and return the measured state
+    // random is a number in [0, 1)
+    bool measure(QubitIndex qubit_index, double random);
+    // Measure the qubit, and flip it if it was measured as one
+    void apply_reset(QubitIndex qubit_index, double random);
+    // Sample the values of all the qubits, shots times, without changing the state, in a single pass over the pages
+    // random_generator returns numbers in [0, 1)
+    template <typename F>
+    [[nodiscard]] std::vector<MeasurementRegister> sample(std::size_t shots, F&& random_generator) {
+        auto randoms = std::vector<double>(shots);
+        for (auto& random : randoms) {
+            random = random_generator();
+        }
+        return sample(std::move(randoms));
+    }
+
+private:
+    // A gate on page bits: bit k of a row or column index of the matrix is the value of page_bits[k]
+    struct QueuedGate {
+        matrix_t matrix;
+        std::vector<std::size_t> page_bits;
+    };
+
+    [[nodiscard]] std::vector<MeasurementRegister> sample(std::vector<double> randoms);
+    [[nodiscard]] bool is_page_bit(std::size_t physical_bit) const;
+    [[nodiscard]] std::size_t get_page_size() const;
+    // Call f(page, amplitudes) on every page that is not zero and passes the filter,
+    // starting with the page in memory, so that a pass does not read it again
+    template <typename F, typename Filter = bool (*)(std::size_t)>
+    void for_each_page(F&& f, Filter&& filter = [](std::size_t) { return true; }) {
+        auto number_of_pages = get_number_of_pages();
+        auto first_page = page_in_memory_.value_or(0);
+        for (std::size_t k = 0; k < number_of_pages; ++k) {
+            auto page = (first_page + k) % number_of_pages;
+            if ((!is_zero_page_[page] || page_in_memory_ == page) && filter(page)) {
+                f(page, load_page(page));
+            }
+        }
+    }
+    // Apply the queued gates to all the pages that are not zero
+    void apply_queued_gates();
+    // The block bit not used by the gate that was used least recently, the highest of them in case of a tie
+    [[nodiscard]] std::size_t get_least_recently_used_block_bit(const std::vector<bool>& is_used) const;
+    // Make the page the one in memory, writing back the previous one if it was modified
+    std::vector<std::complex<double>>& load_page(std::size_t page);
+    void unload_page();
+    void read_page(std::size_t page, std::vector<std::complex<double>>& amplitudes);
+    void write_page(std::size_t page, const std::vector<std::complex<double>>& amplitudes);
+    // Swap a page-index bit with a page bit, reading and writing every pair of pages that differ in the former
+    void swap_bits(std::size_t page_index_bit, std::size_t page_bit);
+    // Store each of the qubits stored at these physical bits at the other one
+    void swap_qubits(std::size_t physical_bit, std::size_t other_physical_bit);
+    [[nodiscard]] MeasurementRegister to_basis_vector(std::uint64_t physical_index) const;
+
+    std::size_t number_of_qubits_;
+    std::size_t number_of_page_qubits_;
+    std::size_t number_of_block_qubits_;
+    std::unique_ptr<PageStore> page_store_;
+    std::vector<std::complex<double>> page_;
+    std::optional<std::size_t> page_in_memory_;
+    bool is_page_modified_ = false;
+    std::vector<bool> is_zero_page_;
+    std::vector<QueuedGate> queued_gates_;
+    // Number of gates applied when every block bit was last used by one
+    std::vector<std::uint64_t> last_use_of_block_bit_;
+    std::uint64_t number_of_gates_ = 0;
+    std::vector<std::size_t> physical_bit_of_qubit_;
+    std::vector<std::size_t> qubit_at_physical_bit_;
+    PagingStatistics paging_statistics_;
+};
+
+}  // namespace qx::core
@@ -2,14 +2,19 @@
 
 #include <fmt/ostream.h>
 
+#include <algorithm>  // fill, find_if, for_each, sort
 #include <array>
 #include <complex>  // norm
 #include <cstdint>  // size_t
 #include <initializer_list>
+#include <istream>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>  // decay_t
 #include <utility>  // invoke, pair
+#include <variant>
+#include <vector>
 
 #include "qx/core.hpp"  // BasisVector, BitMeasurementRegister, MeasurementRegister, QubitIndex
 #include "qx/dense_unitary_matrix.hpp"
@@ -23,25 +28,67 @@ struct QuantumStateError : public std::runtime_error {
     explicit QuantumStateError(const std::string& message);
 };
 
-void apply_impl(const matrix_t& matrix, const operands_t& operands, BasisVector index,
-    const SparseComplex& sparse_complex, SparseArray::MapBasisVectorToSparseComplex& storage);
+template <typename BasisVectorT>
+void apply_impl(const matrix_t& matrix, const operands_t& operands, BasisVectorT index,
+    const SparseComplex& sparse_complex,
+    typename BasicSparseArray<BasisVectorT>::MapBasisVectorToSparseComplex& storage);
+template <typename BasisVectorT>
+void apply_sorted_impl(const matrix_t& matrix, const operands_t& operands,
+    typename BasicSparseArray<BasisVectorT>::VectorOfSparseElements& elements,
+    typename BasicSparseArray<BasisVectorT>::VectorOfSparseElements& scratch);
 
+// The basis vector whose bit positions[i] is bit i of basis_vector
+template <typename BasisVectorT>
+[[nodiscard]] BasisVectorT permute_bits(const BasisVectorT& basis_vector, const std::vector<std::size_t>& positions) {
+    auto ret = BasisVectorT{};
+    basis_vector.for_each_set_bit([&ret, &positions](auto i) { ret.set(positions[i]); });
+    return ret;
+}
+
+// Sparse state vector
+//
+// Its basis vectors are the narrowest ones that can hold all the qubits, i.e., 64, 128, 256 or 1024 bits,
+// so the number of qubits is only limited by the number of non-zero amplitudes.
+// Functions called with the elements of the state, e.g., by for_each, have to accept all these basis vector types.
+//
+// Qubit i is stored at bit i of the basis vectors, unless the qubits are moved to other bit positions,
+// e.g., to store the qubits most gates act on at the lowest bits, where the amplitudes a gate combines are
+// the closest in a sorted_vector layout. The positions only change the storage: the state is still read and
+// updated by qubit index, and its elements are given to for_each with qubit i at bit i.
 class QuantumState {
+    using Data = std::variant<BasicSparseArray<BasisVector>, BasicSparseArray<BasisVector128>,
+        BasicSparseArray<BasisVector256>, BasicSparseArray<BasisVector1024>>;
+
+    [[nodiscard]] static Data make_data(std::size_t number_of_qubits,
+        std::initializer_list<PairBasisVectorStringComplex> values, SparseArrayLayout layout);
     void check_quantum_state();
 
     void reset_data();
 
+    [[nodiscard]] std::vector<bool> get_all_qubits() const;
+    void compute_marginal_probabilities(const std::vector<bool>& qubits);
+
 public:
     QuantumState();
-    QuantumState(std::size_t qubit_register_size, std::size_t bit_register_size);
     QuantumState(std::size_t qubit_register_size, std::size_t bit_register_size,
-        std::initializer_list<PairBasisVectorStringComplex> values);
+        SparseArrayLayout layout = SparseArrayLayout::hash_map);
+    QuantumState(std::size_t qubit_register_size, std::size_t bit_register_size,
+        std::initializer_list<PairBasisVectorStringComplex> values,
+        SparseArrayLayout layout = SparseArrayLayout::hash_map);
 
     [[nodiscard]] std::size_t get_number_of_qubits() const;
     [[nodiscard]] std::size_t get_number_of_bits() const;
     [[nodiscard]] bool is_normalized();
     [[nodiscard]] std::vector<std::complex<double>> to_vector() const;
     void reset();
+    [[nodiscard]] SparseArrayLayout get_layout() const;
+    // Approximate number of bytes taken by the amplitudes
+    [[nodiscard]] std::size_t get_memory_size() const;
+    // Bit of the basis vectors where every qubit is stored
+    [[nodiscard]] std::vector<std::size_t> get_qubit_positions() const;
+    // Move every qubit i to bit positions[i]
+    // Throw a QuantumStateError if positions is not a permutation of the qubit indices
+    void set_qubit_positions(const std::vector<std::size_t>& positions);
 
     QuantumState& apply(const matrix_t& matrix, const operands_t& operands) {
         assert(operands.size() <= number_of_qubits_ &&
@@ -51,17 +98,53 @@ public:
                    [this](auto qubit_index) { return qubit_index.value >= number_of_qubits_; }) == operands.end() &&
             "Operand refers to a non-existing qubit");
 
-        data_.apply_linear([&matrix, &operands](auto index, auto value, auto& storage) {
-            apply_impl(matrix, operands, index, value, storage);
-        });
+        // Pauli gates only change the Pauli frame, and the other gates are conjugated by it
+        if (operands.size() == 1 && absorb_pauli_gate(matrix, operands[0])) {
+            return *this;
+        }
+        if (has_pauli_frame_on(operands)) {
+            apply_under_pauli_frame(conjugate_by_pauli_frame(matrix, operands), operands);
+        } else {
+            apply_under_pauli_frame(matrix, operands);
+        }
         return *this;
     }
 
+    // Number of diagonal gates queued by apply and not applied to the amplitudes yet
+    [[nodiscard]] std::size_t get_number_of_queued_diagonal_gates() const;
+    // Whether some Pauli gates are kept in the Pauli frame, and not applied to the amplitudes yet
+    [[nodiscard]] bool has_pauli_frame() const;
+
+    // Call f with every non-zero element, in basis vector order
     template <typename F>
     void for_each(F&& f) {
-        data_.for_each_sorted(f);
+        apply_diagonal_gates();
+        apply_pauli_frame();
+        std::visit(
+            [this, &f](auto& data) {
+                if (position_of_qubit_.empty()) {
+                    data.for_each_sorted(f);
+                    return;
+                }
+                using SparseElement = typename std::decay_t<decltype(data)>::SparseElement;
+                auto elements = std::vector<SparseElement>{};
+                data.for_each([this, &elements](const auto& kv) {
+                    elements.emplace_back(permute_bits(kv.first, qubit_at_position_), kv.second);
+                });
+                std::sort(
+                    elements.begin(), elements.end(), compare_sparse_elements<typename SparseElement::first_type>);
+                std::for_each(elements.begin(), elements.end(), f);
+            },
+            data_);
     }
 
+    // Probability of measuring one, for every qubit, indexed by qubit index
+    // They are all computed in one pass over the state, and cached until the state changes
+    [[nodiscard]] const std::vector<double>& get_marginal_probabilities();
+    // Probability of measuring one, for each of the given qubits
+    // The ones that are not cached are computed in one pass over the state
+    [[nodiscard]] std::vector<double> get_marginal_probabilities(const std::vector<QubitIndex>& qubit_indices);
+
     [[nodiscard]] double get_probability_of_measuring_one(QubitIndex qubit_index);
     [[nodiscard]] double get_probability_of_measuring_zero(QubitIndex qubit_index);
     void update_data_after_measurement(
@@ -81,10 +164,99 @@ public:
 
     void apply_reset(QubitIndex qubit_index);
 
+    // State of the qubits of *this followed by the qubits of other, i.e., qubit i of other is qubit
+    // get_number_of_qubits() + i of the product, with the layout of *this
+    [[nodiscard]] QuantumState tensor_product(QuantumState& other);
+    // State of the other qubits, once a qubit is left in a basis state, e.g., right after it is measured,
+    // with every qubit i above the removed one moved to qubit i - 1
+    // Throw a QuantumStateError if the qubit is not in a basis state, or is the only qubit of the state
+    [[nodiscard]] QuantumState remove_qubit(QubitIndex qubit_index);
+
+    // Write the state in a compact binary format: its sizes, layout and qubit positions, then its non-zero amplitudes
+    // in stored basis vector order, each as the words of its basis vector followed by its real and imaginary parts
+    void write(std::ostream& os);
+    // Read a state written by write
+    // The amplitudes are inserted in basis vector order, so reading the same bytes always gives the same storage,
+    // and later computations on the state give the same results, bit for bit
+    [[nodiscard]] static QuantumState read(std::istream& is);
+
 private:
+    // Diagonal of a gate, and the bits where its operands are stored
+    struct DiagonalGate {
+        std::vector<std::complex<double>> diagonal;
+        operands_t operands;
+    };
+
+    // Apply a gate to the amplitudes as they are stored, under the Pauli frame
+    void apply_under_pauli_frame(const matrix_t& matrix, const operands_t& operands) {
+        // The gate acts on the bits where its operands are stored
+        auto moved_operands = operands_t{};
+        if (!position_of_qubit_.empty()) {
+            moved_operands.reserve(operands.size());
+            for (const auto& operand : operands) {
+                moved_operands.push_back(get_position(operand));
+            }
+        }
+        const auto& stored_operands = position_of_qubit_.empty() ? operands : moved_operands;
+        // Phase gates leave the marginal probabilities as they are
+        if (matrix.is_phase_gate()) {
+            queue_diagonal_gate(matrix, stored_operands);
+            return;
+        }
+        apply_diagonal_gates();
+        std::fill(cached_marginal_probabilities_.begin(), cached_marginal_probabilities_.end(), false);
+        std::visit(
+            [&matrix, &operands = stored_operands](auto& data) {
+                using BasisVectorT = typename std::decay_t<decltype(data)>::BasisVectorType;
+                if (data.get_layout() == SparseArrayLayout::sorted_vector) {
+                    data.apply_sorted([&matrix, &operands](auto& elements, auto& scratch) {
+                        apply_sorted_impl<BasisVectorT>(matrix, operands, elements, scratch);
+                    });
+                } else {
+                    data.apply_linear([&matrix, &operands](auto index, auto value, auto& storage) {
+                        apply_impl<BasisVectorT>(matrix, operands, index, value, storage);
+                    });
+                }
+            },
+            data_);
+    }
+
+    [[nodiscard]] QubitIndex get_position(QubitIndex qubit_index) const;
+    [[nodiscard]] std::size_t get_qubit_at(std::size_t position) const;
+    [[nodiscard]] bool absorb_pauli_gate(const matrix_t& matrix, QubitIndex qubit_index);
+    [[nodiscard]] bool has_pauli_frame_on(const operands_t& operands) const;
+    [[nodiscard]] matrix_t conjugate_by_pauli_frame(const matrix_t& matrix, const operands_t& operands) const;
+    void apply_pauli_frame();
+    void queue_diagonal_gate(const matrix_t& matrix, const operands_t& operands);
+    void apply_diagonal_gates();
+    template <typename BasisVectorT>
+    [[nodiscard]] std::complex<double> get_queued_phase(const BasisVectorT& basis_vector) const;
+
     std::size_t number_of_qubits_;
     std::size_t number_of_bits_;
-    SparseArray data_;
+    Data data_;
+    // position_of_qubit_[i] is the bit where qubit i is stored, and qubit_at_position_ the inverse permutation;
+    // both are empty while every qubit i is stored at bit i
+    std::vector<std::size_t> position_of_qubit_;
+    std::vector<std::size_t> qubit_at_position_;
+    // marginal_probabilities_[i] is the probability of measuring one for qubit i,
+    // and is only up to date if cached_marginal_probabilities_[i] is set
+    std::vector<double> marginal_probabilities_;
+    std::vector<bool> cached_marginal_probabilities_;
+    // Phase gates, e.g., S, T, Rz, CZ or CR, are queued until an operation needs the amplitudes:
+    // a gate that is not diagonal, a reset, or reading the state. They all commute, so they are applied together,
+    // in one pass over the state, instead of one pass per gate. Measurements commute with them as well.
+    std::vector<DiagonalGate> queued_diagonal_gates_;
+    // Pauli frame: the state is pauli_frame_phase_ times the product over the qubits of X^x Z^z,
+    // with x and z the bits of the qubit in pauli_frame_x_ and pauli_frame_z_, applied to the stored amplitudes.
+    // Pauli gates, e.g., the errors of the depolarizing channel, only update it. Every other gate is conjugated
+    // by the frame on its operands, a measurement flips the outcome of the stored qubits when their x bit is set,
+    // and the frame is only applied to the amplitudes by a reset or when the state is read.
+    // Both the frame and the marginal probabilities are indexed by qubit index; the probabilities are those
+    // of the state, with the frame.
+    std::vector<bool> pauli_frame_x_;
+    std::vector<bool> pauli_frame_z_;
+    std::complex<double> pauli_frame_phase_ = 1.;
 };
 
 std::ostream& operator<<(std::ostream& os, const QuantumState& array);
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <optional>
+#include <string>
+#include <utility>  // move
 #include <variant>  // monostate
 
 #include "qx/simulator.hpp"
@@ -40,4 +43,52 @@ inline std::variant<std::monostate, qx::SimulationResult, qx::SimulationError> e
     return qx::execute_file(file_path, iterations, seed, std::move(version));
 }
 
+/**
+ * Compiles a cQASM program from a string into a compiled circuit file.
+ * A compiled circuit file is simulated by `execute_compiled_file` without parsing the cQASM program again.
+ *
+ * Parameters:
+ *   - `program` is a string containing the cQASM program.
+ *   - `output_file_path` is the file path of the compiled circuit.
+ *   - `version` is the cQASM program version.
+ *
+ * Returns either nothing or an error.
+ */
+inline std::optional<qx::SimulationError> compile_string(
+    const std::string& program, const std::string& output_file_path, std::string version = "3.0") {
+    return qx::compile_string(program, output_file_path, std::move(version));
+}
+
+/**
+ * Compiles a cQASM program from a file into a compiled circuit file.
+ * A compiled circuit file is simulated by `execute_compiled_file` without parsing the cQASM program again.
+ *
+ * Parameters:
+ *   - `file_path` is the file path of the cQASM program.
+ *   - `output_file_path` is the file path of the compiled circuit.
+ *   - `version` is the cQASM program version.
+ *
+ * Returns either nothing or an error.
+ */
+inline std::optional<qx::SimulationError> compile_file(
+    const std::string& file_path, const std::string& output_file_path, std::string version = "3.0") {
+    return qx::compile_file(file_path, output_file_path, std::move(version));
+}
+
+/**
+ * Simulates a compiled circuit file, as written by `compile_string` or `compile_file`.
+ *
+ * Parameters:
+ *   - `compiled_file_path` is the file path of the compiled circuit.
+ *   - `iterations` is the number of times the program is being simulated.
+ *   - `seed` can be used in case a deterministic output is needed.
+ *
+ * Returns either a simulation result or an error.
+ */
+inline std::variant<std::monostate, qx::SimulationResult, qx::SimulationError> execute_compiled_file(
+    const std::string& compiled_file_path, std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt) {
+    return qx::execute_compiled_file(compiled_file_path, iterations, seed);
+}
+
 }  // namespace qxelarator
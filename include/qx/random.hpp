@@ -4,15 +4,30 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace qx::random {
 
 void seed(std::uint_fast64_t seed_value);
 
+// State of the random number generator, so that set_state can later restore the same sequence of random numbers
+std::string get_state();
+
+// Throw a std::invalid_argument if the state was not returned by get_state
+void set_state(const std::string& state);
+
 double random_zero_one_double();
 
 std::uint_fast64_t random_integer(std::uint_fast64_t min, std::uint_fast64_t max);
 
+// Index of a bucket picked at random, given the cumulative sums of the weights of the buckets
+std::size_t random_index(const std::vector<double>& cumulative_weights);
+
+// Number of failed Bernoulli trials, with probability of success p, before the first success
+// Return SIZE_MAX if there is no success, or if the number of failed trials does not fit in a std::size_t
+std::size_t random_geometric(double p);
+
 double uniform_min_max_integer_distribution(std::uint_fast64_t min, std::uint_fast64_t max, double x);
 
 double uniform_zero_one_continuous_distribution(double x);
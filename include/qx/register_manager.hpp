@@ -8,6 +8,7 @@
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>  // pair
 #include <vector>
 
 #include "libqasm/v3x/semantic_generated.hpp"
@@ -47,6 +48,9 @@ struct RegisterManagerError : public SimulationError {
     explicit RegisterManagerError(const std::string& message);
 };
 
+// The variables of a register, with their sizes, in register order
+using RegisterVariables = std::vector<std::pair<VariableName, std::size_t>>;
+
 using VariableNameToRangeMapT = std::unordered_map<VariableName, Range>;
 using IndexToVariableNameMapT = std::vector<VariableName>;
 using DirtyBitsetT = boost::dynamic_bitset<uint32_t>;
@@ -63,8 +67,10 @@ class Register {
 
 public:
     Register(const TreeOne<CqasmV3xProgram>& program, auto&& is_of_type, std::size_t max_register_size);
+    Register(const RegisterVariables& variables, std::size_t max_register_size);
     virtual ~Register() = 0;
     [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] RegisterVariables get_variables() const;
     [[nodiscard]] virtual Range at(const VariableName& name) const;
     [[nodiscard]] virtual Index at(const VariableName& name, const std::optional<Index>& sub_index) const;
     [[nodiscard]] virtual VariableName at(const Index& index) const;
@@ -80,6 +86,7 @@ public:
 class QubitRegister : public Register {
 public:
     explicit QubitRegister(const TreeOne<CqasmV3xProgram>& program);
+    explicit QubitRegister(const RegisterVariables& variables);
     ~QubitRegister() override;
 };
 
@@ -90,6 +97,7 @@ public:
 class BitRegister : public Register {
 public:
     explicit BitRegister(const TreeOne<CqasmV3xProgram>& program);
+    explicit BitRegister(const RegisterVariables& variables);
     ~BitRegister() override;
 };
 
@@ -112,6 +120,8 @@ public:
 
 public:
     static void create_instance(const TreeOne<CqasmV3xProgram>& program);
+    // Create the registers from their variables, e.g., those saved with a compiled circuit
+    static void create_instance(const RegisterVariables& qubit_variables, const RegisterVariables& bit_variables);
     [[nodiscard]] static RegisterManager& get_instance();
     [[nodiscard]] std::size_t get_qubit_register_size() const;
     [[nodiscard]] std::size_t get_bit_register_size() const;
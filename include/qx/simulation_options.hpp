@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <memory>  // shared_ptr
+#include <stop_token>
+#include <string>
+
+#include "qx/communicator.hpp"
+#include "qx/error_models.hpp"  // ErrorModel
+#include "qx/sparse_array.hpp"  // SparseArrayLayout
+
+namespace qx {
+
+// How the shots of a simulation are obtained
+//
+// shot_by_shot: the circuit is executed once per shot, sampling the outcome of every measurement.
+// branch_tree: the circuit is executed once per distinct sequence of measurement outcomes, or branch,
+//   each with the probability of its outcomes; the shots are then sampled from these branches.
+//   Circuits with more branches than shots, or than SimulationOptions::max_branches, are executed shot by shot.
+enum class ExecutionMode {
+    shot_by_shot,
+    branch_tree
+};
+
+// How the quantum state is represented
+//
+// state_vector: a pure state, on which every shot samples its own measurement outcomes and errors.
+// density_matrix: a mixed state, on which errors are applied exactly, as the average over all the errors
+//   that could have occurred. Measurements whose qubits are not used afterwards are deferred to the end
+//   of the circuit, and read from the diagonal of the final density matrix; the remaining ones split
+//   the simulation into branches, as in the branch_tree execution mode.
+//   The final state reports the probability of every basis vector, with real amplitudes.
+// matrix_product_state: a pure state stored as a matrix product state, whose memory grows with the entanglement
+//   of the state rather than with its number of qubits, so that wide circuits with little entanglement fit.
+//   Bonds larger than SimulationOptions::max_bond_dimension are truncated, which may lose accuracy;
+//   the result reports the truncation error. Circuits without mid-circuit measurements or resets are executed once,
+//   and all the shots are sampled from the final state. The final state is not reported.
+// distributed_state_vector: a dense pure state partitioned over the processes of SimulationOptions::communicator,
+//   for circuits whose state vector does not fit in the memory of a single process.
+//   Every process executes the same simulation, and gets the same result. As for matrix_product_state,
+//   circuits without mid-circuit measurements or resets are executed once, and the final state is not reported.
+// paged_state_vector: a dense pure state kept in a file, and paged in and out of memory, for circuits whose
+//   state vector fits on local storage but not in memory. Gates are applied by batches, in a single pass over
+//   the pages. As for matrix_product_state, circuits without mid-circuit measurements or resets are executed once,
+//   and the final state is not reported; the result reports the data paged in and out.
+// compressed_state_vector: same as paged_state_vector, with the pages kept compressed in memory instead of in a file,
+//   for circuits whose amplitudes compress well, e.g., with many equal or zero ones. The compression is lossless,
+//   or lossy within SimulationOptions::compression_tolerance; the result reports the peak memory of the compressed
+//   pages and a bound to the fidelity lost.
+// factorized_state_vector: a pure state stored as a tensor product of sparse state vectors, each over a group
+//   of qubits that interacted, which only merge when a gate acts on several of them, and are split again
+//   by measurements and resets. Its memory grows with the largest group of entangled qubits rather than with
+//   the number of qubits, e.g., for circuits made of independent experiments on disjoint qubits.
+//   As for matrix_product_state, circuits without mid-circuit measurements or resets are executed once,
+//   and the final state is not reported.
+enum class Backend {
+    state_vector,
+    density_matrix,
+    matrix_product_state,
+    distributed_state_vector,
+    paged_state_vector,
+    compressed_state_vector,
+    factorized_state_vector
+};
+
+// Run-time options of a simulation
+//
+// Apart from the error model, they select how a simulation is carried out, not what is simulated,
+// so they do not change its results, other than by floating-point rounding and sampling.
+struct SimulationOptions {
+    // How the quantum state stores its non-zero amplitudes
+    core::SparseArrayLayout sparse_array_layout = core::SparseArrayLayout::hash_map;
+    ExecutionMode execution_mode = ExecutionMode::shot_by_shot;
+    std::size_t max_branches = 4096;
+    Backend backend = Backend::state_vector;
+    // Only used by the matrix_product_state backend
+    std::size_t max_bond_dimension = 64;
+    // Only used by the matrix_product_state backend: largest weight discarded when truncating a bond
+    double truncation_threshold = 1e-12;
+    // Only used by the distributed_state_vector backend: the processes sharing the state, or a single one if null
+    std::shared_ptr<core::Communicator> communicator = nullptr;
+    // Only used by the paged_state_vector and compressed_state_vector backends: a page holds the amplitudes of
+    // that many qubits, 256 MiB for 24
+    std::size_t number_of_page_qubits = 24;
+    // Only used by the paged_state_vector backend: where the page file is created, or the temporary directory if empty
+    std::string page_directory = {};
+    // Only used by the compressed_state_vector backend: largest error of the real or imaginary part of an amplitude
+    // every time it is compressed, or 0 for a lossless compression
+    double compression_tolerance = 0.;
+    // Only used by the compressed_state_vector backend: threads compressing blocks of a page at once,
+    // or 0 for as many as the hardware can run concurrently
+    std::size_t number_of_compression_threads = 0;
+    // Only used by the state_vector backend, when the circuit is executed shot by shot: a file where the progress
+    // of the simulation is saved every checkpoint_interval instructions, and from which it is resumed if it exists
+    // Checkpoints are taken at fixed instructions, so a resumed simulation gives the same result, bit for bit,
+    // as one that was not interrupted. The file is removed when the simulation completes
+    std::string checkpoint_file = {};
+    std::size_t checkpoint_interval = 1'000;
+    // Only used with a checkpoint_file: once a stop is requested, the simulation stops after the next checkpoint,
+    // and returns a SimulationError
+    std::stop_token stop_token = {};
+    // Cancel and merge gates of the circuit before simulating it, see optimize_instructions
+    // Ignored with an error model, since removing instructions would also remove the errors added to them
+    bool optimize_circuit = false;
+    // Only report the measurements, not the final state, so that the circuit can be pruned before simulating it,
+    // see prune_instructions
+    // The circuit is not pruned with an error model, since errors outside the light cone of the measurements
+    // would be removed, but the state is not reported either
+    bool measurements_only = false;
+    // Errors added to every instruction
+    error_models::ErrorModel error_model = std::monostate{};
+};
+
+}  // namespace qx
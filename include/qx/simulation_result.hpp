@@ -3,15 +3,28 @@
 #include <fmt/ostream.h>
 
 #include <cstdint>  // uint64_t
+#include <istream>
 #include <map>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <utility>  // move
+#include <variant>
 #include <vector>
 
+#include "qx/circuit_optimizer.hpp"
+#include "qx/circuit_pruner.hpp"
 #include "qx/compile_time_configuration.hpp"
+#include "qx/compressed_page_store.hpp"
 #include "qx/core.hpp"
+#include "qx/density_matrix.hpp"
+#include "qx/distributed_state_vector.hpp"
+#include "qx/factorized_state_vector.hpp"
+#include "qx/matrix_product_state.hpp"
+#include "qx/paged_state_vector.hpp"
 #include "qx/quantum_state.hpp"
 #include "qx/register_manager.hpp"
+#include "qx/simulation_options.hpp"
 
 namespace qx {
 
@@ -82,6 +95,18 @@ public:
     State state;
     Measurements measurements;
     Measurements bit_measurements;
+    // Only set by the matrix_product_state backend: the largest truncation error of all the executions,
+    // an upper bound to the infidelity of their final states
+    std::optional<double> truncation_error;
+    // Only set by the paged_state_vector backend: the data paged in and out by all the executions
+    std::optional<core::PagingStatistics> paging_statistics;
+    // Only set by the compressed_state_vector backend: the largest memory taken by the compressed pages,
+    // and the largest error, of all the executions
+    std::optional<core::CompressionStatistics> compression_statistics;
+    // Only set when the circuit is optimized: the gates removed from it
+    std::optional<CircuitOptimization> circuit_optimization;
+    // Only set when the circuit is pruned: the instructions removed from it and the qubits simulated
+    std::optional<CircuitPruning> circuit_pruning;
 };
 
 std::ostream& operator<<(std::ostream& os, const Measurement& measurement);
@@ -97,27 +122,123 @@ struct SimulationIterationContext {
     core::MeasurementRegister measurement_register;
     core::BitMeasurementRegister bit_measurement_register;
 
-    explicit SimulationIterationContext();
+    explicit SimulationIterationContext(const SimulationOptions& options = {});
+    // A state of number_of_qubits qubits, e.g., for a pruned circuit, and a measurement register of the same size
+    SimulationIterationContext(std::size_t number_of_qubits, const SimulationOptions& options);
 };
 
+//------------------//
+// SimulationBranch //
+//------------------//
+
+// The context at the end of an iteration for a given sequence of measurement outcomes,
+// and the probability of that sequence
+struct SimulationBranch {
+    double probability = 1.;
+    SimulationIterationContext context;
+};
+
+using SimulationBranches = std::vector<SimulationBranch>;
+
+//---------------------//
+// DensityMatrixBranch //
+//---------------------//
+
+// Same as a SimulationBranch, for the density_matrix backend
+struct DensityMatrixBranch {
+    double probability = 1.;
+    core::DensityMatrix density_matrix;
+    core::MeasurementRegister measurement_register;
+    core::BitMeasurementRegister bit_measurement_register;
+
+    explicit DensityMatrixBranch(std::size_t number_of_qubits, std::size_t number_of_bits);
+};
+
+using DensityMatrixBranches = std::vector<DensityMatrixBranch>;
+
+//----------------//
+// BackendContext //
+//----------------//
+
+// Same as a SimulationIterationContext, for the backends that sample the outcomes of measurements and resets
+template <typename State>
+struct BackendContext {
+    State state;
+    core::MeasurementRegister measurement_register;
+    core::BitMeasurementRegister bit_measurement_register;
+    // Whether a measurement or a reset has sampled an outcome, so that the execution only stands for one shot
+    bool has_sampled_outcomes = false;
+
+    BackendContext(State initial_state, std::size_t number_of_bits)
+    : state{ std::move(initial_state) }
+    , measurement_register{ this->state.get_number_of_qubits() }
+    , bit_measurement_register{ number_of_bits } {}
+};
+
+using MatrixProductStateContext = BackendContext<core::MatrixProductState>;
+using DistributedStateVectorContext = BackendContext<core::DistributedStateVector>;
+// Also for the compressed_state_vector backend
+using PagedStateVectorContext = BackendContext<core::PagedStateVector>;
+using FactorizedStateVectorContext = BackendContext<core::FactorizedStateVector>;
+
+// The context of an execution with any of the backends above
+using BackendContextPtr = std::variant<MatrixProductStateContext*,
+    DistributedStateVectorContext*,
+    PagedStateVectorContext*,
+    FactorizedStateVectorContext*>;
+
 //--------------------------------//
 // SimulationIterationAccumulator //
 //--------------------------------//
 
 class SimulationIterationAccumulator {
 public:
-    void add(const SimulationIterationContext& context);
-    void append_measurement(const core::MeasurementRegister& measurement);
-    void append_bit_measurement(const core::BitMeasurementRegister& bit_measurement);
+    // Account for a number of shots that ended in the same context
+    void add(const SimulationIterationContext& context, count_t shots = 1);
+    // Same for the density_matrix backend, where the final state is given by the diagonal of the density matrix
+    void add(const core::DensityMatrix& density_matrix, const core::MeasurementRegister& measurement_register,
+        const core::BitMeasurementRegister& bit_measurement_register, count_t shots);
+    // Same for the backends whose final state is not kept,
+    // e.g., matrix_product_state, distributed_state_vector, paged_state_vector, or factorized_state_vector
+    template <typename State>
+    void add(const State& final_state, const core::MeasurementRegister& measurement_register,
+        const core::BitMeasurementRegister& bit_measurement_register, count_t shots) {
+        number_of_qubits = final_state.get_number_of_qubits();
+        state.reset();
+        probabilities.reset();
+        append_measurement(measurement_register, shots);
+        append_bit_measurement(bit_measurement_register, shots);
+        shots_done += shots;
+    }
+    // Account for the truncation error of one execution of the matrix_product_state backend
+    void add_truncation_error(double error);
+    // Account for the data paged in and out by one execution
+    void add_paging_statistics(const core::PagingStatistics& statistics);
+    // Account for the memory taken, and the error introduced, by the compression of one execution
+    void add_compression_statistics(const core::CompressionStatistics& statistics);
+    void append_measurement(const core::MeasurementRegister& measurement, count_t shots = 1);
+    void append_bit_measurement(const core::BitMeasurementRegister& bit_measurement, count_t shots = 1);
     SimulationResult get_simulation_result(std::size_t shots_requested);
+    [[nodiscard]] std::uint64_t get_shots_done() const;
+    // Write the measurements of the shots done so far in a binary format, but not the final state
+    void write_shots(std::ostream& os) const;
+    // Replace the shots done so far with the ones written by write_shots
+    // Throw a SimulationError if the data is not valid
+    void read_shots(std::istream& is);
 
 private:
     template <typename F>
     void for_all_non_zero_states(F&& f) {
-        state.for_each([&f](const auto& kv) { f(kv.first, kv.second); });
+        state->for_each([&f](const auto& kv) { f(kv.first, kv.second); });
     }
 
-    core::QuantumState state;
+    std::size_t number_of_qubits = 0;
+    std::optional<core::QuantumState> state;
+    // Probabilities of the basis vectors, which replace the state for the density_matrix backend
+    std::optional<std::vector<double>> probabilities;
+    std::optional<double> truncation_error;
+    std::optional<core::PagingStatistics> paging_statistics;
+    std::optional<core::CompressionStatistics> compression_statistics;
     std::map<state_string_t, count_t> measurements;
     std::map<state_string_t, count_t> bit_measurements;
 
@@ -5,16 +5,33 @@
 #include <variant>  // monostate
 
 #include "qx/simulation_error.hpp"
+#include "qx/simulation_options.hpp"
 #include "qx/simulation_result.hpp"
 
 namespace qx {
 
 std::variant<std::monostate, SimulationResult, SimulationError> execute_string(const std::string& s,
     std::size_t iterations = 1, std::optional<std::uint_fast64_t> seed = std::nullopt,
-    std::string cqasm_version = "3.0");
+    std::string cqasm_version = "3.0", const SimulationOptions& options = {});
 
 std::variant<std::monostate, SimulationResult, SimulationError> execute_file(const std::string& file_path,
     std::size_t iterations = 1, std::optional<std::uint_fast64_t> seed = std::nullopt,
-    std::string cqasm_version = "3.0");
+    std::string cqasm_version = "3.0", const SimulationOptions& options = {});
+
+// Build the circuit of a cQASM program, and save it as a compiled circuit to output_file_path,
+// so that execute_compiled_file can simulate it later without the cQASM front-end
+std::optional<SimulationError> compile_string(
+    const std::string& s, const std::string& output_file_path, std::string cqasm_version = "3.0");
+
+std::optional<SimulationError> compile_file(
+    const std::string& file_path, const std::string& output_file_path, std::string cqasm_version = "3.0");
+
+// Whether a file is a compiled circuit, as saved by compile_string or compile_file
+bool is_compiled_circuit_file(const std::string& file_path);
+
+// Simulate a compiled circuit saved by compile_string or compile_file
+std::variant<std::monostate, SimulationResult, SimulationError> execute_compiled_file(
+    const std::string& compiled_file_path, std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt, const SimulationOptions& options = {});
 
 }  // namespace qx
@@ -3,17 +3,18 @@
 #include <fmt/ostream.h>
 
 #include <algorithm>  // erase_if, for_each, sort
+#include <cassert>
 #include <complex>
 #include <cstdint>  // size_t, uint64_t
 #include <numeric>  // accumulate
 #include <ostream>
 #include <stdexcept>  // runtime_error
-#include <unordered_map>
 #include <utility>  // pair
 #include <vector>
 
 #include "qx/compile_time_configuration.hpp"  // ZERO_CYCLE_SIZE
 #include "qx/core.hpp"  // BasisVector, Complex, PairBasisVectorStringComplex, QubitIndex
+#include "qx/flat_hash_map.hpp"
 
 namespace qx::core {
 
@@ -29,87 +30,204 @@ struct SparseComplex {
     SparseComplex() = default;
     explicit SparseComplex(std::complex<double> c);
 };
-using SparseElement = std::pair<BasisVector, SparseComplex>;
-bool compare_sparse_elements(const SparseElement& lhs, const SparseElement& rhs);
+template <typename BasisVectorT>
+using BasicSparseElement = std::pair<BasisVectorT, SparseComplex>;
+using SparseElement = BasicSparseElement<BasisVector>;
+
+template <typename BasisVectorT>
+bool compare_sparse_elements(
+    const BasicSparseElement<BasisVectorT>& lhs, const BasicSparseElement<BasisVectorT>& rhs) {
+    return lhs.first < rhs.first;
+}
+
+// How a SparseArray stores its non-zero elements
+//
+// hash_map: in a hash map from basis vector to value.
+//   Gates are applied by scattering the contribution of every element into a new map.
+// sorted_vector: in a vector of elements sorted by basis vector.
+//   Gates are applied by merging the runs of elements that only differ in the bits of the operands, without hashing,
+//   and traversing the elements in order does not need to sort them.
+enum class SparseArrayLayout {
+    hash_map,
+    sorted_vector
+};
 
-class SparseArray {
+// Sparse array indexed by basis vectors of type BasisVectorT
+//
+// s is the size of the array, i.e., 2^(number of bits of its basis vectors), or SIZE_MAX if that does not fit.
+template <typename BasisVectorT>
+class BasicSparseArray {
 public:
-    using MapBasisVectorToSparseComplex = std::unordered_map<BasisVector, SparseComplex>;
+    using BasisVectorType = BasisVectorT;
+    using SparseElement = BasicSparseElement<BasisVectorT>;
+    using MapBasisVectorToSparseComplex = FlatHashMap<BasisVectorT, SparseComplex, BasisVectorHash>;
     using VectorOfSparseElements = std::vector<SparseElement>;
-    using Iterator = MapBasisVectorToSparseComplex::iterator;
-    using ConstIterator = MapBasisVectorToSparseComplex::const_iterator;
 
 public:
-    SparseArray() = delete;
-    explicit SparseArray(std::size_t s);
-    SparseArray(std::size_t s, std::initializer_list<PairBasisVectorStringComplex> values);
+    BasicSparseArray() = delete;
+    explicit BasicSparseArray(std::size_t s, SparseArrayLayout layout = SparseArrayLayout::hash_map);
+    BasicSparseArray(std::size_t s, std::initializer_list<PairBasisVectorStringComplex> values,
+        SparseArrayLayout layout = SparseArrayLayout::hash_map);
+
+    // The scratch storage used by apply_linear and apply_sorted is not part of the value of a SparseArray
+    BasicSparseArray(const BasicSparseArray& other);
+    BasicSparseArray(BasicSparseArray&& other) noexcept = default;
+    BasicSparseArray& operator=(const BasicSparseArray& other);
+    BasicSparseArray& operator=(BasicSparseArray&& other) noexcept = default;
+    ~BasicSparseArray() = default;
 
-    [[nodiscard]] ConstIterator begin() const;
-    [[nodiscard]] ConstIterator end() const;
-    [[nodiscard]] Iterator begin();
-    [[nodiscard]] Iterator end();
+    [[nodiscard]] SparseArrayLayout get_layout() const;
 
-    SparseArray& operator*=(double d);
-    SparseComplex& operator[](const BasisVector& index);
+    BasicSparseArray& operator*=(double d);
+    SparseComplex& operator[](const BasisVectorT& index);
 
     void clear();
     [[nodiscard]] std::size_t size() const;
+    // Approximate number of bytes taken by the elements, including the free slots of the storage
+    [[nodiscard]] std::size_t get_memory_size() const;
     [[nodiscard]] double norm();
     [[nodiscard]] std::vector<std::complex<double>> to_vector() const;
 
     template <typename T, typename F>
     T accumulate(T init, F&& f) {
         clean_up_zeros();
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            return std::accumulate(sorted_data_.begin(), sorted_data_.end(), init, f);
+        }
         return std::accumulate(data_.begin(), data_.end(), init, f);
     }
 
     template <typename F>
     void for_each(F&& f) {
         clean_up_zeros();
-        std::for_each(data_.begin(), data_.end(), f);
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            std::for_each(sorted_data_.begin(), sorted_data_.end(), f);
+        } else {
+            std::for_each(data_.begin(), data_.end(), f);
+        }
     }
 
     template <typename F>
     void for_each_sorted(F&& f) {
         clean_up_zeros();
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            std::for_each(sorted_data_.begin(), sorted_data_.end(), f);
+            return;
+        }
         VectorOfSparseElements sorted(data_.begin(), data_.end());
-        std::sort(sorted.begin(), sorted.end(), compare_sparse_elements);
+        std::sort(sorted.begin(), sorted.end(), compare_sparse_elements<BasisVectorT>);
         std::for_each(sorted.begin(), sorted.end(), f);
     }
 
+    // Multiply every element by d, and call f with every scaled element
+    // Zeros are not cleaned up, so f may be called with null elements
+    template <typename F>
+    void scale(double d, F&& f) {
+        auto scale_element = [d, &f](auto& kv) {
+            kv.second.value *= d;
+            f(static_cast<const SparseElement&>(kv));
+        };
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            std::for_each(sorted_data_.begin(), sorted_data_.end(), scale_element);
+        } else {
+            std::for_each(data_.begin(), data_.end(), scale_element);
+        }
+    }
+
+    // Let f(basis vector, value) update the value of every element in place, e.g., to apply diagonal gates,
+    // which leave all the basis vectors where they are
+    template <typename F>
+    void transform_values(F&& f) {
+        auto transform_element = [&f](auto& kv) { f(static_cast<const BasisVectorT&>(kv.first), kv.second.value); };
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            std::for_each(sorted_data_.begin(), sorted_data_.end(), transform_element);
+        } else {
+            std::for_each(data_.begin(), data_.end(), transform_element);
+        }
+    }
+
     template <typename F>
     void erase_if(F&& pred) {
-        std::erase_if(data_, pred);
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            std::erase_if(sorted_data_, pred);
+        } else {
+            data_.erase_if(pred);
+        }
+    }
+
+    // Replace the basis vector of every element with f(basis vector), where f is one-to-one,
+    // e.g., a permutation of the bits
+    template <typename F>
+    void transform_basis_vectors(F&& f) {
+        if (layout_ == SparseArrayLayout::sorted_vector) {
+            for (auto& element : sorted_data_) {
+                element.first = f(element.first);
+            }
+            std::sort(sorted_data_.begin(), sorted_data_.end(), compare_sparse_elements<BasisVectorT>);
+            return;
+        }
+        result_.clear();
+        result_.reserve(data_.size());
+        for (const auto& [basis_vector, complex_value] : data_) {
+            result_[f(basis_vector)] = complex_value;
+        }
+        data_.swap(result_);
     }
 
     // Let f build a new SparseArray to replace *this, assuming f is linear.
+    // Only for the hash_map layout.
     template <typename F>
     void apply_linear(F&& f) {
-        // Every ZERO_CYCLE_SIZE gates, cleanup the 0s
-        if (zero_counter_ >= config::ZERO_CYCLE_SIZE) {
-            clean_up_zeros();
-        }
-        ++zero_counter_;
-        MapBasisVectorToSparseComplex result;
+        assert(layout_ == SparseArrayLayout::hash_map);
+        count_gate();
+        // The result is built in the slots of the previous result, so that no allocation is needed per gate
+        result_.clear();
+        result_.reserve(data_.size());
         for (const auto& [basis_vector, complex_value] : data_) {
-            f(basis_vector, complex_value, result);
+            f(basis_vector, complex_value, result_);
         }
-        data_.swap(result);
+        data_.swap(result_);
+    }
+
+    // Let f replace the elements, given as a vector sorted by basis vector, with a new vector sorted by basis vector.
+    // f is also given an empty vector it can use as scratch storage, e.g., to build the new elements and swap them in.
+    // Only for the sorted_vector layout.
+    template <typename F>
+    void apply_sorted(F&& f) {
+        assert(layout_ == SparseArrayLayout::sorted_vector);
+        count_gate();
+        sorted_result_.clear();
+        f(sorted_data_, sorted_result_);
     }
 
 private:
+    // Every ZERO_CYCLE_SIZE gates, cleanup the 0s
+    void count_gate();
     void clean_up_zeros();
 
     std::size_t size_ = 0;
+    SparseArrayLayout layout_ = SparseArrayLayout::hash_map;
     std::uint64_t zero_counter_ = 0;
     MapBasisVectorToSparseComplex data_;
+    MapBasisVectorToSparseComplex result_;
+    VectorOfSparseElements sorted_data_;
+    VectorOfSparseElements sorted_result_;
 };
 
-std::ostream& operator<<(std::ostream& os, const SparseArray& array);
+// Instantiated in sparse_array.cpp for all the basis vector widths
+extern template class BasicSparseArray<BasisVector>;
+extern template class BasicSparseArray<BasisVector128>;
+extern template class BasicSparseArray<BasisVector256>;
+extern template class BasicSparseArray<BasisVector1024>;
+
+using SparseArray = BasicSparseArray<BasisVector>;
+
+template <typename BasisVectorT>
+std::ostream& operator<<(std::ostream& os, const BasicSparseArray<BasisVectorT>& array);
 
 }  // namespace qx::core
 
 template <>
 struct fmt::formatter<std::complex<double>> : fmt::ostream_formatter {};
-template <>
-struct fmt::formatter<qx::core::SparseArray> : fmt::ostream_formatter {};
+template <typename BasisVectorT>
+struct fmt::formatter<qx::core::BasicSparseArray<BasisVectorT>> : fmt::ostream_formatter {};
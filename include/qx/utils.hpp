@@ -3,7 +3,11 @@
 #include <array>
 #include <cassert>
 #include <climits>
+#include <cstdint>  // uint64_t
+#include <istream>
+#include <ostream>
 #include <string>
+#include <type_traits>  // is_trivially_copyable_v
 
 namespace qx::utils {
 
@@ -11,4 +15,39 @@ static inline bool get_bit(std::size_t x, std::size_t index) {
     return (x >> index) & 1;
 }
 
+// Write a trivially copyable value as its bytes, in native byte order
+template <typename T>
+void write_binary(std::ostream& os, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Read a value written by write_binary
+// Check the stream afterwards: the value is unspecified if the read failed
+template <typename T>
+[[nodiscard]] T read_binary(std::istream& is) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto ret = T{};
+    is.read(reinterpret_cast<char*>(&ret), sizeof(T));
+    return ret;
+}
+
+// Write a string as its size followed by its characters
+inline void write_binary_string(std::ostream& os, const std::string& s) {
+    write_binary(os, static_cast<std::uint64_t>(s.size()));
+    os.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// Read a string written by write_binary_string, of at most max_size characters
+[[nodiscard]] inline std::string read_binary_string(std::istream& is, std::size_t max_size = SIZE_MAX) {
+    auto size = read_binary<std::uint64_t>(is);
+    if (!is || size > max_size) {
+        is.setstate(std::ios::failbit);
+        return {};
+    }
+    auto ret = std::string(static_cast<std::size_t>(size), '\0');
+    is.read(ret.data(), static_cast<std::streamsize>(size));
+    return ret;
+}
+
 }  // namespace qx::utils
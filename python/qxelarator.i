@@ -59,6 +59,28 @@
     }
 }
 
+// Map the output of compile_string/compile_file to None, or to a SimulationError.
+%typemap(out) std::optional<qx::SimulationError> {
+    if ($1.has_value()) {
+        auto pmod = PyImport_ImportModule("qxelarator");
+        auto pclass = PyObject_GetAttrString(pmod, "SimulationError");
+        Py_DECREF(pmod);
+
+        auto error_string = PyUnicode_FromString($1->what());
+        auto args = PyTuple_Pack(1, error_string);
+
+        auto simulation_error = PyObject_CallObject(pclass, args);
+        Py_DECREF(args);
+        Py_DECREF(pclass);
+        Py_DECREF(error_string);
+
+        $result = simulation_error;
+    } else {
+        Py_INCREF(Py_None);
+        $result = Py_None;
+    }
+}
+
 %{
 #include "qx/qxelarator.hpp"
 %}
@@ -3,8 +3,18 @@
 #include <fmt/core.h>
 #include <fmt/ostream.h>
 
+#include <optional>
+#include <string>
+
 #include "qx/version.hpp"
 
+#ifdef QX_MPI
+#include <memory>  // make_shared
+#include <utility>  // move
+
+#include "qx/mpi_communicator.hpp"
+#endif
+
 static constexpr const char* banner = R"(
 ===============================================================================================
       _______     _    __
@@ -24,14 +34,60 @@ void print_banner() {
 int main(int argc, char** argv) {
     std::string file_path;
     size_t iterations = 1;
-    print_banner();
+    bool use_mpi = false;
+    std::optional<std::string> page_directory;
+    std::optional<double> compression_tolerance;
+    bool use_factorized = false;
+    std::optional<std::string> checkpoint_file;
+    std::optional<size_t> checkpoint_interval;
+    bool optimize_circuit = false;
+    bool measurements_only = false;
+    std::optional<std::string> compiled_file;
 
     int arg_index = 1;
     bool arg_parsing_failed = false;
     while (arg_index < argc) {
         auto current_arg = argv[arg_index];
 
-        if (std::string(current_arg) == "-c") {
+        if (std::string(current_arg) == "--mpi") {
+            use_mpi = true;
+        } else if (std::string(current_arg) == "--paged") {
+            if (arg_index + 1 >= argc) {
+                arg_parsing_failed = true;
+            } else {
+                page_directory = std::string(argv[++arg_index]);
+            }
+        } else if (std::string(current_arg) == "--compressed") {
+            if (arg_index + 1 >= argc) {
+                arg_parsing_failed = true;
+            } else {
+                compression_tolerance = atof(argv[++arg_index]);
+            }
+        } else if (std::string(current_arg) == "--factorized") {
+            use_factorized = true;
+        } else if (std::string(current_arg) == "--checkpoint") {
+            if (arg_index + 1 >= argc) {
+                arg_parsing_failed = true;
+            } else {
+                checkpoint_file = std::string(argv[++arg_index]);
+            }
+        } else if (std::string(current_arg) == "--checkpoint-interval") {
+            if (arg_index + 1 >= argc) {
+                arg_parsing_failed = true;
+            } else {
+                checkpoint_interval = atoi(argv[++arg_index]);
+            }
+        } else if (std::string(current_arg) == "--optimize") {
+            optimize_circuit = true;
+        } else if (std::string(current_arg) == "--measurements-only") {
+            measurements_only = true;
+        } else if (std::string(current_arg) == "--compile") {
+            if (arg_index + 1 >= argc) {
+                arg_parsing_failed = true;
+            } else {
+                compiled_file = std::string(argv[++arg_index]);
+            }
+        } else if (std::string(current_arg) == "-c") {
             if (arg_index + 1 >= argc) {
                 arg_parsing_failed = true;
             } else {
@@ -52,18 +108,86 @@ int main(int argc, char** argv) {
         ++arg_index;
     }
 
+#ifndef QX_MPI
+    arg_parsing_failed = arg_parsing_failed || use_mpi;
+#endif
+    auto number_of_backends = static_cast<int>(use_mpi) + static_cast<int>(page_directory.has_value()) +
+        static_cast<int>(compression_tolerance.has_value()) + static_cast<int>(use_factorized);
+    arg_parsing_failed = arg_parsing_failed || number_of_backends > 1 || (checkpoint_interval && !checkpoint_file);
     if (file_path.empty() || arg_parsing_failed) {
-        fmt::print(std::cerr, "Usage: {} [-c iterations] file.cq\n", argv[0]);
+        print_banner();
+        fmt::print(std::cerr,
+            "Usage: {} [--mpi | --paged directory | --compressed tolerance | --factorized] "
+            "[--checkpoint file [--checkpoint-interval instructions]] [--optimize] [--measurements-only] "
+            "[-c iterations] file.cq\n"
+            "       {} --compile compiled_file file.cq\n",
+            argv[0],
+            argv[0]);
         return -1;
     }
-    fmt::print("Executing {} time{} the file '{}'...\n\n", iterations, (iterations > 1 ? "s" : ""), file_path);
 
-    auto simulation_result = qx::execute_file(file_path, iterations);
+    // With --mpi, every process runs the same simulation on its part of the state, and only rank 0 prints
+    // With --paged, the state is kept in a page file in the given directory
+    // With --compressed, the state is kept compressed in memory, losslessly if the tolerance is 0
+    // With --factorized, the state is kept as a product of the states of the groups of qubits that interacted
+    // With --checkpoint, the progress is saved to the given file, and running the same command again resumes from it
+    // With --optimize, gates that cancel out are removed, and gates on the same qubits merged, before the simulation
+    // With --measurements-only, the state is not printed, and the instructions that can not change any measurement
+    // are removed before the simulation
+    // With --compile, the circuit is built and saved to the compiled file, which can then be given instead of file.cq
+    // to skip parsing the cQASM program; nothing is simulated
+    if (compiled_file) {
+        if (auto error = qx::compile_file(file_path, *compiled_file)) {
+            fmt::print(std::cerr, "{}\n", error->what());
+            return 1;
+        }
+        return 0;
+    }
+
+    auto options = qx::SimulationOptions{};
+    options.optimize_circuit = optimize_circuit;
+    options.measurements_only = measurements_only;
+    if (checkpoint_file) {
+        options.checkpoint_file = *checkpoint_file;
+        options.checkpoint_interval = checkpoint_interval.value_or(options.checkpoint_interval);
+    }
+    if (page_directory) {
+        options.backend = qx::Backend::paged_state_vector;
+        options.page_directory = *page_directory;
+    }
+    if (compression_tolerance) {
+        options.backend = qx::Backend::compressed_state_vector;
+        options.compression_tolerance = *compression_tolerance;
+    }
+    if (use_factorized) {
+        options.backend = qx::Backend::factorized_state_vector;
+    }
+    bool is_printing = true;
+#ifdef QX_MPI
+    if (use_mpi) {
+        auto communicator = std::make_shared<qx::core::MpiCommunicator>(&argc, &argv);
+        is_printing = communicator->get_rank() == 0;
+        options.backend = qx::Backend::distributed_state_vector;
+        options.communicator = std::move(communicator);
+    }
+#endif
+    if (is_printing) {
+        print_banner();
+        fmt::print("Executing {} time{} the file '{}'...\n\n", iterations, (iterations > 1 ? "s" : ""), file_path);
+    }
+
+    auto simulation_result = qx::is_compiled_circuit_file(file_path)
+        ? qx::execute_compiled_file(file_path, iterations, std::nullopt, options)
+        : qx::execute_file(file_path, iterations, std::nullopt, "3.0", options);
     if (auto* error = std::get_if<qx::SimulationError>(&simulation_result)) {
-        fmt::print(std::cerr, "{}\n", error->what());
+        if (is_printing) {
+            fmt::print(std::cerr, "{}\n", error->what());
+        }
         return 1;
     }
 
-    fmt::print("{}\n\n", std::get<qx::SimulationResult>(simulation_result));
+    if (is_printing) {
+        fmt::print("{}\n\n", std::get<qx::SimulationResult>(simulation_result));
+    }
     return 0;
 }
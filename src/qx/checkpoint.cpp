@@ -0,0 +1,132 @@
+#include "qx/checkpoint.hpp"
+
+#include <fmt/core.h>
+
+#include <boost/dynamic_bitset.hpp>
+#include <cstdint>  // uint32_t, uint64_t
+#include <fstream>
+#include <iterator>  // back_inserter
+#include <system_error>  // error_code
+#include <utility>  // move
+#include <vector>
+
+#include "qx/compile_time_configuration.hpp"  // MAX_BIT_NUMBER, MAX_QUBIT_NUMBER
+#include "qx/core.hpp"  // MeasurementRegister
+#include "qx/quantum_state.hpp"
+#include "qx/simulation_error.hpp"
+#include "qx/utils.hpp"  // read_binary, write_binary
+
+namespace qx {
+
+namespace {
+
+// "QXCKPT" followed by two zero bytes, in little-endian byte order
+static constexpr std::uint64_t CHECKPOINT_MAGIC_NUMBER = 0x0000'5450'4B43'5851;
+// Version 2 stores the qubit positions of the state
+static constexpr std::uint32_t CHECKPOINT_FORMAT_VERSION = 2;
+
+void write_register(std::ostream& os, const core::MeasurementRegister& measurement_register) {
+    utils::write_binary(os, static_cast<std::uint64_t>(measurement_register.size()));
+    auto blocks = std::vector<core::MeasurementRegister::block_type>{};
+    boost::to_block_range(measurement_register, std::back_inserter(blocks));
+    for (auto block : blocks) {
+        utils::write_binary(os, block);
+    }
+}
+
+[[nodiscard]] core::MeasurementRegister read_register(std::istream& is) {
+    auto size = utils::read_binary<std::uint64_t>(is);
+    if (!is || size > config::MAX_QUBIT_NUMBER + config::MAX_BIT_NUMBER) {
+        throw SimulationError{ "invalid checkpoint: invalid register size" };
+    }
+    auto ret = core::MeasurementRegister{ static_cast<std::size_t>(size) };
+    auto blocks = std::vector<core::MeasurementRegister::block_type>(ret.num_blocks());
+    for (auto& block : blocks) {
+        block = utils::read_binary<core::MeasurementRegister::block_type>(is);
+    }
+    boost::from_block_range(blocks.begin(), blocks.end(), ret);
+    return ret;
+}
+
+}  // namespace
+
+void Checkpoint::write(std::ostream& os) {
+    utils::write_binary(os, CHECKPOINT_MAGIC_NUMBER);
+    utils::write_binary(os, CHECKPOINT_FORMAT_VERSION);
+    utils::write_binary(os, iterations);
+    utils::write_binary(os, number_of_instructions);
+    utils::write_binary_string(os, random_state);
+    accumulator.write_shots(os);
+    utils::write_binary(os, static_cast<std::uint8_t>(cursor.has_value()));
+    if (cursor) {
+        utils::write_binary(os, static_cast<std::uint64_t>(cursor->next_instruction));
+        utils::write_binary(os, static_cast<std::uint64_t>(cursor->next_error));
+        write_register(os, cursor->context.measurement_register);
+        write_register(os, cursor->context.bit_measurement_register);
+        cursor->context.state.write(os);
+    }
+}
+
+/* static */ [[nodiscard]] Checkpoint Checkpoint::read(std::istream& is) {
+    if (utils::read_binary<std::uint64_t>(is) != CHECKPOINT_MAGIC_NUMBER || !is) {
+        throw SimulationError{ "invalid checkpoint: not a checkpoint" };
+    }
+    if (auto version = utils::read_binary<std::uint32_t>(is); version != CHECKPOINT_FORMAT_VERSION || !is) {
+        throw SimulationError{ fmt::format("invalid checkpoint: unsupported format version {}", version) };
+    }
+    auto ret = Checkpoint{};
+    ret.iterations = utils::read_binary<std::uint64_t>(is);
+    ret.number_of_instructions = utils::read_binary<std::uint64_t>(is);
+    // The text representation of a std::mt19937_64 takes about 6 KiB
+    ret.random_state = utils::read_binary_string(is, 1 << 16);
+    ret.accumulator.read_shots(is);
+    if (auto has_cursor = utils::read_binary<std::uint8_t>(is); has_cursor && is) {
+        auto next_instruction = utils::read_binary<std::uint64_t>(is);
+        auto next_error = utils::read_binary<std::uint64_t>(is);
+        auto measurement_register = read_register(is);
+        auto bit_measurement_register = read_register(is);
+        try {
+            auto context = SimulationIterationContext{};
+            context.state = core::QuantumState::read(is);
+            context.measurement_register = std::move(measurement_register);
+            context.bit_measurement_register = std::move(bit_measurement_register);
+            ret.cursor = ExecutionCursor{ std::move(context),
+                static_cast<std::size_t>(next_instruction),
+                static_cast<std::size_t>(next_error) };
+        } catch (const core::QuantumStateError& err) {
+            throw SimulationError{ fmt::format("invalid checkpoint: {}", err.what()) };
+        }
+    }
+    if (!is) {
+        throw SimulationError{ "invalid checkpoint: truncated data" };
+    }
+    return ret;
+}
+
+void Checkpoint::save(const std::filesystem::path& path) {
+    auto temporary_path = std::filesystem::path{ path }.concat(".tmp");
+    {
+        auto file = std::ofstream{ temporary_path, std::ios::binary | std::ios::trunc };
+        write(file);
+        file.close();
+        if (!file) {
+            throw SimulationError{ fmt::format("could not write checkpoint file: {}", temporary_path.string()) };
+        }
+    }
+    auto error_code = std::error_code{};
+    std::filesystem::rename(temporary_path, path, error_code);
+    if (error_code) {
+        throw SimulationError{ fmt::format(
+            "could not write checkpoint file: {}: {}", path.string(), error_code.message()) };
+    }
+}
+
+/* static */ [[nodiscard]] Checkpoint Checkpoint::load(const std::filesystem::path& path) {
+    auto file = std::ifstream{ path, std::ios::binary };
+    if (!file) {
+        throw SimulationError{ fmt::format("could not read checkpoint file: {}", path.string()) };
+    }
+    return read(file);
+}
+
+}  // namespace qx
@@ -1,40 +1,412 @@
 #include "qx/circuit.hpp"
 
-#include <algorithm>  // for_each
+#include <fmt/core.h>
+
+#include <algorithm>  // all_of, count_if, find_if_not, lower_bound, min, sort, upper_bound
+#include <iterator>  // prev
+#include <memory>  // dynamic_pointer_cast, make_unique
+#include <numeric>  // iota
+#include <string_view>
+#include <utility>  // move
+#include <variant>  // holds_alternative, monostate
+#include <vector>
 
 #include "qx/circuit_builder.hpp"
+#include "qx/compile_time_configuration.hpp"
+#include "qx/compressed_page_store.hpp"
 #include "qx/instructions.hpp"
+#include "qx/simulation_error.hpp"
 #include "qx/simulation_result.hpp"
 
 namespace qx {
 
 Circuit::Circuit(const TreeOne<CqasmV3xProgram>& program)
-: program{ program } {
+: program{ program }
+, number_of_qubits_{ RegisterManager::get_instance().get_qubit_register_size() } {
     CircuitBuilder{ *this }.build();
 }
 
+Circuit::Circuit(std::vector<std::shared_ptr<Instruction>> instructions)
+: number_of_qubits_{ RegisterManager::get_instance().get_qubit_register_size() } {
+    instructions_.reserve(instructions.size());
+    for (auto& instruction : instructions) {
+        add_instruction(std::move(instruction));
+    }
+}
+
 void Circuit::add_instruction(std::shared_ptr<Instruction> instruction) {
+    auto& register_manager = RegisterManager::get_instance();
     for (const auto& qubit_index : instruction->get_qubit_indices()) {
-        RegisterManager::get_instance().set_dirty_qubit(qubit_index.value);
+        register_manager.set_dirty_qubit(qubit_index.value);
     }
     instructions_.emplace_back(std::move(instruction));
 }
 
-/* static */ void Circuit::add_error(SimulationIterationContext& context, const error_models::ErrorModel& error_model) {
+/* static */ void Circuit::add_error(DensityMatrixBranches& branches, const error_models::ErrorModel& error_model,
+    const core::BasisVector& excluded_qubits) {
     if (auto* depolarizing_channel = std::get_if<error_models::DepolarizingChannel>(&error_model)) {
-        depolarizing_channel->add_error(context.state);
-    } else if (!std::get_if<std::monostate>(&error_model)) {
+        for (auto& branch : branches) {
+            depolarizing_channel->add_error(branch.density_matrix, excluded_qubits);
+        }
+    } else if (!std::get_if<std::monostate>(&error_model) && !std::get_if<error_models::NoiseModel>(&error_model)) {
         throw std::runtime_error{ "unimplemented error model" };
     }
 }
 
-[[nodiscard]] SimulationIterationContext Circuit::execute(const error_models::ErrorModel& error_model) const {
-    auto context = SimulationIterationContext{};
-    std::for_each(instructions_.begin(), instructions_.end(), [&context, &error_model](const auto& instruction) {
-        add_error(context, error_model);
-        instruction->execute(context);
-    });
-    return context;
+/* static */ void Circuit::add_error(SimulationIterationContext& context, const error_models::NoiseModel& noise_model,
+    const Instruction& instruction) {
+    if (const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(&instruction)) {
+        if (bit_controlled_instruction->are_all_control_bits_set(context.measurement_register)) {
+            add_error(context, noise_model, *bit_controlled_instruction->instruction);
+        }
+    } else if (const auto* unitary = dynamic_cast<const Unitary*>(&instruction)) {
+        noise_model.add_gate_error(context.state, unitary->name, *unitary->operands);
+    } else if (const auto* measure = dynamic_cast<const Measure*>(&instruction)) {
+        auto measured_value = context.measurement_register.test(measure->qubit_index.value);
+        auto read_value = noise_model.add_readout_error(measure->qubit_index, measured_value);
+        context.measurement_register.set(measure->qubit_index.value, read_value);
+        context.bit_measurement_register.set(measure->bit_index.value, read_value);
+    }
+}
+
+/* static */ void Circuit::add_error(
+    DensityMatrixBranch& branch, const error_models::NoiseModel& noise_model, const Instruction& instruction) {
+    if (const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(&instruction)) {
+        if (bit_controlled_instruction->are_all_control_bits_set(branch.measurement_register)) {
+            add_error(branch, noise_model, *bit_controlled_instruction->instruction);
+        }
+    } else if (const auto* unitary = dynamic_cast<const Unitary*>(&instruction)) {
+        noise_model.add_gate_error(branch.density_matrix, unitary->name, *unitary->operands);
+    }
+}
+
+// A measure can be deferred to the end of the circuit if no later instruction
+// uses its qubit, writes its bit, or depends on the measured values
+[[nodiscard]] std::vector<bool> Circuit::get_deferred_measures() const {
+    auto ret = std::vector<bool>(instructions_.size(), false);
+    auto used_qubits = std::vector<bool>(number_of_qubits_, false);
+    auto written_bits = std::vector<bool>(RegisterManager::get_instance().get_bit_register_size(), false);
+    auto is_bit_controlled_later = false;
+    for (auto i = instructions_.size(); i-- > 0;) {
+        const auto& instruction = instructions_[i];
+        if (auto measure = std::dynamic_pointer_cast<Measure>(instruction)) {
+            ret[i] = !used_qubits[measure->qubit_index.value] && !written_bits[measure->bit_index.value] &&
+                !is_bit_controlled_later;
+        }
+        if (std::dynamic_pointer_cast<BitControlledInstruction>(instruction)) {
+            is_bit_controlled_later = true;
+        }
+        for (const auto& qubit_index : instruction->get_qubit_indices()) {
+            used_qubits[qubit_index.value] = true;
+        }
+        for (const auto& bit_index : instruction->get_bit_indices()) {
+            written_bits[bit_index.value] = true;
+        }
+    }
+    return ret;
+}
+
+// The qubits used by every window of instructions are placed at the lowest bits, the most used first,
+// but only if some of them are not there yet, i.e., when the set of qubits in use changes,
+// since moving the qubits takes a pass over the state
+// Ties keep their order, so that as few qubits as possible move
+void Circuit::place_qubits() const {
+    qubit_placements_.clear();
+    are_qubits_placed_ = true;
+    auto number_of_qubits = number_of_qubits_;
+    auto positions = std::vector<std::size_t>(number_of_qubits);
+    std::iota(positions.begin(), positions.end(), 0);
+    for (std::size_t first = 0; first < instructions_.size(); first += config::QUBIT_PLACEMENT_WINDOW) {
+        auto last = std::min(first + config::QUBIT_PLACEMENT_WINDOW, instructions_.size());
+        auto uses = std::vector<std::size_t>(number_of_qubits, 0);
+        for (auto i = first; i < last; ++i) {
+            for (const auto& qubit_index : instructions_[i]->get_qubit_indices()) {
+                ++uses[qubit_index.value];
+            }
+        }
+        auto number_of_used_qubits =
+            static_cast<std::size_t>(std::count_if(uses.begin(), uses.end(), [](auto n) { return n > 0; }));
+        auto is_placed = [&uses, &positions, number_of_used_qubits](std::size_t qubit) {
+            return uses[qubit] == 0 || positions[qubit] < number_of_used_qubits;
+        };
+        auto qubits = std::vector<std::size_t>(number_of_qubits);
+        std::iota(qubits.begin(), qubits.end(), 0);
+        if (std::all_of(qubits.begin(), qubits.end(), is_placed)) {
+            continue;
+        }
+        std::sort(qubits.begin(), qubits.end(), [&uses, &positions](auto lhs, auto rhs) {
+            return uses[lhs] != uses[rhs] ? uses[lhs] > uses[rhs] : positions[lhs] < positions[rhs];
+        });
+        for (std::size_t position = 0; position < number_of_qubits; ++position) {
+            positions[qubits[position]] = position;
+        }
+        qubit_placements_.push_back(QubitPlacement{ first, positions });
+    }
+}
+
+// In a hash_map state, the position of the qubits does not change which amplitudes are close to each other
+void Circuit::move_qubits(core::QuantumState& state, std::size_t instruction) const {
+    if (state.get_layout() != core::SparseArrayLayout::sorted_vector) {
+        return;
+    }
+    if (!are_qubits_placed_) {
+        place_qubits();
+    }
+    auto placement = std::lower_bound(qubit_placements_.begin(),
+        qubit_placements_.end(),
+        instruction,
+        [](const auto& qubit_placement, auto i) { return qubit_placement.instruction < i; });
+    if (placement != qubit_placements_.end() && placement->instruction == instruction) {
+        state.set_qubit_positions(placement->positions);
+    }
+}
+
+[[nodiscard]] const std::vector<QubitPlacement>& Circuit::get_qubit_placements() const {
+    if (!are_qubits_placed_) {
+        place_qubits();
+    }
+    return qubit_placements_;
+}
+
+// Qubit placements refer to instruction indices, so they are planned again
+CircuitOptimization Circuit::optimize() {
+    auto ret = optimize_instructions(instructions_);
+    are_qubits_placed_ = false;
+    return ret;
+}
+
+CircuitPruning Circuit::prune() {
+    auto ret = prune_instructions(instructions_, number_of_qubits_);
+    number_of_qubits_ = ret.simulated_qubits.size();
+    are_qubits_placed_ = false;
+    return ret;
+}
+
+[[nodiscard]] std::size_t Circuit::get_number_of_qubits() const {
+    return number_of_qubits_;
+}
+
+// The unitary prefix does not draw any random number, so resuming from it gives the same results
+void Circuit::cache_noiseless_prefix(const SimulationOptions& options) {
+    prefix_checkpoints_.clear();
+    prefix_layout_ = options.sparse_array_layout;
+    // Shots with a noise model never resume from the prefix
+    if (std::holds_alternative<error_models::NoiseModel>(options.error_model)) {
+        return;
+    }
+    auto is_unitary = [](const auto& instruction) {
+        return dynamic_cast<const Unitary*>(instruction.get()) != nullptr;
+    };
+    auto prefix_size = static_cast<std::size_t>(
+        std::find_if_not(instructions_.begin(), instructions_.end(), is_unitary) - instructions_.begin());
+    if (prefix_size == 0) {
+        return;
+    }
+    // Without errors, every shot resumes from the end of the prefix, so only that state is kept
+    auto interval = std::holds_alternative<std::monostate>(options.error_model)
+        ? prefix_size
+        : (prefix_size + config::MAX_PREFIX_CHECKPOINTS - 1) / config::MAX_PREFIX_CHECKPOINTS;
+    auto context = SimulationIterationContext{ number_of_qubits_, options };
+    auto memory_size = std::size_t{};
+    for (std::size_t i = 0; i + 1 < prefix_size; ++i) {
+        move_qubits(context.state, i);
+        instructions_[i]->execute(context);
+        // A state is only kept if it fits in the memory budget, along with the states kept before it
+        auto state_memory_size = context.state.get_memory_size();
+        if ((i + 1) % interval == 0 &&
+            memory_size + state_memory_size <= config::PREFIX_CHECKPOINTS_MEMORY_FACTOR * state_memory_size) {
+            prefix_checkpoints_.push_back(PrefixCheckpoint{ i + 1, context });
+            memory_size += state_memory_size;
+        }
+    }
+    move_qubits(context.state, prefix_size - 1);
+    instructions_[prefix_size - 1]->execute(context);
+    // The state at the end of the prefix is always kept, and the earliest states dropped if they exceed the budget
+    auto state_memory_size = context.state.get_memory_size();
+    auto first_kept = prefix_checkpoints_.begin();
+    while (first_kept != prefix_checkpoints_.end() &&
+        memory_size + state_memory_size > config::PREFIX_CHECKPOINTS_MEMORY_FACTOR * state_memory_size) {
+        memory_size -= first_kept->context.state.get_memory_size();
+        ++first_kept;
+    }
+    prefix_checkpoints_.erase(prefix_checkpoints_.begin(), first_kept);
+    prefix_checkpoints_.push_back(PrefixCheckpoint{ prefix_size, std::move(context) });
+}
+
+[[nodiscard]] std::size_t Circuit::skip_error_free_instructions(
+    const error_models::DepolarizingChannel* depolarizing_channel, std::size_t from) const {
+    auto number_of_error_free_instructions = depolarizing_channel
+        ? depolarizing_channel->sample_number_of_error_free_instructions()
+        : instructions_.size();
+    return number_of_error_free_instructions < instructions_.size() - from ? from + number_of_error_free_instructions
+                                                                           : instructions_.size();
+}
+
+[[nodiscard]] SimulationIterationContext Circuit::execute(
+    const error_models::ErrorModel& error_model, const SimulationOptions& options) const {
+    auto cursor = start_execution(error_model, options);
+    resume_execution(cursor, error_model);
+    return std::move(cursor.context);
+}
+
+[[nodiscard]] ExecutionCursor Circuit::start_execution(
+    const error_models::ErrorModel& error_model, const SimulationOptions& options) const {
+    const auto* depolarizing_channel = std::get_if<error_models::DepolarizingChannel>(&error_model);
+    const auto* noise_model = std::get_if<error_models::NoiseModel>(&error_model);
+    auto next_error = skip_error_free_instructions(depolarizing_channel, 0);
+    // Resume from the latest checkpoint whose instructions are all before the first error
+    auto checkpoint = std::upper_bound(prefix_checkpoints_.begin(),
+        prefix_checkpoints_.end(),
+        next_error,
+        [](auto n, const auto& prefix_checkpoint) { return n < prefix_checkpoint.number_of_instructions; });
+    auto use_checkpoint = checkpoint != prefix_checkpoints_.begin() && noise_model == nullptr &&
+        options.sparse_array_layout == prefix_layout_;
+    if (use_checkpoint) {
+        return ExecutionCursor{ std::prev(checkpoint)->context,
+            std::prev(checkpoint)->number_of_instructions,
+            next_error };
+    }
+    return ExecutionCursor{ SimulationIterationContext{ number_of_qubits_, options }, 0, next_error };
+}
+
+void Circuit::resume_execution(ExecutionCursor& cursor, const error_models::ErrorModel& error_model,
+    const std::function<void(ExecutionCursor&)>& after_instruction) const {
+    const auto* depolarizing_channel = std::get_if<error_models::DepolarizingChannel>(&error_model);
+    const auto* noise_model = std::get_if<error_models::NoiseModel>(&error_model);
+    while (cursor.next_instruction < instructions_.size()) {
+        auto i = cursor.next_instruction;
+        move_qubits(cursor.context.state, i);
+        if (i == cursor.next_error) {
+            depolarizing_channel->add_random_error(cursor.context.state);
+            cursor.next_error = skip_error_free_instructions(depolarizing_channel, i + 1);
+        }
+        instructions_[i]->execute(cursor.context);
+        if (noise_model) {
+            add_error(cursor.context, *noise_model, *instructions_[i]);
+        }
+        ++cursor.next_instruction;
+        if (after_instruction) {
+            after_instruction(cursor);
+        }
+    }
+}
+
+[[nodiscard]] std::size_t Circuit::get_number_of_instructions() const {
+    return instructions_.size();
+}
+
+[[nodiscard]] const std::vector<std::shared_ptr<Instruction>>& Circuit::get_instructions() const {
+    return instructions_;
+}
+
+[[nodiscard]] std::optional<SimulationBranches> Circuit::execute_branches(
+    const SimulationOptions& options, std::size_t max_branches) const {
+    auto branches =
+        SimulationBranches{ SimulationBranch{ 1., SimulationIterationContext{ number_of_qubits_, options } } };
+    for (std::size_t i = 0; i < instructions_.size(); ++i) {
+        for (auto& branch : branches) {
+            move_qubits(branch.context.state, i);
+        }
+        instructions_[i]->execute_branches(branches);
+        if (branches.size() > max_branches) {
+            return std::nullopt;
+        }
+    }
+    return branches;
+}
+
+// Deferred measures leave their qubits untouched until the end of the circuit,
+// so errors are not added to them, as they would not change the measured values
+[[nodiscard]] DensityMatrixExecution Circuit::execute_density_matrix(const SimulationOptions& options) const {
+    const auto* noise_model = std::get_if<error_models::NoiseModel>(&options.error_model);
+    if (noise_model && noise_model->has_readout_errors()) {
+        throw SimulationError{ "readout errors are not supported by the density matrix backend" };
+    }
+    const auto& register_manager = RegisterManager::get_instance();
+    auto ret = DensityMatrixExecution{ DensityMatrixBranches{ DensityMatrixBranch{
+                                           number_of_qubits_,
+                                           register_manager.get_bit_register_size() } },
+        {} };
+    auto deferred_measures = get_deferred_measures();
+    auto deferred_qubits = core::BasisVector{};
+    for (std::size_t i = 0; i < instructions_.size(); ++i) {
+        add_error(ret.branches, options.error_model, deferred_qubits);
+        if (deferred_measures[i]) {
+            auto qubit_index = instructions_[i]->get_qubit_indices()[0];
+            ret.deferred_measures.emplace_back(qubit_index, instructions_[i]->get_bit_indices()[0]);
+            deferred_qubits.set(qubit_index.value);
+            continue;
+        }
+        instructions_[i]->execute_density_matrix_branches(ret.branches);
+        if (noise_model) {
+            for (auto& branch : ret.branches) {
+                add_error(branch, *noise_model, *instructions_[i]);
+            }
+        }
+        if (ret.branches.size() > options.max_branches) {
+            throw SimulationError{ fmt::format(
+                "density matrix simulation exceeds the maximum number of branches: {}", options.max_branches) };
+        }
+    }
+    return ret;
+}
+
+template <typename Execution, typename MakeState>
+[[nodiscard]] Execution Circuit::execute_without_errors(
+    const SimulationOptions& options, std::string_view backend, MakeState&& make_state) const {
+    if (!std::holds_alternative<std::monostate>(options.error_model)) {
+        throw SimulationError{ fmt::format("error models are not supported by the {} backend", backend) };
+    }
+    const auto& register_manager = RegisterManager::get_instance();
+    auto ret = Execution{ { make_state(number_of_qubits_), register_manager.get_bit_register_size() }, {} };
+    auto deferred_measures = get_deferred_measures();
+    for (std::size_t i = 0; i < instructions_.size(); ++i) {
+        if (deferred_measures[i]) {
+            ret.deferred_measures.emplace_back(
+                instructions_[i]->get_qubit_indices()[0], instructions_[i]->get_bit_indices()[0]);
+            continue;
+        }
+        instructions_[i]->execute_backend(&ret.context);
+    }
+    return ret;
+}
+
+[[nodiscard]] MatrixProductStateExecution Circuit::execute_matrix_product_state(
+    const SimulationOptions& options) const {
+    return execute_without_errors<MatrixProductStateExecution>(
+        options, "matrix product state", [&options](std::size_t number_of_qubits) {
+            return core::MatrixProductState{
+                number_of_qubits, options.max_bond_dimension, options.truncation_threshold };
+        });
+}
+
+[[nodiscard]] DistributedStateVectorExecution Circuit::execute_distributed_state_vector(
+    const SimulationOptions& options, core::Communicator& communicator) const {
+    return execute_without_errors<DistributedStateVectorExecution>(
+        options, "distributed state vector", [&communicator](std::size_t number_of_qubits) {
+            return core::DistributedStateVector{ number_of_qubits, communicator };
+        });
+}
+
+[[nodiscard]] PagedStateVectorExecution Circuit::execute_paged_state_vector(const SimulationOptions& options) const {
+    return execute_without_errors<PagedStateVectorExecution>(
+        options, "paged state vector", [&options](std::size_t number_of_qubits) {
+            if (options.backend == Backend::compressed_state_vector) {
+                return core::PagedStateVector{ number_of_qubits,
+                    options.number_of_page_qubits,
+                    std::make_unique<core::CompressedPageStore>(
+                        options.compression_tolerance, options.number_of_compression_threads) };
+            }
+            return core::PagedStateVector{ number_of_qubits, options.number_of_page_qubits, options.page_directory };
+        });
+}
+
+[[nodiscard]] FactorizedStateVectorExecution Circuit::execute_factorized_state_vector(
+    const SimulationOptions& options) const {
+    return execute_without_errors<FactorizedStateVectorExecution>(
+        options, "factorized state vector", [&options](std::size_t number_of_qubits) {
+            return core::FactorizedStateVector{ number_of_qubits, options.sparse_array_layout };
+        });
 }
 
 }  // namespace qx
@@ -1,9 +1,13 @@
 #include "qx/circuit_builder.hpp"
 
 #include <fmt/format.h>
+#include <fmt/ranges.h>
 
-#include <algorithm>  // for_each
+#include <algorithm>  // for_each, transform
 #include <memory>  // make_shared
+#include <string>
+#include <utility>  // move
+#include <vector>
 
 #include "qx/core.hpp"
 #include "qx/gates.hpp"
@@ -12,6 +16,44 @@
 
 namespace qx {
 
+namespace {
+
+[[nodiscard]] bool is_modifier(const CqasmV3xGate& gate) {
+    return gate.name == "inv" || gate.name == "pow" || gate.name == "ctrl";
+}
+
+// Name of the gate, and of the gates it modifies, e.g., "inv.pow.X"
+[[nodiscard]] std::string get_gate_name(const CqasmV3xGate& gate) {
+    return is_modifier(gate) ? fmt::format("{}.{}", gate.name, get_gate_name(*gate.gate)) : gate.name;
+}
+
+// Name and parameters of the gate, and of the gates it modifies, e.g., "pow(0.5).Rx(1.5707963267948966)"
+// Parameters are written with as many digits as needed to read them back, so different values have different keys
+[[nodiscard]] std::string get_matrix_key(const CqasmV3xGate& gate) {
+    auto parameters = std::vector<std::string>{};
+    for (const auto& parameter : gate.parameters) {
+        if (const auto* const_float = parameter->as_const_float()) {
+            parameters.push_back(fmt::format("{}", const_float->value));
+        } else if (const auto* const_int = parameter->as_const_int()) {
+            parameters.push_back(fmt::format("{}", const_int->value));
+        } else {
+            throw CircuitBuilderError{ fmt::format("unsupported parameter of gate: '{}'", gate.name) };
+        }
+    }
+    auto ret = fmt::format("{}({})", gate.name, fmt::join(parameters, ","));
+    return is_modifier(gate) ? fmt::format("{}.{}", ret, get_matrix_key(*gate.gate)) : ret;
+}
+
+[[nodiscard]] gates::DefaultGateId get_default_gate_id(const CqasmV3xGate& gate) {
+    const auto id = gates::find_default_gate_id(gate.name);
+    if (!id) {
+        throw CircuitBuilderError{ fmt::format("unknown default gate: '{}'", gate.name) };
+    }
+    return *id;
+}
+
+}  // namespace
+
 CircuitBuilder::CircuitBuilder(Circuit& circuit)
 : circuit_{ circuit } {}
 
@@ -33,49 +75,51 @@ void CircuitBuilder::visit_gate_instruction(CqasmV3xGateInstruction& gate_instru
 
 std::vector<std::shared_ptr<Unitary>> CircuitBuilder::get_gates(
     const CqasmV3xGate& gate, const CqasmV3xOperands& operands) {
-    if (gate.name == "inv" || gate.name == "pow" || gate.name == "ctrl") {
-        return get_modified_gates(gate, operands);
-    } else {
-        return get_default_gates(gate, operands);
-    }
+    const auto& matrix = get_matrix(gate);
+    const auto& name = get_gate_name(gate);
+    auto instructions_indices = get_instructions_indices(operands);
+    auto ret = std::vector<std::shared_ptr<Unitary>>(instructions_indices.size());
+    std::transform(instructions_indices.begin(),
+        instructions_indices.end(),
+        ret.begin(),
+        [&matrix, &name](auto& instruction_indices) {
+            return std::make_shared<Unitary>(
+                matrix, std::make_shared<core::operands_t>(std::move(instruction_indices)), name);
+        });
+    return ret;
 }
 
-std::vector<std::shared_ptr<Unitary>> CircuitBuilder::get_modified_gates(
-    const CqasmV3xGate& gate, const CqasmV3xOperands& operands) {
-    const auto& modified_gates = get_gates(*gate.gate, operands);
-    auto ret = std::vector<std::shared_ptr<Unitary>>(modified_gates.size());
-    std::transform(modified_gates.begin(), modified_gates.end(), ret.begin(), [&gate](const auto& modified_gate) {
-        if (gate.name == "inv") {
-            modified_gate->matrix = modified_gate->inverse();
-        } else if (gate.name == "pow") {
-            auto exponent = gate.parameters[0]->as_const_float()->value;
-            modified_gate->matrix = modified_gate->power(exponent);
-        } else if (gate.name == "ctrl") {
-            modified_gate->matrix = modified_gate->control();
+std::shared_ptr<core::matrix_t> CircuitBuilder::get_matrix(const CqasmV3xGate& gate) {
+    if (!is_modifier(gate) && gate.parameters.empty()) {
+        auto& matrix = default_matrices_[get_default_gate_id(gate)];
+        if (!matrix) {
+            matrix = get_default_matrix(gate);
         }
-        return modified_gate;
-    });
-    return ret;
+        return matrix;
+    }
+    auto key = get_matrix_key(gate);
+    if (auto it = matrices_.find(key); it != matrices_.end()) {
+        return it->second;
+    }
+    auto matrix = is_modifier(gate) ? get_modified_matrix(gate) : get_default_matrix(gate);
+    matrices_.emplace(std::move(key), matrix);
+    return matrix;
 }
 
-std::vector<std::shared_ptr<Unitary>> CircuitBuilder::get_default_gates(
-    const CqasmV3xGate& gate, const CqasmV3xOperands& operands) {
-    try {
-        const auto& matrix_generator = gates::default_gates[gate.name];
-        const auto& matrix = matrix_generator(gate.parameters);
-        const auto& instructions_indices = get_instructions_indices(operands);
-        auto ret = std::vector<std::shared_ptr<Unitary>>(instructions_indices.size());
-        std::transform(instructions_indices.begin(),
-            instructions_indices.end(),
-            ret.begin(),
-            [&matrix](const auto& instruction_indices) {
-                return std::make_shared<Unitary>(
-                    std::make_shared<core::matrix_t>(matrix), std::make_shared<core::operands_t>(instruction_indices));
-            });
-        return ret;
-    } catch (const std::exception&) {
-        throw CircuitBuilderError{ fmt::format("unknown default gate: '{}'", gate.name) };
+std::shared_ptr<core::matrix_t> CircuitBuilder::get_modified_matrix(const CqasmV3xGate& gate) {
+    const auto& modified_matrix = *get_matrix(*gate.gate);
+    if (gate.name == "inv") {
+        return std::make_shared<core::matrix_t>(modified_matrix.inverse());
+    } else if (gate.name == "pow") {
+        auto exponent = gate.parameters[0]->as_const_float()->value;
+        return std::make_shared<core::matrix_t>(modified_matrix.power(exponent));
     }
+    return std::make_shared<core::matrix_t>(modified_matrix.control());
+}
+
+std::shared_ptr<core::matrix_t> CircuitBuilder::get_default_matrix(const CqasmV3xGate& gate) {
+    const auto& matrix_generator = gates::default_gates[get_default_gate_id(gate)].generator;
+    return std::make_shared<core::matrix_t>(matrix_generator(gate.parameters));
 }
 
 void CircuitBuilder::visit_non_gate_instruction(CqasmV3xNonGateInstruction& non_gate_instruction) {
@@ -0,0 +1,132 @@
+#include "qx/circuit_optimizer.hpp"
+
+#include <algorithm>  // any_of, erase, find, min
+#include <array>
+#include <complex>
+#include <iterator>  // distance
+#include <memory>  // make_shared
+#include <string>
+#include <utility>  // move
+
+#include "qx/compile_time_configuration.hpp"  // PEEPHOLE_WINDOW
+#include "qx/core.hpp"  // is_null
+#include "qx/instructions.hpp"
+
+namespace qx {
+
+[[nodiscard]] std::size_t CircuitOptimization::get_number_of_removed_gates() const {
+    return number_of_cancelled_gates + number_of_merged_gates;
+}
+
+namespace {
+
+enum class Basis {
+    z,
+    x
+};
+
+// Whether the matrix of a gate only maps basis vectors to basis vectors with the same value of an operand,
+// once that operand is expressed in the given basis
+// Same convention as the rows and columns of gate matrices: bit k is the value of operand number_of_operands - k - 1
+[[nodiscard]] bool is_block_diagonal(const Unitary& gate, std::size_t operand, Basis basis) {
+    auto number_of_operands = gate.operands->size();
+    auto size = static_cast<std::size_t>(1) << number_of_operands;
+    auto mask = static_cast<std::size_t>(1) << (number_of_operands - operand - 1);
+    for (std::size_t i = 0; i < size; ++i) {
+        for (std::size_t j = 0; j < size; ++j) {
+            if (((i ^ j) & mask) == 0) {
+                continue;
+            }
+            auto element = gate.matrix->at(i, j);
+            if (basis == Basis::x) {
+                // Element of H M H, with the Hadamard gates on the operand
+                element = 0.;
+                for (auto x : { std::size_t{ 0 }, mask }) {
+                    for (auto y : { std::size_t{ 0 }, mask }) {
+                        auto sign = ((i & x) != 0) != ((j & y) != 0) ? -1. : 1.;
+                        element += sign * gate.matrix->at((i & ~mask) | x, (j & ~mask) | y) / 2.;
+                    }
+                }
+            }
+            if (!core::is_null(element)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Whether an instruction commutes with a gate, by the rules of optimize_instructions
+[[nodiscard]] bool commutes(Instruction& instruction, const Unitary& gate) {
+    auto qubit_indices = instruction.get_qubit_indices();
+    const auto* other_gate = dynamic_cast<const Unitary*>(&instruction);
+    for (std::size_t operand = 0; operand < gate.operands->size(); ++operand) {
+        auto it = std::find(qubit_indices.begin(), qubit_indices.end(), (*gate.operands)[operand]);
+        if (it == qubit_indices.end()) {
+            continue;
+        }
+        if (other_gate == nullptr) {
+            return false;
+        }
+        auto other_operand = static_cast<std::size_t>(std::distance(qubit_indices.begin(), it));
+        auto bases = std::array{ Basis::z, Basis::x };
+        if (!std::any_of(bases.begin(), bases.end(), [&](auto basis) {
+                return is_block_diagonal(gate, operand, basis) &&
+                    is_block_diagonal(*other_gate, other_operand, basis);
+            })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+// Removed instructions leave a null pointer behind until the end, so that indices do not change
+// A merged gate takes the place of the earlier gate, and its name if both had the same one
+[[nodiscard]] CircuitOptimization optimize_instructions(std::vector<std::shared_ptr<Instruction>>& instructions) {
+    auto ret = CircuitOptimization{};
+    auto optimized = std::vector<std::shared_ptr<Instruction>>{};
+    optimized.reserve(instructions.size());
+    for (auto& instruction : instructions) {
+        const auto* gate = dynamic_cast<const Unitary*>(instruction.get());
+        auto is_removed = false;
+        auto first = optimized.size() - std::min(optimized.size(), config::PEEPHOLE_WINDOW);
+        for (auto k = optimized.size(); gate != nullptr && k-- > first;) {
+            auto& previous = optimized[k];
+            if (!previous) {
+                continue;
+            }
+            const auto* previous_gate = dynamic_cast<const Unitary*>(previous.get());
+            if (previous_gate != nullptr && *previous_gate->operands == *gate->operands) {
+                auto product = *gate->matrix * *previous_gate->matrix;
+                if (product == *previous_gate->matrix * *gate->matrix) {
+                    is_removed = true;
+                    ++ret.removed_gates[gate->name];
+                    if (product == core::matrix_t::identity(static_cast<std::size_t>(1) << gate->operands->size())) {
+                        ++ret.removed_gates[previous_gate->name];
+                        ret.number_of_cancelled_gates += 2;
+                        previous.reset();
+                    } else {
+                        ++ret.number_of_merged_gates;
+                        previous = std::make_shared<Unitary>(std::make_shared<core::matrix_t>(std::move(product)),
+                            previous_gate->operands,
+                            previous_gate->name == gate->name ? gate->name : std::string{});
+                    }
+                }
+                break;
+            }
+            if (!commutes(*previous, *gate)) {
+                break;
+            }
+        }
+        if (!is_removed) {
+            optimized.push_back(instruction);
+        }
+    }
+    std::erase(optimized, nullptr);
+    instructions = std::move(optimized);
+    return ret;
+}
+
+}  // namespace qx
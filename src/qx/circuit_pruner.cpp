@@ -0,0 +1,111 @@
+#include "qx/circuit_pruner.hpp"
+
+#include <algorithm>  // any_of
+#include <memory>  // make_shared
+#include <stdexcept>  // runtime_error
+#include <utility>  // move
+
+#include "qx/core.hpp"  // QubitIndex
+#include "qx/instructions.hpp"
+
+namespace qx {
+
+namespace {
+
+// Whether an instruction is a gate, possibly controlled by some bits
+[[nodiscard]] bool is_gate(const Instruction& instruction) {
+    if (const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(&instruction)) {
+        return is_gate(*bit_controlled_instruction->instruction);
+    }
+    return dynamic_cast<const Unitary*>(&instruction) != nullptr;
+}
+
+// The same instruction, with every qubit i replaced by qubit simulated_index[i]
+// Control bits index the measurement register, which has one bit per qubit, so they are replaced as well
+[[nodiscard]] std::shared_ptr<Instruction> renumber_qubits(
+    const std::shared_ptr<Instruction>& instruction, const std::vector<std::size_t>& simulated_index) {
+    if (const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(instruction.get())) {
+        auto control_bits = ControlBits{};
+        control_bits.reserve(bit_controlled_instruction->control_bits.size());
+        for (const auto& control_bit : bit_controlled_instruction->control_bits) {
+            control_bits.push_back(core::BitIndex{ control_bit.value < simulated_index.size()
+                    ? simulated_index[control_bit.value]
+                    : control_bit.value });
+        }
+        return std::make_shared<BitControlledInstruction>(std::move(control_bits),
+            renumber_qubits(bit_controlled_instruction->instruction, simulated_index));
+    }
+    if (const auto* unitary = dynamic_cast<const Unitary*>(instruction.get())) {
+        auto operands = core::operands_t{};
+        operands.reserve(unitary->operands->size());
+        for (const auto& operand : *unitary->operands) {
+            operands.push_back(core::QubitIndex{ simulated_index[operand.value] });
+        }
+        return std::make_shared<Unitary>(
+            unitary->matrix, std::make_shared<core::operands_t>(std::move(operands)), unitary->name);
+    }
+    if (const auto* measure = dynamic_cast<const Measure*>(instruction.get())) {
+        return std::make_shared<Measure>(
+            core::QubitIndex{ simulated_index[measure->qubit_index.value] }, measure->bit_index);
+    }
+    if (const auto* reset = dynamic_cast<const Reset*>(instruction.get())) {
+        return std::make_shared<Reset>(core::QubitIndex{ simulated_index[reset->qubit_index.value] });
+    }
+    throw std::runtime_error{ "unimplemented instruction" };
+}
+
+}  // namespace
+
+[[nodiscard]] CircuitPruning prune_instructions(
+    std::vector<std::shared_ptr<Instruction>>& instructions, std::size_t number_of_qubits) {
+    auto ret = CircuitPruning{};
+    auto is_in_light_cone = std::vector<bool>(number_of_qubits, false);
+    auto is_kept = std::vector<bool>(instructions.size(), false);
+    for (auto i = instructions.size(); i-- > 0;) {
+        auto qubit_indices = instructions[i]->get_qubit_indices();
+        is_kept[i] = !is_gate(*instructions[i]) ||
+            std::any_of(qubit_indices.begin(), qubit_indices.end(), [&is_in_light_cone](const auto& qubit_index) {
+                return is_in_light_cone[qubit_index.value];
+            });
+        if (is_kept[i]) {
+            for (const auto& qubit_index : qubit_indices) {
+                is_in_light_cone[qubit_index.value] = true;
+            }
+        }
+    }
+    // Once a qubit is in the light cone, it stays in it, so the qubits used by the instructions left are the ones
+    // in the light cone of the first instruction
+    // The qubits whose outcomes control the gates left are simulated as well, even if they are never measured
+    for (std::size_t i = 0; i < instructions.size(); ++i) {
+        const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(instructions[i].get());
+        if (is_kept[i] && bit_controlled_instruction) {
+            for (const auto& control_bit : bit_controlled_instruction->control_bits) {
+                if (control_bit.value < number_of_qubits) {
+                    is_in_light_cone[control_bit.value] = true;
+                }
+            }
+        }
+    }
+    auto simulated_index = std::vector<std::size_t>(number_of_qubits, 0);
+    for (std::size_t qubit = 0; qubit < number_of_qubits; ++qubit) {
+        if (is_in_light_cone[qubit]) {
+            simulated_index[qubit] = ret.simulated_qubits.size();
+            ret.simulated_qubits.push_back(qubit);
+        }
+    }
+    if (ret.simulated_qubits.empty()) {
+        ret.simulated_qubits.push_back(0);
+    }
+    auto is_renumbered = ret.simulated_qubits.size() < number_of_qubits;
+    auto pruned = std::vector<std::shared_ptr<Instruction>>{};
+    for (std::size_t i = 0; i < instructions.size(); ++i) {
+        if (is_kept[i]) {
+            pruned.push_back(is_renumbered ? renumber_qubits(instructions[i], simulated_index) : instructions[i]);
+        }
+    }
+    ret.number_of_removed_instructions = instructions.size() - pruned.size();
+    instructions = std::move(pruned);
+    return ret;
+}
+
+}  // namespace qx
@@ -0,0 +1,104 @@
+#include "qx/communicator.hpp"
+
+#include <algorithm>  // copy_n, find_if
+#include <barrier>
+#include <cassert>  // assert
+#include <exception>  // current_exception, exception_ptr, rethrow_exception
+#include <thread>
+#include <utility>  // move
+#include <vector>
+
+namespace qx::core {
+
+struct LocalCommunicator::Group {
+    explicit Group(std::size_t size)
+    : barrier{ static_cast<std::ptrdiff_t>(size) }
+    , buffers(size, nullptr) {}
+
+    std::barrier<> barrier;
+    // Buffer posted by every rank for the current collective operation
+    std::vector<const void*> buffers;
+};
+
+LocalCommunicator::LocalCommunicator()
+: LocalCommunicator{ std::make_shared<Group>(1), 0 } {}
+
+LocalCommunicator::LocalCommunicator(std::shared_ptr<Group> group, std::size_t rank)
+: group_{ std::move(group) }
+, rank_{ rank } {}
+
+/* static */ void LocalCommunicator::run(std::size_t number_of_ranks, const std::function<void(Communicator&)>& f) {
+    assert(number_of_ranks > 0);
+    auto group = std::make_shared<Group>(number_of_ranks);
+    auto exceptions = std::vector<std::exception_ptr>(number_of_ranks);
+    {
+        auto threads = std::vector<std::jthread>{};
+        threads.reserve(number_of_ranks);
+        for (std::size_t rank = 0; rank < number_of_ranks; ++rank) {
+            threads.emplace_back([&group, &exceptions, &f, rank]() {
+                auto communicator = LocalCommunicator{ group, rank };
+                try {
+                    f(communicator);
+                } catch (...) {
+                    exceptions[rank] = std::current_exception();
+                }
+            });
+        }
+    }
+    if (auto it = std::find_if(exceptions.begin(), exceptions.end(), [](const auto& e) { return e != nullptr; });
+        it != exceptions.end()) {
+        std::rethrow_exception(*it);
+    }
+}
+
+[[nodiscard]] std::size_t LocalCommunicator::get_rank() const {
+    return rank_;
+}
+
+[[nodiscard]] std::size_t LocalCommunicator::get_size() const {
+    return group_->buffers.size();
+}
+
+void LocalCommunicator::exchange(std::size_t partner, std::span<const std::byte> send, std::span<std::byte> receive) {
+    assert(partner < get_size());
+    group_->buffers[rank_] = send.data();
+    group_->barrier.arrive_and_wait();
+    std::copy_n(static_cast<const std::byte*>(group_->buffers[partner]), receive.size(), receive.data());
+    group_->barrier.arrive_and_wait();
+}
+
+void LocalCommunicator::broadcast(std::span<std::byte> data, std::size_t root) {
+    assert(root < get_size());
+    group_->buffers[rank_] = data.data();
+    group_->barrier.arrive_and_wait();
+    if (rank_ != root) {
+        std::copy_n(static_cast<const std::byte*>(group_->buffers[root]), data.size(), data.data());
+    }
+    group_->barrier.arrive_and_wait();
+}
+
+void LocalCommunicator::all_reduce_sum(std::span<double> values) {
+    all_reduce_sum_impl(values);
+}
+
+void LocalCommunicator::all_reduce_sum(std::span<std::uint64_t> values) {
+    all_reduce_sum_impl(values);
+}
+
+// The sums are written back after a second barrier, once no other rank reads the values anymore
+// Every rank adds the values in rank order, so all the ranks get the same floating-point sums
+template <typename T>
+void LocalCommunicator::all_reduce_sum_impl(std::span<T> values) {
+    group_->buffers[rank_] = values.data();
+    group_->barrier.arrive_and_wait();
+    auto sums = std::vector<T>(values.size(), T{});
+    for (const auto* buffer : group_->buffers) {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            sums[i] += static_cast<const T*>(buffer)[i];
+        }
+    }
+    group_->barrier.arrive_and_wait();
+    std::copy_n(sums.begin(), values.size(), values.begin());
+}
+
+}  // namespace qx::core
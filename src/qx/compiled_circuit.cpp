@@ -0,0 +1,458 @@
+#include "qx/compiled_circuit.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>  // find, min
+#include <cassert>
+#include <cstddef>  // byte
+#include <cstdint>  // uint32_t, uint64_t, uintptr_t
+#include <cstring>  // memcpy
+#include <fstream>
+#include <memory>  // make_shared, shared_ptr
+#include <span>
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>  // move
+#include <vector>
+
+#include "qx/compile_time_configuration.hpp"  // MAX_BIT_NUMBER, MAX_QUBIT_NUMBER
+#include "qx/core.hpp"  // BitIndex, QubitIndex
+#include "qx/dense_unitary_matrix.hpp"  // Matrix, matrix_t
+#include "qx/instructions.hpp"
+#include "qx/register_manager.hpp"
+#include "qx/simulation_error.hpp"
+#include "qx/utils.hpp"  // read_binary, write_binary, write_binary_string
+
+#ifndef _WIN32
+#include <fcntl.h>  // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>  // close
+#endif
+
+namespace qx {
+
+namespace {
+
+// "QXCIRC" followed by two zero bytes, in little-endian byte order
+static constexpr std::uint64_t COMPILED_CIRCUIT_MAGIC_NUMBER = 0x0000'4352'4943'5851;
+static constexpr std::uint32_t COMPILED_CIRCUIT_FORMAT_VERSION = 1;
+// Matrices of gates on more qubits are rejected when read, rather than allocated from corrupted data
+static constexpr std::size_t MAX_MATRIX_SIZE = std::size_t{ 1 } << 12;
+// Compiled circuits read from a stream are read by chunks of words
+static constexpr std::size_t WORDS_CHUNK_SIZE = std::size_t{ 1 } << 16;
+
+// The first word of the encoding of every instruction
+//
+// Followed by:
+// - unitary: the index of its matrix, the index of its name, its number of operands, and its operands
+// - measure: its qubit and its bit
+// - reset: its qubit
+// - bit_controlled: its number of control bits, its control bits, and the encoding of the unitary it controls
+enum class InstructionKind : std::uint32_t { unitary, measure, reset, bit_controlled };
+
+// The matrices and names of the instructions, each stored once, and the instructions encoded as words
+class Encoder {
+public:
+    void add(const Instruction& instruction) {
+        if (const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(&instruction)) {
+            if (dynamic_cast<const Unitary*>(bit_controlled_instruction->instruction.get()) == nullptr) {
+                throw std::runtime_error{ "unimplemented bit-controlled instruction" };
+            }
+            add_word(InstructionKind::bit_controlled);
+            add_word(bit_controlled_instruction->control_bits.size());
+            for (const auto& control_bit : bit_controlled_instruction->control_bits) {
+                add_word(control_bit.value);
+            }
+            add(*bit_controlled_instruction->instruction);
+        } else if (const auto* unitary = dynamic_cast<const Unitary*>(&instruction)) {
+            add_word(InstructionKind::unitary);
+            add_word(get_matrix_index(*unitary->matrix));
+            add_word(get_name_index(unitary->name));
+            add_word(unitary->operands->size());
+            for (const auto& operand : *unitary->operands) {
+                add_word(operand.value);
+            }
+        } else if (const auto* measure = dynamic_cast<const Measure*>(&instruction)) {
+            add_word(InstructionKind::measure);
+            add_word(measure->qubit_index.value);
+            add_word(measure->bit_index.value);
+        } else if (const auto* reset = dynamic_cast<const Reset*>(&instruction)) {
+            add_word(InstructionKind::reset);
+            add_word(reset->qubit_index.value);
+        } else {
+            throw std::runtime_error{ "unimplemented instruction" };
+        }
+    }
+
+    // Written right after the magic number and the version, so that the words are aligned in a mapped file
+    void write_words(std::ostream& os, std::size_t number_of_instructions) const {
+        utils::write_binary(os, static_cast<std::uint64_t>(number_of_instructions));
+        utils::write_binary(os, static_cast<std::uint64_t>(words_.size()));
+        os.write(reinterpret_cast<const char*>(words_.data()),
+            static_cast<std::streamsize>(words_.size() * sizeof(std::uint32_t)));
+    }
+
+    void write_tables(std::ostream& os) const {
+        utils::write_binary(os, static_cast<std::uint64_t>(matrices_.size()));
+        for (const auto* matrix : matrices_) {
+            utils::write_binary(os, static_cast<std::uint64_t>(matrix->size()));
+            for (std::size_t i = 0; i < matrix->size(); ++i) {
+                for (std::size_t j = 0; j < matrix->size(); ++j) {
+                    utils::write_binary(os, matrix->at(i, j).real());
+                    utils::write_binary(os, matrix->at(i, j).imag());
+                }
+            }
+        }
+        utils::write_binary(os, static_cast<std::uint64_t>(names_.size()));
+        for (const auto& name : names_) {
+            utils::write_binary_string(os, name);
+        }
+    }
+
+private:
+    void add_word(auto value) {
+        words_.push_back(static_cast<std::uint32_t>(value));
+    }
+
+    std::size_t get_matrix_index(const core::matrix_t& matrix) {
+        auto [it, inserted] = matrix_indices_.try_emplace(&matrix, matrices_.size());
+        if (inserted) {
+            matrices_.push_back(&matrix);
+        }
+        return it->second;
+    }
+
+    std::size_t get_name_index(const std::string& name) {
+        auto [it, inserted] = name_indices_.try_emplace(name, names_.size());
+        if (inserted) {
+            names_.push_back(name);
+        }
+        return it->second;
+    }
+
+    std::vector<const core::matrix_t*> matrices_;
+    std::unordered_map<const core::matrix_t*, std::size_t> matrix_indices_;
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, std::size_t> name_indices_;
+    std::vector<std::uint32_t> words_;
+};
+
+// Read the values written by utils::write_binary and utils::write_binary_string from bytes in memory,
+// e.g., a mapped file, without copying them
+class ByteReader {
+public:
+    explicit ByteReader(std::span<const std::byte> bytes)
+    : bytes_{ bytes } {}
+
+    template <typename T>
+    [[nodiscard]] T read() {
+        auto ret = T{};
+        std::memcpy(&ret, take(sizeof(T)).data(), sizeof(T));
+        return ret;
+    }
+
+    [[nodiscard]] std::string read_string(std::size_t max_size) {
+        auto size = read<std::uint64_t>();
+        if (size > max_size) {
+            throw SimulationError{ "invalid compiled circuit: string too long" };
+        }
+        auto chars = take(static_cast<std::size_t>(size));
+        return std::string{ reinterpret_cast<const char*>(chars.data()), chars.size() };
+    }
+
+    // The words are not copied, so they have to be aligned in memory
+    [[nodiscard]] std::span<const std::uint32_t> read_words(std::uint64_t number_of_words) {
+        if (number_of_words > (bytes_.size() - position_) / sizeof(std::uint32_t)) {
+            throw SimulationError{ "invalid compiled circuit: truncated instructions" };
+        }
+        auto bytes = take(static_cast<std::size_t>(number_of_words) * sizeof(std::uint32_t));
+        assert(reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(std::uint32_t) == 0);
+        return { reinterpret_cast<const std::uint32_t*>(bytes.data()), static_cast<std::size_t>(number_of_words) };
+    }
+
+private:
+    [[nodiscard]] std::span<const std::byte> take(std::size_t size) {
+        if (size > bytes_.size() - position_) {
+            throw SimulationError{ "invalid compiled circuit: truncated data" };
+        }
+        auto ret = bytes_.subspan(position_, size);
+        position_ += size;
+        return ret;
+    }
+
+    std::span<const std::byte> bytes_;
+    std::size_t position_ = 0;
+};
+
+// Rebuild the instructions from their words, checking every index against the registers and the tables
+class Decoder {
+public:
+    Decoder(std::vector<std::shared_ptr<core::matrix_t>> matrices, std::vector<std::string> names,
+        std::span<const std::uint32_t> words)
+    : matrices_{ std::move(matrices) }
+    , names_{ std::move(names) }
+    , words_{ words }
+    , number_of_qubits_{ RegisterManager::get_instance().get_qubit_register_size() }
+    , number_of_bits_{ RegisterManager::get_instance().get_bit_register_size() } {}
+
+    [[nodiscard]] bool done() const {
+        return position_ == words_.size();
+    }
+
+    [[nodiscard]] std::shared_ptr<Instruction> next() {
+        switch (static_cast<InstructionKind>(next_word())) {
+            case InstructionKind::unitary:
+                return next_unitary();
+            case InstructionKind::measure: {
+                auto qubit_index = core::QubitIndex{ next_word(number_of_qubits_) };
+                return std::make_shared<Measure>(qubit_index, core::BitIndex{ next_word(number_of_bits_) });
+            }
+            case InstructionKind::reset:
+                return std::make_shared<Reset>(core::QubitIndex{ next_word(number_of_qubits_) });
+            case InstructionKind::bit_controlled: {
+                auto control_bits = ControlBits(next_count());
+                for (auto& control_bit : control_bits) {
+                    control_bit = core::BitIndex{ next_word(number_of_bits_) };
+                }
+                // Only unitaries are bit-controlled, so a corrupted file can not nest instructions without end
+                if (static_cast<InstructionKind>(next_word()) != InstructionKind::unitary) {
+                    throw SimulationError{ "invalid compiled circuit: bit-controlled instruction is not a unitary" };
+                }
+                return std::make_shared<BitControlledInstruction>(std::move(control_bits), next_unitary());
+            }
+        }
+        throw SimulationError{ "invalid compiled circuit: unknown instruction" };
+    }
+
+private:
+    [[nodiscard]] std::shared_ptr<Unitary> next_unitary() {
+        const auto& matrix = matrices_[next_word(matrices_.size())];
+        auto name = names_[next_word(names_.size())];
+        auto operands = std::make_shared<core::operands_t>(next_count());
+        if (operands->size() >= 64 || (std::size_t{ 1 } << operands->size()) != matrix->size()) {
+            throw SimulationError{ "invalid compiled circuit: gate matrix does not match its operands" };
+        }
+        for (auto it = operands->begin(); it != operands->end(); ++it) {
+            *it = core::QubitIndex{ next_word(number_of_qubits_) };
+            if (std::find(operands->begin(), it, *it) != it) {
+                throw SimulationError{ "invalid compiled circuit: duplicate gate operand" };
+            }
+        }
+        return std::make_shared<Unitary>(matrix, std::move(operands), std::move(name));
+    }
+
+    // The next word, which has to be less than bound
+    [[nodiscard]] std::size_t next_word(std::size_t bound = SIZE_MAX) {
+        if (position_ == words_.size()) {
+            throw SimulationError{ "invalid compiled circuit: truncated instruction" };
+        }
+        auto ret = static_cast<std::size_t>(words_[position_++]);
+        if (ret >= bound) {
+            throw SimulationError{ "invalid compiled circuit: index out of range" };
+        }
+        return ret;
+    }
+
+    // The next word, a number of words that follow it
+    [[nodiscard]] std::size_t next_count() {
+        auto ret = next_word();
+        if (ret > words_.size() - position_) {
+            throw SimulationError{ "invalid compiled circuit: truncated instruction" };
+        }
+        return ret;
+    }
+
+    std::vector<std::shared_ptr<core::matrix_t>> matrices_;
+    std::vector<std::string> names_;
+    std::span<const std::uint32_t> words_;
+    std::size_t number_of_qubits_;
+    std::size_t number_of_bits_;
+    std::size_t position_ = 0;
+};
+
+void write_register_variables(std::ostream& os, const RegisterVariables& variables) {
+    utils::write_binary(os, static_cast<std::uint64_t>(variables.size()));
+    for (const auto& [name, size] : variables) {
+        utils::write_binary_string(os, name);
+        utils::write_binary(os, static_cast<std::uint64_t>(size));
+    }
+}
+
+// Every variable has a distinct name, and a size from 1 to max_register_size
+[[nodiscard]] RegisterVariables read_register_variables(ByteReader& reader, std::size_t max_register_size) {
+    auto ret = RegisterVariables{};
+    auto names = std::unordered_set<std::string>{};
+    auto number_of_variables = reader.read<std::uint64_t>();
+    for (std::uint64_t i = 0; i < number_of_variables; ++i) {
+        auto name = reader.read_string(1 << 16);
+        auto size = reader.read<std::uint64_t>();
+        if (size == 0 || size > max_register_size) {
+            throw SimulationError{ fmt::format("invalid compiled circuit: invalid size of variable '{}'", name) };
+        }
+        if (!names.insert(name).second) {
+            throw SimulationError{ fmt::format("invalid compiled circuit: duplicate variable '{}'", name) };
+        }
+        ret.emplace_back(std::move(name), static_cast<std::size_t>(size));
+    }
+    return ret;
+}
+
+[[nodiscard]] std::shared_ptr<core::matrix_t> read_matrix(ByteReader& reader) {
+    auto size = reader.read<std::uint64_t>();
+    if (size < 2 || size > MAX_MATRIX_SIZE || (size & (size - 1)) != 0) {
+        throw SimulationError{ "invalid compiled circuit: invalid matrix size" };
+    }
+    auto matrix = core::Matrix(size, core::Row(size));
+    for (auto& row : matrix) {
+        for (auto& entry : row) {
+            auto real = reader.read<double>();
+            entry = { real, reader.read<double>() };
+        }
+    }
+    try {
+        return std::make_shared<core::matrix_t>(std::move(matrix));
+    } catch (const std::runtime_error& err) {
+        throw SimulationError{ fmt::format("invalid compiled circuit: {}", err.what()) };
+    }
+}
+
+// Decode a compiled circuit from its bytes, which have to be aligned on 32-bit words
+[[nodiscard]] Circuit decode_compiled_circuit(std::span<const std::byte> bytes) {
+    auto reader = ByteReader{ bytes };
+    if (bytes.size() < sizeof(COMPILED_CIRCUIT_MAGIC_NUMBER) ||
+        reader.read<std::uint64_t>() != COMPILED_CIRCUIT_MAGIC_NUMBER) {
+        throw SimulationError{ "invalid compiled circuit: not a compiled circuit" };
+    }
+    if (auto version = reader.read<std::uint32_t>(); version != COMPILED_CIRCUIT_FORMAT_VERSION) {
+        throw SimulationError{ fmt::format("invalid compiled circuit: unsupported format version {}", version) };
+    }
+    auto number_of_instructions = reader.read<std::uint64_t>();
+    auto words = reader.read_words(reader.read<std::uint64_t>());
+
+    auto qubit_variables = read_register_variables(reader, config::MAX_QUBIT_NUMBER);
+    auto bit_variables = read_register_variables(reader, config::MAX_BIT_NUMBER);
+    RegisterManager::create_instance(qubit_variables, bit_variables);
+
+    auto number_of_matrices = reader.read<std::uint64_t>();
+    auto matrices = std::vector<std::shared_ptr<core::matrix_t>>{};
+    for (std::uint64_t i = 0; i < number_of_matrices; ++i) {
+        matrices.push_back(read_matrix(reader));
+    }
+    auto number_of_names = reader.read<std::uint64_t>();
+    auto names = std::vector<std::string>{};
+    for (std::uint64_t i = 0; i < number_of_names; ++i) {
+        names.push_back(reader.read_string(1 << 16));
+    }
+
+    auto decoder = Decoder{ std::move(matrices), std::move(names), words };
+    auto instructions = std::vector<std::shared_ptr<Instruction>>{};
+    // An instruction takes at least two words
+    instructions.reserve(std::min(number_of_instructions, std::uint64_t{ words.size() / 2 }));
+    while (!decoder.done()) {
+        instructions.push_back(decoder.next());
+    }
+    if (instructions.size() != number_of_instructions) {
+        throw SimulationError{ "invalid compiled circuit: wrong number of instructions" };
+    }
+    return Circuit{ std::move(instructions) };
+}
+
+#ifndef _WIN32
+// A file mapped read-only in memory, unmapped when destroyed
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw SimulationError{ fmt::format("could not read compiled circuit file: {}", path.string()) };
+        }
+        struct stat file_status {};
+        if (::fstat(fd, &file_status) == 0 && file_status.st_size > 0) {
+            size_ = static_cast<std::size_t>(file_status.st_size);
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (data_ == MAP_FAILED) {
+            throw SimulationError{ fmt::format("could not map compiled circuit file: {}", path.string()) };
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    // Mappings start on a page boundary, so the words of the instruction stream are aligned
+    [[nodiscard]] std::span<const std::byte> get_data() const {
+        return data_ != nullptr ? std::span<const std::byte>{ static_cast<const std::byte*>(data_), size_ }
+                                : std::span<const std::byte>{};
+    }
+
+private:
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+#endif
+
+}  // namespace
+
+void write_compiled_circuit(std::ostream& os, const Circuit& circuit) {
+    const auto& register_manager = RegisterManager::get_instance();
+    auto encoder = Encoder{};
+    for (const auto& instruction : circuit.get_instructions()) {
+        encoder.add(*instruction);
+    }
+    utils::write_binary(os, COMPILED_CIRCUIT_MAGIC_NUMBER);
+    utils::write_binary(os, COMPILED_CIRCUIT_FORMAT_VERSION);
+    encoder.write_words(os, circuit.get_number_of_instructions());
+    write_register_variables(os, register_manager.get_qubit_register()->get_variables());
+    write_register_variables(os, register_manager.get_bit_register()->get_variables());
+    encoder.write_tables(os);
+}
+
+[[nodiscard]] Circuit read_compiled_circuit(std::istream& is) {
+    // Read into words, so that the instruction stream is aligned as in a mapped file
+    auto words = std::vector<std::uint32_t>{};
+    auto size = std::size_t{};
+    while (is) {
+        words.resize(size / sizeof(std::uint32_t) + WORDS_CHUNK_SIZE);
+        is.read(reinterpret_cast<char*>(words.data()) + size,
+            static_cast<std::streamsize>(words.size() * sizeof(std::uint32_t) - size));
+        size += static_cast<std::size_t>(is.gcount());
+    }
+    return decode_compiled_circuit(std::as_bytes(std::span{ words }).first(size));
+}
+
+void save_compiled_circuit(const std::filesystem::path& path, const Circuit& circuit) {
+    auto file = std::ofstream{ path, std::ios::binary | std::ios::trunc };
+    write_compiled_circuit(file, circuit);
+    file.close();
+    if (!file) {
+        throw SimulationError{ fmt::format("could not write compiled circuit file: {}", path.string()) };
+    }
+}
+
+[[nodiscard]] bool is_compiled_circuit(const std::filesystem::path& path) {
+    auto file = std::ifstream{ path, std::ios::binary };
+    return utils::read_binary<std::uint64_t>(file) == COMPILED_CIRCUIT_MAGIC_NUMBER && file;
+}
+
+[[nodiscard]] Circuit load_compiled_circuit(const std::filesystem::path& path) {
+#ifdef _WIN32
+    auto file = std::ifstream{ path, std::ios::binary };
+    if (!file) {
+        throw SimulationError{ fmt::format("could not read compiled circuit file: {}", path.string()) };
+    }
+    return read_compiled_circuit(file);
+#else
+    auto mapped_file = MappedFile{ path };
+    return decode_compiled_circuit(mapped_file.get_data());
+#endif
+}
+
+}  // namespace qx
@@ -0,0 +1,368 @@
+#include "qx/compressed_page_store.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>  // max, min
+#include <array>
+#include <bit>  // bit_cast, countl_zero, countr_zero
+#include <cassert>  // assert
+#include <cmath>  // abs, llround, sqrt
+#include <condition_variable>  // condition_variable, condition_variable_any
+#include <exception>  // current_exception, exception_ptr, rethrow_exception
+#include <functional>  // function
+#include <memory>  // make_unique
+#include <mutex>  // lock_guard, unique_lock
+#include <numeric>  // accumulate
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>  // move
+
+#include "qx/compile_time_configuration.hpp"  // COMPRESSED_BLOCK_SIZE
+
+namespace qx::core {
+
+//-----------------------//
+// CompressionStatistics //
+//-----------------------//
+
+[[nodiscard]] double CompressionStatistics::get_fidelity_loss() const {
+    auto overlap = std::max(0., 1 - error * error / 2);
+    return 1 - overlap * overlap;
+}
+
+CompressionStatistics& CompressionStatistics::merge(const CompressionStatistics& other) {
+    peak_bytes = std::max(peak_bytes, other.peak_bytes);
+    error = std::max(error, other.error);
+    return *this;
+}
+
+//---------------------//
+// CompressedPageStore //
+//---------------------//
+
+namespace {
+
+enum class BlockEncoding : std::uint8_t {
+    xor_with_previous,
+    quantized
+};
+
+// Quantized values are kept below 2^52 times the quantization step, so that they are exact as doubles
+constexpr double max_quantized_value = static_cast<double>(std::uint64_t{ 1 } << 52);
+
+// Bits appended to a byte vector, lowest bit first
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<std::uint8_t>& bytes)
+    : bytes_{ bytes } {}
+
+    void put(std::uint64_t value, std::size_t number_of_bits) {
+        while (number_of_bits > 0) {
+            if (used_bits_ == 0) {
+                bytes_.push_back(0);
+            }
+            auto n = std::min<std::size_t>(number_of_bits, 8 - used_bits_);
+            bytes_.back() |= static_cast<std::uint8_t>((value & ((1U << n) - 1)) << used_bits_);
+            value >>= n;
+            number_of_bits -= n;
+            used_bits_ = (used_bits_ + n) % 8;
+        }
+    }
+
+private:
+    std::vector<std::uint8_t>& bytes_;
+    std::size_t used_bits_ = 0;
+};
+
+// Bits read back from a byte vector written by a BitWriter
+class BitReader {
+public:
+    explicit BitReader(std::span<const std::uint8_t> bytes)
+    : bytes_{ bytes } {}
+
+    [[nodiscard]] std::uint64_t get(std::size_t number_of_bits) {
+        auto ret = std::uint64_t{ 0 };
+        auto shift = std::size_t{ 0 };
+        while (number_of_bits > 0) {
+            assert(position_ < bytes_.size());
+            auto n = std::min<std::size_t>(number_of_bits, 8 - used_bits_);
+            ret |= static_cast<std::uint64_t>((bytes_[position_] >> used_bits_) & ((1U << n) - 1)) << shift;
+            shift += n;
+            number_of_bits -= n;
+            used_bits_ += n;
+            if (used_bits_ == 8) {
+                used_bits_ = 0;
+                ++position_;
+            }
+        }
+        return ret;
+    }
+
+private:
+    std::span<const std::uint8_t> bytes_;
+    std::size_t position_ = 0;
+    std::size_t used_bits_ = 0;
+};
+
+// Every real or imaginary part is stored as its bits XORed with the ones of the same part of the previous amplitude:
+// a 0 bit if they are equal, or else a 1 bit, the number of leading zeros and of meaningful bits of the XOR,
+// and the meaningful bits
+void compress_lossless(std::span<const double> values, std::vector<std::uint8_t>& block) {
+    block.push_back(static_cast<std::uint8_t>(BlockEncoding::xor_with_previous));
+    auto writer = BitWriter{ block };
+    auto previous = std::array<std::uint64_t, 2>{};
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        auto bits = std::bit_cast<std::uint64_t>(values[i]);
+        auto difference = bits ^ previous[i % 2];
+        previous[i % 2] = bits;
+        if (difference == 0) {
+            writer.put(0, 1);
+            continue;
+        }
+        auto leading_zeros = static_cast<std::size_t>(std::countl_zero(difference));
+        auto trailing_zeros = static_cast<std::size_t>(std::countr_zero(difference));
+        auto length = 64 - leading_zeros - trailing_zeros;
+        writer.put(1, 1);
+        writer.put(leading_zeros, 6);
+        writer.put(length - 1, 6);
+        writer.put(difference >> trailing_zeros, length);
+    }
+}
+
+// Every value is rounded to a multiple of the step, and the multiple stored in zigzag encoding,
+// i.e., 2q for q >= 0 and -2q - 1 for q < 0, in as many bits as the largest one of the block needs
+// Return the squared norm of the rounding errors, or nothing if the values are too large to be quantized
+[[nodiscard]] std::optional<double> compress_quantized(
+    std::span<const double> values, double step, std::vector<std::uint8_t>& block) {
+    auto max_value = 0.;
+    for (auto value : values) {
+        max_value = std::max(max_value, std::abs(value));
+    }
+    if (!(max_value / step < max_quantized_value)) {
+        return std::nullopt;
+    }
+    auto quantized = std::vector<std::uint64_t>(values.size());
+    auto max_quantized = std::uint64_t{ 0 };
+    auto squared_error = 0.;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        auto q = static_cast<std::int64_t>(std::llround(values[i] / step));
+        auto error = values[i] - static_cast<double>(q) * step;
+        squared_error += error * error;
+        quantized[i] = (static_cast<std::uint64_t>(q) << 1) ^ static_cast<std::uint64_t>(q >> 63);
+        max_quantized = std::max(max_quantized, quantized[i]);
+    }
+    auto width = static_cast<std::size_t>(64 - std::countl_zero(max_quantized));
+    block.push_back(static_cast<std::uint8_t>(BlockEncoding::quantized));
+    block.push_back(static_cast<std::uint8_t>(width));
+    auto writer = BitWriter{ block };
+    for (auto q : quantized) {
+        writer.put(q, width);
+    }
+    return squared_error;
+}
+
+void decompress(std::span<const std::uint8_t> block, double step, std::span<double> values) {
+    assert(!block.empty());
+    if (static_cast<BlockEncoding>(block[0]) == BlockEncoding::quantized) {
+        auto width = static_cast<std::size_t>(block[1]);
+        auto reader = BitReader{ block.subspan(2) };
+        for (auto& value : values) {
+            auto zigzag = reader.get(width);
+            auto q = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+            value = static_cast<double>(q) * step;
+        }
+        return;
+    }
+    auto reader = BitReader{ block.subspan(1) };
+    auto previous = std::array<std::uint64_t, 2>{};
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (reader.get(1) != 0) {
+            auto leading_zeros = static_cast<std::size_t>(reader.get(6));
+            auto length = static_cast<std::size_t>(reader.get(6)) + 1;
+            previous[i % 2] ^= reader.get(length) << (64 - leading_zeros - length);
+        }
+        values[i] = std::bit_cast<double>(previous[i % 2]);
+    }
+}
+
+// The real and imaginary parts of the amplitudes, one after the other
+[[nodiscard]] std::span<const double> to_values(std::span<const std::complex<double>> amplitudes) {
+    return { reinterpret_cast<const double*>(amplitudes.data()), 2 * amplitudes.size() };
+}
+
+[[nodiscard]] std::span<double> to_values(std::span<std::complex<double>> amplitudes) {
+    return { reinterpret_cast<double*>(amplitudes.data()), 2 * amplitudes.size() };
+}
+
+}  // namespace
+
+// Threads waiting for jobs, so that pages are compressed without starting threads every time
+// Thread 0 is the calling thread, and threads 1 to number_of_threads - 1 are the workers of the pool
+class CompressedPageStore::WorkerPool {
+public:
+    explicit WorkerPool(std::size_t number_of_threads) {
+        workers_.reserve(number_of_threads - 1);
+        for (std::size_t thread = 1; thread < number_of_threads; ++thread) {
+            workers_.emplace_back([this, thread](std::stop_token stop_token) { work(stop_token, thread); });
+        }
+    }
+
+    // Call job(thread) for threads 0 to number_of_threads - 1, and wait for all of them
+    // Rethrow the first exception thrown by job
+    void run(std::size_t number_of_threads, const std::function<void(std::size_t)>& job) {
+        assert(number_of_threads <= workers_.size() + 1);
+        {
+            auto lock = std::lock_guard{ mutex_ };
+            job_ = &job;
+            number_of_threads_ = number_of_threads;
+            number_of_running_workers_ = number_of_threads - 1;
+            exception_ = nullptr;
+            ++generation_;
+        }
+        job_started_.notify_all();
+        auto exception = std::exception_ptr{};
+        try {
+            job(0);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        auto lock = std::unique_lock{ mutex_ };
+        job_done_.wait(lock, [this]() { return number_of_running_workers_ == 0; });
+        job_ = nullptr;
+        if (!exception) {
+            exception = exception_;
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+private:
+    void work(std::stop_token stop_token, std::size_t thread) {
+        auto generation = std::uint64_t{};
+        auto lock = std::unique_lock{ mutex_ };
+        while (job_started_.wait(lock, stop_token, [this, &generation]() { return generation_ != generation; })) {
+            generation = generation_;
+            if (thread >= number_of_threads_) {
+                continue;
+            }
+            const auto& job = *job_;
+            lock.unlock();
+            auto exception = std::exception_ptr{};
+            try {
+                job(thread);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            lock.lock();
+            if (exception && !exception_) {
+                exception_ = exception;
+            }
+            if (--number_of_running_workers_ == 0) {
+                job_done_.notify_one();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable_any job_started_;
+    std::condition_variable job_done_;
+    const std::function<void(std::size_t)>* job_ = nullptr;
+    std::size_t number_of_threads_ = 0;
+    std::size_t number_of_running_workers_ = 0;
+    std::uint64_t generation_ = 0;
+    std::exception_ptr exception_;
+    // Last, so that the workers are stopped and joined before the members they use are destroyed
+    std::vector<std::jthread> workers_;
+};
+
+CompressedPageStore::CompressedPageStore(double tolerance, std::size_t number_of_threads)
+: tolerance_{ tolerance }
+, number_of_threads_{ number_of_threads == 0 ? std::max(1U, std::thread::hardware_concurrency())
+                                             : number_of_threads } {
+    if (!(tolerance_ >= 0.)) {
+        throw PagedStateVectorError{ fmt::format("compression tolerance needs to be at least 0: {}", tolerance_) };
+    }
+    worker_pool_ = std::make_unique<WorkerPool>(number_of_threads_);
+}
+
+CompressedPageStore::~CompressedPageStore() = default;
+
+void CompressedPageStore::read(std::size_t page, std::span<std::complex<double>> amplitudes) {
+    auto number_of_blocks = (amplitudes.size() + config::COMPRESSED_BLOCK_SIZE - 1) / config::COMPRESSED_BLOCK_SIZE;
+    if (page >= pages_.size() || pages_[page].size() != number_of_blocks) {
+        throw PagedStateVectorError{ fmt::format("could not read page {} of a compressed page store", page) };
+    }
+    const auto& blocks = pages_[page];
+    for_each_block(number_of_blocks, [this, &blocks, amplitudes](std::size_t block) {
+        auto first = block * config::COMPRESSED_BLOCK_SIZE;
+        auto size = std::min(config::COMPRESSED_BLOCK_SIZE, amplitudes.size() - first);
+        decompress(blocks[block], 2 * tolerance_, to_values(amplitudes.subspan(first, size)));
+    });
+}
+
+void CompressedPageStore::write(std::size_t page, std::span<const std::complex<double>> amplitudes) {
+    auto number_of_blocks = (amplitudes.size() + config::COMPRESSED_BLOCK_SIZE - 1) / config::COMPRESSED_BLOCK_SIZE;
+    auto blocks = std::vector<block_t>(number_of_blocks);
+    auto squared_errors = std::vector<double>(number_of_blocks, 0.);
+    for_each_block(number_of_blocks, [this, &blocks, &squared_errors, amplitudes](std::size_t block) {
+        auto first = block * config::COMPRESSED_BLOCK_SIZE;
+        auto size = std::min(config::COMPRESSED_BLOCK_SIZE, amplitudes.size() - first);
+        auto values = to_values(amplitudes.subspan(first, size));
+        auto squared_error = tolerance_ > 0. ? compress_quantized(values, 2 * tolerance_, blocks[block]) : std::nullopt;
+        if (squared_error) {
+            squared_errors[block] = *squared_error;
+        } else {
+            compress_lossless(values, blocks[block]);
+        }
+        blocks[block].shrink_to_fit();
+    });
+    discard(page);
+    if (page >= pages_.size()) {
+        pages_.resize(page + 1);
+    }
+    for (const auto& block : blocks) {
+        size_ += block.size();
+    }
+    pages_[page] = std::move(blocks);
+    compression_statistics_.peak_bytes = std::max(compression_statistics_.peak_bytes, size_);
+    compression_statistics_.error += std::sqrt(std::accumulate(squared_errors.begin(), squared_errors.end(), 0.));
+}
+
+void CompressedPageStore::discard(std::size_t page) {
+    if (page >= pages_.size()) {
+        return;
+    }
+    for (const auto& block : pages_[page]) {
+        size_ -= block.size();
+    }
+    pages_[page] = {};
+}
+
+[[nodiscard]] const CompressionStatistics& CompressedPageStore::get_compression_statistics() const {
+    return compression_statistics_;
+}
+
+[[nodiscard]] std::uint64_t CompressedPageStore::get_size() const {
+    return size_;
+}
+
+// The calling thread takes its share of the blocks too, and is the only one used for a single block
+template <typename F>
+void CompressedPageStore::for_each_block(std::size_t number_of_blocks, F&& f) {
+    auto number_of_threads = std::min(number_of_threads_, number_of_blocks);
+    if (number_of_threads <= 1) {
+        for (std::size_t block = 0; block < number_of_blocks; ++block) {
+            f(block);
+        }
+        return;
+    }
+    worker_pool_->run(number_of_threads, [&f, number_of_threads, number_of_blocks](std::size_t thread) {
+        for (auto block = thread; block < number_of_blocks; block += number_of_threads) {
+            f(block);
+        }
+    });
+}
+
+}  // namespace qx::core
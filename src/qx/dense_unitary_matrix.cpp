@@ -2,6 +2,7 @@
 
 #include <algorithm>  // copy
 #include <unsupported/Eigen/MatrixFunctions>
+#include <utility>  // move
 
 namespace qx::core {
 
@@ -11,22 +12,24 @@ DenseUnitaryMatrix::DenseUnitaryMatrix(const Matrix& matrix, bool is_unitary_che
     if (is_unitary_check) {
         check_is_unitary();
     }
+    is_phase_gate_ = has_phase_gate_entries();
 }
 
 DenseUnitaryMatrix::DenseUnitaryMatrix(Matrix&& matrix, bool is_unitary_check)
-: matrix_{ matrix }
-, N{ matrix.size() } {
+: matrix_{ std::move(matrix) }
+, N{ matrix_.size() } {
     if (is_unitary_check) {
         check_is_unitary();
     }
+    is_phase_gate_ = has_phase_gate_entries();
 }
 
-[[nodiscard]] std::complex<double>& DenseUnitaryMatrix::at(std::size_t i, std::size_t j) {
+[[nodiscard]] const std::complex<double>& DenseUnitaryMatrix::at(std::size_t i, std::size_t j) const {
     return matrix_.at(i).at(j);
 }
 
-[[nodiscard]] const std::complex<double>& DenseUnitaryMatrix::at(std::size_t i, std::size_t j) const {
-    return matrix_.at(i).at(j);
+[[nodiscard]] std::size_t DenseUnitaryMatrix::size() const {
+    return N;
 }
 
 bool DenseUnitaryMatrix::operator==(const DenseUnitaryMatrix& other) const {
@@ -69,6 +72,21 @@ DenseUnitaryMatrix DenseUnitaryMatrix::operator*(const DenseUnitaryMatrix& other
     return DenseUnitaryMatrix{ std::move(matrix), false };
 }
 
+[[nodiscard]] bool DenseUnitaryMatrix::is_phase_gate() const {
+    return is_phase_gate_;
+}
+
+[[nodiscard]] bool DenseUnitaryMatrix::has_phase_gate_entries() const {
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            if (not is_null(i == j ? std::abs(matrix_[i][j]) - 1. : std::abs(matrix_[i][j]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 DenseUnitaryMatrix DenseUnitaryMatrix::dagger() const {
     Matrix matrix(N, Row(N));
     for (std::size_t i = 0; i < N; ++i) {
@@ -87,19 +105,20 @@ DenseUnitaryMatrix DenseUnitaryMatrix::power(double exponent) const {
     const auto& eigen_matrix = to_eigen_matrix(matrix_);
     Eigen::MatrixPower<Eigen::MatrixXcd> eigen_power_matrix(eigen_matrix);
     auto ret = from_eigen_matrix(eigen_power_matrix(exponent));
-    return DenseUnitaryMatrix{ ret, true };
+    return DenseUnitaryMatrix{ std::move(ret), true };
 }
 
 DenseUnitaryMatrix DenseUnitaryMatrix::control() const {
-    auto ret{ DenseUnitaryMatrix::identity(N * 2) };
-    std::size_t first_index = N;
-    std::size_t last_index = N * 2;
-    for (std::size_t i = first_index; i < last_index; ++i) {
-        for (std::size_t j = first_index; j < last_index; ++j) {
-            ret.at(i, j) = matrix_[i - first_index][j - first_index];
+    auto matrix = Matrix(N * 2, Row(N * 2));
+    for (std::size_t i = 0; i < N; ++i) {
+        matrix[i][i] = 1;
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            matrix[N + i][N + j] = matrix_[i][j];
         }
     }
-    return ret;
+    return DenseUnitaryMatrix{ std::move(matrix), false };
 }
 
 void DenseUnitaryMatrix::check_is_unitary() const {
@@ -0,0 +1,184 @@
+#include "qx/density_matrix.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>  // sort, transform
+#include <array>
+#include <complex>  // conj
+#include <functional>  // plus
+#include <numeric>  // accumulate
+#include <utility>  // move
+
+#include "qx/bit_groups.hpp"  // apply_to_bits, for_each_group
+
+namespace qx::core {
+
+DensityMatrixError::DensityMatrixError(const std::string& message)
+: std::runtime_error{ message } {}
+
+namespace {
+
+// Same convention as the rows and columns of gate matrices: bit k is the value of operand operands.size() - k - 1
+std::vector<std::size_t> get_positions(const operands_t& operands, std::size_t offset) {
+    auto ret = std::vector<std::size_t>(operands.size());
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        ret[k] = operands[operands.size() - k - 1].value + offset;
+    }
+    return ret;
+}
+
+}  // namespace
+
+DensityMatrix::DensityMatrix(std::size_t number_of_qubits)
+: number_of_qubits_{ number_of_qubits } {
+    if (number_of_qubits_ == 0) {
+        throw DensityMatrixError{ "number of qubits needs to be at least 1" };
+    }
+    if (number_of_qubits_ > config::MAX_DENSITY_MATRIX_QUBIT_NUMBER) {
+        throw DensityMatrixError{ fmt::format("number of qubits exceeds maximum allowed for a density matrix: {} > {}",
+            number_of_qubits_,
+            config::MAX_DENSITY_MATRIX_QUBIT_NUMBER) };
+    }
+    data_.resize(static_cast<std::size_t>(1) << (2 * number_of_qubits_), 0.);
+    data_[0] = 1.;
+}
+
+[[nodiscard]] std::size_t DensityMatrix::get_number_of_qubits() const {
+    return number_of_qubits_;
+}
+
+[[nodiscard]] std::complex<double> DensityMatrix::at(const BasisVector& row, const BasisVector& column) const {
+    return data_[(row.to_ulong() << number_of_qubits_) | column.to_ulong()];
+}
+
+[[nodiscard]] double DensityMatrix::trace() const {
+    auto diagonal = get_diagonal();
+    return std::accumulate(diagonal.begin(), diagonal.end(), 0.);
+}
+
+[[nodiscard]] std::vector<double> DensityMatrix::get_diagonal() const {
+    const auto dimension = static_cast<std::size_t>(1) << number_of_qubits_;
+    auto ret = std::vector<double>(dimension);
+    for (std::size_t i = 0; i < dimension; ++i) {
+        ret[i] = data_[i * (dimension + 1)].real();
+    }
+    return ret;
+}
+
+DensityMatrix& DensityMatrix::apply(const matrix_t& matrix, const operands_t& operands) {
+    apply_to_bits(data_, 2 * number_of_qubits_, get_positions(operands, number_of_qubits_), [&matrix](auto i, auto j) {
+        return matrix.at(i, j);
+    });
+    apply_to_bits(data_, 2 * number_of_qubits_, get_positions(operands, 0), [&matrix](auto i, auto j) {
+        return std::conj(matrix.at(i, j));
+    });
+    return *this;
+}
+
+DensityMatrix& DensityMatrix::apply_channel(const std::vector<Matrix>& kraus_operators, const operands_t& operands) {
+    const auto row_positions = get_positions(operands, number_of_qubits_);
+    const auto column_positions = get_positions(operands, 0);
+    auto apply_kraus_operator = [&](std::vector<std::complex<double>>& data, const Matrix& kraus_operator) {
+        apply_to_bits(data, 2 * number_of_qubits_, row_positions, [&kraus_operator](auto i, auto j) {
+            return kraus_operator[i][j];
+        });
+        apply_to_bits(data, 2 * number_of_qubits_, column_positions, [&kraus_operator](auto i, auto j) {
+            return std::conj(kraus_operator[i][j]);
+        });
+    };
+    if (kraus_operators.size() == 1) {
+        apply_kraus_operator(data_, kraus_operators[0]);
+        return *this;
+    }
+    auto result = std::vector<std::complex<double>>(data_.size(), 0.);
+    for (const auto& kraus_operator : kraus_operators) {
+        auto term = data_;
+        apply_kraus_operator(term, kraus_operator);
+        std::transform(result.begin(), result.end(), term.begin(), result.begin(), std::plus<>{});
+    }
+    data_ = std::move(result);
+    return *this;
+}
+
+// Every qubit q only mixes the 2x2 blocks of elements that differ in the row and column bits of q,
+// so E_q is applied to each block of the old density matrix through the 4x4 superoperator of E
+DensityMatrix& DensityMatrix::apply_channel_to_random_qubit(
+    double p, const std::vector<Matrix>& kraus_operators, const BasisVector& excluded_qubits) {
+    // superoperator[(a, b)][(c, d)] = sum_k K_k[a][c] conj(K_k[b][d])
+    auto superoperator = std::array<std::array<std::complex<double>, 4>, 4>{};
+    for (const auto& kraus_operator : kraus_operators) {
+        for (std::size_t a = 0; a < 2; ++a) {
+            for (std::size_t b = 0; b < 2; ++b) {
+                for (std::size_t c = 0; c < 2; ++c) {
+                    for (std::size_t d = 0; d < 2; ++d) {
+                        superoperator[2 * a + b][2 * c + d] += kraus_operator[a][c] * std::conj(kraus_operator[b][d]);
+                    }
+                }
+            }
+        }
+    }
+    const auto n = static_cast<double>(number_of_qubits_);
+    std::size_t number_of_excluded_qubits = 0;
+    excluded_qubits.for_each_set_bit([&number_of_excluded_qubits](auto) { ++number_of_excluded_qubits; });
+    const auto old_data = data_;
+    const auto weight = (1 - p) + p * static_cast<double>(number_of_excluded_qubits) / n;
+    std::transform(data_.begin(), data_.end(), data_.begin(), [weight](auto value) { return weight * value; });
+    for (std::size_t q = 0; q < number_of_qubits_; ++q) {
+        if (excluded_qubits.test(q)) {
+            continue;
+        }
+        const auto row_offset = static_cast<std::size_t>(1) << (number_of_qubits_ + q);
+        const auto column_offset = static_cast<std::size_t>(1) << q;
+        const auto offsets = std::array<std::size_t, 4>{ 0, column_offset, row_offset, row_offset | column_offset };
+        for_each_group(2 * number_of_qubits_, { number_of_qubits_ + q, q }, [&](std::size_t base) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                std::complex<double> value = 0.;
+                for (std::size_t j = 0; j < 4; ++j) {
+                    value += superoperator[i][j] * old_data[base | offsets[j]];
+                }
+                data_[base | offsets[i]] += p / n * value;
+            }
+        });
+    }
+    return *this;
+}
+
+[[nodiscard]] double DensityMatrix::get_probability_of_measuring_one(QubitIndex qubit_index) const {
+    auto diagonal = get_diagonal();
+    double ret = 0.;
+    for (std::size_t i = 0; i < diagonal.size(); ++i) {
+        if (BasisVector{ i }.test(qubit_index.value)) {
+            ret += diagonal[i];
+        }
+    }
+    return ret;
+}
+
+void DensityMatrix::update_data_after_measurement(
+    QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one) {
+    const auto factor = 1 / (measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one));
+    const auto row_bit = number_of_qubits_ + qubit_index.value;
+    const auto column_bit = qubit_index.value;
+    for (std::size_t i = 0; i < data_.size(); ++i) {
+        auto index = BasisVector{ i };
+        if (index.test(row_bit) == measured_state && index.test(column_bit) == measured_state) {
+            data_[i] *= factor;
+        } else {
+            data_[i] = 0.;
+        }
+    }
+}
+
+void DensityMatrix::apply_reset(QubitIndex qubit_index) {
+    const auto row_offset = static_cast<std::size_t>(1) << (number_of_qubits_ + qubit_index.value);
+    const auto column_offset = static_cast<std::size_t>(1) << qubit_index.value;
+    for_each_group(2 * number_of_qubits_, { number_of_qubits_ + qubit_index.value, qubit_index.value },
+        [this, row_offset, column_offset](std::size_t base) {
+            data_[base] += data_[base | row_offset | column_offset];
+            data_[base | row_offset] = 0.;
+            data_[base | column_offset] = 0.;
+            data_[base | row_offset | column_offset] = 0.;
+        });
+}
+
+}  // namespace qx::core
@@ -0,0 +1,274 @@
+#include "qx/distributed_state_vector.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>  // all_of, min, sort, upper_bound
+#include <bit>  // countr_zero, has_single_bit
+#include <cassert>  // assert
+#include <cmath>  // sqrt
+#include <iterator>  // distance
+#include <numeric>  // accumulate, iota, partial_sum
+#include <span>
+#include <utility>  // swap
+
+#include "qx/bit_groups.hpp"  // apply_to_bits, deposit_zeros
+#include "qx/compile_time_configuration.hpp"  // MAX_DISTRIBUTED_STATE_VECTOR_QUBIT_NUMBER
+
+namespace qx::core {
+
+DistributedStateVectorError::DistributedStateVectorError(const std::string& message)
+: std::runtime_error{ message } {}
+
+DistributedStateVector::DistributedStateVector(std::size_t number_of_qubits, Communicator& communicator)
+: number_of_qubits_{ number_of_qubits }
+, communicator_{ &communicator }
+, physical_bit_of_qubit_(number_of_qubits)
+, qubit_at_physical_bit_(number_of_qubits) {
+    auto number_of_ranks = communicator.get_size();
+    if (!std::has_single_bit(number_of_ranks)) {
+        throw DistributedStateVectorError{ fmt::format(
+            "number of processes needs to be a power of 2: {}", number_of_ranks) };
+    }
+    auto number_of_global_qubits = static_cast<std::size_t>(std::countr_zero(number_of_ranks));
+    if (number_of_qubits_ <= number_of_global_qubits) {
+        throw DistributedStateVectorError{ fmt::format(
+            "number of qubits needs to be larger than log2 of the number of processes: {} <= {}",
+            number_of_qubits_,
+            number_of_global_qubits) };
+    }
+    if (number_of_qubits_ > config::MAX_DISTRIBUTED_STATE_VECTOR_QUBIT_NUMBER) {
+        throw DistributedStateVectorError{ fmt::format(
+            "number of qubits exceeds maximum allowed for a distributed state vector: {} > {}",
+            number_of_qubits_,
+            config::MAX_DISTRIBUTED_STATE_VECTOR_QUBIT_NUMBER) };
+    }
+    number_of_local_qubits_ = number_of_qubits_ - number_of_global_qubits;
+    local_amplitudes_.resize(static_cast<std::size_t>(1) << number_of_local_qubits_, 0.);
+    if (communicator.get_rank() == 0) {
+        local_amplitudes_[0] = 1.;
+    }
+    std::iota(physical_bit_of_qubit_.begin(), physical_bit_of_qubit_.end(), 0);
+    std::iota(qubit_at_physical_bit_.begin(), qubit_at_physical_bit_.end(), 0);
+}
+
+[[nodiscard]] std::size_t DistributedStateVector::get_number_of_qubits() const {
+    return number_of_qubits_;
+}
+
+[[nodiscard]] std::size_t DistributedStateVector::get_number_of_local_qubits() const {
+    return number_of_local_qubits_;
+}
+
+[[nodiscard]] Communicator& DistributedStateVector::get_communicator() const {
+    return *communicator_;
+}
+
+[[nodiscard]] const std::vector<std::complex<double>>& DistributedStateVector::get_local_amplitudes() const {
+    return local_amplitudes_;
+}
+
+// The rank that stores the amplitude broadcasts it
+[[nodiscard]] std::complex<double> DistributedStateVector::get_amplitude(const MeasurementRegister& basis_vector) {
+    auto physical_index = to_physical_index(basis_vector);
+    auto owner = static_cast<std::size_t>(physical_index >> number_of_local_qubits_);
+    auto local_index = physical_index & (local_amplitudes_.size() - 1);
+    auto ret = communicator_->get_rank() == owner ? local_amplitudes_[local_index] : std::complex<double>{};
+    return communicator_->broadcast(ret, owner);
+}
+
+[[nodiscard]] double DistributedStateVector::get_norm() {
+    auto ret = std::accumulate(local_amplitudes_.begin(), local_amplitudes_.end(), 0., [](double sum, const auto& c) {
+        return sum + std::norm(c);
+    });
+    communicator_->all_reduce_sum(std::span{ &ret, 1 });
+    return std::sqrt(ret);
+}
+
+DistributedStateVector& DistributedStateVector::apply(const matrix_t& matrix, const operands_t& operands) {
+    assert(!operands.empty());
+    assert(std::all_of(operands.begin(), operands.end(), [this](auto qubit_index) {
+        return qubit_index.value < number_of_qubits_;
+    }) && "Operand refers to a non-existing qubit");
+
+    if (operands.size() > number_of_local_qubits_) {
+        throw DistributedStateVectorError{ fmt::format(
+            "gate on {} qubits needs at least as many qubits stored by every process: {}",
+            operands.size(),
+            number_of_local_qubits_) };
+    }
+    // Bring the operands stored at global bits to the highest local bits not used by the gate
+    auto is_used = std::vector<bool>(number_of_local_qubits_, false);
+    for (const auto& operand : operands) {
+        if (auto bit = physical_bit_of_qubit_[operand.value]; is_local(bit)) {
+            is_used[bit] = true;
+        }
+    }
+    auto free_bit = number_of_local_qubits_;
+    for (const auto& operand : operands) {
+        if (auto bit = physical_bit_of_qubit_[operand.value]; !is_local(bit)) {
+            do {
+                --free_bit;
+            } while (is_used[free_bit]);
+            is_used[free_bit] = true;
+            swap_bits(bit, free_bit);
+        }
+    }
+    // Same convention as the rows and columns of gate matrices: bit k is the value of operand operands.size() - k - 1
+    auto local_bits = std::vector<std::size_t>(operands.size());
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        local_bits[k] = physical_bit_of_qubit_[operands[operands.size() - k - 1].value];
+    }
+    apply_to_local_bits(matrix, local_bits);
+    return *this;
+}
+
+[[nodiscard]] double DistributedStateVector::get_probability_of_measuring_one(QubitIndex qubit_index) {
+    auto bit = physical_bit_of_qubit_[qubit_index.value];
+    auto ret = 0.;
+    if (is_local(bit)) {
+        for (std::size_t i = 0; i < local_amplitudes_.size(); ++i) {
+            if ((i >> bit) & 1) {
+                ret += std::norm(local_amplitudes_[i]);
+            }
+        }
+    } else if ((communicator_->get_rank() >> (bit - number_of_local_qubits_)) & 1) {
+        for (const auto& amplitude : local_amplitudes_) {
+            ret += std::norm(amplitude);
+        }
+    }
+    communicator_->all_reduce_sum(std::span{ &ret, 1 });
+    return ret;
+}
+
+// A qubit stored at a global bit has the same value for all the amplitudes of a rank
+void DistributedStateVector::update_data_after_measurement(
+    QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one) {
+    auto bit = physical_bit_of_qubit_[qubit_index.value];
+    auto probability = measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one);
+    auto factor = 1 / std::sqrt(probability);
+    auto rank_value = !is_local(bit) && ((communicator_->get_rank() >> (bit - number_of_local_qubits_)) & 1);
+    for (std::size_t i = 0; i < local_amplitudes_.size(); ++i) {
+        auto value = is_local(bit) ? static_cast<bool>((i >> bit) & 1) : rank_value;
+        local_amplitudes_[i] = value == measured_state ? local_amplitudes_[i] * factor : std::complex<double>{};
+    }
+}
+
+bool DistributedStateVector::measure(QubitIndex qubit_index, double random) {
+    random = communicator_->broadcast(random);
+    auto probability_of_measuring_one = get_probability_of_measuring_one(qubit_index);
+    auto ret = random < probability_of_measuring_one;
+    update_data_after_measurement(qubit_index, ret, probability_of_measuring_one);
+    return ret;
+}
+
+void DistributedStateVector::apply_reset(QubitIndex qubit_index, double random) {
+    static const auto x = matrix_t{ Matrix{ { 0, 1 }, { 1, 0 } } };
+    if (measure(qubit_index, random)) {
+        apply(x, { qubit_index });
+    }
+}
+
+// Every rank finds the samples that fall within its own amplitudes, in a single pass over them,
+// and the physical indices of all the samples are then summed over all the ranks
+[[nodiscard]] std::vector<MeasurementRegister> DistributedStateVector::sample(std::vector<double> randoms) {
+    communicator_->broadcast(std::as_writable_bytes(std::span{ randoms }), 0);
+    std::sort(randoms.begin(), randoms.end());
+
+    auto rank = communicator_->get_rank();
+    auto weights = std::vector<double>(communicator_->get_size(), 0.);
+    for (const auto& amplitude : local_amplitudes_) {
+        weights[rank] += std::norm(amplitude);
+    }
+    communicator_->all_reduce_sum(std::span{ weights });
+    auto cumulative_weights = std::vector<double>(weights.size());
+    std::partial_sum(weights.begin(), weights.end(), cumulative_weights.begin());
+    auto last_rank = weights.size() - 1;
+    while (last_rank > 0 && weights[last_rank] == 0.) {
+        --last_rank;
+    }
+    // Rounding errors may leave the last samples past the last amplitude
+    auto last_index = local_amplitudes_.size() - 1;
+    while (last_index > 0 && std::norm(local_amplitudes_[last_index]) == 0.) {
+        --last_index;
+    }
+
+    auto physical_indices = std::vector<std::uint64_t>(randoms.size(), 0);
+    auto local_index = std::size_t{ 0 };
+    auto cumulative_weight = rank == 0 ? 0. : cumulative_weights[rank - 1];
+    for (std::size_t j = 0; j < randoms.size(); ++j) {
+        auto random = randoms[j] * cumulative_weights.back();
+        auto owner = static_cast<std::size_t>(std::distance(cumulative_weights.begin(),
+            std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), random)));
+        if (std::min(owner, last_rank) != rank) {
+            continue;
+        }
+        while (local_index < local_amplitudes_.size() &&
+            cumulative_weight + std::norm(local_amplitudes_[local_index]) <= random) {
+            cumulative_weight += std::norm(local_amplitudes_[local_index]);
+            ++local_index;
+        }
+        auto index = std::min(local_index, last_index);
+        physical_indices[j] = (static_cast<std::uint64_t>(rank) << number_of_local_qubits_) | index;
+    }
+    communicator_->all_reduce_sum(std::span{ physical_indices });
+
+    auto ret = std::vector<MeasurementRegister>{};
+    ret.reserve(randoms.size());
+    for (auto physical_index : physical_indices) {
+        ret.push_back(to_basis_vector(physical_index));
+    }
+    return ret;
+}
+
+[[nodiscard]] std::uint64_t DistributedStateVector::to_physical_index(const MeasurementRegister& basis_vector) const {
+    auto ret = std::uint64_t{ 0 };
+    for (std::size_t qubit = 0; qubit < number_of_qubits_; ++qubit) {
+        ret |= static_cast<std::uint64_t>(basis_vector.test(qubit)) << physical_bit_of_qubit_[qubit];
+    }
+    return ret;
+}
+
+[[nodiscard]] MeasurementRegister DistributedStateVector::to_basis_vector(std::uint64_t physical_index) const {
+    auto ret = MeasurementRegister{ number_of_qubits_ };
+    for (std::size_t bit = 0; bit < number_of_qubits_; ++bit) {
+        ret.set(qubit_at_physical_bit_[bit], (physical_index >> bit) & 1);
+    }
+    return ret;
+}
+
+[[nodiscard]] bool DistributedStateVector::is_local(std::size_t physical_bit) const {
+    return physical_bit < number_of_local_qubits_;
+}
+
+// The amplitudes whose global bit and local bit differ move to the partner rank, at the same local index:
+// a rank whose global bit is b sends, and receives, the amplitudes whose local bit is !b
+void DistributedStateVector::swap_bits(std::size_t global_bit, std::size_t local_bit) {
+    assert(!is_local(global_bit) && is_local(local_bit));
+    auto rank = communicator_->get_rank();
+    auto rank_bit = global_bit - number_of_local_qubits_;
+    auto partner = rank ^ (static_cast<std::size_t>(1) << rank_bit);
+    auto moved_bit = static_cast<std::size_t>(((rank >> rank_bit) & 1) ^ 1) << local_bit;
+
+    auto positions = std::vector<std::size_t>{ local_bit };
+    auto send = std::vector<std::complex<double>>(local_amplitudes_.size() / 2);
+    for (std::size_t i = 0; i < send.size(); ++i) {
+        send[i] = local_amplitudes_[deposit_zeros(i, positions) | moved_bit];
+    }
+    auto receive = std::vector<std::complex<double>>(send.size());
+    communicator_->exchange(partner, std::span<const std::complex<double>>{ send }, std::span{ receive });
+    for (std::size_t i = 0; i < receive.size(); ++i) {
+        local_amplitudes_[deposit_zeros(i, positions) | moved_bit] = receive[i];
+    }
+
+    std::swap(qubit_at_physical_bit_[global_bit], qubit_at_physical_bit_[local_bit]);
+    physical_bit_of_qubit_[qubit_at_physical_bit_[global_bit]] = global_bit;
+    physical_bit_of_qubit_[qubit_at_physical_bit_[local_bit]] = local_bit;
+}
+
+void DistributedStateVector::apply_to_local_bits(const matrix_t& matrix, const std::vector<std::size_t>& local_bits) {
+    apply_to_bits(local_amplitudes_, number_of_local_qubits_, local_bits, [&matrix](auto i, auto j) {
+        return matrix.at(i, j);
+    });
+}
+
+}  // namespace qx::core
@@ -1,10 +1,21 @@
 #include "qx/error_models.hpp"
 
+#include <fmt/core.h>
+
+#include <array>
+#include <cmath>  // exp, sqrt
+#include <complex>
+#include <utility>  // move
+#include <vector>
+
+#include "qx/compile_time_configuration.hpp"  // EPSILON
 #include "qx/gates.hpp"
 #include "qx/random.hpp"
 
 namespace qx::error_models {
 
+using namespace std::complex_literals;
+
 DepolarizingChannel::DepolarizingChannel(double p)
 : probability{ p } {
     assert(0. <= p && p <= 1.);
@@ -27,4 +38,221 @@ void DepolarizingChannel::add_error(qx::core::QuantumState& quantum_state) const
     }
 }
 
+[[nodiscard]] std::size_t DepolarizingChannel::sample_number_of_error_free_instructions() const {
+    return random::random_geometric(probability);
+}
+
+void DepolarizingChannel::add_random_error(qx::core::QuantumState& quantum_state) const {
+    assert(quantum_state.get_number_of_qubits() > 0);
+
+    auto operand = std::vector<core::QubitIndex>{ core::QubitIndex{
+        random::random_integer(0, quantum_state.get_number_of_qubits() - 1) } };
+    static const auto paulis = std::array<const core::matrix_t*, 3>{ &gates::X, &gates::Y, &gates::Z };
+    quantum_state.apply(*paulis[random::random_integer(0, 2)], operand);
+}
+
+void DepolarizingChannel::add_error(
+    qx::core::DensityMatrix& density_matrix, const core::BasisVector& excluded_qubits) const {
+    // X, Y, or Z, each with probability 1/3, on a qubit picked at random
+    static const auto sqrt_one_third = std::sqrt(1. / 3);
+    static const auto kraus_operators = std::vector<core::Matrix>{
+        { { 0, sqrt_one_third }, { sqrt_one_third, 0 } },
+        { { 0, -1i * sqrt_one_third }, { 1i * sqrt_one_third, 0 } },
+        { { sqrt_one_third, 0 }, { 0, -sqrt_one_third } },
+    };
+    density_matrix.apply_channel_to_random_qubit(probability, kraus_operators, excluded_qubits);
+}
+
+ErrorModelError::ErrorModelError(const std::string& message)
+: std::runtime_error{ message } {}
+
+//--------------//
+// KrausChannel //
+//--------------//
+
+KrausChannel::KrausChannel(const std::vector<core::Matrix>& kraus_operators)
+: kraus_operators_{ kraus_operators } {
+    if (kraus_operators_.empty()) {
+        throw ErrorModelError{ "a Kraus channel needs at least one Kraus operator" };
+    }
+    auto sum = std::array<std::complex<double>, 3>{};
+    for (const auto& k : kraus_operators_) {
+        if (k.size() != 2 || k[0].size() != 2 || k[1].size() != 2) {
+            throw ErrorModelError{ "Kraus operators of a single-qubit channel have to be 2x2 matrices" };
+        }
+        auto effect = std::array<std::complex<double>, 3>{
+            std::norm(k[0][0]) + std::norm(k[1][0]),
+            std::norm(k[0][1]) + std::norm(k[1][1]),
+            std::conj(k[0][0]) * k[0][1] + std::conj(k[1][0]) * k[1][1],
+        };
+        has_diagonal_effects_ = has_diagonal_effects_ && core::is_null(effect[2]);
+        for (std::size_t i = 0; i < 3; ++i) {
+            sum[i] += effect[i];
+        }
+        effects_.push_back(effect);
+    }
+    if (core::is_not_null(sum[0] - 1.) || core::is_not_null(sum[1] - 1.) || core::is_not_null(sum[2])) {
+        throw ErrorModelError{ "Kraus operators do not preserve the trace" };
+    }
+}
+
+/* static */ [[nodiscard]] KrausChannel KrausChannel::amplitude_damping(double gamma) {
+    if (gamma < 0. || gamma > 1.) {
+        throw ErrorModelError{ fmt::format("invalid amplitude damping probability: {}", gamma) };
+    }
+    return KrausChannel{ {
+        { { 1, 0 }, { 0, std::sqrt(1 - gamma) } },
+        { { 0, std::sqrt(gamma) }, { 0, 0 } },
+    } };
+}
+
+/* static */ [[nodiscard]] KrausChannel KrausChannel::phase_damping(double lambda) {
+    if (lambda < 0. || lambda > 1.) {
+        throw ErrorModelError{ fmt::format("invalid phase damping probability: {}", lambda) };
+    }
+    return KrausChannel{ {
+        { { 1, 0 }, { 0, std::sqrt(1 - lambda) } },
+        { { 0, 0 }, { 0, std::sqrt(lambda) } },
+    } };
+}
+
+// The product of the phase damping and amplitude damping Kraus operators,
+// leaving out the one that is always null
+/* static */ [[nodiscard]] KrausChannel KrausChannel::thermal_relaxation(double t1, double t2, double gate_time) {
+    if (t1 <= 0. || t2 <= 0. || t2 > 2 * t1 || gate_time < 0.) {
+        throw ErrorModelError{ fmt::format(
+            "invalid thermal relaxation times: t1 = {}, t2 = {}, gate time = {}", t1, t2, gate_time) };
+    }
+    auto gamma = 1 - std::exp(-gate_time / t1);
+    // Amplitude damping already makes the coherences decay as exp(-gate_time / (2 * t1))
+    auto lambda = 1 - std::exp(-2 * gate_time / t2 + gate_time / t1);
+    return KrausChannel{ {
+        { { 1, 0 }, { 0, std::sqrt((1 - lambda) * (1 - gamma)) } },
+        { { 0, 0 }, { 0, std::sqrt(lambda * (1 - gamma)) } },
+        { { 0, std::sqrt(gamma) }, { 0, 0 } },
+    } };
+}
+
+[[nodiscard]] const std::vector<core::Matrix>& KrausChannel::get_kraus_operators() const {
+    return kraus_operators_;
+}
+
+// <psi|K_k^dagger K_k|psi> = e_00 p_0 + e_11 p_1 + 2 Re(e_01 rho_10)
+// Without coherence terms, only the probability of measuring one is needed;
+// otherwise K_k is applied to a copy of the state
+[[nodiscard]] double KrausChannel::get_probability(
+    std::size_t k, core::QuantumState& quantum_state, core::QubitIndex qubit_index) const {
+    if (has_diagonal_effects_) {
+        auto probability_of_measuring_one = quantum_state.get_probability_of_measuring_one(qubit_index);
+        return effects_[k][0].real() * (1 - probability_of_measuring_one) +
+            effects_[k][1].real() * probability_of_measuring_one;
+    }
+    auto copy = quantum_state;
+    copy.apply(core::matrix_t{ kraus_operators_[k], false }, { qubit_index });
+    double ret = 0.;
+    copy.for_each([&ret](const auto& kv) { ret += std::norm(kv.second.value); });
+    return ret;
+}
+
+void KrausChannel::apply(core::QuantumState& quantum_state, core::QubitIndex qubit_index, double random) const {
+    std::size_t picked = 0;
+    double picked_probability = 0.;
+    double cumulative_probability = 0.;
+    for (std::size_t k = 0; k < kraus_operators_.size(); ++k) {
+        auto probability = get_probability(k, quantum_state, qubit_index);
+        if (probability <= config::EPSILON) {
+            continue;
+        }
+        picked = k;
+        picked_probability = probability;
+        cumulative_probability += probability;
+        if (random < cumulative_probability) {
+            break;
+        }
+    }
+    auto factor = 1 / std::sqrt(picked_probability);
+    const auto& k = kraus_operators_[picked];
+    quantum_state.apply(core::matrix_t{ core::Matrix{ { factor * k[0][0], factor * k[0][1] },
+                                                      { factor * k[1][0], factor * k[1][1] } },
+                            false },
+        { qubit_index });
+}
+
+void KrausChannel::apply(core::DensityMatrix& density_matrix, core::QubitIndex qubit_index) const {
+    density_matrix.apply_channel(kraus_operators_, { qubit_index });
+}
+
+//------------//
+// NoiseModel //
+//------------//
+
+NoiseModel& NoiseModel::add_gate_error(const std::string& gate_name, KrausChannel channel) {
+    gate_errors_[gate_name].push_back(std::move(channel));
+    return *this;
+}
+
+NoiseModel& NoiseModel::add_qubit_error(core::QubitIndex qubit_index, KrausChannel channel) {
+    if (qubit_errors_.size() <= qubit_index.value) {
+        qubit_errors_.resize(qubit_index.value + 1);
+    }
+    qubit_errors_[qubit_index.value].push_back(std::move(channel));
+    return *this;
+}
+
+NoiseModel& NoiseModel::add_readout_error(core::QubitIndex qubit_index, ReadoutError readout_error) {
+    if (readout_errors_.size() <= qubit_index.value) {
+        readout_errors_.resize(qubit_index.value + 1);
+    }
+    readout_errors_[qubit_index.value] = readout_error;
+    return *this;
+}
+
+[[nodiscard]] bool NoiseModel::has_readout_errors() const {
+    return !readout_errors_.empty();
+}
+
+template <typename F>
+void NoiseModel::for_each_channel(const std::string& gate_name, const core::operands_t& operands, F&& f) const {
+    if (auto it = gate_errors_.find(gate_name); it != gate_errors_.end()) {
+        for (const auto& qubit_index : operands) {
+            for (const auto& channel : it->second) {
+                f(channel, qubit_index);
+            }
+        }
+    }
+    for (const auto& qubit_index : operands) {
+        if (qubit_index.value < qubit_errors_.size()) {
+            for (const auto& channel : qubit_errors_[qubit_index.value]) {
+                f(channel, qubit_index);
+            }
+        }
+    }
+}
+
+void NoiseModel::add_gate_error(
+    core::QuantumState& quantum_state, const std::string& gate_name, const core::operands_t& operands) const {
+    for_each_channel(gate_name, operands, [&quantum_state](const auto& channel, auto qubit_index) {
+        channel.apply(quantum_state, qubit_index, random::random_zero_one_double());
+    });
+}
+
+void NoiseModel::add_gate_error(
+    core::DensityMatrix& density_matrix, const std::string& gate_name, const core::operands_t& operands) const {
+    for_each_channel(gate_name, operands, [&density_matrix](const auto& channel, auto qubit_index) {
+        channel.apply(density_matrix, qubit_index);
+    });
+}
+
+[[nodiscard]] bool NoiseModel::add_readout_error(core::QubitIndex qubit_index, bool measured_value) const {
+    if (qubit_index.value >= readout_errors_.size()) {
+        return measured_value;
+    }
+    const auto& readout_error = readout_errors_[qubit_index.value];
+    auto probability_of_flipping = measured_value ? readout_error.probability_of_reading_zero_for_one
+                                                  : readout_error.probability_of_reading_one_for_zero;
+    return (probability_of_flipping > 0. && random::random_zero_one_double() < probability_of_flipping)
+        ? !measured_value
+        : measured_value;
+}
+
 }  // namespace qx::error_models
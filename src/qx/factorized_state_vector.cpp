@@ -0,0 +1,128 @@
+#include "qx/factorized_state_vector.hpp"
+
+#include <algorithm>  // max
+#include <cstddef>  // ptrdiff_t
+#include <utility>  // move
+
+#include "qx/gates.hpp"  // X
+
+namespace qx::core {
+
+FactorizedStateVectorError::FactorizedStateVectorError(const std::string& message)
+: std::runtime_error{ message } {}
+
+FactorizedStateVector::FactorizedStateVector(std::size_t number_of_qubits, SparseArrayLayout layout)
+: number_of_qubits_{ number_of_qubits }
+, layout_{ layout }
+, factor_of_qubit_(number_of_qubits)
+, qubit_in_factor_(number_of_qubits, 0) {
+    if (number_of_qubits_ == 0) {
+        throw FactorizedStateVectorError{ "number of qubits needs to be at least 1" };
+    }
+    factors_.reserve(number_of_qubits_);
+    for (std::size_t qubit = 0; qubit < number_of_qubits_; ++qubit) {
+        factor_of_qubit_[qubit] = qubit;
+        factors_.push_back(Factor{ QuantumState{ 1, 0, layout_ }, { qubit } });
+    }
+}
+
+[[nodiscard]] std::size_t FactorizedStateVector::get_number_of_qubits() const {
+    return number_of_qubits_;
+}
+
+[[nodiscard]] std::size_t FactorizedStateVector::get_number_of_factors() const {
+    return factors_.size();
+}
+
+[[nodiscard]] std::size_t FactorizedStateVector::get_factor_size(QubitIndex qubit_index) const {
+    return factors_[factor_of_qubit_[qubit_index.value]].qubits.size();
+}
+
+[[nodiscard]] std::size_t FactorizedStateVector::get_largest_factor_size() const {
+    return largest_factor_size_;
+}
+
+FactorizedStateVector& FactorizedStateVector::apply(const matrix_t& matrix, const operands_t& operands) {
+    auto& factor = factors_[merge_factors(operands)];
+    auto factor_operands = operands_t{};
+    factor_operands.reserve(operands.size());
+    for (const auto& operand : operands) {
+        factor_operands.push_back(QubitIndex{ qubit_in_factor_[operand.value] });
+    }
+    factor.state.apply(matrix, factor_operands);
+    return *this;
+}
+
+// A merged factor is replaced by the last one, so that the indices of the other factors do not change
+std::size_t FactorizedStateVector::merge_factors(const operands_t& operands) {
+    auto target = factor_of_qubit_[operands[0].value];
+    for (const auto& operand : operands) {
+        auto source = factor_of_qubit_[operand.value];
+        if (source == target) {
+            continue;
+        }
+        auto& factor = factors_[target];
+        factor.state = factor.state.tensor_product(factors_[source].state);
+        for (auto qubit : factors_[source].qubits) {
+            factor_of_qubit_[qubit] = target;
+            qubit_in_factor_[qubit] = factor.qubits.size();
+            factor.qubits.push_back(qubit);
+        }
+        largest_factor_size_ = std::max(largest_factor_size_, factor.qubits.size());
+        if (source != factors_.size() - 1) {
+            if (target == factors_.size() - 1) {
+                target = source;
+            }
+            factors_[source] = std::move(factors_.back());
+            for (auto qubit : factors_[source].qubits) {
+                factor_of_qubit_[qubit] = source;
+            }
+        }
+        factors_.pop_back();
+    }
+    return target;
+}
+
+void FactorizedStateVector::split_qubit(QubitIndex qubit_index, bool value) {
+    auto& factor = factors_[factor_of_qubit_[qubit_index.value]];
+    if (factor.qubits.size() == 1) {
+        return;
+    }
+    auto index = qubit_in_factor_[qubit_index.value];
+    factor.state = factor.state.remove_qubit(QubitIndex{ index });
+    factor.qubits.erase(factor.qubits.begin() + static_cast<std::ptrdiff_t>(index));
+    for (auto i = index; i < factor.qubits.size(); ++i) {
+        qubit_in_factor_[factor.qubits[i]] = i;
+    }
+    auto state = QuantumState{ 1, 0, layout_ };
+    if (value) {
+        state.apply(gates::X, operands_t{ QubitIndex{ 0 } });
+    }
+    factor_of_qubit_[qubit_index.value] = factors_.size();
+    qubit_in_factor_[qubit_index.value] = 0;
+    factors_.push_back(Factor{ std::move(state), { qubit_index.value } });
+}
+
+[[nodiscard]] double FactorizedStateVector::get_probability_of_measuring_one(QubitIndex qubit_index) {
+    return factors_[factor_of_qubit_[qubit_index.value]].state.get_probability_of_measuring_one(
+        QubitIndex{ qubit_in_factor_[qubit_index.value] });
+}
+
+void FactorizedStateVector::update_data_after_measurement(
+    QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one) {
+    factors_[factor_of_qubit_[qubit_index.value]].state.update_data_after_measurement(
+        QubitIndex{ qubit_in_factor_[qubit_index.value] }, measured_state, probability_of_measuring_one);
+    split_qubit(qubit_index, measured_state);
+}
+
+void FactorizedStateVector::apply_reset(QubitIndex qubit_index, double random) {
+    auto probability_of_measuring_one = get_probability_of_measuring_one(qubit_index);
+    auto measured_state = random < probability_of_measuring_one;
+    update_data_after_measurement(qubit_index, measured_state, probability_of_measuring_one);
+    // The qubit is now in a factor of its own
+    if (measured_state) {
+        apply(gates::X, operands_t{ qubit_index });
+    }
+}
+
+}  // namespace qx::core
@@ -1,21 +1,121 @@
 #include "qx/instructions.hpp"
 
+#include <algorithm>  // all_of, move
+#include <iterator>  // back_inserter
+#include <utility>  // move
+#include <variant>  // visit
+
+#include "qx/compile_time_configuration.hpp"  // EPSILON
 #include "qx/random.hpp"
 
 namespace qx {
 
+void Instruction::execute_branches(SimulationBranches& branches) {
+    for (auto& branch : branches) {
+        execute(branch.context);
+    }
+}
+
+namespace {
+
+// Only the branches whose control bits are all set go through execute
+template <typename Branches, typename GetMeasurementRegister, typename Execute>
+void execute_controlled_branches(const BitControlledInstruction& instruction, Branches& branches,
+    GetMeasurementRegister&& get_measurement_register, Execute&& execute) {
+    auto controlled_branches = Branches{};
+    auto uncontrolled_branches = Branches{};
+    for (auto& branch : branches) {
+        (instruction.are_all_control_bits_set(get_measurement_register(branch)) ? controlled_branches
+                                                                                : uncontrolled_branches)
+            .push_back(std::move(branch));
+    }
+    execute(controlled_branches);
+    branches = std::move(uncontrolled_branches);
+    std::move(controlled_branches.begin(), controlled_branches.end(), std::back_inserter(branches));
+}
+
+// Split every branch into the branches where the qubit is measured as 0 and as 1,
+// leaving out the outcomes that are not possible
+template <typename Branches, typename GetProbabilityOfMeasuringOne, typename Collapse>
+void split_branches(
+    Branches& branches, GetProbabilityOfMeasuringOne&& get_probability_of_measuring_one, Collapse&& collapse) {
+    auto new_branches = Branches{};
+    new_branches.reserve(2 * branches.size());
+    for (auto& branch : branches) {
+        auto probability_of_measuring_one = get_probability_of_measuring_one(branch);
+        auto can_measure_one = probability_of_measuring_one > config::EPSILON;
+        auto can_measure_zero = 1 - probability_of_measuring_one > config::EPSILON;
+        if (can_measure_zero && can_measure_one) {
+            new_branches.push_back(collapse(branch, false, probability_of_measuring_one));
+        }
+        new_branches.push_back(collapse(std::move(branch), can_measure_one, probability_of_measuring_one));
+    }
+    branches = std::move(new_branches);
+}
+
+// Call f on the context of the backend, whichever it is
+template <typename F>
+void visit_backend_context(BackendContextPtr context, F&& f) {
+    std::visit([&f](auto* backend_context) { f(*backend_context); }, context);
+}
+
+// Sample the outcome of measuring a qubit, and collapse the state accordingly
+// States that can measure a qubit in one pass, e.g., distributed or paged state vectors, do so
+template <typename State>
+bool sample_measure(State& state, core::QubitIndex qubit_index) {
+    if constexpr (requires { state.measure(qubit_index, 0.); }) {
+        return state.measure(qubit_index, random::random_zero_one_double());
+    } else {
+        auto probability_of_measuring_one = state.get_probability_of_measuring_one(qubit_index);
+        auto measured_state = random::random_zero_one_double() < probability_of_measuring_one;
+        state.update_data_after_measurement(qubit_index, measured_state, probability_of_measuring_one);
+        return measured_state;
+    }
+}
+
+}  // namespace
+
 BitControlledInstruction::BitControlledInstruction(ControlBits control_bits, std::shared_ptr<Instruction> instruction)
 : control_bits{ std::move(control_bits) }
 , instruction{ std::move(instruction) } {}
 
+[[nodiscard]] bool BitControlledInstruction::are_all_control_bits_set(
+    const core::MeasurementRegister& measurement_register) const {
+    auto is_bit_set = [&measurement_register](
+                          const auto& control_bit) { return measurement_register.test(control_bit.value); };
+    return std::all_of(control_bits.begin(), control_bits.end(), is_bit_set);
+}
+
 void BitControlledInstruction::execute(SimulationIterationContext& context) {
-    auto is_bit_set = [&context](
-                          const auto& control_bit) { return context.measurement_register.test(control_bit.value); };
-    if (std::all_of(control_bits.begin(), control_bits.end(), is_bit_set)) {
+    if (are_all_control_bits_set(context.measurement_register)) {
         instruction->execute(context);
     }
 }
 
+void BitControlledInstruction::execute_branches(SimulationBranches& branches) {
+    execute_controlled_branches(
+        *this,
+        branches,
+        [](const auto& branch) -> const auto& { return branch.context.measurement_register; },
+        [this](auto& controlled_branches) { instruction->execute_branches(controlled_branches); });
+}
+
+void BitControlledInstruction::execute_density_matrix_branches(DensityMatrixBranches& branches) {
+    execute_controlled_branches(
+        *this,
+        branches,
+        [](const auto& branch) -> const auto& { return branch.measurement_register; },
+        [this](auto& controlled_branches) { instruction->execute_density_matrix_branches(controlled_branches); });
+}
+
+void BitControlledInstruction::execute_backend(BackendContextPtr context) {
+    visit_backend_context(context, [this, context](const auto& backend_context) {
+        if (are_all_control_bits_set(backend_context.measurement_register)) {
+            instruction->execute_backend(context);
+        }
+    });
+}
+
 [[nodiscard]] qubit_indices_t BitControlledInstruction::get_qubit_indices() {
     return instruction->get_qubit_indices();
 }
@@ -24,14 +124,26 @@ void BitControlledInstruction::execute(SimulationIterationContext& context) {
     return instruction->get_bit_indices();
 }
 
-Unitary::Unitary(std::shared_ptr<core::matrix_t> matrix, std::shared_ptr<core::operands_t> operands)
+Unitary::Unitary(
+    std::shared_ptr<core::matrix_t> matrix, std::shared_ptr<core::operands_t> operands, std::string name)
 : matrix{ std::move(matrix) }
-, operands{ std::move(operands) } {}
+, operands{ std::move(operands) }
+, name{ std::move(name) } {}
 
 void Unitary::execute(SimulationIterationContext& context) {
     context.state.apply(*matrix, *operands);
 }
 
+void Unitary::execute_density_matrix_branches(DensityMatrixBranches& branches) {
+    for (auto& branch : branches) {
+        branch.density_matrix.apply(*matrix, *operands);
+    }
+}
+
+void Unitary::execute_backend(BackendContextPtr context) {
+    visit_backend_context(context, [this](auto& backend_context) { backend_context.state.apply(*matrix, *operands); });
+}
+
 [[nodiscard]] std::shared_ptr<core::matrix_t> Unitary::inverse() const {
     return std::make_shared<core::matrix_t>(matrix->inverse());
 }
@@ -64,6 +176,43 @@ void Measure::execute(SimulationIterationContext& context) {
         context.bit_measurement_register);
 }
 
+void Measure::execute_branches(SimulationBranches& branches) {
+    split_branches(
+        branches,
+        [this](auto& branch) { return branch.context.state.get_probability_of_measuring_one(qubit_index); },
+        [this](SimulationBranch branch, bool measured_state, double probability_of_measuring_one) {
+            branch.probability *= measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one);
+            branch.context.state.update_data_after_measurement(
+                qubit_index, measured_state, probability_of_measuring_one);
+            branch.context.measurement_register.set(qubit_index.value, measured_state);
+            branch.context.bit_measurement_register.set(bit_index.value, measured_state);
+            return branch;
+        });
+}
+
+void Measure::execute_density_matrix_branches(DensityMatrixBranches& branches) {
+    split_branches(
+        branches,
+        [this](auto& branch) { return branch.density_matrix.get_probability_of_measuring_one(qubit_index); },
+        [this](DensityMatrixBranch branch, bool measured_state, double probability_of_measuring_one) {
+            branch.probability *= measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one);
+            branch.density_matrix.update_data_after_measurement(
+                qubit_index, measured_state, probability_of_measuring_one);
+            branch.measurement_register.set(qubit_index.value, measured_state);
+            branch.bit_measurement_register.set(bit_index.value, measured_state);
+            return branch;
+        });
+}
+
+void Measure::execute_backend(BackendContextPtr context) {
+    visit_backend_context(context, [this](auto& backend_context) {
+        auto measured_state = sample_measure(backend_context.state, qubit_index);
+        backend_context.measurement_register.set(qubit_index.value, measured_state);
+        backend_context.bit_measurement_register.set(bit_index.value, measured_state);
+        backend_context.has_sampled_outcomes = true;
+    });
+}
+
 [[nodiscard]] qubit_indices_t Measure::get_qubit_indices() {
     return qubit_indices_t{ qubit_index };
 }
@@ -79,6 +228,19 @@ void Reset::execute(SimulationIterationContext& context) {
     context.state.apply_reset(qubit_index);
 }
 
+void Reset::execute_density_matrix_branches(DensityMatrixBranches& branches) {
+    for (auto& branch : branches) {
+        branch.density_matrix.apply_reset(qubit_index);
+    }
+}
+
+void Reset::execute_backend(BackendContextPtr context) {
+    visit_backend_context(context, [this](auto& backend_context) {
+        backend_context.state.apply_reset(qubit_index, random::random_zero_one_double());
+        backend_context.has_sampled_outcomes = true;
+    });
+}
+
 [[nodiscard]] qubit_indices_t Reset::get_qubit_indices() {
     return qubit_indices_t{ qubit_index };
 }
@@ -0,0 +1,236 @@
+#include "qx/matrix_product_state.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>  // all_of, clamp, max, min
+#include <cassert>  // assert
+#include <cmath>  // sqrt
+#include <numeric>  // iota
+#include <utility>  // move, swap
+
+namespace qx::core {
+
+MatrixProductStateError::MatrixProductStateError(const std::string& message)
+: std::runtime_error{ message } {}
+
+MatrixProductState::MatrixProductState(
+    std::size_t number_of_qubits, std::size_t max_bond_dimension, double truncation_threshold)
+: number_of_qubits_{ number_of_qubits }
+, max_bond_dimension_{ max_bond_dimension }
+, truncation_threshold_{ truncation_threshold }
+, sites_(number_of_qubits, Site{ Eigen::MatrixXcd::Ones(1, 1), Eigen::MatrixXcd::Zero(1, 1) })
+, site_of_qubit_(number_of_qubits)
+, qubit_at_site_(number_of_qubits) {
+    if (number_of_qubits_ == 0) {
+        throw MatrixProductStateError{ "number of qubits needs to be at least 1" };
+    }
+    if (max_bond_dimension_ == 0) {
+        throw MatrixProductStateError{ "maximum bond dimension needs to be at least 1" };
+    }
+    if (truncation_threshold_ < 0. || truncation_threshold_ >= 1.) {
+        throw MatrixProductStateError{ fmt::format("invalid truncation threshold: {}", truncation_threshold_) };
+    }
+    std::iota(site_of_qubit_.begin(), site_of_qubit_.end(), 0);
+    std::iota(qubit_at_site_.begin(), qubit_at_site_.end(), 0);
+}
+
+[[nodiscard]] std::size_t MatrixProductState::get_number_of_qubits() const {
+    return number_of_qubits_;
+}
+
+[[nodiscard]] std::size_t MatrixProductState::get_bond_dimension() const {
+    auto ret = Eigen::Index{ 1 };
+    for (const auto& site : sites_) {
+        ret = std::max(ret, site[0].cols());
+    }
+    return static_cast<std::size_t>(ret);
+}
+
+[[nodiscard]] double MatrixProductState::get_truncation_error() const {
+    return truncation_error_;
+}
+
+[[nodiscard]] std::complex<double> MatrixProductState::get_amplitude(const MeasurementRegister& basis_vector) const {
+    Eigen::MatrixXcd product = Eigen::MatrixXcd::Ones(1, 1);
+    for (std::size_t site = 0; site < number_of_qubits_; ++site) {
+        product = product * sites_[site][basis_vector.test(qubit_at_site_[site]) ? 1 : 0];
+    }
+    return product(0, 0);
+}
+
+MatrixProductState& MatrixProductState::apply(const matrix_t& matrix, const operands_t& operands) {
+    assert(!operands.empty());
+    assert(std::all_of(operands.begin(), operands.end(), [this](auto qubit_index) {
+        return qubit_index.value < number_of_qubits_;
+    }) && "Operand refers to a non-existing qubit");
+
+    // A single-qubit gate keeps the canonical form, as it only mixes the two matrices of a site
+    if (operands.size() == 1) {
+        auto& site = sites_[site_of_qubit_[operands[0].value]];
+        Eigen::MatrixXcd zero = matrix.at(0, 0) * site[0] + matrix.at(0, 1) * site[1];
+        site[1] = matrix.at(1, 0) * site[0] + matrix.at(1, 1) * site[1];
+        site[0] = std::move(zero);
+        return *this;
+    }
+    // Bubble the operands, in order, down to the sites following the lowest of their sites
+    auto first_site = number_of_qubits_;
+    for (const auto& operand : operands) {
+        first_site = std::min(first_site, site_of_qubit_[operand.value]);
+    }
+    for (std::size_t i = 0; i < operands.size(); ++i) {
+        for (auto site = site_of_qubit_[operands[i].value]; site > first_site + i; --site) {
+            swap_sites(site - 1);
+        }
+    }
+    apply_to_sites(first_site, operands.size(), matrix);
+    return *this;
+}
+
+[[nodiscard]] double MatrixProductState::get_probability_of_measuring_one(QubitIndex qubit_index) {
+    auto site = site_of_qubit_[qubit_index.value];
+    move_center_to(site);
+    auto norm_of_one = sites_[site][1].squaredNorm();
+    return norm_of_one / (sites_[site][0].squaredNorm() + norm_of_one);
+}
+
+// Only the site of the qubit changes, as the center is moved to it
+void MatrixProductState::update_data_after_measurement(
+    QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one) {
+    auto site = site_of_qubit_[qubit_index.value];
+    move_center_to(site);
+    auto probability = measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one);
+    sites_[site][measured_state ? 1 : 0] /= std::sqrt(probability);
+    sites_[site][measured_state ? 0 : 1].setZero();
+}
+
+void MatrixProductState::apply_reset(QubitIndex qubit_index, double random) {
+    auto probability_of_measuring_one = get_probability_of_measuring_one(qubit_index);
+    auto measured_state = random < probability_of_measuring_one;
+    update_data_after_measurement(qubit_index, measured_state, probability_of_measuring_one);
+    if (measured_state) {
+        auto& site = sites_[site_of_qubit_[qubit_index.value]];
+        std::swap(site[0], site[1]);
+    }
+}
+
+// Moving the center right, the site is left-normalized by a QR decomposition of its matrices stacked vertically,
+// and R goes into the next site
+// Moving the center left, the site is right-normalized by an LQ decomposition of its matrices side by side,
+// and L goes into the previous site
+void MatrixProductState::move_center_to(std::size_t site) {
+    while (center_ < site) {
+        auto& current = sites_[center_];
+        auto& next = sites_[center_ + 1];
+        auto rows = current[0].rows();
+        Eigen::MatrixXcd stacked(2 * rows, current[0].cols());
+        stacked << current[0], current[1];
+        auto qr = Eigen::HouseholderQR<Eigen::MatrixXcd>{ stacked };
+        auto rank = std::min(stacked.rows(), stacked.cols());
+        Eigen::MatrixXcd q = qr.householderQ() * Eigen::MatrixXcd::Identity(stacked.rows(), rank);
+        Eigen::MatrixXcd r = qr.matrixQR().topRows(rank).triangularView<Eigen::Upper>();
+        current[0] = q.topRows(rows);
+        current[1] = q.bottomRows(rows);
+        next[0] = r * next[0];
+        next[1] = r * next[1];
+        ++center_;
+    }
+    while (center_ > site) {
+        auto& current = sites_[center_];
+        auto& previous = sites_[center_ - 1];
+        auto columns = current[0].cols();
+        Eigen::MatrixXcd side_by_side(current[0].rows(), 2 * columns);
+        side_by_side << current[0], current[1];
+        auto qr = Eigen::HouseholderQR<Eigen::MatrixXcd>{ side_by_side.adjoint() };
+        auto rank = std::min(side_by_side.rows(), side_by_side.cols());
+        Eigen::MatrixXcd q = qr.householderQ() * Eigen::MatrixXcd::Identity(side_by_side.cols(), rank);
+        Eigen::MatrixXcd l = qr.matrixQR().topRows(rank).triangularView<Eigen::Upper>().adjoint();
+        current[0] = q.topRows(columns).adjoint();
+        current[1] = q.bottomRows(columns).adjoint();
+        previous[0] = previous[0] * l;
+        previous[1] = previous[1] * l;
+        --center_;
+    }
+}
+
+void MatrixProductState::swap_sites(std::size_t site) {
+    static const auto swap = matrix_t{ Matrix{ { 1, 0, 0, 0 }, { 0, 0, 1, 0 }, { 0, 1, 0, 0 }, { 0, 0, 0, 1 } } };
+    apply_to_sites(site, 2, swap);
+    std::swap(qubit_at_site_[site], qubit_at_site_[site + 1]);
+    site_of_qubit_[qubit_at_site_[site]] = site;
+    site_of_qubit_[qubit_at_site_[site + 1]] = site + 1;
+}
+
+void MatrixProductState::apply_to_sites(std::size_t first_site, std::size_t number_of_sites, const matrix_t& matrix) {
+    auto last_site = first_site + number_of_sites - 1;
+    move_center_to(std::clamp(center_, first_site, last_site));
+
+    // Contract the sites: block[i] is the product of the matrices picked by the bits of i
+    auto block = std::vector<Eigen::MatrixXcd>{ sites_[first_site][0], sites_[first_site][1] };
+    for (auto site = first_site + 1; site <= last_site; ++site) {
+        auto contracted = std::vector<Eigen::MatrixXcd>(2 * block.size());
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            contracted[2 * i] = block[i] * sites_[site][0];
+            contracted[2 * i + 1] = block[i] * sites_[site][1];
+        }
+        block = std::move(contracted);
+    }
+
+    // Apply the matrix
+    auto result = std::vector<Eigen::MatrixXcd>(
+        block.size(), Eigen::MatrixXcd::Zero(block[0].rows(), block[0].cols()));
+    for (std::size_t i = 0; i < block.size(); ++i) {
+        for (std::size_t j = 0; j < block.size(); ++j) {
+            if (is_not_null(matrix.at(i, j))) {
+                result[i] += matrix.at(i, j) * block[j];
+            }
+        }
+    }
+
+    // Split the sites back, from left to right, so that the center ends at the last site
+    for (auto site = first_site; site < last_site; ++site) {
+        auto rest = result.size() / 2;
+        auto rows = result[0].rows();
+        auto columns = result[0].cols();
+        Eigen::MatrixXcd unfolded(2 * rows, static_cast<Eigen::Index>(rest) * columns);
+        for (std::size_t bit = 0; bit < 2; ++bit) {
+            for (std::size_t r = 0; r < rest; ++r) {
+                unfolded.block(static_cast<Eigen::Index>(bit) * rows, static_cast<Eigen::Index>(r) * columns, rows,
+                    columns) = result[bit * rest + r];
+            }
+        }
+        auto svd = Eigen::BDCSVD<Eigen::MatrixXcd>{ unfolded, Eigen::ComputeThinU | Eigen::ComputeThinV };
+        const auto& singular_values = svd.singularValues();
+        auto kept = get_number_of_kept_singular_values(singular_values);
+        Eigen::VectorXd kept_singular_values = singular_values.head(kept).normalized();
+        Eigen::MatrixXcd u = svd.matrixU().leftCols(kept);
+        sites_[site][0] = u.topRows(rows);
+        sites_[site][1] = u.bottomRows(rows);
+        Eigen::MatrixXcd remainder = kept_singular_values.asDiagonal() * svd.matrixV().leftCols(kept).adjoint();
+        result.resize(rest);
+        for (std::size_t r = 0; r < rest; ++r) {
+            result[r] = remainder.middleCols(static_cast<Eigen::Index>(r) * columns, columns);
+        }
+    }
+    sites_[last_site][0] = std::move(result[0]);
+    sites_[last_site][1] = std::move(result[1]);
+    center_ = last_site;
+}
+
+[[nodiscard]] Eigen::Index MatrixProductState::get_number_of_kept_singular_values(
+    const Eigen::VectorXd& singular_values) {
+    auto total_weight = singular_values.squaredNorm();
+    auto kept = std::min(singular_values.size(), static_cast<Eigen::Index>(max_bond_dimension_));
+    auto discarded_weight = singular_values.tail(singular_values.size() - kept).squaredNorm();
+    while (kept > 1) {
+        auto weight = singular_values[kept - 1] * singular_values[kept - 1];
+        if (discarded_weight + weight > truncation_threshold_ * total_weight) {
+            break;
+        }
+        discarded_weight += weight;
+        --kept;
+    }
+    truncation_error_ += discarded_weight / total_weight;
+    return kept;
+}
+
+}  // namespace qx::core
@@ -0,0 +1,86 @@
+#include "qx/mpi_communicator.hpp"
+
+#include <fmt/core.h>
+#include <mpi.h>
+
+#include <algorithm>  // min
+#include <climits>  // INT_MAX
+
+namespace qx::core {
+
+MpiError::MpiError(const std::string& message)
+: std::runtime_error{ message } {}
+
+namespace {
+
+void check(int error_code, const char* function_name) {
+    if (error_code != MPI_SUCCESS) {
+        throw MpiError{ fmt::format("{} failed with error code {}", function_name, error_code) };
+    }
+}
+
+// MPI counts are ints, so large buffers are sent in chunks of at most INT_MAX bytes
+constexpr std::size_t MAX_CHUNK_SIZE = INT_MAX;
+
+int to_int(std::size_t value) {
+    return static_cast<int>(value);
+}
+
+}  // namespace
+
+MpiCommunicator::MpiCommunicator(int* argc, char*** argv) {
+    int is_initialized = 0;
+    check(MPI_Initialized(&is_initialized), "MPI_Initialized");
+    if (!is_initialized) {
+        check(MPI_Init(argc, argv), "MPI_Init");
+        has_initialized_ = true;
+    }
+    int rank = 0;
+    int size = 0;
+    check(MPI_Comm_rank(MPI_COMM_WORLD, &rank), "MPI_Comm_rank");
+    check(MPI_Comm_size(MPI_COMM_WORLD, &size), "MPI_Comm_size");
+    rank_ = static_cast<std::size_t>(rank);
+    size_ = static_cast<std::size_t>(size);
+}
+
+MpiCommunicator::~MpiCommunicator() {
+    if (has_initialized_) {
+        MPI_Finalize();
+    }
+}
+
+[[nodiscard]] std::size_t MpiCommunicator::get_rank() const {
+    return rank_;
+}
+
+[[nodiscard]] std::size_t MpiCommunicator::get_size() const {
+    return size_;
+}
+
+void MpiCommunicator::exchange(std::size_t partner, std::span<const std::byte> send, std::span<std::byte> receive) {
+    for (std::size_t offset = 0; offset < send.size(); offset += MAX_CHUNK_SIZE) {
+        auto count = to_int(std::min(MAX_CHUNK_SIZE, send.size() - offset));
+        check(MPI_Sendrecv(send.data() + offset, count, MPI_BYTE, to_int(partner), 0,
+                  receive.data() + offset, count, MPI_BYTE, to_int(partner), 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE),
+            "MPI_Sendrecv");
+    }
+}
+
+void MpiCommunicator::broadcast(std::span<std::byte> data, std::size_t root) {
+    for (std::size_t offset = 0; offset < data.size(); offset += MAX_CHUNK_SIZE) {
+        auto count = to_int(std::min(MAX_CHUNK_SIZE, data.size() - offset));
+        check(MPI_Bcast(data.data() + offset, count, MPI_BYTE, to_int(root), MPI_COMM_WORLD), "MPI_Bcast");
+    }
+}
+
+void MpiCommunicator::all_reduce_sum(std::span<double> values) {
+    check(MPI_Allreduce(MPI_IN_PLACE, values.data(), to_int(values.size()), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD),
+        "MPI_Allreduce");
+}
+
+void MpiCommunicator::all_reduce_sum(std::span<std::uint64_t> values) {
+    check(MPI_Allreduce(MPI_IN_PLACE, values.data(), to_int(values.size()), MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD),
+        "MPI_Allreduce");
+}
+
+}  // namespace qx::core
@@ -1,7 +1,8 @@
 #include "qx/operands_helper.hpp"
 
-#include <algorithm>  // generate_n, transform
+#include <algorithm>  // generate_n, min, transform
 #include <cassert>
+#include <stdexcept>  // runtime_error
 
 #include "qx/core.hpp"
 #include "qx/cqasm_v3x.hpp"
@@ -9,8 +10,54 @@
 
 namespace qx {
 
+namespace {
+
+// Range of the qubit or bit register a variable is mapped to, empty for other variables
+[[nodiscard]] Range get_register_range(const RegisterManager& register_manager, const CqasmV3xVariable& variable) {
+    if (is_qubit_variable(variable)) {
+        return register_manager.get_qubit_range(variable.name);
+    } else if (is_bit_variable(variable)) {
+        return register_manager.get_bit_range(variable.name);
+    }
+    return Range{ 0, 0 };
+}
+
+}  // namespace
+
+// Same result as to_instructions_indices(to_cqasm_v3x_instructions_indices(get_cqasm_v3x_sgmq_groups_indices())),
+// but the SGMQ group of every operand is expanded straight into the instructions indices,
+// without building a cQASM v3x integer node per index, since circuits call it once per statement
 [[nodiscard]] InstructionsIndices get_instructions_indices(const CqasmV3xOperands& operands) {
-    return to_instructions_indices(to_cqasm_v3x_instructions_indices(get_cqasm_v3x_sgmq_groups_indices(operands)));
+    const auto& register_manager = RegisterManager::get_instance();
+    auto ret = InstructionsIndices{};
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        const auto& operand = *operands[k];
+        auto range = Range{};
+        const CqasmV3xIndices* indices = nullptr;
+        if (auto variable_ref = operand.as_variable_ref()) {
+            range = get_register_range(register_manager, *variable_ref->variable);
+        } else if (auto index_ref = operand.as_index_ref()) {
+            range = get_register_range(register_manager, *index_ref->variable);
+            if (range.size != 0) {
+                indices = &index_ref->indices;
+                range.size = indices->size();
+            }
+        } else {
+            throw std::runtime_error{ "operand is neither a variable reference nor an index reference" };
+        }
+        // The number of indices of the first SGMQ group determines the number of instructions
+        if (k == 0) {
+            ret.resize(range.size);
+            for (auto& instruction_indices : ret) {
+                instruction_indices.reserve(operands.size());
+            }
+        }
+        for (std::size_t j = 0; j < std::min(range.size, ret.size()); ++j) {
+            auto index = indices ? static_cast<std::size_t>(indices->get_vec()[j]->value) : j;
+            ret[j].push_back(core::Index{ range.first + index });
+        }
+    }
+    return ret;
 }
 
 [[nodiscard]] CqasmV3xSgmqGroupsIndices get_cqasm_v3x_sgmq_groups_indices(const CqasmV3xOperands& operands) {
@@ -0,0 +1,479 @@
+#include "qx/paged_state_vector.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>  // all_of, fill, find_if_not, min, sort, upper_bound
+#include <atomic>
+#include <cassert>  // assert
+#include <chrono>
+#include <cmath>  // sqrt
+#include <fstream>
+#include <iterator>  // distance, next
+#include <memory>  // make_unique
+#include <numeric>  // iota, partial_sum
+#include <random>  // random_device
+#include <system_error>  // error_code
+#include <utility>  // move, swap
+
+#include "qx/bit_groups.hpp"  // apply_to_bits, deposit_zeros
+#include "qx/compile_time_configuration.hpp"  // CACHE_BLOCK_QUBITS, MAX_PAGED_STATE_VECTOR_QUBIT_NUMBER
+
+namespace qx::core {
+
+PagedStateVectorError::PagedStateVectorError(const std::string& message)
+: std::runtime_error{ message } {}
+
+//------------------//
+// PagingStatistics //
+//------------------//
+
+[[nodiscard]] double PagingStatistics::get_throughput() const {
+    return seconds > 0. ? static_cast<double>(bytes_read + bytes_written) / seconds : 0.;
+}
+
+PagingStatistics& PagingStatistics::operator+=(const PagingStatistics& other) {
+    bytes_read += other.bytes_read;
+    bytes_written += other.bytes_written;
+    seconds += other.seconds;
+    return *this;
+}
+
+//------------------//
+// PagedStateVector //
+//------------------//
+
+namespace {
+
+// Pages stored one after the other in a file, which is removed with the page store
+class PageFile : public PageStore {
+public:
+    explicit PageFile(const std::filesystem::path& directory) {
+        static auto counter = std::atomic<std::uint64_t>{ 0 };
+        path_ = (directory.empty() ? std::filesystem::temp_directory_path() : directory) /
+            fmt::format("qx_paged_state_vector_{:08x}_{}.bin", std::random_device{}(), counter++);
+        stream_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream_) {
+            throw PagedStateVectorError{ fmt::format("could not create page file: {}", path_.string()) };
+        }
+    }
+    ~PageFile() override {
+        stream_.close();
+        auto error_code = std::error_code{};
+        std::filesystem::remove(path_, error_code);
+    }
+    PageFile(const PageFile&) = delete;
+    PageFile& operator=(const PageFile&) = delete;
+
+    void read(std::size_t page, std::span<std::complex<double>> amplitudes) override {
+        auto size = static_cast<std::streamsize>(amplitudes.size_bytes());
+        stream_.seekg(static_cast<std::streamoff>(page) * size);
+        stream_.read(reinterpret_cast<char*>(amplitudes.data()), size);
+        if (!stream_) {
+            throw PagedStateVectorError{ fmt::format("could not read page {} of {}", page, path_.string()) };
+        }
+    }
+
+    void write(std::size_t page, std::span<const std::complex<double>> amplitudes) override {
+        auto size = static_cast<std::streamsize>(amplitudes.size_bytes());
+        stream_.seekp(static_cast<std::streamoff>(page) * size);
+        stream_.write(reinterpret_cast<const char*>(amplitudes.data()), size);
+        if (!stream_) {
+            throw PagedStateVectorError{ fmt::format("could not write page {} of {}", page, path_.string()) };
+        }
+    }
+
+private:
+    std::filesystem::path path_;
+    std::fstream stream_;
+};
+
+// A state of a single page does not need a page file
+std::unique_ptr<PageStore> make_page_file(
+    std::size_t number_of_qubits, std::size_t number_of_page_qubits, const std::filesystem::path& directory) {
+    if (number_of_qubits <= number_of_page_qubits) {
+        return nullptr;
+    }
+    return std::make_unique<PageFile>(directory);
+}
+
+}  // namespace
+
+PagedStateVector::PagedStateVector(
+    std::size_t number_of_qubits, std::size_t number_of_page_qubits, const std::filesystem::path& directory)
+: PagedStateVector{ number_of_qubits,
+    number_of_page_qubits,
+    make_page_file(number_of_qubits, number_of_page_qubits, directory) } {}
+
+PagedStateVector::PagedStateVector(
+    std::size_t number_of_qubits, std::size_t number_of_page_qubits, std::unique_ptr<PageStore> page_store)
+: number_of_qubits_{ number_of_qubits }
+, number_of_page_qubits_{ std::min(number_of_page_qubits, number_of_qubits) }
+, number_of_block_qubits_{ std::min(config::CACHE_BLOCK_QUBITS, number_of_page_qubits_) }
+, page_store_{ std::move(page_store) }
+, physical_bit_of_qubit_(number_of_qubits)
+, qubit_at_physical_bit_(number_of_qubits) {
+    if (number_of_qubits_ == 0) {
+        throw PagedStateVectorError{ "number of qubits needs to be at least 1" };
+    }
+    if (number_of_qubits_ > config::MAX_PAGED_STATE_VECTOR_QUBIT_NUMBER) {
+        throw PagedStateVectorError{ fmt::format(
+            "number of qubits exceeds maximum allowed for a paged state vector: {} > {}",
+            number_of_qubits_,
+            config::MAX_PAGED_STATE_VECTOR_QUBIT_NUMBER) };
+    }
+    if (number_of_page_qubits_ == 0) {
+        throw PagedStateVectorError{ "number of qubits of a page needs to be at least 1" };
+    }
+    auto number_of_pages = static_cast<std::size_t>(1) << (number_of_qubits_ - number_of_page_qubits_);
+    if (number_of_pages > 1 && !page_store_) {
+        throw PagedStateVectorError{ "a state of more than one page needs a page store" };
+    }
+    is_zero_page_.resize(number_of_pages, true);
+    last_use_of_block_bit_.resize(number_of_block_qubits_, 0);
+    page_.resize(get_page_size(), 0.);
+    page_[0] = 1.;
+    page_in_memory_ = 0;
+    is_page_modified_ = true;
+    std::iota(physical_bit_of_qubit_.begin(), physical_bit_of_qubit_.end(), 0);
+    std::iota(qubit_at_physical_bit_.begin(), qubit_at_physical_bit_.end(), 0);
+}
+
+PagedStateVector::~PagedStateVector() = default;
+PagedStateVector::PagedStateVector(PagedStateVector&& other) noexcept = default;
+PagedStateVector& PagedStateVector::operator=(PagedStateVector&& other) noexcept = default;
+
+[[nodiscard]] std::size_t PagedStateVector::get_number_of_qubits() const {
+    return number_of_qubits_;
+}
+
+[[nodiscard]] std::size_t PagedStateVector::get_number_of_pages() const {
+    return is_zero_page_.size();
+}
+
+[[nodiscard]] const PagingStatistics& PagedStateVector::get_paging_statistics() const {
+    return paging_statistics_;
+}
+
+[[nodiscard]] const PageStore* PagedStateVector::get_page_store() const {
+    return page_store_.get();
+}
+
+[[nodiscard]] std::complex<double> PagedStateVector::get_amplitude(const MeasurementRegister& basis_vector) {
+    apply_queued_gates();
+    auto physical_index = std::uint64_t{ 0 };
+    for (std::size_t qubit = 0; qubit < number_of_qubits_; ++qubit) {
+        physical_index |= static_cast<std::uint64_t>(basis_vector.test(qubit)) << physical_bit_of_qubit_[qubit];
+    }
+    auto page = static_cast<std::size_t>(physical_index >> number_of_page_qubits_);
+    if (is_zero_page_[page] && page_in_memory_ != page) {
+        return 0.;
+    }
+    return load_page(page)[physical_index & (get_page_size() - 1)];
+}
+
+[[nodiscard]] double PagedStateVector::get_norm() {
+    apply_queued_gates();
+    auto ret = 0.;
+    for_each_page([&ret](std::size_t, const auto& amplitudes) {
+        for (const auto& amplitude : amplitudes) {
+            ret += std::norm(amplitude);
+        }
+    });
+    return std::sqrt(ret);
+}
+
+PagedStateVector& PagedStateVector::apply(const matrix_t& matrix, const operands_t& operands) {
+    assert(!operands.empty());
+    assert(std::all_of(operands.begin(), operands.end(), [this](auto qubit_index) {
+        return qubit_index.value < number_of_qubits_;
+    }) && "Operand refers to a non-existing qubit");
+
+    if (operands.size() > number_of_block_qubits_) {
+        throw PagedStateVectorError{ fmt::format("gate on {} qubits needs at least as many qubits in a cache block: {}",
+            operands.size(),
+            number_of_block_qubits_) };
+    }
+    // Bring the operands stored at page-index bits, or at page bits above the block bits, to block bits
+    auto is_used = std::vector<bool>(number_of_block_qubits_, false);
+    for (const auto& operand : operands) {
+        if (auto bit = physical_bit_of_qubit_[operand.value]; bit < number_of_block_qubits_) {
+            is_used[bit] = true;
+        }
+    }
+    for (const auto& operand : operands) {
+        if (auto bit = physical_bit_of_qubit_[operand.value]; bit >= number_of_block_qubits_) {
+            auto free_bit = get_least_recently_used_block_bit(is_used);
+            is_used[free_bit] = true;
+            if (is_page_bit(bit)) {
+                static const auto swap =
+                    matrix_t{ Matrix{ { 1, 0, 0, 0 }, { 0, 0, 1, 0 }, { 0, 1, 0, 0 }, { 0, 0, 0, 1 } } };
+                queued_gates_.push_back(QueuedGate{ swap, { free_bit, bit } });
+                swap_qubits(bit, free_bit);
+            } else {
+                apply_queued_gates();
+                swap_bits(bit, free_bit);
+            }
+        }
+    }
+    // Same convention as the rows and columns of gate matrices: bit k is the value of operand operands.size() - k - 1
+    auto page_bits = std::vector<std::size_t>(operands.size());
+    ++number_of_gates_;
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        page_bits[k] = physical_bit_of_qubit_[operands[operands.size() - k - 1].value];
+        last_use_of_block_bit_[page_bits[k]] = number_of_gates_;
+    }
+    queued_gates_.push_back(QueuedGate{ matrix, std::move(page_bits) });
+    return *this;
+}
+
+// Pages whose page-index bit is 0 are not even read
+[[nodiscard]] double PagedStateVector::get_probability_of_measuring_one(QubitIndex qubit_index) {
+    apply_queued_gates();
+    auto bit = physical_bit_of_qubit_[qubit_index.value];
+    auto ret = 0.;
+    if (!is_page_bit(bit)) {
+        auto page_index_bit = bit - number_of_page_qubits_;
+        for_each_page([&ret](std::size_t, const auto& amplitudes) {
+            for (const auto& amplitude : amplitudes) {
+                ret += std::norm(amplitude);
+            }
+        }, [page_index_bit](std::size_t page) { return static_cast<bool>((page >> page_index_bit) & 1); });
+        return ret;
+    }
+    for_each_page([&ret, bit](std::size_t, const auto& amplitudes) {
+        for (std::size_t i = 0; i < amplitudes.size(); ++i) {
+            if ((i >> bit) & 1) {
+                ret += std::norm(amplitudes[i]);
+            }
+        }
+    });
+    return ret;
+}
+
+// The projection is queued as a gate on page bits, except that pages projected out are just marked as zero
+void PagedStateVector::update_data_after_measurement(
+    QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one) {
+    auto bit = physical_bit_of_qubit_[qubit_index.value];
+    auto probability = measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one);
+    auto factor = std::complex<double>{ 1 / std::sqrt(probability) };
+    if (is_page_bit(bit)) {
+        auto projection = measured_state ? Matrix{ { 0, 0 }, { 0, factor } } : Matrix{ { factor, 0 }, { 0, 0 } };
+        queued_gates_.push_back(QueuedGate{ matrix_t{ std::move(projection), false }, { bit } });
+        return;
+    }
+    for (std::size_t page = 0; page < get_number_of_pages(); ++page) {
+        if (static_cast<bool>((page >> (bit - number_of_page_qubits_)) & 1) != measured_state) {
+            is_zero_page_[page] = true;
+            if (page_store_) {
+                page_store_->discard(page);
+            }
+            if (page_in_memory_ == page) {
+                page_in_memory_.reset();
+                is_page_modified_ = false;
+            }
+        }
+    }
+    queued_gates_.push_back(QueuedGate{ matrix_t{ Matrix{ { factor, 0 }, { 0, factor } }, false }, { 0 } });
+}
+
+bool PagedStateVector::measure(QubitIndex qubit_index, double random) {
+    auto probability_of_measuring_one = get_probability_of_measuring_one(qubit_index);
+    auto ret = random < probability_of_measuring_one;
+    update_data_after_measurement(qubit_index, ret, probability_of_measuring_one);
+    return ret;
+}
+
+void PagedStateVector::apply_reset(QubitIndex qubit_index, double random) {
+    static const auto x = matrix_t{ Matrix{ { 0, 1 }, { 1, 0 } } };
+    if (measure(qubit_index, random)) {
+        apply(x, { qubit_index });
+    }
+}
+
+// The samples are sorted, so that a single pass over the pages finds all of them
+[[nodiscard]] std::vector<MeasurementRegister> PagedStateVector::sample(std::vector<double> randoms) {
+    apply_queued_gates();
+    auto weights = std::vector<double>(get_number_of_pages(), 0.);
+    for_each_page([&weights](std::size_t page, const auto& amplitudes) {
+        for (const auto& amplitude : amplitudes) {
+            weights[page] += std::norm(amplitude);
+        }
+    });
+    auto cumulative_weights = std::vector<double>(weights.size());
+    std::partial_sum(weights.begin(), weights.end(), cumulative_weights.begin());
+    auto last_page = weights.size() - 1;
+    while (last_page > 0 && weights[last_page] == 0.) {
+        --last_page;
+    }
+
+    std::sort(randoms.begin(), randoms.end());
+    auto ret = std::vector<MeasurementRegister>{};
+    ret.reserve(randoms.size());
+    auto current_page = get_number_of_pages();
+    auto index = std::size_t{ 0 };
+    auto cumulative_weight = 0.;
+    for (auto random : randoms) {
+        random *= cumulative_weights.back();
+        auto page = std::min(last_page,
+            static_cast<std::size_t>(std::distance(cumulative_weights.begin(),
+                std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), random))));
+        const auto& amplitudes = load_page(page);
+        if (page != current_page) {
+            current_page = page;
+            index = 0;
+            cumulative_weight = page == 0 ? 0. : cumulative_weights[page - 1];
+        }
+        while (index + 1 < amplitudes.size() && cumulative_weight + std::norm(amplitudes[index]) <= random) {
+            cumulative_weight += std::norm(amplitudes[index]);
+            ++index;
+        }
+        // Rounding errors may leave the last samples past the last amplitude
+        while (index > 0 && std::norm(amplitudes[index]) == 0.) {
+            --index;
+        }
+        ret.push_back(to_basis_vector((static_cast<std::uint64_t>(page) << number_of_page_qubits_) | index));
+    }
+    return ret;
+}
+
+[[nodiscard]] bool PagedStateVector::is_page_bit(std::size_t physical_bit) const {
+    return physical_bit < number_of_page_qubits_;
+}
+
+[[nodiscard]] std::size_t PagedStateVector::get_page_size() const {
+    return static_cast<std::size_t>(1) << number_of_page_qubits_;
+}
+
+// Runs of consecutive gates on block bits are applied one block at a time,
+// and the other gates, i.e., queued swaps and projections, to the whole page
+void PagedStateVector::apply_queued_gates() {
+    if (queued_gates_.empty()) {
+        return;
+    }
+    auto is_block_gate = [this](const QueuedGate& gate) {
+        return std::all_of(
+            gate.page_bits.begin(), gate.page_bits.end(), [this](auto bit) { return bit < number_of_block_qubits_; });
+    };
+    auto apply_gate = [](const QueuedGate& gate, std::span<std::complex<double>> amplitudes, std::size_t bits) {
+        apply_to_bits(amplitudes, bits, gate.page_bits, [&gate](auto i, auto j) { return gate.matrix.at(i, j); });
+    };
+    auto block_size = static_cast<std::size_t>(1) << number_of_block_qubits_;
+    for_each_page([this, &is_block_gate, &apply_gate, block_size](std::size_t, auto& amplitudes) {
+        for (auto first = queued_gates_.begin(); first != queued_gates_.end();) {
+            auto last = std::find_if_not(first, queued_gates_.end(), is_block_gate);
+            if (first == last) {
+                apply_gate(*first, amplitudes, number_of_page_qubits_);
+                first = std::next(last);
+                continue;
+            }
+            for (std::size_t block = 0; block < amplitudes.size(); block += block_size) {
+                auto block_amplitudes = std::span{ amplitudes }.subspan(block, block_size);
+                for (auto gate = first; gate != last; ++gate) {
+                    apply_gate(*gate, block_amplitudes, number_of_block_qubits_);
+                }
+            }
+            first = last;
+        }
+        is_page_modified_ = true;
+    });
+    queued_gates_.clear();
+}
+
+[[nodiscard]] std::size_t PagedStateVector::get_least_recently_used_block_bit(const std::vector<bool>& is_used) const {
+    auto ret = number_of_block_qubits_;
+    for (auto bit = number_of_block_qubits_; bit-- > 0;) {
+        auto is_older = ret == number_of_block_qubits_ || last_use_of_block_bit_[bit] < last_use_of_block_bit_[ret];
+        if (!is_used[bit] && is_older) {
+            ret = bit;
+        }
+    }
+    assert(ret < number_of_block_qubits_);
+    return ret;
+}
+
+std::vector<std::complex<double>>& PagedStateVector::load_page(std::size_t page) {
+    if (page_in_memory_ != page) {
+        unload_page();
+        if (is_zero_page_[page]) {
+            std::fill(page_.begin(), page_.end(), 0.);
+        } else {
+            read_page(page, page_);
+        }
+        page_in_memory_ = page;
+    }
+    return page_;
+}
+
+void PagedStateVector::unload_page() {
+    if (page_in_memory_ && is_page_modified_) {
+        write_page(*page_in_memory_, page_);
+    }
+    page_in_memory_.reset();
+    is_page_modified_ = false;
+}
+
+void PagedStateVector::read_page(std::size_t page, std::vector<std::complex<double>>& amplitudes) {
+    auto start = std::chrono::steady_clock::now();
+    page_store_->read(page, amplitudes);
+    paging_statistics_.bytes_read += amplitudes.size() * sizeof(std::complex<double>);
+    paging_statistics_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PagedStateVector::write_page(std::size_t page, const std::vector<std::complex<double>>& amplitudes) {
+    if (!page_store_) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    page_store_->write(page, amplitudes);
+    is_zero_page_[page] = false;
+    paging_statistics_.bytes_written += amplitudes.size() * sizeof(std::complex<double>);
+    paging_statistics_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The amplitudes whose page-index bit and page bit differ move to the other page of the pair, at the same index:
+// the page whose page-index bit is 0 swaps its amplitudes whose page bit is 1 with the ones of the other page
+// whose page bit is 0
+void PagedStateVector::swap_bits(std::size_t page_index_bit, std::size_t page_bit) {
+    assert(!is_page_bit(page_index_bit) && is_page_bit(page_bit));
+    unload_page();
+    auto page_index_mask = static_cast<std::size_t>(1) << (page_index_bit - number_of_page_qubits_);
+    auto positions = std::vector<std::size_t>{ page_bit };
+    auto page_bit_mask = static_cast<std::size_t>(1) << page_bit;
+    auto other_page = std::vector<std::complex<double>>(get_page_size());
+    for (std::size_t page = 0; page < get_number_of_pages(); ++page) {
+        auto other = page | page_index_mask;
+        if ((page & page_index_mask) || (is_zero_page_[page] && is_zero_page_[other])) {
+            continue;
+        }
+        auto& amplitudes = load_page(page);
+        if (is_zero_page_[other]) {
+            std::fill(other_page.begin(), other_page.end(), 0.);
+        } else {
+            read_page(other, other_page);
+        }
+        for (std::size_t i = 0; i < get_page_size() / 2; ++i) {
+            auto index = deposit_zeros(i, positions);
+            std::swap(amplitudes[index | page_bit_mask], other_page[index]);
+        }
+        is_page_modified_ = true;
+        write_page(other, other_page);
+    }
+    unload_page();
+    swap_qubits(page_index_bit, page_bit);
+}
+
+void PagedStateVector::swap_qubits(std::size_t physical_bit, std::size_t other_physical_bit) {
+    std::swap(qubit_at_physical_bit_[physical_bit], qubit_at_physical_bit_[other_physical_bit]);
+    physical_bit_of_qubit_[qubit_at_physical_bit_[physical_bit]] = physical_bit;
+    physical_bit_of_qubit_[qubit_at_physical_bit_[other_physical_bit]] = other_physical_bit;
+}
+
+[[nodiscard]] MeasurementRegister PagedStateVector::to_basis_vector(std::uint64_t physical_index) const {
+    auto ret = MeasurementRegister{ number_of_qubits_ };
+    for (std::size_t bit = 0; bit < number_of_qubits_; ++bit) {
+        ret.set(qubit_at_physical_bit_[bit], (physical_index >> bit) & 1);
+    }
+    return ret;
+}
+
+}  // namespace qx::core
@@ -3,22 +3,34 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>  // any_of, fill, find, find_if, transform
+#include <bit>  // popcount
 #include <complex>
+#include <cstdint>  // uint8_t, uint64_t
+#include <limits>  // numeric_limits
+#include <numeric>  // iota
+#include <optional>
 #include <ostream>
+#include <type_traits>  // decay_t
+#include <utility>  // in_place_index, move
+#include <variant>  // visit
+#include <vector>
 
 namespace qx::core {
 
 QuantumStateError::QuantumStateError(const std::string& message)
 : std::runtime_error{ message } {}
 
-void apply_impl(const matrix_t& matrix, const operands_t& operands, BasisVector index,
-    const SparseComplex& sparse_complex, SparseArray::MapBasisVectorToSparseComplex& storage) {
-    BasisVector reduced_index{ operands.size() };
+template <typename BasisVectorT>
+void apply_impl(const matrix_t& matrix, const operands_t& operands, BasisVectorT index,
+    const SparseComplex& sparse_complex,
+    typename BasicSparseArray<BasisVectorT>::MapBasisVectorToSparseComplex& storage) {
+    std::size_t reduced_index = 0;
     for (std::size_t i = 0; i < operands.size(); ++i) {
-        reduced_index.set(i, index.test(operands.at(operands.size() - i - 1).value));
+        reduced_index |= static_cast<std::size_t>(index.test(operands.at(operands.size() - i - 1).value)) << i;
     }
     for (std::size_t i = 0; i < (static_cast<size_t>(1) << operands.size()); ++i) {
-        std::complex<double> added_value = sparse_complex.value * matrix.at(i, reduced_index.to_ulong());
+        std::complex<double> added_value = sparse_complex.value * matrix.at(i, reduced_index);
         if (not is_null(added_value)) {
             auto new_index = index;
             for (std::size_t k = 0; k < operands.size(); ++k) {
@@ -30,14 +42,174 @@ void apply_impl(const matrix_t& matrix, const operands_t& operands, BasisVector
     }
 }
 
+namespace {
+
+// Basis vector masks for the operands of a gate
+//
+// patterns[i] sets the bits of the operands according to the bits of i,
+// following the same convention as the rows and columns of the gate matrix:
+// bit k of i is the value of operand operands.size() - k - 1.
+template <typename BasisVectorT>
+struct OperandsPatterns {
+    BasisVectorT mask;
+    std::vector<BasisVectorT> patterns;
+};
+
+template <typename BasisVectorT>
+OperandsPatterns<BasisVectorT> get_operands_patterns(const operands_t& operands) {
+    auto ret = OperandsPatterns<BasisVectorT>{ BasisVectorT{},
+        std::vector<BasisVectorT>(static_cast<size_t>(1) << operands.size()) };
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        ret.mask.set(operands.at(operands.size() - k - 1).value);
+    }
+    for (std::size_t i = 0; i < ret.patterns.size(); ++i) {
+        for (std::size_t k = 0; k < operands.size(); ++k) {
+            ret.patterns[i].set(operands.at(operands.size() - k - 1).value, utils::get_bit(i, k));
+        }
+    }
+    return ret;
+}
+
+// Call f(base, amplitudes, present) for every group of elements whose basis vectors only differ in the operand bits,
+// in increasing order of base, the basis vector of the group with all the operand bits cleared
+//
+// amplitudes[i] and present[i] are the amplitude of base | patterns[i], and whether that element exists.
+// elements has to be sorted by basis vector, so that the elements of every pattern form a sorted subsequence;
+// one cursor walks each of these subsequences, and the groups come out of merging them.
+template <typename BasisVectorT, typename F>
+void for_each_group(const std::vector<BasicSparseElement<BasisVectorT>>& elements,
+    const OperandsPatterns<BasisVectorT>& op, F&& f) {
+    const auto number_of_patterns = op.patterns.size();
+    const auto not_mask = ~op.mask;
+    auto cursors = std::vector<std::size_t>(number_of_patterns, 0);
+    auto advance = [&elements, &op, &cursors](std::size_t p) {
+        while (cursors[p] < elements.size() && (elements[cursors[p]].first & op.mask) != op.patterns[p]) {
+            ++cursors[p];
+        }
+    };
+    for (std::size_t p = 0; p < number_of_patterns; ++p) {
+        advance(p);
+    }
+    auto amplitudes = std::vector<std::complex<double>>(number_of_patterns);
+    auto present = std::vector<bool>(number_of_patterns);
+    for (;;) {
+        std::optional<BasisVectorT> base;
+        for (std::size_t p = 0; p < number_of_patterns; ++p) {
+            if (cursors[p] < elements.size()) {
+                auto element_base = elements[cursors[p]].first & not_mask;
+                if (!base.has_value() || element_base < *base) {
+                    base = element_base;
+                }
+            }
+        }
+        if (!base.has_value()) {
+            return;
+        }
+        for (std::size_t p = 0; p < number_of_patterns; ++p) {
+            present[p] = cursors[p] < elements.size() && (elements[cursors[p]].first & not_mask) == *base;
+            amplitudes[p] = present[p] ? elements[cursors[p]].second.value : 0.;
+            if (present[p]) {
+                ++cursors[p];
+                advance(p);
+            }
+        }
+        f(*base, amplitudes, present);
+    }
+}
+
+}  // namespace
+
+// The new amplitudes of a group of elements only depend on the old amplitudes of that same group.
+// They are written group after group, so each pattern gets a sorted subsequence of the scratch storage,
+// at a fixed stride, and these subsequences are finally merged back into elements.
+template <typename BasisVectorT>
+void apply_sorted_impl(const matrix_t& matrix, const operands_t& operands,
+    typename BasicSparseArray<BasisVectorT>::VectorOfSparseElements& elements,
+    typename BasicSparseArray<BasisVectorT>::VectorOfSparseElements& scratch) {
+    const auto op = get_operands_patterns<BasisVectorT>(operands);
+    const auto number_of_patterns = op.patterns.size();
+    for_each_group(elements, op, [&](auto base, const auto& amplitudes, const auto& /* present */) {
+        for (std::size_t i = 0; i < number_of_patterns; ++i) {
+            std::complex<double> value = 0.;
+            for (std::size_t j = 0; j < number_of_patterns; ++j) {
+                value += matrix.at(i, j) * amplitudes[j];
+            }
+            scratch.emplace_back(base | op.patterns[i], SparseComplex{ value });
+        }
+    });
+    elements.clear();
+    auto heads = std::vector<std::size_t>(number_of_patterns);
+    std::iota(heads.begin(), heads.end(), 0);
+    for (;;) {
+        std::optional<std::size_t> next;
+        for (std::size_t p = 0; p < number_of_patterns; ++p) {
+            if (heads[p] < scratch.size() &&
+                (!next.has_value() || scratch[heads[p]].first < scratch[heads[*next]].first)) {
+                next = p;
+            }
+        }
+        if (!next.has_value()) {
+            return;
+        }
+        if (const auto& element = scratch[heads[*next]]; not is_null(element.second.value)) {
+            elements.push_back(element);
+        }
+        heads[*next] += number_of_patterns;
+    }
+}
+
+#define QX_INSTANTIATE_APPLY(BASIS_VECTOR)                                                                        \
+    template void apply_impl<BASIS_VECTOR>(const matrix_t& matrix, const operands_t& operands, BASIS_VECTOR index, \
+        const SparseComplex& sparse_complex,                                                                       \
+        BasicSparseArray<BASIS_VECTOR>::MapBasisVectorToSparseComplex& storage);                                   \
+    template void apply_sorted_impl<BASIS_VECTOR>(const matrix_t& matrix, const operands_t& operands,              \
+        BasicSparseArray<BASIS_VECTOR>::VectorOfSparseElements& elements,                                          \
+        BasicSparseArray<BASIS_VECTOR>::VectorOfSparseElements& scratch);
+QX_INSTANTIATE_APPLY(BasisVector)
+QX_INSTANTIATE_APPLY(BasisVector128)
+QX_INSTANTIATE_APPLY(BasisVector256)
+QX_INSTANTIATE_APPLY(BasisVector1024)
+#undef QX_INSTANTIATE_APPLY
+
+namespace {
+
+// Move the amplitude of every basis vector where the qubit is 1 to its partner where the qubit is 0
+template <typename BasisVectorT>
+void reset_qubit(BasicSparseArray<BasisVectorT>& data, QubitIndex qubit_index) {
+    if (data.get_layout() == SparseArrayLayout::sorted_vector) {
+        // Same update, done while merging every element with its partner
+        data.apply_sorted([qubit_index](auto& elements, auto& scratch) {
+            for_each_group(elements,
+                get_operands_patterns<BasisVectorT>(operands_t{ qubit_index }),
+                [&scratch](auto base, const auto& amplitudes, const auto& present) {
+                    scratch.emplace_back(base,
+                        SparseComplex{ present[1] ? std::sqrt(std::norm(amplitudes[0]) + std::norm(amplitudes[1]))
+                                                  : amplitudes[0] });
+                });
+            elements.swap(scratch);
+        });
+        return;
+    }
+    auto new_data = data;
+    data.for_each([qubit_index, &new_data](const auto& kv) {
+        const auto& [basis_vector, amplitude] = kv;
+        if (basis_vector.test(qubit_index.value)) {
+            auto basis_vector_after_reset = basis_vector;
+            basis_vector_after_reset.set(qubit_index.value, false);
+            new_data[basis_vector_after_reset].value =
+                std::sqrt(std::norm(new_data[basis_vector_after_reset].value) + std::norm(amplitude.value));
+            new_data[basis_vector].value = 0;
+        }
+    });
+    data = std::move(new_data);
+}
+
+}  // namespace
+
 void QuantumState::check_quantum_state() {
     if (number_of_qubits_ == 0) {
         throw QuantumStateError{ "number of qubits needs to be at least 1" };
     }
-    if (number_of_qubits_ > config::MAX_QUBIT_NUMBER) {
-        throw QuantumStateError{ fmt::format(
-            "number of qubits exceeds maximum allowed: {} > {}", number_of_qubits_, config::MAX_QUBIT_NUMBER) };
-    }
     if (number_of_bits_ > config::MAX_BIT_NUMBER) {
         throw QuantumStateError{ fmt::format(
             "number of bits exceeds maximum allowed: {} > {}", number_of_bits_, config::MAX_BIT_NUMBER) };
@@ -47,22 +219,53 @@ void QuantumState::check_quantum_state() {
     }
 }
 
+// Pick the narrowest basis vectors that can hold all the qubits
+/* static */ [[nodiscard]] QuantumState::Data QuantumState::make_data(std::size_t number_of_qubits,
+    std::initializer_list<PairBasisVectorStringComplex> values, SparseArrayLayout layout) {
+    static_assert(BasisVector1024::MAX_NUMBER_OF_BITS == config::MAX_STATE_VECTOR_QUBIT_NUMBER);
+    if (number_of_qubits > config::MAX_STATE_VECTOR_QUBIT_NUMBER) {
+        throw QuantumStateError{ fmt::format("number of qubits exceeds maximum allowed for a state vector: {} > {}",
+            number_of_qubits,
+            config::MAX_STATE_VECTOR_QUBIT_NUMBER) };
+    }
+    auto size = number_of_qubits < BasisVector::MAX_NUMBER_OF_BITS ? static_cast<size_t>(1) << number_of_qubits
+                                                                    : std::numeric_limits<std::size_t>::max();
+    if (number_of_qubits <= BasisVector::MAX_NUMBER_OF_BITS) {
+        return Data{ std::in_place_index<0>, size, values, layout };
+    }
+    if (number_of_qubits <= BasisVector128::MAX_NUMBER_OF_BITS) {
+        return Data{ std::in_place_index<1>, size, values, layout };
+    }
+    if (number_of_qubits <= BasisVector256::MAX_NUMBER_OF_BITS) {
+        return Data{ std::in_place_index<2>, size, values, layout };
+    }
+    return Data{ std::in_place_index<3>, size, values, layout };
+}
+
 QuantumState::QuantumState()
 : QuantumState{ 1, 1 } {}
 
-QuantumState::QuantumState(std::size_t qubit_register_size, std::size_t bit_register_size)
+QuantumState::QuantumState(std::size_t qubit_register_size, std::size_t bit_register_size, SparseArrayLayout layout)
 : number_of_qubits_{ qubit_register_size }
 , number_of_bits_{ bit_register_size }
-, data_{ static_cast<size_t>(1) << number_of_qubits_ } {
+, data_{ make_data(number_of_qubits_, {}, layout) }
+, marginal_probabilities_(number_of_qubits_)
+, cached_marginal_probabilities_(number_of_qubits_)
+, pauli_frame_x_(number_of_qubits_)
+, pauli_frame_z_(number_of_qubits_) {
     reset_data();
     check_quantum_state();
 }
 
 QuantumState::QuantumState(std::size_t qubit_register_size, std::size_t bit_register_size,
-    std::initializer_list<PairBasisVectorStringComplex> values)
+    std::initializer_list<PairBasisVectorStringComplex> values, SparseArrayLayout layout)
 : number_of_qubits_{ qubit_register_size }
 , number_of_bits_{ bit_register_size }
-, data_{ static_cast<size_t>(1) << number_of_qubits_, values } {
+, data_{ make_data(number_of_qubits_, values, layout) }
+, marginal_probabilities_(number_of_qubits_)
+, cached_marginal_probabilities_(number_of_qubits_)
+, pauli_frame_x_(number_of_qubits_)
+, pauli_frame_z_(number_of_qubits_) {
     check_quantum_state();
 }
 
@@ -75,30 +278,334 @@ QuantumState::QuantumState(std::size_t qubit_register_size, std::size_t bit_regi
 }
 
 [[nodiscard]] bool QuantumState::is_normalized() {
-    return is_null(data_.norm() - 1.);
+    return is_null(std::visit([](auto& data) { return data.norm(); }, data_) - 1.);
 }
 
 [[nodiscard]] std::vector<std::complex<double>> QuantumState::to_vector() const {
-    return data_.to_vector();
+    if (number_of_qubits_ >= BasisVector::MAX_NUMBER_OF_BITS) {
+        throw QuantumStateError{ fmt::format(
+            "quantum state is too large to be converted to a vector: {} qubits", number_of_qubits_) };
+    }
+    auto stored = std::visit([](const auto& data) { return data.to_vector(); }, data_);
+    // The state is not changed, so the queued phases and the Pauli frame are only applied to the copy
+    if (!queued_diagonal_gates_.empty()) {
+        for (std::size_t i = 0; i < stored.size(); ++i) {
+            stored[i] *= get_queued_phase(BasisVector{ i });
+        }
+    }
+    if (position_of_qubit_.empty() && !has_pauli_frame()) {
+        return stored;
+    }
+    auto x = std::uint64_t{ 0 };
+    auto z = std::uint64_t{ 0 };
+    for (std::size_t qubit = 0; qubit < number_of_qubits_; ++qubit) {
+        x |= static_cast<std::uint64_t>(pauli_frame_x_[qubit]) << qubit;
+        z |= static_cast<std::uint64_t>(pauli_frame_z_[qubit]) << qubit;
+    }
+    auto ret = std::vector<std::complex<double>>(stored.size());
+    for (std::size_t i = 0; i < stored.size(); ++i) {
+        auto index = position_of_qubit_.empty() ? i : permute_bits(BasisVector{ i }, qubit_at_position_).to_ulong();
+        ret[index ^ x] = (std::popcount(index & z) % 2 == 0 ? pauli_frame_phase_ : -pauli_frame_phase_) * stored[i];
+    }
+    return ret;
 }
 
 void QuantumState::reset_data() {
-    data_.clear();
-    data_[BasisVector{ number_of_qubits_ }] = SparseComplex{ 1. };  // start initialized in state 00...000
+    std::visit(
+        [](auto& data) {
+            data.clear();
+            // Start initialized in state 00...000
+            data[typename std::decay_t<decltype(data)>::BasisVectorType{}] = SparseComplex{ 1. };
+        },
+        data_);
+    queued_diagonal_gates_.clear();
+    std::fill(pauli_frame_x_.begin(), pauli_frame_x_.end(), false);
+    std::fill(pauli_frame_z_.begin(), pauli_frame_z_.end(), false);
+    pauli_frame_phase_ = 1.;
+    std::fill(marginal_probabilities_.begin(), marginal_probabilities_.end(), 0.);
+    cached_marginal_probabilities_ = get_all_qubits();
 }
 
 void QuantumState::reset() {
     reset_data();
 }
 
-[[nodiscard]] double QuantumState::get_probability_of_measuring_one(QubitIndex qubit_index) {
-    return data_.accumulate(double{}, [qubit_index](auto total, const auto& kv) {
-        const auto& [basis_vector, sparse_complex] = kv;
-        if (basis_vector.test(qubit_index.value)) {
-            total += std::norm(sparse_complex.value);
+[[nodiscard]] SparseArrayLayout QuantumState::get_layout() const {
+    return std::visit([](const auto& data) { return data.get_layout(); }, data_);
+}
+
+[[nodiscard]] std::size_t QuantumState::get_memory_size() const {
+    return std::visit([](const auto& data) { return data.get_memory_size(); }, data_);
+}
+
+[[nodiscard]] std::vector<std::size_t> QuantumState::get_qubit_positions() const {
+    if (position_of_qubit_.empty()) {
+        auto ret = std::vector<std::size_t>(number_of_qubits_);
+        std::iota(ret.begin(), ret.end(), 0);
+        return ret;
+    }
+    return position_of_qubit_;
+}
+
+// Every stored bit moves from the position of its qubit to the new one, and so do the operands of the queued gates
+// The marginal probabilities are indexed by qubit, so they stay valid
+void QuantumState::set_qubit_positions(const std::vector<std::size_t>& positions) {
+    auto is_used = std::vector<bool>(number_of_qubits_, false);
+    auto is_permutation = positions.size() == number_of_qubits_;
+    for (auto position : positions) {
+        is_permutation = is_permutation && position < number_of_qubits_ && !is_used[position];
+        if (is_permutation) {
+            is_used[position] = true;
         }
-        return total;
+    }
+    if (!is_permutation) {
+        throw QuantumStateError{ fmt::format(
+            "qubit positions need to be a permutation of the {} qubits", number_of_qubits_) };
+    }
+    auto moves = std::vector<std::size_t>(number_of_qubits_);
+    auto is_moved = false;
+    for (std::size_t position = 0; position < number_of_qubits_; ++position) {
+        moves[position] = positions[get_qubit_at(position)];
+        is_moved = is_moved || moves[position] != position;
+    }
+    if (!is_moved) {
+        return;
+    }
+    std::visit(
+        [&moves](auto& data) {
+            data.transform_basis_vectors(
+                [&moves](const auto& basis_vector) { return permute_bits(basis_vector, moves); });
+        },
+        data_);
+    for (auto& gate : queued_diagonal_gates_) {
+        for (auto& operand : gate.operands) {
+            operand = QubitIndex{ moves[operand.value] };
+        }
+    }
+    auto is_identity = true;
+    qubit_at_position_.assign(number_of_qubits_, 0);
+    for (std::size_t qubit = 0; qubit < number_of_qubits_; ++qubit) {
+        qubit_at_position_[positions[qubit]] = qubit;
+        is_identity = is_identity && positions[qubit] == qubit;
+    }
+    position_of_qubit_ = positions;
+    if (is_identity) {
+        position_of_qubit_.clear();
+        qubit_at_position_.clear();
+    }
+}
+
+[[nodiscard]] QubitIndex QuantumState::get_position(QubitIndex qubit_index) const {
+    return position_of_qubit_.empty() ? qubit_index : QubitIndex{ position_of_qubit_[qubit_index.value] };
+}
+
+[[nodiscard]] std::size_t QuantumState::get_qubit_at(std::size_t position) const {
+    return qubit_at_position_.empty() ? position : qubit_at_position_[position];
+}
+
+[[nodiscard]] std::size_t QuantumState::get_number_of_queued_diagonal_gates() const {
+    return queued_diagonal_gates_.size();
+}
+
+[[nodiscard]] bool QuantumState::has_pauli_frame() const {
+    return std::ranges::find(pauli_frame_x_, true) != pauli_frame_x_.end() ||
+        std::ranges::find(pauli_frame_z_, true) != pauli_frame_z_.end() || pauli_frame_phase_ != 1.;
+}
+
+// X X^x Z^z = X^(x + 1) Z^z, Z X^x Z^z = (-1)^x X^x Z^(z + 1), and Y = i X Z
+// Flipping a qubit flips its probability of measuring one
+[[nodiscard]] bool QuantumState::absorb_pauli_gate(const matrix_t& matrix, QubitIndex qubit_index) {
+    auto is_x = matrix == gates::X;
+    auto is_y = !is_x && matrix == gates::Y;
+    auto is_z = !is_x && !is_y && matrix == gates::Z;
+    if (!is_x && !is_y && !is_z) {
+        return false;
+    }
+    auto qubit = qubit_index.value;
+    if (is_y) {
+        pauli_frame_phase_ *= std::complex<double>{ 0., 1. };
+    }
+    if (!is_x && pauli_frame_x_[qubit]) {
+        pauli_frame_phase_ = -pauli_frame_phase_;
+    }
+    if (!is_z) {
+        pauli_frame_x_[qubit] = !pauli_frame_x_[qubit];
+        marginal_probabilities_[qubit] = 1. - marginal_probabilities_[qubit];
+    }
+    if (!is_x) {
+        pauli_frame_z_[qubit] = !pauli_frame_z_[qubit];
+    }
+    return true;
+}
+
+[[nodiscard]] bool QuantumState::has_pauli_frame_on(const operands_t& operands) const {
+    return std::ranges::any_of(operands, [this](const auto& operand) {
+        return pauli_frame_x_[operand.value] || pauli_frame_z_[operand.value];
+    });
+}
+
+// Gate U becomes P^-1 U P, with P the product of X^x Z^z over its operands, so that applying it to the stored
+// amplitudes and then the frame is the same as applying U to the state
+// P |j> = (-1)^(number of bits of j & z) |j ^ x>, with the same bit convention as the rows and columns of U
+[[nodiscard]] matrix_t QuantumState::conjugate_by_pauli_frame(
+    const matrix_t& matrix, const operands_t& operands) const {
+    auto x = std::size_t{ 0 };
+    auto z = std::size_t{ 0 };
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        x |= static_cast<std::size_t>(pauli_frame_x_[operands[k].value]) << (operands.size() - k - 1);
+        z |= static_cast<std::size_t>(pauli_frame_z_[operands[k].value]) << (operands.size() - k - 1);
+    }
+    auto size = static_cast<std::size_t>(1) << operands.size();
+    auto ret = Matrix(size, Row(size));
+    for (std::size_t i = 0; i < size; ++i) {
+        for (std::size_t j = 0; j < size; ++j) {
+            auto element = matrix.at(i ^ x, j ^ x);
+            ret[i][j] = (std::popcount(i & z) + std::popcount(j & z)) % 2 == 0 ? element : -element;
+        }
+    }
+    return matrix_t{ std::move(ret), false };
+}
+
+// Every stored basis vector b becomes b ^ x, and its amplitude is multiplied by the phase of the frame,
+// and by -1 if b & z has an odd number of bits
+// The queued diagonal gates act on the amplitudes under the frame, so they are applied first
+void QuantumState::apply_pauli_frame() {
+    if (!has_pauli_frame()) {
+        return;
+    }
+    apply_diagonal_gates();
+    std::visit(
+        [this](auto& data) {
+            using BasisVectorT = typename std::decay_t<decltype(data)>::BasisVectorType;
+            auto x = BasisVectorT{};
+            auto z = BasisVectorT{};
+            for (std::size_t qubit = 0; qubit < number_of_qubits_; ++qubit) {
+                x.set(get_position(QubitIndex{ qubit }).value, pauli_frame_x_[qubit]);
+                z.set(get_position(QubitIndex{ qubit }).value, pauli_frame_z_[qubit]);
+            }
+            data.transform_values([this, &z](const auto& basis_vector, auto& value) {
+                auto is_odd = false;
+                (basis_vector & z).for_each_set_bit([&is_odd](auto) { is_odd = !is_odd; });
+                value *= is_odd ? -pauli_frame_phase_ : pauli_frame_phase_;
+            });
+            if (x != BasisVectorT{}) {
+                data.transform_basis_vectors([&x](const auto& basis_vector) { return basis_vector ^ x; });
+            }
+        },
+        data_);
+    std::fill(pauli_frame_x_.begin(), pauli_frame_x_.end(), false);
+    std::fill(pauli_frame_z_.begin(), pauli_frame_z_.end(), false);
+    pauli_frame_phase_ = 1.;
+}
+
+// Queued gates on the same operands are merged into one
+void QuantumState::queue_diagonal_gate(const matrix_t& matrix, const operands_t& operands) {
+    auto it = std::find_if(queued_diagonal_gates_.begin(), queued_diagonal_gates_.end(), [&operands](const auto& gate) {
+        return gate.operands == operands;
     });
+    if (it == queued_diagonal_gates_.end()) {
+        it = queued_diagonal_gates_.insert(it,
+            DiagonalGate{ std::vector<std::complex<double>>(static_cast<std::size_t>(1) << operands.size(), 1.),
+                operands });
+    }
+    for (std::size_t i = 0; i < it->diagonal.size(); ++i) {
+        it->diagonal[i] *= matrix.at(i, i);
+    }
+}
+
+// Every amplitude is multiplied by the product of the entries its basis vector picks from the queued diagonals
+void QuantumState::apply_diagonal_gates() {
+    if (queued_diagonal_gates_.empty()) {
+        return;
+    }
+    std::visit(
+        [this](auto& data) {
+            data.transform_values([this](const auto& basis_vector, auto& value) {
+                value *= get_queued_phase(basis_vector);
+            });
+        },
+        data_);
+    queued_diagonal_gates_.clear();
+}
+
+// Same convention as apply_impl: bit k of the entry of a diagonal is the value of operand operands.size() - k - 1
+template <typename BasisVectorT>
+[[nodiscard]] std::complex<double> QuantumState::get_queued_phase(const BasisVectorT& basis_vector) const {
+    auto ret = std::complex<double>{ 1. };
+    for (const auto& gate : queued_diagonal_gates_) {
+        std::size_t entry = 0;
+        for (const auto& operand : gate.operands) {
+            entry = (entry << 1) | static_cast<std::size_t>(basis_vector.test(operand.value));
+        }
+        ret *= gate.diagonal[entry];
+    }
+    return ret;
+}
+
+[[nodiscard]] std::vector<bool> QuantumState::get_all_qubits() const {
+    return std::vector<bool>(number_of_qubits_, true);
+}
+
+// Compute, in one pass over the state, the marginal probabilities of the given qubits that are not cached yet
+void QuantumState::compute_marginal_probabilities(const std::vector<bool>& qubits) {
+    auto missing = std::vector<std::size_t>{};
+    for (std::size_t i = 0; i < number_of_qubits_; ++i) {
+        if (qubits[i] && !cached_marginal_probabilities_[i]) {
+            missing.push_back(i);
+            marginal_probabilities_[i] = 0.;
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+    std::visit(
+        [this, &missing](auto& data) {
+            auto mask = typename std::decay_t<decltype(data)>::BasisVectorType{};
+            for (auto i : missing) {
+                mask.set(get_position(QubitIndex{ i }).value);
+            }
+            data.for_each([this, &mask](const auto& kv) {
+                const auto& [basis_vector, sparse_complex] = kv;
+                auto probability = std::norm(sparse_complex.value);
+                (basis_vector & mask).for_each_set_bit([this, probability](auto i) {
+                    marginal_probabilities_[get_qubit_at(i)] += probability;
+                });
+            });
+        },
+        data_);
+    for (auto i : missing) {
+        if (pauli_frame_x_[i]) {
+            marginal_probabilities_[i] = 1. - marginal_probabilities_[i];
+        }
+        cached_marginal_probabilities_[i] = true;
+    }
+}
+
+[[nodiscard]] const std::vector<double>& QuantumState::get_marginal_probabilities() {
+    compute_marginal_probabilities(get_all_qubits());
+    return marginal_probabilities_;
+}
+
+[[nodiscard]] std::vector<double> QuantumState::get_marginal_probabilities(
+    const std::vector<QubitIndex>& qubit_indices) {
+    auto qubits = std::vector<bool>(number_of_qubits_, false);
+    for (const auto& qubit_index : qubit_indices) {
+        qubits[qubit_index.value] = true;
+    }
+    compute_marginal_probabilities(qubits);
+    auto ret = std::vector<double>(qubit_indices.size());
+    std::transform(qubit_indices.begin(), qubit_indices.end(), ret.begin(), [this](const auto& qubit_index) {
+        return marginal_probabilities_[qubit_index.value];
+    });
+    return ret;
+}
+
+// A single qubit is seldom measured alone, so the probabilities of all the qubits are computed at once
+[[nodiscard]] double QuantumState::get_probability_of_measuring_one(QubitIndex qubit_index) {
+    if (not cached_marginal_probabilities_[qubit_index.value]) {
+        compute_marginal_probabilities(get_all_qubits());
+    }
+    return marginal_probabilities_[qubit_index.value];
 }
 
 [[nodiscard]] double QuantumState::get_probability_of_measuring_zero(QubitIndex qubit_index) {
@@ -124,14 +631,43 @@ void QuantumState::reset() {
 //   This function:
 //     1) Erases all the entries in data_ for which qubit 0 is not 0, i.e., entry 11.
 //     2) Normalizes data_ (all the squares of all the amplitudes add up to 1).
+//
+// The marginal probabilities of the new state are gathered while normalizing it,
+// so that measuring several qubits in a row only needs one more pass over the state per qubit.
 void QuantumState::update_data_after_measurement(
     QubitIndex qubit_index, bool measured_state, double probability_of_measuring_one) {
-    data_.erase_if([qubit_index, measured_state](const auto& kv) {
-        const auto& [basis_vector, _] = kv;
-        auto current_state = basis_vector.test(qubit_index.value);
-        return current_state != measured_state;
-    });
-    data_ *= std::sqrt(1 / (measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one)));
+    if (not measured_state && probability_of_measuring_one == 0.) {
+        return;  // no entry to erase, and the state is already normalized
+    }
+    // The stored amplitudes are measured under the Pauli frame
+    if (pauli_frame_x_[qubit_index.value]) {
+        measured_state = !measured_state;
+        probability_of_measuring_one = 1 - probability_of_measuring_one;
+    }
+    std::fill(marginal_probabilities_.begin(), marginal_probabilities_.end(), 0.);
+    std::visit(
+        [this, position = get_position(qubit_index), measured_state, probability_of_measuring_one](auto& data) {
+            data.erase_if([position, measured_state](const auto& kv) {
+                const auto& [basis_vector, _] = kv;
+                auto current_state = basis_vector.test(position.value);
+                return current_state != measured_state;
+            });
+            auto probability = measured_state ? probability_of_measuring_one : (1 - probability_of_measuring_one);
+            data.scale(std::sqrt(1 / probability), [this](const auto& kv) {
+                const auto& [basis_vector, sparse_complex] = kv;
+                auto probability_of_element = std::norm(sparse_complex.value);
+                basis_vector.for_each_set_bit([this, probability_of_element](auto i) {
+                    marginal_probabilities_[get_qubit_at(i)] += probability_of_element;
+                });
+            });
+        },
+        data_);
+    for (std::size_t i = 0; i < number_of_qubits_; ++i) {
+        if (pauli_frame_x_[i]) {
+            marginal_probabilities_[i] = 1. - marginal_probabilities_[i];
+        }
+    }
+    cached_marginal_probabilities_ = get_all_qubits();
 }
 
 // Update data_ after a reset of a single qubit
@@ -155,19 +691,17 @@ void QuantumState::update_data_after_measurement(
 //             0  1: (   0,    0)  <-- 01 is reset to 00, old 01 amplitude added to 00, 01 amplitude set to 0
 //             1  0: ( 0.7,    0)
 //             1  1: (   0,    0)  <-- 11 is reset to 10, old 11 amplitude added to 10, 11 amplitude set to 0
+//
+// Resetting a qubit does not change the marginal probabilities of the other qubits.
 void QuantumState::update_data_after_reset(QubitIndex qubit_index) {
-    auto new_data = data_;
-    data_.for_each([qubit_index, &new_data](const auto& kv) {
-        const auto& [basis_vector, amplitude] = kv;
-        if (basis_vector.test(qubit_index.value)) {
-            auto basis_vector_after_reset = basis_vector;
-            basis_vector_after_reset.set(qubit_index.value, false);
-            new_data[basis_vector_after_reset].value =
-                std::sqrt(std::norm(new_data[basis_vector_after_reset].value) + std::norm(amplitude.value));
-            new_data[basis_vector].value = 0;
-        }
-    });
-    data_ = std::move(new_data);
+    if (cached_marginal_probabilities_[qubit_index.value] && marginal_probabilities_[qubit_index.value] == 0.) {
+        return;  // the qubit is already in state 0
+    }
+    apply_diagonal_gates();
+    apply_pauli_frame();
+    marginal_probabilities_[qubit_index.value] = 0.;
+    cached_marginal_probabilities_[qubit_index.value] = true;
+    std::visit([position = get_position(qubit_index)](auto& data) { reset_qubit(data, position); }, data_);
 }
 
 // reset does not modify the measurement register
@@ -175,6 +709,146 @@ void QuantumState::apply_reset(QubitIndex qubit_index) {
     update_data_after_reset(qubit_index);
 }
 
+// Both states are traversed in basis vector order, other in the outer loop, so the elements of the product,
+// where other takes the highest bits, are inserted in basis vector order too
+[[nodiscard]] QuantumState QuantumState::tensor_product(QuantumState& other) {
+    auto ret = QuantumState{ number_of_qubits_ + other.number_of_qubits_, number_of_bits_, get_layout() };
+    std::visit(
+        [this, &other](auto& data) {
+            using BasisVectorT = typename std::decay_t<decltype(data)>::BasisVectorType;
+            auto elements = std::vector<std::pair<BasisVectorT, std::complex<double>>>{};
+            for_each([&elements](const auto& kv) {
+                auto basis_vector = BasisVectorT{};
+                kv.first.for_each_set_bit([&basis_vector](auto i) { basis_vector.set(i); });
+                elements.emplace_back(basis_vector, kv.second.value);
+            });
+            data.clear();
+            other.for_each([this, &data, &elements](const auto& kv) {
+                auto other_basis_vector = BasisVectorT{};
+                kv.first.for_each_set_bit(
+                    [this, &other_basis_vector](auto i) { other_basis_vector.set(number_of_qubits_ + i); });
+                for (const auto& [basis_vector, value] : elements) {
+                    data[basis_vector | other_basis_vector] = SparseComplex{ value * kv.second.value };
+                }
+            });
+        },
+        ret.data_);
+    std::fill(ret.cached_marginal_probabilities_.begin(), ret.cached_marginal_probabilities_.end(), false);
+    return ret;
+}
+
+// The removed bit is the same for all the elements, so they stay in basis vector order without it
+[[nodiscard]] QuantumState QuantumState::remove_qubit(QubitIndex qubit_index) {
+    if (number_of_qubits_ == 1) {
+        throw QuantumStateError{ "can not remove the only qubit of a quantum state" };
+    }
+    auto ret = QuantumState{ number_of_qubits_ - 1, number_of_bits_, get_layout() };
+    auto value = std::optional<bool>{};
+    std::visit(
+        [this, qubit = qubit_index.value, &value](auto& data) {
+            using BasisVectorT = typename std::decay_t<decltype(data)>::BasisVectorType;
+            data.clear();
+            for_each([qubit, &value, &data](const auto& kv) {
+                if (value.value_or(kv.first.test(qubit)) != kv.first.test(qubit)) {
+                    throw QuantumStateError{ fmt::format("qubit {} is not in a basis state", qubit) };
+                }
+                value = kv.first.test(qubit);
+                auto basis_vector = BasisVectorT{};
+                kv.first.for_each_set_bit([qubit, &basis_vector](auto i) {
+                    if (i != qubit) {
+                        basis_vector.set(i < qubit ? i : i - 1);
+                    }
+                });
+                data[basis_vector] = kv.second;
+            });
+        },
+        ret.data_);
+    std::fill(ret.cached_marginal_probabilities_.begin(), ret.cached_marginal_probabilities_.end(), false);
+    return ret;
+}
+
+void QuantumState::write(std::ostream& os) {
+    apply_diagonal_gates();
+    apply_pauli_frame();
+    utils::write_binary(os, static_cast<std::uint64_t>(number_of_qubits_));
+    utils::write_binary(os, static_cast<std::uint64_t>(number_of_bits_));
+    utils::write_binary(os, static_cast<std::uint8_t>(get_layout()));
+    utils::write_binary(os, static_cast<std::uint64_t>(position_of_qubit_.size()));
+    for (auto position : position_of_qubit_) {
+        utils::write_binary(os, static_cast<std::uint64_t>(position));
+    }
+    std::visit(
+        [&os](auto& data) {
+            using BasisVectorT = typename std::decay_t<decltype(data)>::BasisVectorType;
+            constexpr auto number_of_words = BasisVectorT::MAX_NUMBER_OF_BITS / 64;
+            auto number_of_amplitudes =
+                data.template accumulate<std::uint64_t>(0, [](auto n, const auto&) { return n + 1; });
+            utils::write_binary(os, number_of_amplitudes);
+            data.for_each_sorted([&os](const auto& kv) {
+                for (std::size_t w = 0; w < number_of_words; ++w) {
+                    utils::write_binary(os, kv.first.get_word(w));
+                }
+                utils::write_binary(os, kv.second.value.real());
+                utils::write_binary(os, kv.second.value.imag());
+            });
+        },
+        data_);
+}
+
+/* static */ [[nodiscard]] QuantumState QuantumState::read(std::istream& is) {
+    auto number_of_qubits = utils::read_binary<std::uint64_t>(is);
+    auto number_of_bits = utils::read_binary<std::uint64_t>(is);
+    auto layout = utils::read_binary<std::uint8_t>(is);
+    if (!is || layout > static_cast<std::uint8_t>(SparseArrayLayout::sorted_vector)) {
+        throw QuantumStateError{ "invalid quantum state data" };
+    }
+    auto ret = QuantumState{ static_cast<std::size_t>(number_of_qubits),
+        static_cast<std::size_t>(number_of_bits),
+        static_cast<SparseArrayLayout>(layout) };
+    auto number_of_positions = utils::read_binary<std::uint64_t>(is);
+    if (!is || (number_of_positions != 0 && number_of_positions != number_of_qubits)) {
+        throw QuantumStateError{ "invalid quantum state data" };
+    }
+    // The amplitudes are stored with the qubits at these positions already
+    if (number_of_positions != 0) {
+        ret.position_of_qubit_.resize(ret.number_of_qubits_);
+        ret.qubit_at_position_.assign(ret.number_of_qubits_, ret.number_of_qubits_);
+        for (std::size_t qubit = 0; qubit < ret.number_of_qubits_; ++qubit) {
+            auto position = utils::read_binary<std::uint64_t>(is);
+            if (!is || position >= number_of_qubits || ret.qubit_at_position_[position] != ret.number_of_qubits_) {
+                throw QuantumStateError{ "invalid quantum state data" };
+            }
+            ret.position_of_qubit_[qubit] = position;
+            ret.qubit_at_position_[position] = qubit;
+        }
+    }
+    auto size = utils::read_binary<std::uint64_t>(is);
+    std::visit(
+        [&is, size](auto& data) {
+            using BasisVectorT = typename std::decay_t<decltype(data)>::BasisVectorType;
+            constexpr auto number_of_words = BasisVectorT::MAX_NUMBER_OF_BITS / 64;
+            data.clear();
+            for (std::uint64_t i = 0; i < size && is; ++i) {
+                auto basis_vector = BasisVectorT{};
+                for (std::size_t w = 0; w < number_of_words; ++w) {
+                    auto word = utils::read_binary<std::uint64_t>(is);
+                    for (std::size_t bit = 0; bit < 64; ++bit) {
+                        basis_vector.set(w * 64 + bit, (word >> bit) & 1);
+                    }
+                }
+                auto real = utils::read_binary<double>(is);
+                auto imag = utils::read_binary<double>(is);
+                data[basis_vector] = SparseComplex{ std::complex<double>{ real, imag } };
+            }
+        },
+        ret.data_);
+    if (!is) {
+        throw QuantumStateError{ "invalid quantum state data" };
+    }
+    std::fill(ret.cached_marginal_probabilities_.begin(), ret.cached_marginal_probabilities_.end(), false);
+    return ret;
+}
+
 std::ostream& operator<<(std::ostream& os, const QuantumState& state) {
     return os << fmt::format("[{}]", fmt::join(state.to_vector(), ", "));
 }
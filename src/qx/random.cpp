@@ -1,6 +1,11 @@
 #include "qx/random.hpp"
 
+#include <algorithm>  // min, upper_bound
+#include <cmath>  // floor, log, log1p
+#include <limits>
 #include <random>
+#include <sstream>
+#include <stdexcept>  // invalid_argument
 
 namespace qx::random {
 
@@ -29,6 +34,22 @@ void seed(std::uint_fast64_t seed_value) {
     RandomNumberGenerator::get_instance().seed(seed_value);
 }
 
+std::string get_state() {
+    auto ss = std::ostringstream{};
+    ss << RandomNumberGenerator::get_instance();
+    return ss.str();
+}
+
+void set_state(const std::string& state) {
+    auto ss = std::istringstream{ state };
+    auto random_number_generator = RandomNumberGenerator::RandomNumberGeneratorType{};
+    ss >> random_number_generator;
+    if (!ss) {
+        throw std::invalid_argument{ "invalid random number generator state" };
+    }
+    RandomNumberGenerator::get_instance() = random_number_generator;
+}
+
 double random_zero_one_double() {
     // std::uniform_real_distribution<double> does not give the same result across platforms, so use this instead
     double result = uniform_min_max_integer_distribution(
@@ -67,6 +88,29 @@ std::uint_fast64_t random_integer(std::uint_fast64_t min, std::uint_fast64_t max
     return result;
 }
 
+std::size_t random_index(const std::vector<double>& cumulative_weights) {
+    assert(!cumulative_weights.empty());
+
+    auto x = random_zero_one_double() * cumulative_weights.back();
+    auto it = std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), x);
+    return std::min(static_cast<std::size_t>(it - cumulative_weights.begin()), cumulative_weights.size() - 1);
+}
+
+// Inverse transform sampling: P(k or more failures) = (1 - p)^k
+std::size_t random_geometric(double p) {
+    assert(0. <= p && p <= 1.);
+
+    if (p == 1.) {
+        return 0;
+    }
+    if (p == 0.) {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    auto k = std::floor(std::log(random_zero_one_double()) / std::log1p(-p));
+    return k < static_cast<double>(std::numeric_limits<std::size_t>::max()) ? static_cast<std::size_t>(k)
+                                                                           : std::numeric_limits<std::size_t>::max();
+}
+
 double uniform_min_max_integer_distribution(std::uint_fast64_t min, std::uint_fast64_t max, double x) {
     assert(min <= max);
 
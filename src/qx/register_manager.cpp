@@ -3,9 +3,9 @@
 #include <fmt/format.h>
 
 #include <algorithm>  // fill
+#include <cstdint>  // SIZE_MAX
 #include <range/v3/numeric/accumulate.hpp>
 #include <range/v3/view/filter.hpp>
-#include <range/v3/view/transform.hpp>
 
 #include "qx/compile_time_configuration.hpp"
 #include "qx/cqasm_v3x.hpp"
@@ -23,13 +23,32 @@ RegisterManagerError::RegisterManagerError(const std::string& message)
 // Register //
 //----------//
 
-Register::Register(const TreeOne<CqasmV3xProgram>& program, auto&& is_of_type, std::size_t max_register_size) {
+namespace {
+
+[[nodiscard]] RegisterVariables get_register_variables(const TreeOne<CqasmV3xProgram>& program, auto&& is_of_type) {
     auto&& variables = program->variables.get_vec() |
         ranges::views::filter([&](const TreeOne<CqasmV3xVariable>& variable) { return is_of_type(*variable); });
-    auto&& variable_sizes = variables | ranges::views::transform([](const TreeOne<CqasmV3xVariable>& variable) {
-        return cqasm_v3x_types::size_of(variable->typ);
-    });
-    register_size_ = ranges::accumulate(variable_sizes, size_t{});
+    auto ret = RegisterVariables{};
+    for (auto&& variable : variables) {
+        ret.emplace_back(variable->name, static_cast<size_t>(cqasm_v3x_types::size_of(variable->typ)));
+    }
+    return ret;
+}
+
+}  // namespace
+
+Register::Register(const TreeOne<CqasmV3xProgram>& program, auto&& is_of_type, std::size_t max_register_size)
+: Register{ get_register_variables(program, is_of_type), max_register_size } {}
+
+Register::Register(const RegisterVariables& variables, std::size_t max_register_size) {
+    register_size_ = 0;
+    for (const auto& [name, variable_size] : variables) {
+        // Sizes read from a compiled circuit can be anything, so their sum is checked
+        if (variable_size > SIZE_MAX - register_size_) {
+            throw RegisterManagerError{ "register size overflows" };
+        }
+        register_size_ += variable_size;
+    }
 
     if (register_size_ > max_register_size) {
         throw RegisterManagerError{ fmt::format(
@@ -41,12 +60,11 @@ Register::Register(const TreeOne<CqasmV3xProgram>& program, auto&& is_of_type, s
     dirty_bitset_ = DirtyBitsetT{ register_size_ };
 
     auto current_index = size_t{};
-    for (auto&& variable : variables) {
-        const auto& variable_size = static_cast<size_t>(cqasm::v3x::types::size_of(variable->typ));
-        variable_name_to_range_[variable->name] = Range{ current_index, variable_size };
+    for (const auto& [name, variable_size] : variables) {
+        variable_name_to_range_[name] = Range{ current_index, variable_size };
         std::fill(index_to_variable_name_.begin() + static_cast<long>(current_index),
             index_to_variable_name_.begin() + static_cast<long>(current_index + variable_size),
-            variable->name);
+            name);
         current_index += variable_size;
     };
 }
@@ -57,6 +75,17 @@ Register::~Register() = default;
     return register_size_;
 }
 
+[[nodiscard]] RegisterVariables Register::get_variables() const {
+    auto ret = RegisterVariables{};
+    for (std::size_t index = 0; index < register_size_;) {
+        const auto& name = index_to_variable_name_[index];
+        const auto& range = variable_name_to_range_.at(name);
+        ret.emplace_back(name, range.size);
+        index = range.first + range.size;
+    }
+    return ret;
+}
+
 [[nodiscard]] Range Register::at(const VariableName& name) const {
     return variable_name_to_range_.at(name);
 }
@@ -97,6 +126,9 @@ void Register::set_dirty(const Index& index) {
 QubitRegister::QubitRegister(const TreeOne<CqasmV3xProgram>& program)
 : Register{ program, is_qubit_variable, config::MAX_QUBIT_NUMBER } {}
 
+QubitRegister::QubitRegister(const RegisterVariables& variables)
+: Register{ variables, config::MAX_QUBIT_NUMBER } {}
+
 QubitRegister::~QubitRegister() = default;
 
 //-----------------//
@@ -106,6 +138,9 @@ QubitRegister::~QubitRegister() = default;
 BitRegister::BitRegister(const TreeOne<CqasmV3xProgram>& program)
 : Register{ program, is_bit_variable, config::MAX_BIT_NUMBER } {}
 
+BitRegister::BitRegister(const RegisterVariables& variables)
+: Register{ variables, config::MAX_BIT_NUMBER } {}
+
 BitRegister::~BitRegister() = default;
 
 //-----------------//
@@ -123,6 +158,13 @@ BitRegister::~BitRegister() = default;
     instance.bit_register_ = std::make_shared<BitRegister>(program);
 }
 
+/* static */ void RegisterManager::create_instance(
+    const RegisterVariables& qubit_variables, const RegisterVariables& bit_variables) {
+    auto& instance = get_instance_impl();
+    instance.qubit_register_ = std::make_shared<QubitRegister>(qubit_variables);
+    instance.bit_register_ = std::make_shared<BitRegister>(bit_variables);
+}
+
 [[nodiscard]] /* static */ RegisterManager& RegisterManager::get_instance() {
     auto& instance = get_instance_impl();
     if (!instance.qubit_register_ or !instance.bit_register_) {
@@ -3,12 +3,21 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>  // max
+#include <cmath>  // sqrt
+#include <complex>
 #include <cstdint>  // uint8_t
+#include <istream>
 #include <ostream>
+#include <string>
+#include <vector>
 
+#include "qx/compile_time_configuration.hpp"  // MAX_BIT_NUMBER
 #include "qx/core.hpp"
 #include "qx/quantum_state.hpp"
 #include "qx/register_manager.hpp"
+#include "qx/simulation_error.hpp"
+#include "qx/utils.hpp"  // read_binary, write_binary
 
 namespace qx {
 
@@ -53,6 +62,44 @@ std::ostream& operator<<(std::ostream& os, const SuperposedState& superposed_sta
 std::ostream& operator<<(std::ostream& os, const SimulationResult& simulation_result) {
     fmt::print(os, "Shots requested: {}\n", simulation_result.shots_requested);
     fmt::print(os, "Shots done: {}\n", simulation_result.shots_done);
+    if (simulation_result.truncation_error) {
+        fmt::print(os, "Truncation error: {}\n", *simulation_result.truncation_error);
+    }
+    if (simulation_result.paging_statistics) {
+        const auto& statistics = *simulation_result.paging_statistics;
+        fmt::print(os,
+            "Paging: {} bytes read, {} bytes written, {:.1f} MB/s\n",
+            statistics.bytes_read,
+            statistics.bytes_written,
+            statistics.get_throughput() / 1e6);
+    }
+    if (simulation_result.compression_statistics) {
+        const auto& statistics = *simulation_result.compression_statistics;
+        fmt::print(os,
+            "Compression: {} bytes at peak, error {}, fidelity loss {}\n",
+            statistics.peak_bytes,
+            statistics.error,
+            statistics.get_fidelity_loss());
+    }
+    if (simulation_result.circuit_optimization) {
+        const auto& optimization = *simulation_result.circuit_optimization;
+        auto removed_gates = std::vector<std::string>{};
+        for (const auto& [name, count] : optimization.removed_gates) {
+            removed_gates.push_back(fmt::format("{} x{}", name.empty() ? "unnamed" : name, count));
+        }
+        fmt::print(os,
+            "Optimization: {} gates cancelled, {} gates merged ({})\n",
+            optimization.number_of_cancelled_gates,
+            optimization.number_of_merged_gates,
+            fmt::join(removed_gates, ", "));
+    }
+    if (simulation_result.circuit_pruning) {
+        const auto& pruning = *simulation_result.circuit_pruning;
+        fmt::print(os,
+            "Pruning: {} instructions removed, qubits simulated {}\n",
+            pruning.number_of_removed_instructions,
+            pruning.simulated_qubits);
+    }
     fmt::print(os, "State:\n\t{}\n", fmt::join(simulation_result.state, "\n\t"));
     fmt::print(os, "Measurements:\n\t{}\n", fmt::join(simulation_result.measurements, "\n\t"));
     fmt::print(os, "Bit measurements:\n\t{}\n", fmt::join(simulation_result.bit_measurements, "\n\t"));
@@ -65,36 +112,110 @@ std::ostream& operator<<(std::ostream& os, const SimulationResult& simulation_re
 // SimulationIterationContext //
 //----------------------------//
 
-SimulationIterationContext::SimulationIterationContext()
-: state{ RegisterManager::get_instance().get_qubit_register_size(),
-    RegisterManager::get_instance().get_bit_register_size() }
-, measurement_register{ RegisterManager::get_instance().get_qubit_register_size() }
+SimulationIterationContext::SimulationIterationContext(const SimulationOptions& options)
+: SimulationIterationContext{ RegisterManager::get_instance().get_qubit_register_size(), options } {}
+
+SimulationIterationContext::SimulationIterationContext(std::size_t number_of_qubits, const SimulationOptions& options)
+: state{ number_of_qubits, RegisterManager::get_instance().get_bit_register_size(), options.sparse_array_layout }
+, measurement_register{ number_of_qubits }
 , bit_measurement_register{ RegisterManager::get_instance().get_bit_register_size() } {}
 
+//---------------------//
+// DensityMatrixBranch //
+//---------------------//
+
+DensityMatrixBranch::DensityMatrixBranch(std::size_t number_of_qubits, std::size_t number_of_bits)
+: density_matrix{ number_of_qubits }
+, measurement_register{ number_of_qubits }
+, bit_measurement_register{ number_of_bits } {}
+
 //--------------------------------//
 // SimulationIterationAccumulator //
 //--------------------------------//
 
-void SimulationIterationAccumulator::add(const SimulationIterationContext& context) {
+void SimulationIterationAccumulator::add(const SimulationIterationContext& context, count_t shots) {
+    number_of_qubits = context.state.get_number_of_qubits();
     state = context.state;
+    probabilities.reset();
     // Notice that the simulator always stores the values of the measurement registers
     // even when no measure instruction has been executed
     // When a measure instruction is executed, the outcome of the quantum state collapse is simulated
-    append_measurement(context.measurement_register);
-    append_bit_measurement(context.bit_measurement_register);
-    shots_done++;
+    append_measurement(context.measurement_register, shots);
+    append_bit_measurement(context.bit_measurement_register, shots);
+    shots_done += shots;
+}
+
+void SimulationIterationAccumulator::add(const core::DensityMatrix& density_matrix,
+    const core::MeasurementRegister& measurement_register,
+    const core::BitMeasurementRegister& bit_measurement_register, count_t shots) {
+    number_of_qubits = density_matrix.get_number_of_qubits();
+    state.reset();
+    probabilities = density_matrix.get_diagonal();
+    append_measurement(measurement_register, shots);
+    append_bit_measurement(bit_measurement_register, shots);
+    shots_done += shots;
+}
+
+void SimulationIterationAccumulator::add_truncation_error(double error) {
+    truncation_error = std::max(truncation_error.value_or(0.), error);
+}
+
+void SimulationIterationAccumulator::add_paging_statistics(const core::PagingStatistics& statistics) {
+    if (!paging_statistics) {
+        paging_statistics = core::PagingStatistics{};
+    }
+    *paging_statistics += statistics;
+}
+
+void SimulationIterationAccumulator::add_compression_statistics(const core::CompressionStatistics& statistics) {
+    if (!compression_statistics) {
+        compression_statistics = core::CompressionStatistics{};
+    }
+    compression_statistics->merge(statistics);
 }
 
-void SimulationIterationAccumulator::append_measurement(const core::MeasurementRegister& measurement) {
-    assert(measurements.size() < (static_cast<size_t>(1) << state.get_number_of_qubits()));
-    auto measured_state_string{ core::to_substring(measurement, state.get_number_of_qubits()) };
-    measurements[measured_state_string]++;
+void SimulationIterationAccumulator::append_measurement(
+    const core::MeasurementRegister& measurement, count_t shots) {
+    auto measured_state_string{ core::to_substring(measurement, number_of_qubits) };
+    measurements[measured_state_string] += shots;
 }
 
-void SimulationIterationAccumulator::append_bit_measurement(const core::BitMeasurementRegister& bit_measurement) {
-    assert(bit_measurements.size() < (static_cast<size_t>(1) << state.get_number_of_qubits()));
+void SimulationIterationAccumulator::append_bit_measurement(
+    const core::BitMeasurementRegister& bit_measurement, count_t shots) {
     auto bit_measured_state_string{ fmt::format("{}", bit_measurement) };
-    bit_measurements[bit_measured_state_string]++;
+    bit_measurements[bit_measured_state_string] += shots;
+}
+
+[[nodiscard]] std::uint64_t SimulationIterationAccumulator::get_shots_done() const {
+    return shots_done;
+}
+
+void SimulationIterationAccumulator::write_shots(std::ostream& os) const {
+    utils::write_binary(os, static_cast<std::uint64_t>(number_of_qubits));
+    utils::write_binary(os, shots_done);
+    for (const auto* histogram : { &measurements, &bit_measurements }) {
+        utils::write_binary(os, static_cast<std::uint64_t>(histogram->size()));
+        for (const auto& [state_string, count] : *histogram) {
+            utils::write_binary_string(os, state_string);
+            utils::write_binary(os, count);
+        }
+    }
+}
+
+void SimulationIterationAccumulator::read_shots(std::istream& is) {
+    *this = SimulationIterationAccumulator{};
+    number_of_qubits = static_cast<std::size_t>(utils::read_binary<std::uint64_t>(is));
+    shots_done = utils::read_binary<std::uint64_t>(is);
+    for (auto* histogram : { &measurements, &bit_measurements }) {
+        auto size = utils::read_binary<std::uint64_t>(is);
+        for (std::uint64_t i = 0; i < size && is; ++i) {
+            auto state_string = utils::read_binary_string(is, config::MAX_BIT_NUMBER);
+            (*histogram)[state_string] = utils::read_binary<count_t>(is);
+        }
+    }
+    if (!is) {
+        throw SimulationError{ "invalid shot data" };
+    }
 }
 
 // Notice that, with the current implementation:
@@ -108,13 +229,25 @@ SimulationResult SimulationIterationAccumulator::get_simulation_result(std::size
         RegisterManager::get_instance().get_qubit_register(),
         RegisterManager::get_instance().get_bit_register() };
 
-    for_all_non_zero_states([this, &simulation_result](
-                                const core::BasisVector& superposed_state, const core::SparseComplex& sparse_complex) {
-        auto state_string = core::to_substring(superposed_state, state.get_number_of_qubits());
-        auto c = sparse_complex.value;
-        auto amplitude = amplitude_t{ c.real(), c.imag(), std::norm(c) };
-        simulation_result.state.push_back(SuperposedState{ state_string, amplitude });
-    });
+    if (probabilities) {
+        // The probability p of every basis vector is reported as a real amplitude sqrt(p), so that its norm is p
+        for (std::size_t i = 0; i < probabilities->size(); ++i) {
+            auto c = std::complex<double>{ std::sqrt(std::max((*probabilities)[i], 0.)) };
+            if (core::is_not_null(c)) {
+                auto state_string = core::to_substring(core::BasisVector{ i }, number_of_qubits);
+                auto amplitude = amplitude_t{ c.real(), c.imag(), std::norm(c) };
+                simulation_result.state.push_back(SuperposedState{ state_string, amplitude });
+            }
+        }
+    } else if (state) {
+        for_all_non_zero_states([this, &simulation_result](const auto& superposed_state,
+                                    const core::SparseComplex& sparse_complex) {
+            auto state_string = core::to_substring(superposed_state, number_of_qubits);
+            auto c = sparse_complex.value;
+            auto amplitude = amplitude_t{ c.real(), c.imag(), std::norm(c) };
+            simulation_result.state.push_back(SuperposedState{ state_string, amplitude });
+        });
+    }
 
     for (const auto& [state_string, count] : measurements) {
         simulation_result.measurements.push_back(Measurement{ state_string, count });
@@ -122,6 +255,9 @@ SimulationResult SimulationIterationAccumulator::get_simulation_result(std::size
     for (const auto& [state_string, count] : bit_measurements) {
         simulation_result.bit_measurements.push_back(Measurement{ state_string, count });
     }
+    simulation_result.truncation_error = truncation_error;
+    simulation_result.paging_statistics = paging_statistics;
+    simulation_result.compression_statistics = compression_statistics;
 
     return simulation_result;
 }
@@ -1,6 +1,8 @@
 #include "qx/simulator.hpp"
 
+#include "qx/checkpoint.hpp"
 #include "qx/circuit_builder.hpp"
+#include "qx/compiled_circuit.hpp"
 #include "qx/cqasm_v3x.hpp"
 #include "qx/random.hpp"
 #include "qx/register_manager.hpp"
@@ -10,11 +12,19 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>  // min
+#include <filesystem>
+#include <functional>  // function, plus
 #include <iostream>
+#include <map>
+#include <numeric>  // partial_sum, transform_inclusive_scan
 #include <optional>
 #include <range/v3/numeric/accumulate.hpp>
 #include <range/v3/view/iota.hpp>
+#include <stdexcept>  // invalid_argument
+#include <utility>  // move, pair
 #include <variant>  // monostate
+#include <vector>
 
 #include "libqasm/v3x/cqasm.hpp"  // default_analyzer
 
@@ -45,15 +55,273 @@ std::variant<TreeOne<CqasmV3xProgram>, SimulationError> get_analysis_result(
     return program;
 }
 
-std::variant<std::monostate, SimulationResult, SimulationError> execute(
-    const CqasmV3xAnalysisResult& cqasm_v3x_analysis_result, std::size_t iterations,
-    std::optional<std::uint_fast64_t> seed) {
-    auto analysis_result = get_analysis_result(cqasm_v3x_analysis_result);
-    if (auto* error = std::get_if<SimulationError>(&analysis_result)) {
-        return *error;
+// Distribute the shots among the branches, and accumulate them
+// The final quantum state is the state of the branch of the last shot
+SimulationIterationAccumulator sample_branches(const SimulationBranches& branches, std::size_t iterations) {
+    auto cumulative_probabilities = std::vector<double>(branches.size());
+    std::transform_inclusive_scan(branches.begin(),
+        branches.end(),
+        cumulative_probabilities.begin(),
+        std::plus<>{},
+        [](const auto& branch) { return branch.probability; });
+    auto shots = std::vector<count_t>(branches.size(), 0);
+    std::size_t last_branch = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        last_branch = random::random_index(cumulative_probabilities);
+        ++shots[last_branch];
     }
-    const auto& program = std::get<TreeOne<CqasmV3xProgram>>(analysis_result);
+    auto acc = SimulationIterationAccumulator{};
+    for (std::size_t i = 0; i < branches.size(); ++i) {
+        if (shots[i] != 0 && i != last_branch) {
+            acc.add(branches[i].context, shots[i]);
+        }
+    }
+    acc.add(branches[last_branch].context, shots[last_branch]);
+    return acc;
+}
+
+// Distribute the shots among the branches, and among the basis vectors of the final density matrix of each branch
+// The values of the deferred measures are the values of their qubits in the sampled basis vector
+// The final state is the diagonal of the final density matrix of the branch of the last shot
+SimulationIterationAccumulator sample_density_matrix_execution(
+    const DensityMatrixExecution& execution, std::size_t iterations) {
+    const auto& branches = execution.branches;
+    auto cumulative_probabilities = std::vector<double>(branches.size());
+    std::transform_inclusive_scan(branches.begin(),
+        branches.end(),
+        cumulative_probabilities.begin(),
+        std::plus<>{},
+        [](const auto& branch) { return branch.probability; });
+    auto cumulative_diagonals = std::vector<std::vector<double>>(branches.size());
+    auto shots = std::map<std::pair<std::size_t, std::size_t>, count_t>{};
+    auto last_shot = std::pair<std::size_t, std::size_t>{};
+    for (std::size_t i = 0; i < iterations; ++i) {
+        auto branch = random::random_index(cumulative_probabilities);
+        auto& cumulative_diagonal = cumulative_diagonals[branch];
+        if (cumulative_diagonal.empty()) {
+            cumulative_diagonal = branches[branch].density_matrix.get_diagonal();
+            std::partial_sum(cumulative_diagonal.begin(), cumulative_diagonal.end(), cumulative_diagonal.begin());
+        }
+        last_shot = { branch, random::random_index(cumulative_diagonal) };
+        ++shots[last_shot];
+    }
+    auto acc = SimulationIterationAccumulator{};
+    auto add = [&acc, &execution](const auto& shot, count_t count) {
+        const auto& branch = execution.branches[shot.first];
+        auto measurement_register = branch.measurement_register;
+        auto bit_measurement_register = branch.bit_measurement_register;
+        auto basis_vector = core::BasisVector{ shot.second };
+        for (const auto& [qubit_index, bit_index] : execution.deferred_measures) {
+            measurement_register.set(qubit_index.value, basis_vector.test(qubit_index.value));
+            bit_measurement_register.set(bit_index.value, basis_vector.test(qubit_index.value));
+        }
+        acc.add(branch.density_matrix, measurement_register, bit_measurement_register, count);
+    };
+    for (const auto& [shot, count] : shots) {
+        if (shot != last_shot) {
+            add(shot, count);
+        }
+    }
+    add(last_shot, shots[last_shot]);
+    return acc;
+}
+
+// Execute the circuit with execute(), which returns an execution of a backend whose final states are sampled
+// shot by shot, and add to acc the shots sampled from the final states
+// An execution that has not sampled the outcome of any measurement or reset stands for all the remaining shots
+template <typename Execute>
+void sample_executions(SimulationIterationAccumulator& acc, std::size_t iterations, Execute&& execute) {
+    for (std::size_t shots_left = iterations; shots_left > 0;) {
+        auto execution = execute();
+        auto& context = execution.context;
+        auto shots = context.has_sampled_outcomes ? 1 : shots_left;
+        for (std::size_t i = 0; i < shots; ++i) {
+            auto measurement_register = context.measurement_register;
+            auto bit_measurement_register = context.bit_measurement_register;
+            if (!execution.deferred_measures.empty()) {
+                auto sample = context.state.sample(&random::random_zero_one_double);
+                for (const auto& [qubit_index, bit_index] : execution.deferred_measures) {
+                    measurement_register.set(qubit_index.value, sample.test(qubit_index.value));
+                    bit_measurement_register.set(bit_index.value, sample.test(qubit_index.value));
+                }
+            }
+            acc.add(context.state, measurement_register, bit_measurement_register, 1);
+        }
+        shots_left -= shots;
+    }
+}
+
+// Add shots of an execution of a dense state vector backend
+// All the shots are sampled at once, in a single pass over the amplitudes
+template <typename Execution>
+void add_state_vector_shots(SimulationIterationAccumulator& acc, Execution& execution, std::size_t shots) {
+    auto& context = execution.context;
+    if (execution.deferred_measures.empty()) {
+        acc.add(context.state, context.measurement_register, context.bit_measurement_register, shots);
+        return;
+    }
+    for (const auto& sample : context.state.sample(shots, &random::random_zero_one_double)) {
+        auto measurement_register = context.measurement_register;
+        auto bit_measurement_register = context.bit_measurement_register;
+        for (const auto& [qubit_index, bit_index] : execution.deferred_measures) {
+            measurement_register.set(qubit_index.value, sample.test(qubit_index.value));
+            bit_measurement_register.set(bit_index.value, sample.test(qubit_index.value));
+        }
+        acc.add(context.state, measurement_register, bit_measurement_register, 1);
+    }
+}
+
+// Same as sample_executions, for the distributed_state_vector backend
+SimulationIterationAccumulator sample_distributed_state_vector_executions(
+    const Circuit& circuit, const SimulationOptions& options, std::size_t iterations) {
+    auto local_communicator = core::LocalCommunicator{};
+    auto& communicator = options.communicator ? *options.communicator : local_communicator;
+    auto acc = SimulationIterationAccumulator{};
+    for (std::size_t shots_left = iterations; shots_left > 0;) {
+        auto execution = circuit.execute_distributed_state_vector(options, communicator);
+        auto shots = execution.context.has_sampled_outcomes ? 1 : shots_left;
+        add_state_vector_shots(acc, execution, shots);
+        shots_left -= shots;
+    }
+    return acc;
+}
+
+// Same for the paged_state_vector and compressed_state_vector backends, also accounting for the data paged in and out,
+// and the compression, of every execution
+SimulationIterationAccumulator sample_paged_state_vector_executions(
+    const Circuit& circuit, const SimulationOptions& options, std::size_t iterations) {
+    auto acc = SimulationIterationAccumulator{};
+    for (std::size_t shots_left = iterations; shots_left > 0;) {
+        auto execution = circuit.execute_paged_state_vector(options);
+        auto shots = execution.context.has_sampled_outcomes ? 1 : shots_left;
+        add_state_vector_shots(acc, execution, shots);
+        acc.add_paging_statistics(execution.context.state.get_paging_statistics());
+        if (const auto* page_store =
+                dynamic_cast<const core::CompressedPageStore*>(execution.context.state.get_page_store())) {
+            acc.add_compression_statistics(page_store->get_compression_statistics());
+        }
+        shots_left -= shots;
+    }
+    return acc;
+}
+
+// Execute the circuit shot by shot, saving a checkpoint every options.checkpoint_interval instructions,
+// and resuming from options.checkpoint_file if it exists
+// After saving a checkpoint, the simulation goes on from the checkpoint read back from the file,
+// exactly as a resumed simulation would
+SimulationIterationAccumulator execute_with_checkpoints(
+    const Circuit& circuit, const SimulationOptions& options, std::size_t iterations) {
+    auto path = std::filesystem::path{ options.checkpoint_file };
+    auto checkpoint = Checkpoint{ iterations, circuit.get_number_of_instructions(), {}, {}, std::nullopt };
+    if (std::filesystem::exists(path)) {
+        checkpoint = Checkpoint::load(path);
+        if (checkpoint.iterations != iterations ||
+            checkpoint.number_of_instructions != circuit.get_number_of_instructions()) {
+            throw SimulationError{ fmt::format(
+                "checkpoint file does not belong to this simulation: {}", options.checkpoint_file) };
+        }
+        try {
+            random::set_state(checkpoint.random_state);
+        } catch (const std::invalid_argument&) {
+            throw SimulationError{ fmt::format("invalid checkpoint file: {}", options.checkpoint_file) };
+        }
+    }
+    auto instructions_since_checkpoint = std::size_t{ 0 };
+    auto save_checkpoint = [&](ExecutionCursor& cursor) {
+        if (++instructions_since_checkpoint < options.checkpoint_interval) {
+            return;
+        }
+        instructions_since_checkpoint = 0;
+        checkpoint.random_state = random::get_state();
+        checkpoint.cursor = std::move(cursor);
+        checkpoint.save(path);
+        checkpoint = Checkpoint::load(path);
+        cursor = std::move(*checkpoint.cursor);
+        checkpoint.cursor.reset();
+        if (options.stop_token.stop_requested()) {
+            throw SimulationError{ fmt::format(
+                "simulation stopped, progress saved to checkpoint file: {}", options.checkpoint_file) };
+        }
+    };
+    auto cursor = std::move(checkpoint.cursor);
+    checkpoint.cursor.reset();
+    while (checkpoint.accumulator.get_shots_done() < iterations) {
+        auto shot = cursor ? std::move(*cursor) : circuit.start_execution(options.error_model, options);
+        cursor.reset();
+        circuit.resume_execution(shot, options.error_model, save_checkpoint);
+        checkpoint.accumulator.add(shot.context);
+    }
+    std::filesystem::remove(path);
+    return std::move(checkpoint.accumulator);
+}
+
+// Run all the shots with the backend and the execution mode of the options
+SimulationResult simulate(Circuit& circuit, const SimulationOptions& options, std::size_t iterations) {
+    if (options.backend == Backend::density_matrix) {
+        return sample_density_matrix_execution(circuit.execute_density_matrix(options), iterations)
+            .get_simulation_result(iterations);
+    }
+    if (options.backend == Backend::matrix_product_state) {
+        auto acc = SimulationIterationAccumulator{};
+        sample_executions(acc, iterations, [&acc, &circuit, &options]() {
+            auto execution = circuit.execute_matrix_product_state(options);
+            acc.add_truncation_error(execution.context.state.get_truncation_error());
+            return execution;
+        });
+        return acc.get_simulation_result(iterations);
+    }
+    if (options.backend == Backend::factorized_state_vector) {
+        auto acc = SimulationIterationAccumulator{};
+        sample_executions(
+            acc, iterations, [&circuit, &options]() { return circuit.execute_factorized_state_vector(options); });
+        return acc.get_simulation_result(iterations);
+    }
+    if (options.backend == Backend::distributed_state_vector) {
+        return sample_distributed_state_vector_executions(circuit, options, iterations)
+            .get_simulation_result(iterations);
+    }
+    if (options.backend == Backend::paged_state_vector || options.backend == Backend::compressed_state_vector) {
+        return sample_paged_state_vector_executions(circuit, options, iterations).get_simulation_result(iterations);
+    }
+    // Errors are sampled shot by shot, so noisy circuits can not be executed as a branch tree
+    if (options.execution_mode == ExecutionMode::branch_tree &&
+        std::holds_alternative<std::monostate>(options.error_model)) {
+        if (auto branches = circuit.execute_branches(options, std::min(options.max_branches, iterations))) {
+            return sample_branches(*branches, iterations).get_simulation_result(iterations);
+        }
+    }
+    if (iterations > 1) {
+        circuit.cache_noiseless_prefix(options);
+    }
+    if (!options.checkpoint_file.empty()) {
+        return execute_with_checkpoints(circuit, options, iterations).get_simulation_result(iterations);
+    }
+    auto simulation_iteration_accumulator = ranges::accumulate(ranges::views::iota(static_cast<size_t>(0), iterations),
+        SimulationIterationAccumulator{},
+        [&circuit, &options](auto& acc, auto) {
+            acc.add(circuit.execute(options.error_model, options));
+            return acc;
+        });
+    return simulation_iteration_accumulator.get_simulation_result(iterations);
+}
 
+// The measurements of a pruned circuit only have the qubits simulated: give them all the qubits of the register,
+// the ones that were not simulated being 0, as they were never acted on
+void expand_measurements(
+    SimulationResult::Measurements& measurements, const std::vector<std::size_t>& simulated_qubits) {
+    auto number_of_qubits = RegisterManager::get_instance().get_qubit_register_size();
+    for (auto& measurement : measurements) {
+        auto state = state_string_t(number_of_qubits, '0');
+        for (std::size_t i = 0; i < simulated_qubits.size(); ++i) {
+            state[number_of_qubits - simulated_qubits[i] - 1] = measurement.state[simulated_qubits.size() - i - 1];
+        }
+        measurement.state = std::move(state);
+    }
+}
+
+// Simulate the circuit returned by get_circuit, which also creates the register manager
+std::variant<std::monostate, SimulationResult, SimulationError> execute(const std::function<Circuit()>& get_circuit,
+    std::size_t iterations, std::optional<std::uint_fast64_t> seed, const SimulationOptions& options) {
     if (iterations == 0) {
         return SimulationError{ "invalid number of iterations" };
     }
@@ -61,40 +329,128 @@ std::variant<std::monostate, SimulationResult, SimulationError> execute(
         random::seed(*seed);
     }
 
+    try {
+        auto circuit = get_circuit();
+        auto circuit_pruning = std::optional<CircuitPruning>{};
+        if (options.measurements_only && std::holds_alternative<std::monostate>(options.error_model)) {
+            circuit_pruning = circuit.prune();
+        }
+        auto circuit_optimization = std::optional<CircuitOptimization>{};
+        if (options.optimize_circuit && std::holds_alternative<std::monostate>(options.error_model)) {
+            circuit_optimization = circuit.optimize();
+        }
+        auto simulation_result = simulate(circuit, options, iterations);
+        if (circuit_pruning) {
+            expand_measurements(simulation_result.measurements, circuit_pruning->simulated_qubits);
+        }
+        if (options.measurements_only) {
+            simulation_result.state.clear();
+        }
+        simulation_result.circuit_optimization = std::move(circuit_optimization);
+        simulation_result.circuit_pruning = std::move(circuit_pruning);
+        return simulation_result;
+    } catch (const SimulationError& err) {
+        return err;
+    } catch (const core::DensityMatrixError& err) {
+        return SimulationError{ err.what() };
+    } catch (const core::DistributedStateVectorError& err) {
+        return SimulationError{ err.what() };
+    } catch (const core::FactorizedStateVectorError& err) {
+        return SimulationError{ err.what() };
+    } catch (const core::MatrixProductStateError& err) {
+        return SimulationError{ err.what() };
+    } catch (const core::PagedStateVectorError& err) {
+        return SimulationError{ err.what() };
+    } catch (const core::QuantumStateError& err) {
+        return SimulationError{ err.what() };
+    }
+}
+
+std::variant<std::monostate, SimulationResult, SimulationError> execute(
+    const CqasmV3xAnalysisResult& cqasm_v3x_analysis_result, std::size_t iterations,
+    std::optional<std::uint_fast64_t> seed, const SimulationOptions& options) {
+    auto analysis_result = get_analysis_result(cqasm_v3x_analysis_result);
+    if (auto* error = std::get_if<SimulationError>(&analysis_result)) {
+        return *error;
+    }
+    const auto& program = std::get<TreeOne<CqasmV3xProgram>>(analysis_result);
+    return execute(
+        [&program]() {
+            RegisterManager::create_instance(program);
+            return Circuit{ program };
+        },
+        iterations,
+        seed,
+        options);
+}
+
+std::optional<SimulationError> compile(
+    const CqasmV3xAnalysisResult& cqasm_v3x_analysis_result, const std::string& output_file_path) {
+    auto analysis_result = get_analysis_result(cqasm_v3x_analysis_result);
+    if (auto* error = std::get_if<SimulationError>(&analysis_result)) {
+        return *error;
+    }
+    const auto& program = std::get<TreeOne<CqasmV3xProgram>>(analysis_result);
     try {
         RegisterManager::create_instance(program);
-        auto circuit = Circuit{ program };
-        auto simulation_iteration_accumulator =
-            ranges::accumulate(ranges::views::iota(static_cast<size_t>(0), iterations),
-                SimulationIterationAccumulator{},
-                [&circuit](auto& acc, auto) {
-                    acc.add(circuit.execute(std::monostate{}));
-                    return acc;
-                });
-        return simulation_iteration_accumulator.get_simulation_result(iterations);
+        save_compiled_circuit(output_file_path, Circuit{ program });
     } catch (const SimulationError& err) {
         return err;
     }
+    return std::nullopt;
 }
 
 }  // namespace
 
 std::variant<std::monostate, SimulationResult, SimulationError> execute_string(const std::string& program,
-    std::size_t iterations, std::optional<std::uint_fast64_t> seed, std::string cqasm_version) {
+    std::size_t iterations, std::optional<std::uint_fast64_t> seed, std::string cqasm_version,
+    const SimulationOptions& options) {
     if (cqasm_version != "3.0") {
         return SimulationError{ fmt::format("unknown cQASM version: {}", cqasm_version) };
     }
     auto analysis_result = parse_cqasm_v3x_string(program);
-    return execute(analysis_result, iterations, seed);
+    return execute(analysis_result, iterations, seed, options);
 }
 
 std::variant<std::monostate, SimulationResult, SimulationError> execute_file(const std::string& file_path,
-    std::size_t iterations, std::optional<std::uint_fast64_t> seed, std::string cqasm_version) {
+    std::size_t iterations, std::optional<std::uint_fast64_t> seed, std::string cqasm_version,
+    const SimulationOptions& options) {
     if (cqasm_version != "3.0") {
         return SimulationError{ fmt::format("unknown cQASM version: {}", cqasm_version) };
     }
     auto analysis_result = parse_cqasm_v3x_file(file_path);
-    return execute(analysis_result, iterations, seed);
+    return execute(analysis_result, iterations, seed, options);
+}
+
+std::optional<SimulationError> compile_string(
+    const std::string& program, const std::string& output_file_path, std::string cqasm_version) {
+    if (cqasm_version != "3.0") {
+        return SimulationError{ fmt::format("unknown cQASM version: {}", cqasm_version) };
+    }
+    auto analysis_result = parse_cqasm_v3x_string(program);
+    return compile(analysis_result, output_file_path);
+}
+
+std::optional<SimulationError> compile_file(
+    const std::string& file_path, const std::string& output_file_path, std::string cqasm_version) {
+    if (cqasm_version != "3.0") {
+        return SimulationError{ fmt::format("unknown cQASM version: {}", cqasm_version) };
+    }
+    auto analysis_result = parse_cqasm_v3x_file(file_path);
+    return compile(analysis_result, output_file_path);
+}
+
+bool is_compiled_circuit_file(const std::string& file_path) {
+    return is_compiled_circuit(file_path);
+}
+
+std::variant<std::monostate, SimulationResult, SimulationError> execute_compiled_file(
+    const std::string& compiled_file_path, std::size_t iterations, std::optional<std::uint_fast64_t> seed,
+    const SimulationOptions& options) {
+    return execute([&compiled_file_path]() { return load_compiled_circuit(compiled_file_path); },
+        iterations,
+        seed,
+        options);
 }
 
 }  // namespace qx
@@ -3,9 +3,10 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
-#include <algorithm>  // erase_if
+#include <algorithm>  // lower_bound
 #include <complex>
 #include <ostream>
+#include <type_traits>  // is_same_v
 
 namespace qx::core {
 
@@ -16,89 +17,144 @@ SparseComplex::SparseComplex(std::complex<double> c) {
     value = c;
 }
 
-bool compare_sparse_elements(const SparseElement& lhs, const SparseElement& rhs) {
-    return lhs.first < rhs.first;
-}
-
-SparseArray::SparseArray(std::size_t s)
-: size_{ s } {}
+template <typename BasisVectorT>
+BasicSparseArray<BasisVectorT>::BasicSparseArray(std::size_t s, SparseArrayLayout layout)
+: size_{ s }
+, layout_{ layout } {}
 
-SparseArray::SparseArray(std::size_t s, std::initializer_list<PairBasisVectorStringComplex> values)
-: size_{ s } {
+template <typename BasisVectorT>
+BasicSparseArray<BasisVectorT>::BasicSparseArray(
+    std::size_t s, std::initializer_list<PairBasisVectorStringComplex> values, SparseArrayLayout layout)
+: size_{ s }
+, layout_{ layout } {
     for (const auto& [basis_vector_string, complex_value] : values) {
-        if ((static_cast<size_t>(1) << basis_vector_string.size()) > s) {
+        if (basis_vector_string.size() < BasisVector::MAX_NUMBER_OF_BITS &&
+            (static_cast<size_t>(1) << basis_vector_string.size()) > s) {
             throw SparseArrayError{ fmt::format(
                 "found value '{}' for a sparse array of size {}", basis_vector_string, s) };
         }
-        data_[BasisVector{ basis_vector_string }] = SparseComplex{ complex_value };
+        (*this)[BasisVectorT{ basis_vector_string }] = SparseComplex{ complex_value };
     }
 }
 
-SparseArray& SparseArray::operator*=(double d) {
-    for (auto& [_, sparse_complex] : data_) {
-        sparse_complex.value *= d;
-    }
+template <typename BasisVectorT>
+BasicSparseArray<BasisVectorT>::BasicSparseArray(const BasicSparseArray& other)
+: size_{ other.size_ }
+, layout_{ other.layout_ }
+, zero_counter_{ other.zero_counter_ }
+, data_{ other.data_ }
+, sorted_data_{ other.sorted_data_ } {}
+
+template <typename BasisVectorT>
+BasicSparseArray<BasisVectorT>& BasicSparseArray<BasisVectorT>::operator=(const BasicSparseArray& other) {
+    size_ = other.size_;
+    layout_ = other.layout_;
+    zero_counter_ = other.zero_counter_;
+    data_ = other.data_;
+    sorted_data_ = other.sorted_data_;
     return *this;
 }
 
-SparseComplex& SparseArray::operator[](const BasisVector& index) {
-#ifndef NDEBUG
-    if (index.to_ulong() >= size_) {
-        throw SparseArrayError{ "index out of bounds" };
-    }
-#endif
-    return data_[index];
-}
-
-[[nodiscard]] SparseArray::ConstIterator SparseArray::begin() const {
-    return data_.cbegin();
-}
-
-[[nodiscard]] SparseArray::ConstIterator SparseArray::end() const {
-    return data_.cend();
+template <typename BasisVectorT>
+[[nodiscard]] SparseArrayLayout BasicSparseArray<BasisVectorT>::get_layout() const {
+    return layout_;
 }
 
-[[nodiscard]] SparseArray::Iterator SparseArray::begin() {
-    return data_.begin();
+template <typename BasisVectorT>
+BasicSparseArray<BasisVectorT>& BasicSparseArray<BasisVectorT>::operator*=(double d) {
+    scale(d, [](const auto&) {});
+    return *this;
 }
 
-[[nodiscard]] SparseArray::Iterator SparseArray::end() {
-    return data_.end();
+template <typename BasisVectorT>
+SparseComplex& BasicSparseArray<BasisVectorT>::operator[](const BasisVectorT& index) {
+#ifndef NDEBUG
+    // Wider basis vectors index arrays whose size does not fit in a size_t
+    if constexpr (std::is_same_v<BasisVectorT, BasisVector>) {
+        if (index.to_ulong() >= size_) {
+            throw SparseArrayError{ "index out of bounds" };
+        }
+    }
+#endif
+    if (layout_ == SparseArrayLayout::sorted_vector) {
+        auto it = std::lower_bound(sorted_data_.begin(), sorted_data_.end(), index,
+            [](const SparseElement& element, const BasisVectorT& basis_vector) {
+                return element.first < basis_vector;
+            });
+        if (it == sorted_data_.end() || it->first != index) {
+            it = sorted_data_.emplace(it, index, SparseComplex{});
+        }
+        return it->second;
+    }
+    return data_[index];
 }
 
-void SparseArray::clear() {
+template <typename BasisVectorT>
+void BasicSparseArray<BasisVectorT>::clear() {
     data_.clear();
+    sorted_data_.clear();
 }
 
-[[nodiscard]] std::size_t SparseArray::size() const {
+template <typename BasisVectorT>
+[[nodiscard]] std::size_t BasicSparseArray<BasisVectorT>::size() const {
     return size_;
 }
 
-[[nodiscard]] double SparseArray::norm() {
+template <typename BasisVectorT>
+[[nodiscard]] std::size_t BasicSparseArray<BasisVectorT>::get_memory_size() const {
+    return (data_.capacity() + sorted_data_.capacity()) * sizeof(SparseElement);
+}
+
+template <typename BasisVectorT>
+[[nodiscard]] double BasicSparseArray<BasisVectorT>::norm() {
     return accumulate<double>(0., [](double total, const auto& kv) {
         const auto& [basis_vector, sparse_complex] = kv;
         return total + std::norm(sparse_complex.value);
     });
 }
 
-[[nodiscard]] std::vector<std::complex<double>> SparseArray::to_vector() const {
+template <typename BasisVectorT>
+[[nodiscard]] std::vector<std::complex<double>> BasicSparseArray<BasisVectorT>::to_vector() const {
     auto result = std::vector<std::complex<double>>(size_, 0.);
     for (const auto& [basis_vector, sparse_complex] : data_) {
         result[basis_vector.to_ulong()] = sparse_complex.value;
     }
+    for (const auto& [basis_vector, sparse_complex] : sorted_data_) {
+        result[basis_vector.to_ulong()] = sparse_complex.value;
+    }
     return result;
 }
 
-void SparseArray::clean_up_zeros() {
-    std::erase_if(data_, [](const auto& kv) {
+template <typename BasisVectorT>
+void BasicSparseArray<BasisVectorT>::count_gate() {
+    if (zero_counter_ >= config::ZERO_CYCLE_SIZE) {
+        clean_up_zeros();
+    }
+    ++zero_counter_;
+}
+
+template <typename BasisVectorT>
+void BasicSparseArray<BasisVectorT>::clean_up_zeros() {
+    erase_if([](const auto& kv) {
         const auto& [_, sparse_complex] = kv;
         return is_null(sparse_complex.value);
     });
     zero_counter_ = 0;
 }
 
-std::ostream& operator<<(std::ostream& os, const SparseArray& array) {
+template <typename BasisVectorT>
+std::ostream& operator<<(std::ostream& os, const BasicSparseArray<BasisVectorT>& array) {
     return os << fmt::format("[{}]", fmt::join(array.to_vector(), ", "));
 }
 
+template class BasicSparseArray<BasisVector>;
+template class BasicSparseArray<BasisVector128>;
+template class BasicSparseArray<BasisVector256>;
+template class BasicSparseArray<BasisVector1024>;
+
+template std::ostream& operator<<(std::ostream& os, const BasicSparseArray<BasisVector>& array);
+template std::ostream& operator<<(std::ostream& os, const BasicSparseArray<BasisVector128>& array);
+template std::ostream& operator<<(std::ostream& os, const BasicSparseArray<BasisVector256>& array);
+template std::ostream& operator<<(std::ostream& os, const BasicSparseArray<BasisVector1024>& array);
+
 }  // namespace qx::core
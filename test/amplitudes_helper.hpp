@@ -0,0 +1,27 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstddef>  // size_t
+
+#include "qx/core.hpp"
+#include "qx/quantum_state.hpp"
+
+namespace qx::core {
+
+[[nodiscard]] inline MeasurementRegister basis_vector(std::size_t number_of_qubits, std::size_t index) {
+    return MeasurementRegister{ number_of_qubits, index };
+}
+
+// Compare every amplitude with the ones of a state vector
+template <typename Victim>
+void check_eq(Victim& victim, const QuantumState& expected) {
+    auto expected_amplitudes = expected.to_vector();
+    for (std::size_t i = 0; i < expected_amplitudes.size(); ++i) {
+        auto actual = victim.get_amplitude(basis_vector(victim.get_number_of_qubits(), i));
+        EXPECT_NEAR(expected_amplitudes[i].real(), actual.real(), .000'000'000'01);
+        EXPECT_NEAR(expected_amplitudes[i].imag(), actual.imag(), .000'000'000'01);
+    }
+}
+
+}  // namespace qx::core
@@ -0,0 +1,140 @@
+#include "qx/circuit_optimizer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <complex>
+#include <cstddef>  // size_t
+#include <map>
+#include <memory>  // make_shared, shared_ptr
+#include <string>
+#include <vector>
+
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/instructions.hpp"
+#include "qx/quantum_state.hpp"
+
+#include "instructions_helper.hpp"
+
+namespace qx {
+
+class CircuitOptimizerTest : public ::testing::Test {
+protected:
+    // Final amplitudes of the gates applied to |00...000>
+    static std::vector<std::complex<double>> execute(
+        const std::vector<std::shared_ptr<Instruction>>& instructions, std::size_t number_of_qubits) {
+        auto state = core::QuantumState{ number_of_qubits, number_of_qubits };
+        for (const auto& instruction : instructions) {
+            const auto& unitary = dynamic_cast<const Unitary&>(*instruction);
+            state.apply(*unitary.matrix, *unitary.operands);
+        }
+        return state.to_vector();
+    }
+
+    static void check_same_state(const std::vector<std::shared_ptr<Instruction>>& original,
+        const std::vector<std::shared_ptr<Instruction>>& optimized, std::size_t number_of_qubits) {
+        auto expected = execute(original, number_of_qubits);
+        auto actual = execute(optimized, number_of_qubits);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(actual[i].real(), expected[i].real(), 1e-12);
+            EXPECT_NEAR(actual[i].imag(), expected[i].imag(), 1e-12);
+        }
+    }
+};
+
+TEST_F(CircuitOptimizerTest, cancels_pairs_separated_by_commuting_gates) {
+    auto original = std::vector{
+        make_unitary(gates::RY(.3), { 1 }, "Ry"),
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::Z, { 2 }, "Z"),
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::CNOT, { 0, 1 }, "CNOT"),
+        // Diagonal on the control, and block diagonal in the X basis on the target
+        make_unitary(gates::T, { 0 }, "T"),
+        make_unitary(gates::RX(.4), { 1 }, "Rx"),
+        make_unitary(gates::CZ, { 0, 2 }, "CZ"),
+        make_unitary(gates::CNOT, { 0, 1 }, "CNOT"),
+        make_unitary(gates::TDAG, { 0 }, "inv.T"),
+    };
+    auto optimized = original;
+    auto optimization = optimize_instructions(optimized);
+
+    // inv.T cancels with T, once CNOT; CNOT is gone
+    EXPECT_EQ(optimization.number_of_cancelled_gates, 6);
+    EXPECT_EQ(optimization.number_of_merged_gates, 0);
+    EXPECT_EQ(optimization.get_number_of_removed_gates(), 6);
+    EXPECT_EQ(optimization.removed_gates,
+        (std::map<std::string, std::size_t>{ { "CNOT", 2 }, { "H", 2 }, { "T", 1 }, { "inv.T", 1 } }));
+    ASSERT_EQ(optimized.size(), 4);
+    EXPECT_EQ(optimized[0], original[0]);
+    EXPECT_EQ(optimized[1], original[2]);
+    EXPECT_EQ(optimized[2], original[6]);
+    EXPECT_EQ(optimized[3], original[7]);
+    check_same_state(original, optimized, 3);
+}
+
+TEST_F(CircuitOptimizerTest, merges_rotations_on_the_same_axis) {
+    auto original = std::vector{
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::RX(.1), { 1 }, "Rx"),
+        make_unitary(gates::CNOT, { 0, 1 }, "CNOT"),
+        make_unitary(gates::RX(.2), { 1 }, "Rx"),
+        make_unitary(gates::RZ(.5), { 0 }, "Rz"),
+        make_unitary(gates::S, { 0 }, "S"),
+    };
+    auto optimized = original;
+    auto optimization = optimize_instructions(optimized);
+
+    EXPECT_EQ(optimization.number_of_cancelled_gates, 0);
+    EXPECT_EQ(optimization.number_of_merged_gates, 2);
+    ASSERT_EQ(optimized.size(), 4);
+    const auto& rx = dynamic_cast<const Unitary&>(*optimized[1]);
+    EXPECT_EQ(*rx.matrix, gates::RX(.3));
+    EXPECT_EQ(rx.name, "Rx");
+    const auto& phase = dynamic_cast<const Unitary&>(*optimized[3]);
+    EXPECT_EQ(*phase.matrix, gates::S * gates::RZ(.5));
+    EXPECT_EQ(phase.name, "");
+    check_same_state(original, optimized, 2);
+}
+
+TEST_F(CircuitOptimizerTest, does_not_move_gates_through_other_instructions) {
+    auto original = std::vector<std::shared_ptr<Instruction>>{
+        make_unitary(gates::H, { 0 }, "H"),
+        // H is block diagonal in neither basis
+        make_unitary(gates::CNOT, { 0, 1 }, "CNOT"),
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::X, { 1 }, "X"),
+        std::make_shared<Measure>(core::QubitIndex{ 1 }, core::BitIndex{ 1 }),
+        make_unitary(gates::X, { 1 }, "X"),
+        // Operands in another order
+        make_unitary(gates::CNOT, { 1, 0 }, "CNOT"),
+        make_unitary(gates::CNOT, { 0, 1 }, "CNOT"),
+    };
+    auto optimized = original;
+    auto optimization = optimize_instructions(optimized);
+
+    EXPECT_EQ(optimization.get_number_of_removed_gates(), 0);
+    EXPECT_EQ(optimized, original);
+}
+
+TEST_F(CircuitOptimizerTest, same_state_as_unoptimized_circuit) {
+    auto original = std::vector<std::shared_ptr<Instruction>>{};
+    for (std::size_t i = 0; i < 20; ++i) {
+        original.push_back(make_unitary(gates::H, { i % 4 }, "H"));
+        original.push_back(make_unitary(gates::CNOT, { i % 4, (i + 1) % 4 }, "CNOT"));
+        original.push_back(make_unitary(gates::RZ(.1 * static_cast<double>(i)), { i % 4 }, "Rz"));
+        original.push_back(make_unitary(gates::CNOT, { i % 4, (i + 1) % 4 }, "CNOT"));
+        original.push_back(make_unitary(gates::CZ, { (i + 2) % 4, i % 4 }, "CZ"));
+        original.push_back(make_unitary(gates::RX(.2), { (i + 3) % 4 }, "Rx"));
+        original.push_back(make_unitary(gates::H, { i % 4 }, "H"));
+    }
+    auto optimized = original;
+    auto optimization = optimize_instructions(optimized);
+
+    EXPECT_GT(optimization.get_number_of_removed_gates(), 0);
+    EXPECT_EQ(optimized.size() + optimization.get_number_of_removed_gates(), original.size());
+    check_same_state(original, optimized, 4);
+}
+
+}  // namespace qx
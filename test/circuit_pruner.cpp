@@ -0,0 +1,162 @@
+#include "qx/circuit_pruner.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>  // size_t
+#include <map>
+#include <memory>  // make_shared, shared_ptr
+#include <variant>  // monostate
+#include <vector>
+
+#include "qx/circuit.hpp"
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/instructions.hpp"
+#include "qx/random.hpp"
+#include "qx/register_manager.hpp"
+
+#include "instructions_helper.hpp"
+
+namespace qx {
+
+class CircuitPrunerTest : public ::testing::Test {
+protected:
+    static std::shared_ptr<Instruction> measure(std::size_t qubit_index, std::size_t bit_index) {
+        return std::make_shared<Measure>(core::QubitIndex{ qubit_index }, core::BitIndex{ bit_index });
+    }
+
+    static std::vector<std::size_t> get_qubits(Instruction& instruction) {
+        auto ret = std::vector<std::size_t>{};
+        for (const auto& qubit_index : instruction.get_qubit_indices()) {
+            ret.push_back(qubit_index.value);
+        }
+        return ret;
+    }
+
+    // Number of shots ending with every value of the bit measurement register
+    static std::map<core::BitMeasurementRegister, std::size_t> get_histogram(
+        const Circuit& circuit, std::size_t iterations) {
+        random::seed(1234);
+        auto ret = std::map<core::BitMeasurementRegister, std::size_t>{};
+        for (std::size_t i = 0; i < iterations; ++i) {
+            ++ret[circuit.execute(std::monostate{}).bit_measurement_register];
+        }
+        return ret;
+    }
+};
+
+TEST_F(CircuitPrunerTest, removes_gates_outside_the_light_cone) {
+    auto instructions = std::vector{
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::H, { 1 }, "H"),
+        make_unitary(gates::CNOT, { 1, 2 }, "CNOT"),
+        make_unitary(gates::X, { 3 }, "X"),
+        make_unitary(gates::CNOT, { 0, 2 }, "CNOT"),
+        measure(2, 0),
+        // After the last measurement of qubit 2
+        make_unitary(gates::CNOT, { 2, 3 }, "CNOT"),
+        make_unitary(gates::H, { 1 }, "H"),
+    };
+    auto pruning = prune_instructions(instructions, 4);
+
+    // Qubit 3 is only acted on by gates that can not change the measurement
+    EXPECT_EQ(pruning.number_of_removed_instructions, 3);
+    EXPECT_EQ(pruning.simulated_qubits, (std::vector<std::size_t>{ 0, 1, 2 }));
+    ASSERT_EQ(instructions.size(), 5);
+    EXPECT_EQ(get_qubits(*instructions[2]), (std::vector<std::size_t>{ 1, 2 }));
+    EXPECT_EQ(get_qubits(*instructions[3]), (std::vector<std::size_t>{ 0, 2 }));
+    EXPECT_EQ(get_qubits(*instructions[4]), (std::vector<std::size_t>{ 2 }));
+}
+
+TEST_F(CircuitPrunerTest, renumbers_the_qubits_left) {
+    auto instructions = std::vector{
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::H, { 3 }, "H"),
+        make_unitary(gates::CZ, { 3, 1 }, "CZ"),
+        measure(1, 1),
+        make_unitary(gates::X, { 2 }, "X"),
+    };
+    auto pruning = prune_instructions(instructions, 4);
+
+    EXPECT_EQ(pruning.number_of_removed_instructions, 2);
+    EXPECT_EQ(pruning.simulated_qubits, (std::vector<std::size_t>{ 1, 3 }));
+    ASSERT_EQ(instructions.size(), 3);
+    EXPECT_EQ(get_qubits(*instructions[0]), (std::vector<std::size_t>{ 1 }));
+    EXPECT_EQ(get_qubits(*instructions[1]), (std::vector<std::size_t>{ 1, 0 }));
+    const auto* measure_instruction = dynamic_cast<const Measure*>(instructions[2].get());
+    ASSERT_NE(measure_instruction, nullptr);
+    EXPECT_EQ(measure_instruction->qubit_index.value, 0);
+    EXPECT_EQ(measure_instruction->bit_index.value, 1);
+}
+
+TEST_F(CircuitPrunerTest, keeps_resets_and_bit_controlled_gates) {
+    auto instructions = std::vector<std::shared_ptr<Instruction>>{
+        make_unitary(gates::H, { 2 }, "H"),
+        std::make_shared<Reset>(core::QubitIndex{ 2 }),
+        make_unitary(gates::H, { 0 }, "H"),
+        measure(0, 0),
+        std::make_shared<BitControlledInstruction>(
+            ControlBits{ core::BitIndex{ 0 } }, make_unitary(gates::X, { 1 }, "X")),
+        std::make_shared<BitControlledInstruction>(
+            ControlBits{ core::BitIndex{ 0 } }, make_unitary(gates::X, { 3 }, "X")),
+        measure(1, 1),
+    };
+    auto pruning = prune_instructions(instructions, 4);
+
+    // The reset keeps the H before it, but the bit-controlled gate on qubit 3 is never measured
+    EXPECT_EQ(pruning.number_of_removed_instructions, 1);
+    EXPECT_EQ(pruning.simulated_qubits, (std::vector<std::size_t>{ 0, 1, 2 }));
+    ASSERT_EQ(instructions.size(), 6);
+    const auto* bit_controlled_instruction = dynamic_cast<const BitControlledInstruction*>(instructions[4].get());
+    ASSERT_NE(bit_controlled_instruction, nullptr);
+    EXPECT_EQ(get_qubits(*bit_controlled_instruction->instruction), (std::vector<std::size_t>{ 1 }));
+}
+
+TEST_F(CircuitPrunerTest, renumbers_the_control_bits_left) {
+    RegisterManager::create_instance({ { "q", 4 } }, { { "b", 4 } });
+    auto instructions = std::vector<std::shared_ptr<Instruction>>{
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::H, { 1 }, "H"),
+        measure(1, 1),
+        make_unitary(gates::X, { 2 }, "X"),
+        std::make_shared<BitControlledInstruction>(
+            ControlBits{ core::BitIndex{ 1 } }, make_unitary(gates::X, { 3 }, "X")),
+        measure(3, 3),
+    };
+    auto expected = Circuit{ instructions };
+    auto actual = Circuit{ instructions };
+    auto pruning = actual.prune();
+
+    // The outcome of qubit 1 is at index 0 of the measurement register of the pruned circuit
+    EXPECT_EQ(pruning.simulated_qubits, (std::vector<std::size_t>{ 1, 3 }));
+    ASSERT_EQ(actual.get_instructions().size(), 4);
+    const auto* bit_controlled_instruction =
+        dynamic_cast<const BitControlledInstruction*>(actual.get_instructions()[2].get());
+    ASSERT_NE(bit_controlled_instruction, nullptr);
+    ASSERT_EQ(bit_controlled_instruction->control_bits.size(), 1);
+    EXPECT_EQ(bit_controlled_instruction->control_bits[0].value, 0);
+    EXPECT_EQ(get_qubits(*bit_controlled_instruction->instruction), (std::vector<std::size_t>{ 1 }));
+
+    std::size_t iterations = 100;
+    auto histogram = get_histogram(actual, iterations);
+    EXPECT_EQ(histogram, get_histogram(expected, iterations));
+    // b[3] is always b[1]
+    EXPECT_EQ(histogram.size(), 2);
+    for (const auto& [bit_measurement_register, count] : histogram) {
+        EXPECT_EQ(bit_measurement_register.test(3), bit_measurement_register.test(1));
+    }
+}
+
+TEST_F(CircuitPrunerTest, keeps_one_qubit_without_measurements) {
+    auto instructions = std::vector{
+        make_unitary(gates::H, { 0 }, "H"),
+        make_unitary(gates::CNOT, { 0, 1 }, "CNOT"),
+    };
+    auto pruning = prune_instructions(instructions, 2);
+
+    EXPECT_EQ(pruning.number_of_removed_instructions, 2);
+    EXPECT_EQ(pruning.simulated_qubits, (std::vector<std::size_t>{ 0 }));
+    EXPECT_TRUE(instructions.empty());
+}
+
+}  // namespace qx
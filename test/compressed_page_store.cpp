@@ -0,0 +1,145 @@
+#include "qx/compressed_page_store.hpp"
+
+#include <gtest/gtest.h>
+
+#include <bit>  // bit_cast
+#include <cmath>  // abs, cos, sin, sqrt
+#include <complex>
+#include <cstdint>  // size_t, uint64_t
+#include <memory>  // make_unique
+#include <vector>
+
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/paged_state_vector.hpp"
+#include "qx/quantum_state.hpp"
+
+namespace qx::core {
+
+class CompressedPageStoreTest : public ::testing::Test {
+protected:
+    // Amplitudes of several blocks, with a run of zeros, and no two other real or imaginary parts equal
+    static std::vector<std::complex<double>> make_page(std::size_t size) {
+        auto ret = std::vector<std::complex<double>>(size);
+        for (std::size_t i = size / 4; i < size; ++i) {
+            ret[i] = { std::cos(.1 * static_cast<double>(i)), -std::sin(.37 * static_cast<double>(i)) / 3 };
+        }
+        ret.back() = { -0., 1e-300 };
+        return ret;
+    }
+};
+
+TEST_F(CompressedPageStoreTest, lossless) {
+    auto page = make_page(3 * config::COMPRESSED_BLOCK_SIZE + 5);
+    auto victim = CompressedPageStore{};
+    victim.write(2, page);
+    auto actual = std::vector<std::complex<double>>(page.size());
+    victim.read(2, actual);
+    for (std::size_t i = 0; i < page.size(); ++i) {
+        EXPECT_EQ(std::bit_cast<std::uint64_t>(actual[i].real()), std::bit_cast<std::uint64_t>(page[i].real()));
+        EXPECT_EQ(std::bit_cast<std::uint64_t>(actual[i].imag()), std::bit_cast<std::uint64_t>(page[i].imag()));
+    }
+    EXPECT_EQ(victim.get_compression_statistics().error, 0.);
+    EXPECT_EQ(victim.get_compression_statistics().get_fidelity_loss(), 0.);
+}
+
+TEST_F(CompressedPageStoreTest, equal_amplitudes_take_a_bit_each) {
+    auto page = std::vector<std::complex<double>>(4 * config::COMPRESSED_BLOCK_SIZE, { .125, -.125 });
+    auto victim = CompressedPageStore{};
+    victim.write(0, page);
+    // Every block stores its first real and imaginary parts in full, and a bit for each of the others
+    EXPECT_LT(victim.get_size(), 4 * (config::COMPRESSED_BLOCK_SIZE / 4 + 32));
+    EXPECT_EQ(victim.get_compression_statistics().peak_bytes, victim.get_size());
+    victim.discard(0);
+    EXPECT_EQ(victim.get_size(), 0);
+    EXPECT_GT(victim.get_compression_statistics().peak_bytes, 0);
+    auto actual = std::vector<std::complex<double>>(page.size());
+    EXPECT_THROW(victim.read(0, actual), PagedStateVectorError);
+}
+
+TEST_F(CompressedPageStoreTest, lossy_within_tolerance) {
+    auto tolerance = 1e-4;
+    auto page = make_page(2 * config::COMPRESSED_BLOCK_SIZE);
+    auto victim = CompressedPageStore{ tolerance, 3 };
+    victim.write(0, page);
+    // 2 / 2e-4 = 10^4 multiples of the step, on 15 bits with their sign
+    EXPECT_LT(victim.get_size(), page.size() * 2 * 15 / 8 + 8);
+    auto actual = std::vector<std::complex<double>>(page.size());
+    victim.read(0, actual);
+    auto squared_error = 0.;
+    for (std::size_t i = 0; i < page.size(); ++i) {
+        EXPECT_LE(std::abs(actual[i].real() - page[i].real()), tolerance);
+        EXPECT_LE(std::abs(actual[i].imag() - page[i].imag()), tolerance);
+        squared_error += std::norm(actual[i] - page[i]);
+    }
+    EXPECT_NEAR(victim.get_compression_statistics().error, std::sqrt(squared_error), 1e-12);
+    EXPECT_GT(victim.get_compression_statistics().get_fidelity_loss(), 0.);
+
+    // Amplitudes already rounded do not lose anything more
+    auto error = victim.get_compression_statistics().error;
+    victim.write(0, actual);
+    EXPECT_EQ(victim.get_compression_statistics().error, error);
+}
+
+TEST_F(CompressedPageStoreTest, same_result_with_any_number_of_threads) {
+    auto page = make_page(7 * config::COMPRESSED_BLOCK_SIZE);
+    auto single_thread = CompressedPageStore{ 1e-6, 1 };
+    auto many_threads = CompressedPageStore{ 1e-6, 4 };
+    single_thread.write(1, page);
+    many_threads.write(1, page);
+    EXPECT_EQ(single_thread.get_size(), many_threads.get_size());
+    EXPECT_EQ(single_thread.get_compression_statistics().error, many_threads.get_compression_statistics().error);
+    auto expected = std::vector<std::complex<double>>(page.size());
+    auto actual = std::vector<std::complex<double>>(page.size());
+    single_thread.read(1, expected);
+    many_threads.read(1, actual);
+    EXPECT_EQ(actual, expected);
+}
+
+TEST_F(CompressedPageStoreTest, threads_reused_for_every_page) {
+    auto victim = CompressedPageStore{ 0., 4 };
+    for (std::size_t number_of_blocks = 1; number_of_blocks <= 9; ++number_of_blocks) {
+        auto page = make_page(number_of_blocks * config::COMPRESSED_BLOCK_SIZE);
+        for (std::size_t i = 0; i < 10; ++i) {
+            victim.write(i, page);
+            auto actual = std::vector<std::complex<double>>(page.size());
+            victim.read(i, actual);
+            EXPECT_EQ(actual, page);
+        }
+    }
+}
+
+TEST_F(CompressedPageStoreTest, paged_state_vector) {
+    auto victim = PagedStateVector{ 6, 3, std::make_unique<CompressedPageStore>() };
+    auto expected = QuantumState{ 6, 6 };
+    auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+        victim.apply(matrix, operands);
+        expected.apply(matrix, operands);
+    };
+    apply(gates::H, { QubitIndex{ 0 } });
+    apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 5 } });
+    apply(gates::RY(.9), { QubitIndex{ 4 } });
+    apply(gates::CR(.7), { QubitIndex{ 4 }, QubitIndex{ 1 } });
+    auto expected_amplitudes = expected.to_vector();
+    for (std::size_t i = 0; i < expected_amplitudes.size(); ++i) {
+        auto actual = victim.get_amplitude(MeasurementRegister{ 6, i });
+        EXPECT_NEAR(actual.real(), expected_amplitudes[i].real(), 1e-12);
+        EXPECT_NEAR(actual.imag(), expected_amplitudes[i].imag(), 1e-12);
+    }
+    const auto* page_store = dynamic_cast<const CompressedPageStore*>(victim.get_page_store());
+    ASSERT_NE(page_store, nullptr);
+    EXPECT_GT(page_store->get_compression_statistics().peak_bytes, 0);
+
+    // Measuring qubit 5, stored at a page-index bit, frees the compressed pages projected out
+    auto size = page_store->get_size();
+    victim.update_data_after_measurement(QubitIndex{ 5 }, true, .5);
+    EXPECT_LT(page_store->get_size(), size);
+    EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+}
+
+TEST_F(CompressedPageStoreTest, invalid_arguments) {
+    EXPECT_THROW(CompressedPageStore{ -1. }, PagedStateVectorError);
+    EXPECT_THROW(PagedStateVector(4, 2, std::unique_ptr<PageStore>{}), PagedStateVectorError);
+}
+
+}  // namespace qx::core
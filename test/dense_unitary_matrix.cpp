@@ -146,6 +146,40 @@ TEST(dense_unitary_matrix_test, control) {
     EXPECT_EQ(gates::X.control().control(), gates::TOFFOLI);
 }
 
+TEST(dense_unitary_matrix_test, fixed_matrix) {
+    static_assert(is_unitary(gates::matrices::T));
+    static_assert(not is_unitary(FixedMatrix<2>{{
+        { 1,   0 },
+        { 0, 1.1 }
+    }}));
+    static_assert(not is_unitary(FixedMatrix<2>{{
+        { 0, 0 },
+        { 0, 1 }
+    }}));
+
+    const auto& t = DenseUnitaryMatrix{ gates::matrices::T };
+    const auto& expected_t = DenseUnitaryMatrix{
+        Matrix{
+            { 1,                                         0 },
+            { 0, std::exp(std::complex<double>(0, PI / 4)) }
+        }
+    };
+    EXPECT_EQ(t, expected_t);
+    EXPECT_TRUE(t.is_phase_gate());
+    EXPECT_FALSE(DenseUnitaryMatrix{ gates::matrices::H }.is_phase_gate());
+}
+
+TEST(dense_unitary_matrix_test, default_gates) {
+    ASSERT_NE(gates::find_default_gate("TOFFOLI"), nullptr);
+    EXPECT_EQ(gates::find_default_gate("TOFFOLI")({}), gates::TOFFOLI);
+    EXPECT_EQ(gates::find_default_gate("mX90")({}), gates::MX90);
+    EXPECT_EQ(gates::find_default_gate("measure"), nullptr);
+    static_assert(gates::find_default_gate("CNOT") != nullptr);
+    static_assert(gates::find_default_gate_id("CNOT") == 0);
+    static_assert(gates::default_gates[*gates::find_default_gate_id("Rz")].name == "Rz");
+    static_assert(not gates::find_default_gate_id("inv"));
+}
+
 // clang-format on
 
 }  // namespace qx::core
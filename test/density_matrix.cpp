@@ -0,0 +1,101 @@
+#include "qx/density_matrix.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>  // sqrt
+#include <complex>
+#include <vector>
+
+#include "qx/core.hpp"
+#include "qx/error_models.hpp"
+#include "qx/gates.hpp"
+
+namespace qx::core {
+
+using namespace std::complex_literals;
+
+class DensityMatrixTest : public ::testing::Test {
+protected:
+    // expected is given row by row
+    static void check_eq(const DensityMatrix& victim, const std::vector<std::vector<std::complex<double>>>& expected) {
+        ASSERT_EQ(expected.size(), 1 << victim.get_number_of_qubits());
+        for (std::size_t row = 0; row < expected.size(); ++row) {
+            for (std::size_t column = 0; column < expected.size(); ++column) {
+                auto actual = victim.at(BasisVector{ row }, BasisVector{ column });
+                EXPECT_NEAR(expected[row][column].real(), actual.real(), .000'000'000'000'01);
+                EXPECT_NEAR(expected[row][column].imag(), actual.imag(), .000'000'000'000'01);
+            }
+        }
+    }
+};
+
+TEST_F(DensityMatrixTest, apply_identity) {
+    auto victim = DensityMatrix{ 2 };
+    EXPECT_EQ(victim.get_number_of_qubits(), 2);
+    victim.apply(gates::IDENTITY, { QubitIndex{ 1 } });
+    check_eq(victim, { { 1, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } });
+}
+
+TEST_F(DensityMatrixTest, apply_hadamard_and_cnot) {
+    auto victim = DensityMatrix{ 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    // |00> + |11>
+    check_eq(victim, { { .5, 0, 0, .5 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { .5, 0, 0, .5 } });
+    EXPECT_NEAR(victim.trace(), 1., 1e-14);
+}
+
+TEST_F(DensityMatrixTest, apply_keeps_complex_coherences) {
+    auto victim = DensityMatrix{ 1 };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::S, { QubitIndex{ 0 } });
+    // |0> + i|1>
+    check_eq(victim, { { .5, -.5i }, { .5i, .5 } });
+}
+
+TEST_F(DensityMatrixTest, apply_channel) {
+    // Phase flip with probability 1/2 removes all the coherences
+    auto victim = DensityMatrix{ 1 };
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    auto a = std::sqrt(.5);
+    victim.apply_channel({ { { a, 0 }, { 0, a } }, { { a, 0 }, { 0, -a } } }, { QubitIndex{ 0 } });
+    check_eq(victim, { { .5, 0 }, { 0, .5 } });
+}
+
+TEST_F(DensityMatrixTest, depolarizing_channel) {
+    // Each qubit is picked with probability 1/2, and then flipped by X or Y with probability 2/3
+    auto victim = DensityMatrix{ 2 };
+    error_models::DepolarizingChannel{ .3 }.add_error(victim);
+    auto p = .3 / 2 * 2 / 3;
+    check_eq(victim, { { 1 - 2 * p, 0, 0, 0 }, { 0, p, 0, 0 }, { 0, 0, p, 0 }, { 0, 0, 0, 0 } });
+    EXPECT_NEAR(victim.trace(), 1., 1e-14);
+}
+
+TEST_F(DensityMatrixTest, depolarizing_channel__excluded_qubits) {
+    auto victim = DensityMatrix{ 2 };
+    error_models::DepolarizingChannel{ .3 }.add_error(victim, BasisVector{ 1 });
+    auto p = .3 / 2 * 2 / 3;
+    check_eq(victim, { { 1 - p, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, p, 0 }, { 0, 0, 0, 0 } });
+}
+
+TEST_F(DensityMatrixTest, measurement) {
+    auto victim = DensityMatrix{ 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    auto probability_of_measuring_one = victim.get_probability_of_measuring_one(QubitIndex{ 1 });
+    EXPECT_NEAR(probability_of_measuring_one, .5, 1e-14);
+    victim.update_data_after_measurement(QubitIndex{ 1 }, true, probability_of_measuring_one);
+    check_eq(victim, { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 1 } });
+}
+
+TEST_F(DensityMatrixTest, reset) {
+    auto victim = DensityMatrix{ 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    victim.apply_reset(QubitIndex{ 0 });
+    // Qubit 1 is left in a classical mixture of 0 and 1
+    check_eq(victim, { { .5, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, .5, 0 }, { 0, 0, 0, 0 } });
+}
+
+TEST_F(DensityMatrixTest, too_many_qubits) {
+    EXPECT_THROW(DensityMatrix{ 0 }, DensityMatrixError);
+    EXPECT_THROW(DensityMatrix{ config::MAX_DENSITY_MATRIX_QUBIT_NUMBER + 1 }, DensityMatrixError);
+}
+
+}  // namespace qx::core
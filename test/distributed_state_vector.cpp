@@ -0,0 +1,143 @@
+#include "qx/distributed_state_vector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>  // abs
+#include <complex>
+#include <cstdint>  // size_t
+#include <mutex>
+#include <vector>
+
+#include "qx/communicator.hpp"
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/quantum_state.hpp"
+
+#include "amplitudes_helper.hpp"
+
+namespace qx::core {
+
+class DistributedStateVectorTest : public ::testing::Test {};
+
+TEST_F(DistributedStateVectorTest, local_communicator) {
+    auto mutex = std::mutex{};
+    auto sums = std::vector<double>{};
+    LocalCommunicator::run(4, [&mutex, &sums](Communicator& communicator) {
+        auto rank = communicator.get_rank();
+        EXPECT_EQ(communicator.get_size(), 4);
+        auto values = std::vector<double>{ static_cast<double>(rank), 1. };
+        communicator.all_reduce_sum(std::span{ values });
+        EXPECT_EQ(values, (std::vector<double>{ 6., 4. }));
+        EXPECT_EQ(communicator.broadcast(rank, 2), 2);
+        auto send = std::vector<std::size_t>{ rank };
+        auto receive = std::vector<std::size_t>{ 0 };
+        communicator.exchange(rank ^ 1, std::span<const std::size_t>{ send }, std::span{ receive });
+        EXPECT_EQ(receive[0], rank ^ 1);
+        auto lock = std::lock_guard{ mutex };
+        sums.push_back(values[0]);
+    });
+    EXPECT_EQ(sums.size(), 4);
+}
+
+TEST_F(DistributedStateVectorTest, single_process) {
+    auto communicator = LocalCommunicator{};
+    auto victim = DistributedStateVector{ 3, communicator };
+    EXPECT_EQ(victim.get_number_of_local_qubits(), 3);
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 2 } });
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(3, 0))), gates::SQRT_2 / 2, 1e-12);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(3, 5))), gates::SQRT_2 / 2, 1e-12);
+}
+
+TEST_F(DistributedStateVectorTest, same_amplitudes_as_state_vector) {
+    // With 4 processes, qubits 3 and 4 start at global bits, and gates on them move them to local bits
+    LocalCommunicator::run(4, [](Communicator& communicator) {
+        auto victim = DistributedStateVector{ 5, communicator };
+        EXPECT_EQ(victim.get_number_of_local_qubits(), 3);
+        EXPECT_EQ(victim.get_local_amplitudes().size(), 8);
+        auto expected = QuantumState{ 5, 5 };
+        auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+            victim.apply(matrix, operands);
+            expected.apply(matrix, operands);
+        };
+        apply(gates::H, { QubitIndex{ 0 } });
+        apply(gates::RX(.3), { QubitIndex{ 4 } });
+        apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 3 } });
+        apply(gates::T, { QubitIndex{ 3 } });
+        apply(gates::CR(.7), { QubitIndex{ 4 }, QubitIndex{ 1 } });
+        apply(gates::H, { QubitIndex{ 2 } });
+        apply(gates::TOFFOLI, { QubitIndex{ 3 }, QubitIndex{ 0 }, QubitIndex{ 4 } });
+        apply(gates::RY(1.1), { QubitIndex{ 1 } });
+        apply(gates::SWAP, { QubitIndex{ 2 }, QubitIndex{ 4 } });
+        apply(gates::CZ, { QubitIndex{ 1 }, QubitIndex{ 3 } });
+        check_eq(victim, expected);
+        EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+    });
+}
+
+TEST_F(DistributedStateVectorTest, measurement) {
+    LocalCommunicator::run(4, [](Communicator& communicator) {
+        auto victim = DistributedStateVector{ 4, communicator };
+        victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+        auto probability_of_measuring_one = victim.get_probability_of_measuring_one(QubitIndex{ 1 });
+        EXPECT_NEAR(probability_of_measuring_one, .5, 1e-12);
+        // The gate on qubit 3 moves qubit 1 to a global bit,
+        // so measuring qubit 1 keeps or discards the amplitudes of whole processes
+        victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 3 } });
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), .5, 1e-12);
+        victim.update_data_after_measurement(QubitIndex{ 1 }, true, probability_of_measuring_one);
+        EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(4, 11))), 1., 1e-12);
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), 1., 1e-12);
+        // Only the random number of rank 0 is used
+        victim.apply(gates::H, { QubitIndex{ 2 } });
+        auto random = communicator.get_rank() == 0 ? .9 : .1;
+        EXPECT_FALSE(victim.measure(QubitIndex{ 2 }, random));
+    });
+}
+
+TEST_F(DistributedStateVectorTest, reset) {
+    LocalCommunicator::run(2, [](Communicator& communicator) {
+        auto victim = DistributedStateVector{ 3, communicator };
+        victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 2 } });
+        // Qubit 0 is measured as one, which collapses qubit 2 to one too
+        victim.apply_reset(QubitIndex{ 0 }, .1);
+        EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(3, 4))), 1., 1e-12);
+    });
+}
+
+TEST_F(DistributedStateVectorTest, sample) {
+    LocalCommunicator::run(4, [](Communicator& communicator) {
+        auto victim = DistributedStateVector{ 6, communicator };
+        victim.apply(gates::H, { QubitIndex{ 0 } });
+        for (std::size_t i = 1; i < 6; ++i) {
+            victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ i } });
+        }
+        auto randoms = std::vector<double>{ .7, .2, .9, .4 };
+        std::size_t next = 0;
+        auto samples = victim.sample(100, [&randoms, &next]() { return randoms[next++ % randoms.size()]; });
+        ASSERT_EQ(samples.size(), 100);
+        auto number_of_ones = 0;
+        for (const auto& sample : samples) {
+            EXPECT_TRUE(sample.none() || sample.all());
+            number_of_ones += sample.all() ? 1 : 0;
+        }
+        EXPECT_EQ(number_of_ones, 50);
+    });
+}
+
+TEST_F(DistributedStateVectorTest, invalid_arguments) {
+    EXPECT_THROW(LocalCommunicator::run(3, [](Communicator& communicator) {
+        [[maybe_unused]] auto victim = DistributedStateVector{ 4, communicator };
+    }),
+        DistributedStateVectorError);
+    EXPECT_THROW(LocalCommunicator::run(4, [](Communicator& communicator) {
+        [[maybe_unused]] auto victim = DistributedStateVector{ 2, communicator };
+    }),
+        DistributedStateVectorError);
+    EXPECT_THROW(LocalCommunicator::run(4, [](Communicator& communicator) {
+        auto victim = DistributedStateVector{ 4, communicator };
+        victim.apply(gates::TOFFOLI, { QubitIndex{ 0 }, QubitIndex{ 1 }, QubitIndex{ 2 } });
+    }),
+        DistributedStateVectorError);
+}
+
+}  // namespace qx::core
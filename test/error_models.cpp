@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>  // exp, sqrt
+#include <complex>
+#include <limits>
+#include <vector>
+
 #include "qx/random.hpp"
 
 namespace qx::error_models {
@@ -15,8 +20,9 @@ protected:
     void check_state(const std::map<core::BasisVector, std::complex<double>>& expected) {
         state.for_each([&expected](const auto& kv) {
             const auto& [basis_vector, sparse_complex] = kv;
-            ASSERT_EQ(expected.count(basis_vector), 1);
-            EXPECT_EQ(expected.at(basis_vector), sparse_complex.value);
+            auto key = core::BasisVector{ basis_vector.to_ulong() };
+            ASSERT_EQ(expected.count(key), 1);
+            EXPECT_EQ(expected.at(key), sparse_complex.value);
         });
     }
 
@@ -64,4 +70,113 @@ TEST_F(ErrorModelsTest, depolarizing_channel__probability_0) {
     });
 }
 
+TEST_F(ErrorModelsTest, depolarizing_channel__skip_ahead) {
+    EXPECT_EQ(DepolarizingChannel{ 1. }.sample_number_of_error_free_instructions(), 0);
+    EXPECT_EQ(DepolarizingChannel{ 0. }.sample_number_of_error_free_instructions(),
+        std::numeric_limits<std::size_t>::max());
+
+    // The mean number of error-free instructions is (1 - p) / p
+    const DepolarizingChannel channel(.01);
+    double sum = 0.;
+    for (std::size_t i = 0; i < 10'000; ++i) {
+        sum += static_cast<double>(channel.sample_number_of_error_free_instructions());
+    }
+    EXPECT_NEAR(sum / 10'000, 99., 3.);
+}
+
+TEST_F(ErrorModelsTest, depolarizing_channel__add_random_error) {
+    auto state = core::QuantumState{ 1, 1 };
+    DepolarizingChannel{ .5 }.add_random_error(state);
+    // X and Y flip the qubit, up to a phase, and Z leaves it unchanged
+    auto actual = state.to_vector();
+    EXPECT_NEAR(std::norm(actual[0]) + std::norm(actual[1]), 1., 1e-12);
+    EXPECT_TRUE(std::norm(actual[0]) == 1. || std::norm(actual[1]) == 1.);
+}
+
+TEST(kraus_channel, invalid_kraus_operators) {
+    EXPECT_THROW(KrausChannel({}), ErrorModelError);
+    EXPECT_THROW(KrausChannel({ { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } } }), ErrorModelError);
+    EXPECT_THROW(KrausChannel({ { { 1, 0 }, { 0, .5 } } }), ErrorModelError);
+    EXPECT_THROW(KrausChannel::amplitude_damping(1.5), ErrorModelError);
+    EXPECT_THROW(KrausChannel::phase_damping(-.5), ErrorModelError);
+    EXPECT_THROW(KrausChannel::thermal_relaxation(10., 30., 1.), ErrorModelError);
+}
+
+TEST(kraus_channel, amplitude_damping) {
+    auto channel = KrausChannel::amplitude_damping(.3);
+    // |1> stays |1> with probability .7
+    auto state = core::QuantumState{ 1, 1, { { "1", 1. } } };
+    channel.apply(state, core::QubitIndex{ 0 }, .69);
+    EXPECT_EQ(state.to_vector(), (std::vector<std::complex<double>>{ 0., 1. }));
+    channel.apply(state, core::QubitIndex{ 0 }, .71);
+    EXPECT_EQ(state.to_vector(), (std::vector<std::complex<double>>{ 1., 0. }));
+}
+
+TEST(kraus_channel, amplitude_damping__superposition) {
+    // (|0> + |1>) / sqrt(2) keeps no excitation with probability .5 * .3, and is renormalized otherwise
+    auto channel = KrausChannel::amplitude_damping(.3);
+    auto state = core::QuantumState{ 1, 1, { { "0", 1 / std::sqrt(2.) }, { "1", 1 / std::sqrt(2.) } } };
+    channel.apply(state, core::QubitIndex{ 0 }, .5);
+    auto expected = std::vector<std::complex<double>>{ 1 / std::sqrt(1.7), std::sqrt(.7 / 1.7) };
+    auto actual = state.to_vector();
+    EXPECT_NEAR(actual[0].real(), expected[0].real(), 1e-12);
+    EXPECT_NEAR(actual[1].real(), expected[1].real(), 1e-12);
+}
+
+TEST(kraus_channel, non_diagonal_effects) {
+    // Measurement in the X basis
+    auto plus = std::vector<core::Matrix>{ { { .5, .5 }, { .5, .5 } }, { { .5, -.5 }, { -.5, .5 } } };
+    auto channel = KrausChannel{ plus };
+    auto state = core::QuantumState{ 1, 1 };
+    channel.apply(state, core::QubitIndex{ 0 }, .3);
+    auto actual = state.to_vector();
+    EXPECT_NEAR(actual[0].real(), 1 / std::sqrt(2.), 1e-12);
+    EXPECT_NEAR(actual[1].real(), 1 / std::sqrt(2.), 1e-12);
+    // |+> is never projected onto |->
+    channel.apply(state, core::QubitIndex{ 0 }, .99);
+    actual = state.to_vector();
+    EXPECT_NEAR(actual[0].real(), 1 / std::sqrt(2.), 1e-12);
+    EXPECT_NEAR(actual[1].real(), 1 / std::sqrt(2.), 1e-12);
+}
+
+TEST(kraus_channel, thermal_relaxation__density_matrix) {
+    auto t1 = 50.;
+    auto t2 = 30.;
+    auto gate_time = 2.;
+    auto density_matrix = core::DensityMatrix{ 1 };
+    density_matrix.apply(core::matrix_t{ { { 1 / std::sqrt(2.), 1 / std::sqrt(2.) },
+                                            { 1 / std::sqrt(2.), -1 / std::sqrt(2.) } } },
+        { core::QubitIndex{ 0 } });
+    KrausChannel::thermal_relaxation(t1, t2, gate_time).apply(density_matrix, core::QubitIndex{ 0 });
+    auto zero = core::BasisVector{ 0 };
+    auto one = core::BasisVector{ 1 };
+    EXPECT_NEAR(density_matrix.at(one, one).real(), .5 * std::exp(-gate_time / t1), 1e-12);
+    EXPECT_NEAR(density_matrix.at(zero, one).real(), .5 * std::exp(-gate_time / t2), 1e-12);
+    EXPECT_NEAR(density_matrix.trace(), 1., 1e-12);
+}
+
+TEST(noise_model, gate_qubit_and_readout_errors) {
+    auto noise_model = NoiseModel{}
+                           .add_gate_error("X", KrausChannel::amplitude_damping(1.))
+                           .add_qubit_error(core::QubitIndex{ 1 }, KrausChannel::amplitude_damping(1.))
+                           .add_readout_error(core::QubitIndex{ 0 }, ReadoutError{ 1., 0. });
+    EXPECT_TRUE(noise_model.has_readout_errors());
+
+    // Gate errors only follow gates with that name
+    auto state = core::QuantumState{ 2, 2, { { "01", 1. } } };
+    noise_model.add_gate_error(state, "Y", { core::QubitIndex{ 0 } });
+    EXPECT_EQ(state.to_vector(), (std::vector<std::complex<double>>{ 0., 1., 0., 0. }));
+    noise_model.add_gate_error(state, "X", { core::QubitIndex{ 0 } });
+    EXPECT_EQ(state.to_vector(), (std::vector<std::complex<double>>{ 1., 0., 0., 0. }));
+
+    // Qubit errors follow any gate on that qubit
+    state = core::QuantumState{ 2, 2, { { "10", 1. } } };
+    noise_model.add_gate_error(state, "Y", { core::QubitIndex{ 1 } });
+    EXPECT_EQ(state.to_vector(), (std::vector<std::complex<double>>{ 1., 0., 0., 0. }));
+
+    EXPECT_TRUE(noise_model.add_readout_error(core::QubitIndex{ 0 }, false));
+    EXPECT_TRUE(noise_model.add_readout_error(core::QubitIndex{ 0 }, true));
+    EXPECT_FALSE(noise_model.add_readout_error(core::QubitIndex{ 1 }, false));
+}
+
 }  // namespace qx::error_models
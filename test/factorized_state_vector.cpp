@@ -0,0 +1,120 @@
+#include "qx/factorized_state_vector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>  // size_t
+#include <vector>
+
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/quantum_state.hpp"
+
+namespace qx::core {
+
+class FactorizedStateVectorTest : public ::testing::Test {
+protected:
+    // Compare the probabilities of measuring one of every qubit with the ones of a state vector
+    static void check_probabilities(FactorizedStateVector& victim, QuantumState& expected) {
+        for (std::size_t i = 0; i < victim.get_number_of_qubits(); ++i) {
+            EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ i }),
+                expected.get_probability_of_measuring_one(QubitIndex{ i }),
+                .000'000'000'01);
+        }
+    }
+};
+
+TEST_F(FactorizedStateVectorTest, initial_state) {
+    auto victim = FactorizedStateVector{ 3 };
+    EXPECT_EQ(victim.get_number_of_qubits(), 3);
+    EXPECT_EQ(victim.get_number_of_factors(), 3);
+    EXPECT_EQ(victim.get_largest_factor_size(), 1);
+    EXPECT_EQ(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), 0.);
+    EXPECT_THROW((FactorizedStateVector{ 0 }), FactorizedStateVectorError);
+}
+
+TEST_F(FactorizedStateVectorTest, gates_merge_factors) {
+    auto victim = FactorizedStateVector{ 6 };
+    auto expected = QuantumState{ 6, 6 };
+    auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+        victim.apply(matrix, operands);
+        expected.apply(matrix, operands);
+    };
+    apply(gates::H, { QubitIndex{ 0 } });
+    apply(gates::RX(.3), { QubitIndex{ 3 } });
+    apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 4 } });
+    apply(gates::RY(.7), { QubitIndex{ 1 } });
+    apply(gates::CNOT, { QubitIndex{ 3 }, QubitIndex{ 1 } });
+    EXPECT_EQ(victim.get_number_of_factors(), 4);
+    EXPECT_EQ(victim.get_factor_size(QubitIndex{ 4 }), 2);
+    EXPECT_EQ(victim.get_factor_size(QubitIndex{ 2 }), 1);
+    check_probabilities(victim, expected);
+
+    // Joins both groups, in the reversed order of their qubits
+    apply(gates::TOFFOLI, { QubitIndex{ 1 }, QubitIndex{ 4 }, QubitIndex{ 5 } });
+    apply(gates::H, { QubitIndex{ 4 } });
+    EXPECT_EQ(victim.get_number_of_factors(), 2);
+    EXPECT_EQ(victim.get_factor_size(QubitIndex{ 0 }), 5);
+    EXPECT_EQ(victim.get_largest_factor_size(), 5);
+    check_probabilities(victim, expected);
+}
+
+TEST_F(FactorizedStateVectorTest, measurements_split_factors) {
+    auto victim = FactorizedStateVector{ 3 };
+    auto expected = QuantumState{ 3, 3 };
+    auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+        victim.apply(matrix, operands);
+        expected.apply(matrix, operands);
+    };
+    apply(gates::H, { QubitIndex{ 0 } });
+    apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    apply(gates::CNOT, { QubitIndex{ 1 }, QubitIndex{ 2 } });
+    EXPECT_EQ(victim.get_number_of_factors(), 1);
+
+    victim.update_data_after_measurement(QubitIndex{ 1 }, true, .5);
+    expected.update_data_after_measurement(QubitIndex{ 1 }, true, .5);
+    EXPECT_EQ(victim.get_number_of_factors(), 2);
+    EXPECT_EQ(victim.get_factor_size(QubitIndex{ 1 }), 1);
+    EXPECT_EQ(victim.get_factor_size(QubitIndex{ 2 }), 2);
+    check_probabilities(victim, expected);
+
+    apply(gates::H, { QubitIndex{ 1 } });
+    apply(gates::CZ, { QubitIndex{ 2 }, QubitIndex{ 1 } });
+    check_probabilities(victim, expected);
+}
+
+TEST_F(FactorizedStateVectorTest, reset_collapses_and_splits) {
+    auto victim = FactorizedStateVector{ 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    // 0.7 >= .5, so qubit 0 is measured as zero, and qubit 1 collapses with it
+    victim.apply_reset(QubitIndex{ 0 }, .7);
+    EXPECT_EQ(victim.get_number_of_factors(), 2);
+    EXPECT_EQ(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), 0.);
+    EXPECT_EQ(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), 0.);
+
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    // Measured as one, then flipped
+    victim.apply_reset(QubitIndex{ 0 }, .2);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), 0., 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), 1., 1e-12);
+}
+
+TEST_F(FactorizedStateVectorTest, sample) {
+    auto victim = FactorizedStateVector{ 4 };
+    victim.apply(gates::X, { QubitIndex{ 3 } });
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 2 } });
+    auto randoms = std::vector<double>{ .7, .2, .1 };
+    auto next = std::size_t{ 0 };
+    auto sample = victim.sample([&randoms, &next]() { return randoms[next++ % randoms.size()]; });
+    // One random number per factor
+    EXPECT_EQ(next, 3);
+    EXPECT_EQ(sample.size(), 4);
+    EXPECT_TRUE(sample.test(0));
+    EXPECT_FALSE(sample.test(1));
+    EXPECT_TRUE(sample.test(2));
+    EXPECT_TRUE(sample.test(3));
+}
+
+}  // namespace qx::core
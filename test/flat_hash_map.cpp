@@ -0,0 +1,87 @@
+#include "qx/flat_hash_map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>  // uint64_t
+#include <map>
+
+#include "qx/basis_vector.hpp"
+
+namespace qx::core {
+
+using Map = FlatHashMap<BasisVector, std::uint64_t, BasisVectorHash>;
+
+TEST(flat_hash_map, try_emplace_and_find) {
+    auto victim = Map{};
+    EXPECT_TRUE(victim.empty());
+    EXPECT_EQ(victim.find(BasisVector{ 3 }), victim.end());
+
+    auto [it, inserted] = victim.try_emplace(BasisVector{ 3 }, 30);
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(it->second, 30);
+
+    std::tie(it, inserted) = victim.try_emplace(BasisVector{ 3 }, 31);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(it->second, 30);
+
+    victim[BasisVector{ 5 }] += 50;
+    EXPECT_EQ(victim.size(), 2);
+    EXPECT_EQ(victim.find(BasisVector{ 5 })->second, 50);
+    EXPECT_TRUE(victim.contains(BasisVector{ 3 }));
+    EXPECT_FALSE(victim.contains(BasisVector{ 4 }));
+}
+
+TEST(flat_hash_map, grow_keeps_all_elements) {
+    // Keys sharing long runs of zeros in their low bits, as basis vectors of states with untouched low qubits do
+    auto victim = Map{};
+    for (std::uint64_t i = 0; i < 10'000; ++i) {
+        victim[BasisVector{ i << 20 }] = i;
+    }
+    EXPECT_EQ(victim.size(), 10'000);
+    for (std::uint64_t i = 0; i < 10'000; ++i) {
+        ASSERT_EQ(victim.find(BasisVector{ i << 20 })->second, i);
+    }
+    std::uint64_t sum = 0;
+    for (const auto& [key, value] : victim) {
+        EXPECT_EQ(key.to_ulong() >> 20, value);
+        sum += value;
+    }
+    EXPECT_EQ(sum, 10'000 * 9'999 / 2);
+}
+
+TEST(flat_hash_map, erase_if) {
+    auto victim = Map{};
+    auto expected = std::map<BasisVector, std::uint64_t>{};
+    for (std::uint64_t i = 0; i < 1'000; ++i) {
+        victim[BasisVector{ i * 7 }] = i;
+        if (i % 3 != 0) {
+            expected[BasisVector{ i * 7 }] = i;
+        }
+    }
+    EXPECT_EQ(victim.erase_if([](const auto& kv) { return kv.second % 3 == 0; }), 334);
+    EXPECT_EQ(victim.size(), expected.size());
+    for (const auto& [key, value] : expected) {
+        ASSERT_TRUE(victim.contains(key));
+        EXPECT_EQ(victim.find(key)->second, value);
+    }
+    for (const auto& [key, value] : victim) {
+        EXPECT_NE(value % 3, 0);
+    }
+}
+
+TEST(flat_hash_map, clear_keeps_capacity) {
+    auto victim = Map{};
+    victim.reserve(100);
+    auto capacity = victim.capacity();
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        victim[BasisVector{ i }] = i;
+    }
+    EXPECT_EQ(victim.capacity(), capacity);
+    victim.clear();
+    EXPECT_TRUE(victim.empty());
+    EXPECT_EQ(victim.capacity(), capacity);
+    EXPECT_EQ(victim.begin(), victim.end());
+    EXPECT_FALSE(victim.contains(BasisVector{ 7 }));
+}
+
+}  // namespace qx::core
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <memory>  // make_shared, shared_ptr
+#include <string>
+#include <utility>  // move
+#include <vector>
+
+#include "qx/core.hpp"
+#include "qx/instructions.hpp"
+
+namespace qx {
+
+// A gate of its own copy of matrix, on the given qubits
+[[nodiscard]] inline std::shared_ptr<Instruction> make_unitary(
+    const core::matrix_t& matrix, const std::vector<std::size_t>& operands, const std::string& name) {
+    auto qubit_indices = core::operands_t{};
+    for (auto operand : operands) {
+        qubit_indices.push_back(core::QubitIndex{ operand });
+    }
+    return std::make_shared<Unitary>(std::make_shared<core::matrix_t>(matrix),
+        std::make_shared<core::operands_t>(std::move(qubit_indices)),
+        name);
+}
+
+}  // namespace qx
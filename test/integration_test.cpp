@@ -2,8 +2,14 @@
 #include <gtest/gtest.h>
 
 #include <cmath>  // abs
+#include <cstdint>  // uint32_t, uint64_t
+#include <cstring>  // memcpy
+#include <filesystem>
+#include <fstream>
+#include <iterator>  // istreambuf_iterator
 #include <optional>  // nullopt
 #include <stdexcept>  // runtime_error
+#include <stop_token>
 
 #include "qx/simulator.hpp"
 
@@ -17,6 +23,13 @@ public:
         EXPECT_TRUE(std::holds_alternative<SimulationResult>(result));
         return *std::get_if<SimulationResult>(&result);
     }
+
+    static SimulationResult run_from_string_with_options(
+        const std::string& s, std::uint64_t iterations, const SimulationOptions& options) {
+        auto result = execute_string(s, iterations, std::nullopt, "3.0", options);
+        EXPECT_TRUE(std::holds_alternative<SimulationResult>(result));
+        return *std::get_if<SimulationResult>(&result);
+    }
 };
 
 TEST_F(IntegrationTest, bell_pair) {
@@ -62,12 +75,12 @@ CNOT q[0:2], q[3:5]
 }
 
 TEST_F(IntegrationTest, too_many_qubits) {
-    EXPECT_TRUE(std::holds_alternative<SimulationResult>(execute_string("version 3.0; qubit[62] q")));
-    EXPECT_TRUE(std::holds_alternative<SimulationResult>(execute_string("version 3.0; qubit[63] q")));
     EXPECT_TRUE(std::holds_alternative<SimulationResult>(execute_string("version 3.0; qubit[64] q")));
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(execute_string("version 3.0; qubit[65] q")));
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(execute_string("version 3.0; qubit[1024] q")));
 
-    EXPECT_TRUE(std::holds_alternative<SimulationError>(execute_string("version 3.0; qubit[65] q")));
-    EXPECT_TRUE(std::holds_alternative<SimulationError>(execute_string("version 3.0; qubit[66] q")));
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(execute_string("version 3.0; qubit[1025] q")));
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(execute_string("version 3.0; qubit[1026] q")));
 }
 
 TEST_F(IntegrationTest, syntax_error) {
@@ -504,6 +517,27 @@ pow(2).X q
     }));
 }
 
+TEST_F(IntegrationTest, power_gate_modifier__repeated_pow_half_x) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+
+pow(0.5).X q
+pow(0.5).X q[0:1]
+inv.pow(0.5).X q[2]
+pow(0.25).X q[2]
+inv.pow(0.25).X q[2]
+)";
+    auto actual = run_from_string(program);
+
+    // The matrices of pow(0.5).X and inv.pow(0.5).X are built once, and shared by all their gates
+    ASSERT_EQ(actual.state.size(), 1);
+    EXPECT_EQ(actual.state[0].value, "011");
+    EXPECT_NEAR(actual.state[0].amplitude.real, 1., 1e-12);
+    EXPECT_NEAR(actual.state[0].amplitude.imag, 0., 1e-12);
+}
+
 TEST_F(IntegrationTest, control_gate_modifier__ctrl_x) {
     auto program = R"(
 version 3.0
@@ -703,4 +737,967 @@ TEST_F(IntegrationTest, power_gate_modifier__fractional_exponent) {
     }
 }
 
+TEST_F(IntegrationTest, branch_tree__mid_circuit_measure_instruction) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+b[0] = measure q[0]
+CNOT q[0], q[1]
+H q[2]
+b[2] = measure q[2]
+b[1] = measure q[1]
+)";
+    std::size_t iterations = 10'000;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .execution_mode = ExecutionMode::branch_tree });
+
+    EXPECT_EQ(actual.shots_requested, iterations);
+    EXPECT_EQ(actual.shots_done, iterations);
+
+    // Expected 'b' value should be "000", "011", "100", and "111", 25% of the cases each
+    auto error = static_cast<std::uint64_t>(static_cast<double>(iterations) / 4 * 0.1);
+    ASSERT_EQ(actual.measurements.size(), 4);
+    EXPECT_EQ(actual.measurements[0].state, "000");
+    EXPECT_EQ(actual.measurements[1].state, "011");
+    EXPECT_EQ(actual.measurements[2].state, "100");
+    EXPECT_EQ(actual.measurements[3].state, "111");
+    for (const auto& measurement : actual.measurements) {
+        EXPECT_LT(std::abs(static_cast<long long>(iterations / 4 - measurement.count)), error);
+    }
+
+    // Expected 'q' state should be one of the measured ones
+    ASSERT_EQ(actual.state.size(), 1);
+    EXPECT_EQ(actual.state[0].amplitude, (core::Complex{ .real = 1, .imag = 0, .norm = 1 }));
+}
+
+TEST_F(IntegrationTest, branch_tree__more_branches_than_shots) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q
+b = measure q
+)";
+    // 4 branches for 2 shots, so the circuit is executed shot by shot
+    auto actual = run_from_string_with_options(
+        program, 2, SimulationOptions{ .execution_mode = ExecutionMode::branch_tree });
+    EXPECT_EQ(actual.shots_done, 2);
+    // Same with a maximum number of branches
+    actual = run_from_string_with_options(
+        program, 100, SimulationOptions{ .execution_mode = ExecutionMode::branch_tree, .max_branches = 2 });
+    EXPECT_EQ(actual.shots_done, 100);
+}
+
+TEST_F(IntegrationTest, density_matrix__bell_pair) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+CNOT q[0], q[1]
+b = measure q
+)";
+    std::size_t iterations = 10'000;
+    auto actual =
+        run_from_string_with_options(program, iterations, SimulationOptions{ .backend = Backend::density_matrix });
+
+    EXPECT_EQ(actual.shots_requested, iterations);
+    EXPECT_EQ(actual.shots_done, iterations);
+
+    // The measures are deferred to the end of the circuit, so the final state keeps both outcomes
+    EXPECT_EQ(actual.state,
+        (SimulationResult::State{
+            { "00", core::Complex{ .real = 1 / gates::SQRT_2, .imag = 0, .norm = 0.5 } },
+            { "11", core::Complex{ .real = 1 / gates::SQRT_2, .imag = 0, .norm = 0.5 } }
+    }));
+
+    // Expected 'b' value should be "00" and "11", 50% of the cases each
+    auto error = static_cast<std::uint64_t>(static_cast<double>(iterations) / 2 * 0.05);
+    ASSERT_EQ(actual.measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "00");
+    EXPECT_EQ(actual.bit_measurements[1].state, "11");
+    for (const auto& measurement : actual.bit_measurements) {
+        EXPECT_LT(std::abs(static_cast<long long>(iterations / 2 - measurement.count)), error);
+    }
+}
+
+TEST_F(IntegrationTest, density_matrix__mid_circuit_measure_instruction) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+b[0] = measure q[0]
+X q[0]
+b[1] = measure q[0]
+)";
+    std::size_t iterations = 1'000;
+    auto actual =
+        run_from_string_with_options(program, iterations, SimulationOptions{ .backend = Backend::density_matrix });
+
+    // The first measure is followed by a gate on its qubit, so it splits the simulation in two branches
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "01");
+    EXPECT_EQ(actual.bit_measurements[1].state, "10");
+    ASSERT_EQ(actual.state.size(), 1);
+    EXPECT_EQ(actual.state[0].amplitude, (core::Complex{ .real = 1, .imag = 0, .norm = 1 }));
+}
+
+TEST_F(IntegrationTest, density_matrix__depolarizing_channel) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+X q[0]
+X q[0]
+b = measure q
+)";
+    std::size_t iterations = 10'000;
+    auto options = SimulationOptions{ .backend = Backend::density_matrix,
+        .error_model = error_models::DepolarizingChannel{ .3 } };
+    auto actual = run_from_string_with_options(program, iterations, options);
+
+    // An error is added before every instruction, with probability .3 on either qubit,
+    // and flips the picked qubit with probability 2/3, so it flips each qubit with probability .1
+    // Qubit 0 goes through 3 errors, as the last one happens after it has been measured,
+    // and qubit 1 through 4
+    auto expected = SimulationResult::State{
+        { "00", core::Complex{ .real = std::sqrt(.5236), .imag = 0, .norm = .5236 } },
+        { "01", core::Complex{ .real = std::sqrt(.1812), .imag = 0, .norm = .1812 } },
+        { "10", core::Complex{ .real = std::sqrt(.2324), .imag = 0, .norm = .2324 } },
+        { "11", core::Complex{ .real = std::sqrt(.0628), .imag = 0, .norm = .0628 } }
+    };
+    EXPECT_EQ(actual.state, expected);
+    ASSERT_EQ(actual.bit_measurements.size(), 4);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        auto expected_count = static_cast<double>(iterations) * expected[i].amplitude.norm;
+        EXPECT_EQ(actual.bit_measurements[i].state, expected[i].value);
+        EXPECT_LT(
+            std::abs(expected_count - static_cast<double>(actual.bit_measurements[i].count)), 0.15 * expected_count);
+    }
+}
+
+TEST_F(IntegrationTest, density_matrix__too_many_qubits) {
+    auto program = R"(
+version 3.0
+
+qubit[15] q
+)";
+    auto result =
+        execute_string(program, 1, std::nullopt, "3.0", SimulationOptions{ .backend = Backend::density_matrix });
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+}
+
+TEST_F(IntegrationTest, noise_model) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+X q
+b = measure q
+)";
+    // q[0] always decays after X, and q[1] is always read out as 0
+    auto noise_model = error_models::NoiseModel{}
+                           .add_qubit_error(core::QubitIndex{ 0 }, error_models::KrausChannel::amplitude_damping(1.))
+                           .add_readout_error(core::QubitIndex{ 1 }, error_models::ReadoutError{ 0., 1. });
+    auto actual = run_from_string_with_options(program, 100, SimulationOptions{ .error_model = noise_model });
+    ASSERT_EQ(actual.bit_measurements.size(), 1);
+    EXPECT_EQ(actual.bit_measurements[0].state, "00");
+    // The state is not affected by readout errors
+    ASSERT_EQ(actual.state.size(), 1);
+    EXPECT_EQ(actual.state[0].value, "10");
+}
+
+TEST_F(IntegrationTest, noise_model__density_matrix) {
+    auto program = R"(
+version 3.0
+
+qubit q
+bit b
+
+H q
+b = measure q
+)";
+    auto noise_model =
+        error_models::NoiseModel{}.add_gate_error("H", error_models::KrausChannel::amplitude_damping(.4));
+    auto actual = run_from_string_with_options(
+        program, 1, SimulationOptions{ .backend = Backend::density_matrix, .error_model = noise_model });
+    ASSERT_EQ(actual.state.size(), 2);
+    EXPECT_NEAR(actual.state[0].amplitude.norm, .7, 1e-12);
+    EXPECT_NEAR(actual.state[1].amplitude.norm, .3, 1e-12);
+
+    noise_model.add_readout_error(core::QubitIndex{ 0 }, error_models::ReadoutError{ .1, .1 });
+    auto result = execute_string(program,
+        1,
+        std::nullopt,
+        "3.0",
+        SimulationOptions{ .backend = Backend::density_matrix, .error_model = noise_model });
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+}
+
+TEST_F(IntegrationTest, depolarizing_channel__same_distribution_as_density_matrix) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+X q[0]
+X q[0]
+b = measure q
+)";
+    std::size_t iterations = 20'000;
+    auto options = SimulationOptions{ .error_model = error_models::DepolarizingChannel{ .3 } };
+    auto actual = run_from_string_with_options(program, iterations, options);
+
+    // Same probabilities as in density_matrix__depolarizing_channel
+    auto expected = std::vector<std::pair<std::string, double>>{
+        { "00", .5236 },
+        { "01", .1812 },
+        { "10", .2324 },
+        { "11", .0628 }
+    };
+    ASSERT_EQ(actual.bit_measurements.size(), 4);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        auto expected_count = static_cast<double>(iterations) * expected[i].second;
+        EXPECT_EQ(actual.bit_measurements[i].state, expected[i].first);
+        EXPECT_LT(
+            std::abs(expected_count - static_cast<double>(actual.bit_measurements[i].count)), 0.1 * expected_count);
+    }
+}
+
+TEST_F(IntegrationTest, depolarizing_channel__resume_from_noiseless_prefix) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+CNOT q[0], q[1]
+X q[2]
+Rx(pi / 3) q[1]
+CNOT q[1], q[2]
+H q[0]
+reset q[0]
+X q[0]
+b = measure q
+)";
+    // Shots resume from the states cached along the unitary prefix, so they have to match the exact probabilities
+    std::size_t iterations = 20'000;
+    auto error_model = error_models::DepolarizingChannel{ .05 };
+    auto exact = run_from_string_with_options(
+        program, 1, SimulationOptions{ .backend = Backend::density_matrix, .error_model = error_model });
+    auto actual = run_from_string_with_options(program, iterations, SimulationOptions{ .error_model = error_model });
+
+    ASSERT_EQ(actual.bit_measurements.size(), exact.state.size());
+    for (std::size_t i = 0; i < exact.state.size(); ++i) {
+        auto expected_count = static_cast<double>(iterations) * exact.state[i].amplitude.norm;
+        EXPECT_EQ(actual.bit_measurements[i].state, exact.state[i].value);
+        EXPECT_LT(std::abs(expected_count - static_cast<double>(actual.bit_measurements[i].count)),
+            0.1 * expected_count + 50);
+    }
+}
+
+TEST_F(IntegrationTest, matrix_product_state__ghz_state) {
+    auto program = R"(
+version 3.0
+
+qubit[100] q
+bit[100] b
+
+H q[0]
+CNOT q[0:98], q[1:99]
+b = measure q
+)";
+    std::size_t iterations = 1'000;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::matrix_product_state });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    EXPECT_TRUE(actual.state.empty());
+    ASSERT_TRUE(actual.truncation_error.has_value());
+    EXPECT_NEAR(*actual.truncation_error, 0., 1e-12);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, std::string(100, '0'));
+    EXPECT_EQ(actual.bit_measurements[1].state, std::string(100, '1'));
+    for (const auto& measurement : actual.bit_measurements) {
+        EXPECT_LT(std::abs(static_cast<long long>(iterations / 2 - measurement.count)), 100);
+    }
+}
+
+TEST_F(IntegrationTest, matrix_product_state__mid_circuit_measure_instruction) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+b[0] = measure q[0]
+X q[0]
+b[1] = measure q[0]
+)";
+    std::size_t iterations = 1'000;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::matrix_product_state });
+
+    // The first measure is sampled on every execution, so the circuit is executed shot by shot
+    EXPECT_EQ(actual.shots_done, iterations);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "01");
+    EXPECT_EQ(actual.bit_measurements[1].state, "10");
+}
+
+TEST_F(IntegrationTest, matrix_product_state__error_model) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+)";
+    auto result = execute_string(program,
+        1,
+        std::nullopt,
+        "3.0",
+        SimulationOptions{ .backend = Backend::matrix_product_state,
+            .error_model = error_models::DepolarizingChannel{ .1 } });
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+}
+
+TEST_F(IntegrationTest, factorized_state_vector__independent_bell_pairs) {
+    auto program = R"(
+version 3.0
+
+qubit[100] a
+qubit[100] b
+bit[100] ba
+bit[100] bb
+
+H a
+CNOT a, b
+ba = measure a
+bb = measure b
+)";
+    std::size_t iterations = 100;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::factorized_state_vector });
+
+    // A single state vector would hold 2^100 amplitudes
+    EXPECT_EQ(actual.shots_done, iterations);
+    EXPECT_TRUE(actual.state.empty());
+    EXPECT_GT(actual.measurements.size(), 1);
+    for (const auto& measurement : actual.measurements) {
+        ASSERT_EQ(measurement.state.size(), 200);
+        EXPECT_EQ(measurement.state.substr(0, 100), measurement.state.substr(100));
+    }
+}
+
+TEST_F(IntegrationTest, factorized_state_vector__mid_circuit_measure_and_reset) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+CNOT q[0], q[1]
+b[0] = measure q[0]
+reset q[0]
+CNOT q[1], q[2]
+b[1] = measure q[0]
+b[2] = measure q[2]
+)";
+    std::size_t iterations = 1'000;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::factorized_state_vector });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "000");
+    EXPECT_EQ(actual.bit_measurements[1].state, "101");
+    EXPECT_LT(std::abs(static_cast<long long>(iterations / 2 - actual.bit_measurements[0].count)), 100);
+
+    auto result = execute_string(program,
+        1,
+        std::nullopt,
+        "3.0",
+        SimulationOptions{ .backend = Backend::factorized_state_vector,
+            .error_model = error_models::DepolarizingChannel{ .1 } });
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+}
+
+TEST_F(IntegrationTest, state_vector__wide_register) {
+    auto program = R"(
+version 3.0
+
+qubit[1024] q
+bit[1024] b
+
+H q[0]
+CNOT q[0], q[1023]
+b = measure q
+)";
+    auto actual = run_from_string(program, 100);
+
+    // The state vector only holds the amplitudes of the outcome of the last shot
+    auto zeros = std::string(1024, '0');
+    auto ones = zeros;
+    ones.front() = ones.back() = '1';
+    ASSERT_EQ(actual.state.size(), 1);
+    EXPECT_TRUE(actual.state[0].value == zeros || actual.state[0].value == ones);
+    EXPECT_EQ(actual.state[0].amplitude, (core::Complex{ .real = 1, .imag = 0, .norm = 1 }));
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, zeros);
+    EXPECT_EQ(actual.bit_measurements[1].state, ones);
+}
+
+TEST_F(IntegrationTest, sorted_vector_layout__qubit_placement) {
+    // The first window of instructions works on qubits 4 and 5, which are then placed at the lowest bits,
+    // and the following ones on qubits 0 to 2
+    auto program = std::string{ "version 3.0\nqubit[6] q\nH q[4]\n" };
+    for (auto i = 0; i < 40; ++i) {
+        program += "CNOT q[4], q[5]\nRx(0.1) q[5]\n";
+    }
+    program += "H q[0]\nH q[3]\n";
+    for (auto i = 0; i < 40; ++i) {
+        program += "CNOT q[0], q[1]\nRy(0.2) q[2]\nCZ q[2], q[0]\n";
+    }
+    auto expected = run_from_string(program);
+    auto actual = run_from_string_with_options(
+        program, 1, SimulationOptions{ .sparse_array_layout = core::SparseArrayLayout::sorted_vector });
+
+    ASSERT_EQ(actual.state.size(), expected.state.size());
+    for (std::size_t i = 0; i < actual.state.size(); ++i) {
+        EXPECT_EQ(actual.state[i].value, expected.state[i].value);
+        EXPECT_NEAR(actual.state[i].amplitude.real, expected.state[i].amplitude.real, 1e-12);
+        EXPECT_NEAR(actual.state[i].amplitude.imag, expected.state[i].amplitude.imag, 1e-12);
+    }
+}
+
+TEST_F(IntegrationTest, optimize_circuit) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+T q[2]
+X q[1]
+H q[0]
+CNOT q[2], q[1]
+Rx(0.3) q[1]
+Rz(0.2) q[2]
+CNOT q[2], q[1]
+inv.T q[2]
+Rx(0.4) q[1]
+H q[2]
+)";
+    auto expected = run_from_string(program);
+    auto actual = run_from_string_with_options(program, 1, SimulationOptions{ .optimize_circuit = true });
+
+    EXPECT_FALSE(expected.circuit_optimization.has_value());
+    ASSERT_TRUE(actual.circuit_optimization.has_value());
+    EXPECT_EQ(actual.circuit_optimization->number_of_cancelled_gates, 4);
+    EXPECT_EQ(actual.circuit_optimization->number_of_merged_gates, 4);
+    ASSERT_EQ(actual.state.size(), expected.state.size());
+    for (std::size_t i = 0; i < actual.state.size(); ++i) {
+        EXPECT_EQ(actual.state[i].value, expected.state[i].value);
+        EXPECT_NEAR(actual.state[i].amplitude.real, expected.state[i].amplitude.real, 1e-12);
+        EXPECT_NEAR(actual.state[i].amplitude.imag, expected.state[i].amplitude.imag, 1e-12);
+    }
+
+    // With an error model, the circuit is not optimized
+    auto noisy = run_from_string_with_options(program,
+        1,
+        SimulationOptions{ .optimize_circuit = true, .error_model = error_models::DepolarizingChannel{ 0. } });
+    EXPECT_FALSE(noisy.circuit_optimization.has_value());
+}
+
+TEST_F(IntegrationTest, measurements_only) {
+    auto program = R"(
+version 3.0
+
+qubit[5] q
+bit[5] b
+
+X q[1]
+H q[3]
+H q[2]
+CNOT q[1], q[4]
+CNOT q[3], q[2]
+H q[0]
+b[1] = measure q[1]
+b[4] = measure q[4]
+CNOT q[4], q[0]
+b[0] = measure q[0]
+X q[3]
+)";
+    std::size_t iterations = 1'000;
+    auto expected = run_from_string(program, iterations);
+    auto actual = run_from_string_with_options(program, iterations, SimulationOptions{ .measurements_only = true });
+
+    EXPECT_FALSE(expected.circuit_pruning.has_value());
+    ASSERT_TRUE(actual.circuit_pruning.has_value());
+    // H q[3], H q[2], CNOT q[3], q[2] and X q[3] can not change any measurement
+    EXPECT_EQ(actual.circuit_pruning->number_of_removed_instructions, 4);
+    EXPECT_EQ(actual.circuit_pruning->simulated_qubits, (std::vector<std::size_t>{ 0, 1, 4 }));
+    EXPECT_TRUE(actual.state.empty());
+    EXPECT_EQ(actual.shots_done, iterations);
+    // The measurements have all the qubits of the register, in the same order as without pruning
+    ASSERT_EQ(actual.measurements.size(), 2);
+    ASSERT_EQ(expected.measurements.size(), 2);
+    for (std::size_t i = 0; i < actual.measurements.size(); ++i) {
+        EXPECT_EQ(actual.measurements[i].state, expected.measurements[i].state);
+    }
+    EXPECT_EQ(actual.measurements[0].state, "10010");
+    EXPECT_EQ(actual.measurements[1].state, "10011");
+    EXPECT_NEAR(static_cast<double>(actual.measurements[0].count), iterations / 2., 100.);
+    EXPECT_EQ(actual.bit_measurements.size(), expected.bit_measurements.size());
+
+    // With an error model, the circuit is not pruned, but the state is not reported either
+    auto noisy = run_from_string_with_options(program,
+        1,
+        SimulationOptions{ .measurements_only = true, .error_model = error_models::DepolarizingChannel{ 0. } });
+    EXPECT_FALSE(noisy.circuit_pruning.has_value());
+    EXPECT_TRUE(noisy.state.empty());
+}
+
+TEST_F(IntegrationTest, distributed_state_vector__bell_pair) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+CNOT q[0], q[1]
+b = measure q
+)";
+    std::size_t iterations = 1'000;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::distributed_state_vector });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    EXPECT_TRUE(actual.state.empty());
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "00");
+    EXPECT_EQ(actual.bit_measurements[1].state, "11");
+    EXPECT_EQ(actual.bit_measurements[0].count + actual.bit_measurements[1].count, iterations);
+    EXPECT_NEAR(static_cast<double>(actual.bit_measurements[0].count), iterations / 2., 100.);
+}
+
+TEST_F(IntegrationTest, distributed_state_vector__mid_circuit_measure_instruction) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+b[0] = measure q[0]
+X q[0]
+b[1] = measure q[0]
+reset q[1]
+)";
+    std::size_t iterations = 100;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::distributed_state_vector });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "01");
+    EXPECT_EQ(actual.bit_measurements[1].state, "10");
+}
+
+TEST_F(IntegrationTest, distributed_state_vector__error_model) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+)";
+    auto result = execute_string(program,
+        1,
+        std::nullopt,
+        "3.0",
+        SimulationOptions{ .backend = Backend::distributed_state_vector,
+            .error_model = error_models::DepolarizingChannel{ .1 } });
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+}
+
+TEST_F(IntegrationTest, paged_state_vector__ghz_state) {
+    auto program = R"(
+version 3.0
+
+qubit[8] q
+bit[8] b
+
+H q[0]
+CNOT q[0:6], q[1:7]
+b = measure q
+)";
+    std::size_t iterations = 1'000;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::paged_state_vector, .number_of_page_qubits = 4 });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    EXPECT_TRUE(actual.state.empty());
+    ASSERT_TRUE(actual.paging_statistics.has_value());
+    EXPECT_GT(actual.paging_statistics->bytes_read, 0);
+    EXPECT_GT(actual.paging_statistics->bytes_written, 0);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "00000000");
+    EXPECT_EQ(actual.bit_measurements[1].state, "11111111");
+    EXPECT_EQ(actual.bit_measurements[0].count + actual.bit_measurements[1].count, iterations);
+    EXPECT_NEAR(static_cast<double>(actual.bit_measurements[0].count), iterations / 2., 100.);
+}
+
+TEST_F(IntegrationTest, paged_state_vector__mid_circuit_measure_instruction) {
+    auto program = R"(
+version 3.0
+
+qubit[4] q
+bit[2] b
+
+H q[3]
+b[0] = measure q[3]
+X q[3]
+b[1] = measure q[3]
+reset q[1]
+)";
+    std::size_t iterations = 100;
+    auto actual = run_from_string_with_options(
+        program, iterations, SimulationOptions{ .backend = Backend::paged_state_vector, .number_of_page_qubits = 2 });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "01");
+    EXPECT_EQ(actual.bit_measurements[1].state, "10");
+}
+
+TEST_F(IntegrationTest, paged_state_vector__error_model) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+)";
+    auto result = execute_string(program,
+        1,
+        std::nullopt,
+        "3.0",
+        SimulationOptions{ .backend = Backend::paged_state_vector,
+            .error_model = error_models::DepolarizingChannel{ .1 } });
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+}
+
+TEST_F(IntegrationTest, compressed_state_vector__ghz_state) {
+    auto program = R"(
+version 3.0
+
+qubit[8] q
+bit[8] b
+
+H q[0]
+CNOT q[0:6], q[1:7]
+b = measure q
+)";
+    std::size_t iterations = 1'000;
+    auto actual = run_from_string_with_options(program,
+        iterations,
+        SimulationOptions{ .backend = Backend::compressed_state_vector, .number_of_page_qubits = 4 });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    EXPECT_TRUE(actual.state.empty());
+    ASSERT_TRUE(actual.compression_statistics.has_value());
+    EXPECT_GT(actual.compression_statistics->peak_bytes, 0);
+    EXPECT_LT(actual.compression_statistics->peak_bytes, 16 * 256);
+    EXPECT_EQ(actual.compression_statistics->error, 0.);
+    ASSERT_EQ(actual.bit_measurements.size(), 2);
+    EXPECT_EQ(actual.bit_measurements[0].state, "00000000");
+    EXPECT_EQ(actual.bit_measurements[1].state, "11111111");
+    EXPECT_NEAR(static_cast<double>(actual.bit_measurements[0].count), iterations / 2., 100.);
+}
+
+TEST_F(IntegrationTest, compressed_state_vector__lossy) {
+    auto program = R"(
+version 3.0
+
+qubit[6] q
+bit[6] b
+
+Ry(1.1) q
+CNOT q[0:4], q[1:5]
+Rx(0.3) q
+b = measure q
+)";
+    std::size_t iterations = 1'000;
+    auto tolerance = 1e-6;
+    auto actual = run_from_string_with_options(program,
+        iterations,
+        SimulationOptions{ .backend = Backend::compressed_state_vector,
+            .number_of_page_qubits = 2,
+            .compression_tolerance = tolerance });
+
+    EXPECT_EQ(actual.shots_done, iterations);
+    ASSERT_TRUE(actual.compression_statistics.has_value());
+    EXPECT_GT(actual.compression_statistics->error, 0.);
+    EXPECT_LT(actual.compression_statistics->get_fidelity_loss(), 1e-6);
+}
+
+TEST_F(IntegrationTest, checkpoint__resumed_simulation_gives_the_same_result) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+CNOT q[0], q[1]
+b[0] = measure q[0]
+Rx(0.3) q[2]
+CNOT q[1], q[2]
+reset q[0]
+H q[0]
+b = measure q
+)";
+    auto checkpoint_file =
+        (std::filesystem::temp_directory_path() / "qx_checkpoint_resumed_simulation_test.bin").string();
+    std::filesystem::remove(checkpoint_file);
+    auto options = SimulationOptions{ .checkpoint_file = checkpoint_file,
+        .checkpoint_interval = 5,
+        .error_model = error_models::DepolarizingChannel{ .05 } };
+    auto execute = [&program, &options]() { return execute_string(program, 40, 1234, "3.0", options); };
+
+    auto uninterrupted = execute();
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(uninterrupted));
+    EXPECT_FALSE(std::filesystem::exists(checkpoint_file));
+
+    // Every execution stops after its first checkpoint, and the next one resumes from it
+    auto stop_source = std::stop_source{};
+    stop_source.request_stop();
+    options.stop_token = stop_source.get_token();
+    auto number_of_stops = 0;
+    auto result = execute();
+    while (std::holds_alternative<SimulationError>(result)) {
+        ++number_of_stops;
+        ASSERT_TRUE(std::filesystem::exists(checkpoint_file));
+        result = execute();
+    }
+    // 40 shots of 9 instructions, the first 2 of which may be resumed from the cached unitary prefix,
+    // with a checkpoint every 5 instructions
+    EXPECT_GE(number_of_stops, 40 * 7 / 5);
+    EXPECT_LE(number_of_stops, 40 * 9 / 5);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    const auto& expected = std::get<SimulationResult>(uninterrupted);
+    const auto& actual = std::get<SimulationResult>(result);
+    EXPECT_EQ(actual.shots_done, 40);
+    EXPECT_EQ(actual.measurements, expected.measurements);
+    EXPECT_EQ(actual.bit_measurements, expected.bit_measurements);
+    ASSERT_EQ(actual.state.size(), expected.state.size());
+    for (std::size_t i = 0; i < actual.state.size(); ++i) {
+        EXPECT_EQ(actual.state[i].value, expected.state[i].value);
+        EXPECT_EQ(actual.state[i].amplitude.real, expected.state[i].amplitude.real);
+        EXPECT_EQ(actual.state[i].amplitude.imag, expected.state[i].amplitude.imag);
+    }
+}
+
+TEST_F(IntegrationTest, checkpoint__of_another_simulation) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+H q[0]
+CNOT q[0], q[1]
+)";
+    auto checkpoint_file =
+        (std::filesystem::temp_directory_path() / "qx_checkpoint_of_another_simulation_test.bin").string();
+    std::filesystem::remove(checkpoint_file);
+    auto stop_source = std::stop_source{};
+    stop_source.request_stop();
+    auto options = SimulationOptions{ .checkpoint_file = checkpoint_file,
+        .checkpoint_interval = 1,
+        .stop_token = stop_source.get_token() };
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(execute_string(program, 1, std::nullopt, "3.0", options)));
+    ASSERT_TRUE(std::filesystem::exists(checkpoint_file));
+
+    // Another number of shots, which also resumes the shots from the unitary prefix, without any checkpoint
+    auto result = execute_string(program, 20, std::nullopt, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(result));
+    EXPECT_THAT(std::get<SimulationError>(result).what(), ::testing::HasSubstr("does not belong to this simulation"));
+
+    // Not a checkpoint
+    std::ofstream{ checkpoint_file } << "not a checkpoint";
+    result = execute_string(program, 1, std::nullopt, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(result));
+    EXPECT_THAT(std::get<SimulationError>(result).what(), ::testing::HasSubstr("invalid checkpoint"));
+    std::filesystem::remove(checkpoint_file);
+}
+
+TEST_F(IntegrationTest, compiled_circuit__gives_the_same_result) {
+    auto program = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+CNOT q[0], q[1]
+b[0] = measure q[0]
+Rx(0.3) q[2]
+inv.pow(0.5).X q[1]
+ctrl.Rz(0.7) q[1], q[2]
+reset q[0]
+H q
+b = measure q
+)";
+    auto compiled_file = (std::filesystem::temp_directory_path() / "qx_compiled_circuit_same_result_test.qxc").string();
+    std::filesystem::remove(compiled_file);
+    EXPECT_FALSE(compile_string(program, compiled_file).has_value());
+    ASSERT_TRUE(std::filesystem::exists(compiled_file));
+    EXPECT_TRUE(is_compiled_circuit_file(compiled_file));
+
+    auto expected_result = execute_string(program, 40, 1234);
+    auto actual_result = execute_compiled_file(compiled_file, 40, 1234);
+    std::filesystem::remove(compiled_file);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(expected_result));
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(actual_result));
+    const auto& expected = std::get<SimulationResult>(expected_result);
+    const auto& actual = std::get<SimulationResult>(actual_result);
+    EXPECT_EQ(actual.shots_done, 40);
+    EXPECT_EQ(actual.measurements, expected.measurements);
+    EXPECT_EQ(actual.bit_measurements, expected.bit_measurements);
+    ASSERT_EQ(actual.state.size(), expected.state.size());
+    for (std::size_t i = 0; i < actual.state.size(); ++i) {
+        EXPECT_EQ(actual.state[i].value, expected.state[i].value);
+        EXPECT_EQ(actual.state[i].amplitude.real, expected.state[i].amplitude.real);
+        EXPECT_EQ(actual.state[i].amplitude.imag, expected.state[i].amplitude.imag);
+    }
+}
+
+TEST_F(IntegrationTest, compiled_circuit__with_options) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+H q[0]
+X q[1]
+CNOT q[1], q[0]
+b = measure q
+)";
+    auto compiled_file = (std::filesystem::temp_directory_path() / "qx_compiled_circuit_options_test.qxc").string();
+    std::filesystem::remove(compiled_file);
+    ASSERT_FALSE(compile_string(program, compiled_file).has_value());
+    auto options = SimulationOptions{ .optimize_circuit = true, .measurements_only = true };
+    auto result = execute_compiled_file(compiled_file, 10, std::nullopt, options);
+    std::filesystem::remove(compiled_file);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    const auto& actual = std::get<SimulationResult>(result);
+    EXPECT_TRUE(actual.circuit_optimization.has_value());
+    EXPECT_TRUE(actual.circuit_pruning.has_value());
+    ASSERT_EQ(actual.measurements.size(), 1);
+    EXPECT_EQ(actual.measurements[0].state, "11");
+    EXPECT_EQ(actual.measurements[0].count, 10);
+}
+
+TEST_F(IntegrationTest, compiled_circuit__invalid_file) {
+    auto compiled_file = (std::filesystem::temp_directory_path() / "qx_compiled_circuit_invalid_test.qxc").string();
+
+    // Not a cQASM version that can be compiled
+    std::filesystem::remove(compiled_file);
+    EXPECT_TRUE(compile_string("version 1.0\n\nqubit q\n", compiled_file, "1.0").has_value());
+    EXPECT_FALSE(std::filesystem::exists(compiled_file));
+
+    // Not a compiled circuit
+    std::ofstream{ compiled_file } << "not a compiled circuit";
+    EXPECT_FALSE(is_compiled_circuit_file(compiled_file));
+    auto result = execute_compiled_file(compiled_file);
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(result));
+    EXPECT_THAT(std::get<SimulationError>(result).what(), ::testing::HasSubstr("invalid compiled circuit"));
+    std::filesystem::remove(compiled_file);
+
+    // No file
+    EXPECT_FALSE(is_compiled_circuit_file(compiled_file));
+    result = execute_compiled_file(compiled_file);
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(result));
+    EXPECT_THAT(std::get<SimulationError>(result).what(), ::testing::HasSubstr("could not read compiled circuit file"));
+}
+
+TEST_F(IntegrationTest, compiled_circuit__corrupted_file) {
+    auto program = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+CNOT q[0], q[1]
+H q[0]
+b = measure q
+)";
+    auto compiled_file = (std::filesystem::temp_directory_path() / "qx_compiled_circuit_corrupted_test.qxc").string();
+    ASSERT_FALSE(compile_string(program, compiled_file).has_value());
+    auto bytes = std::string{};
+    {
+        auto file = std::ifstream{ compiled_file, std::ios::binary };
+        bytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+    }
+    // Magic number, format version, number of instructions, and number of words, followed by the words
+    const auto words_offset = std::size_t{ 28 };
+    auto number_of_words = std::uint64_t{};
+    std::memcpy(&number_of_words, bytes.data() + 20, sizeof(number_of_words));
+    // CNOT q[0], q[1] is encoded as: unitary, matrix index, name index, 2 operands, 0, 1
+    ASSERT_GE(number_of_words, 6);
+
+    auto execute_corrupted = [&compiled_file](const std::string& corrupted_bytes) {
+        std::ofstream{ compiled_file, std::ios::binary | std::ios::trunc } << corrupted_bytes;
+        auto result = execute_compiled_file(compiled_file);
+        EXPECT_TRUE(std::holds_alternative<SimulationError>(result));
+        return std::holds_alternative<SimulationError>(result) ? std::string{ std::get<SimulationError>(result).what() }
+                                                              : std::string{};
+    };
+    auto with_word = [&bytes](std::size_t offset, std::uint32_t word) {
+        auto ret = bytes;
+        std::memcpy(ret.data() + offset, &word, sizeof(word));
+        return ret;
+    };
+
+    EXPECT_THAT(execute_corrupted(with_word(8, 99)), ::testing::HasSubstr("unsupported format version 99"));
+    EXPECT_THAT(execute_corrupted(bytes.substr(0, words_offset + 3 * sizeof(std::uint32_t))),
+        ::testing::HasSubstr("truncated instructions"));
+    EXPECT_THAT(execute_corrupted(bytes.substr(0, bytes.size() - 1)), ::testing::HasSubstr("truncated"));
+    EXPECT_THAT(execute_corrupted(with_word(words_offset + 4, 1'000)), ::testing::HasSubstr("index out of range"));
+    EXPECT_THAT(execute_corrupted(with_word(words_offset + 16, 2)), ::testing::HasSubstr("index out of range"));
+    EXPECT_THAT(execute_corrupted(with_word(words_offset + 20, 0)), ::testing::HasSubstr("duplicate gate operand"));
+    EXPECT_THAT(execute_corrupted(with_word(words_offset + 12, 1)),
+        ::testing::HasSubstr("gate matrix does not match its operands"));
+    EXPECT_THAT(execute_corrupted(with_word(12, 99)), ::testing::HasSubstr("wrong number of instructions"));
+    // A bit-controlled instruction, without control bits, of another bit-controlled instruction
+    auto nested_bit_controlled = with_word(words_offset, 3);
+    std::memcpy(nested_bit_controlled.data() + words_offset + 8, nested_bit_controlled.data() + words_offset, 4);
+    EXPECT_THAT(execute_corrupted(nested_bit_controlled), ::testing::HasSubstr("is not a unitary"));
+
+    // The qubit register, after the words: number of variables, and variable "q", of 2 qubits
+    const auto qubit_size_offset = words_offset + number_of_words * sizeof(std::uint32_t) + 8 + 8 + 1;
+    EXPECT_THAT(execute_corrupted(with_word(qubit_size_offset, 0)), ::testing::HasSubstr("invalid size of variable"));
+    EXPECT_THAT(
+        execute_corrupted(with_word(qubit_size_offset + 4, 1)), ::testing::HasSubstr("invalid size of variable"));
+    std::filesystem::remove(compiled_file);
+}
+
 }  // namespace qx
@@ -0,0 +1,129 @@
+#include "qx/matrix_product_state.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>  // abs, sin
+#include <complex>
+#include <cstdint>  // size_t
+#include <vector>
+
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/quantum_state.hpp"
+
+#include "amplitudes_helper.hpp"
+
+namespace qx::core {
+
+class MatrixProductStateTest : public ::testing::Test {};
+
+TEST_F(MatrixProductStateTest, initial_state) {
+    auto victim = MatrixProductState{ 3, 4, 0. };
+    EXPECT_EQ(victim.get_number_of_qubits(), 3);
+    EXPECT_EQ(victim.get_bond_dimension(), 1);
+    EXPECT_EQ(victim.get_amplitude(basis_vector(3, 0)), std::complex<double>{ 1. });
+    EXPECT_EQ(victim.get_amplitude(basis_vector(3, 5)), std::complex<double>{ 0. });
+}
+
+TEST_F(MatrixProductStateTest, ghz_state) {
+    auto victim = MatrixProductState{ 100, 4, 1e-12 };
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    for (std::size_t i = 1; i < 100; ++i) {
+        victim.apply(gates::CNOT, { QubitIndex{ i - 1 }, QubitIndex{ i } });
+    }
+    EXPECT_EQ(victim.get_bond_dimension(), 2);
+    EXPECT_NEAR(victim.get_truncation_error(), 0., 1e-12);
+    auto all_ones = MeasurementRegister{ 100 };
+    all_ones.set();
+    EXPECT_NEAR(std::abs(victim.get_amplitude(MeasurementRegister{ 100 })), gates::SQRT_2 / 2, 1e-12);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(all_ones)), gates::SQRT_2 / 2, 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 57 }), .5, 1e-12);
+}
+
+TEST_F(MatrixProductStateTest, same_amplitudes_as_state_vector) {
+    // Gates on non-adjacent qubits, and in reversed order, move the qubits along the chain
+    auto victim = MatrixProductState{ 5, 32, 0. };
+    auto expected = QuantumState{ 5, 5 };
+    auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+        victim.apply(matrix, operands);
+        expected.apply(matrix, operands);
+    };
+    apply(gates::H, { QubitIndex{ 0 } });
+    apply(gates::RX(.3), { QubitIndex{ 2 } });
+    apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 3 } });
+    apply(gates::T, { QubitIndex{ 3 } });
+    apply(gates::CR(.7), { QubitIndex{ 4 }, QubitIndex{ 1 } });
+    apply(gates::H, { QubitIndex{ 4 } });
+    apply(gates::CNOT, { QubitIndex{ 4 }, QubitIndex{ 1 } });
+    apply(gates::TOFFOLI, { QubitIndex{ 3 }, QubitIndex{ 0 }, QubitIndex{ 2 } });
+    apply(gates::RY(1.1), { QubitIndex{ 1 } });
+    apply(gates::SWAP, { QubitIndex{ 2 }, QubitIndex{ 4 } });
+    apply(gates::CZ, { QubitIndex{ 1 }, QubitIndex{ 3 } });
+    check_eq(victim, expected);
+    EXPECT_NEAR(victim.get_truncation_error(), 0., 1e-12);
+}
+
+TEST_F(MatrixProductStateTest, truncation) {
+    // A bond dimension of 1 can only hold product states, so the Bell state loses half of its weight
+    auto victim = MatrixProductState{ 2, 1, 0. };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    EXPECT_EQ(victim.get_bond_dimension(), 1);
+    EXPECT_NEAR(victim.get_truncation_error(), .5, 1e-12);
+    auto norm =
+        std::norm(victim.get_amplitude(basis_vector(2, 0))) + std::norm(victim.get_amplitude(basis_vector(2, 3)));
+    EXPECT_NEAR(norm, 1., 1e-12);
+}
+
+TEST_F(MatrixProductStateTest, truncation_threshold) {
+    // The weight of the smallest singular value is sin^2(.001 / 2)
+    auto victim = MatrixProductState{ 2, 4, 1e-3 };
+    victim.apply(gates::RY(.001), { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    EXPECT_EQ(victim.get_bond_dimension(), 1);
+    EXPECT_NEAR(victim.get_truncation_error(), std::sin(.0005) * std::sin(.0005), 1e-12);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(2, 0))), 1., 1e-12);
+}
+
+TEST_F(MatrixProductStateTest, measurement) {
+    auto victim = MatrixProductState{ 3, 4, 0. };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 2 } });
+    auto probability_of_measuring_one = victim.get_probability_of_measuring_one(QubitIndex{ 2 });
+    EXPECT_NEAR(probability_of_measuring_one, .5, 1e-12);
+    victim.update_data_after_measurement(QubitIndex{ 2 }, true, probability_of_measuring_one);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(3, 5))), 1., 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), 1., 1e-12);
+}
+
+TEST_F(MatrixProductStateTest, reset) {
+    auto victim = MatrixProductState{ 2, 4, 0. };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    // Qubit 0 is measured as one, which collapses qubit 1 to one too
+    victim.apply_reset(QubitIndex{ 0 }, .1);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(2, 2))), 1., 1e-12);
+}
+
+TEST_F(MatrixProductStateTest, sample) {
+    auto victim = MatrixProductState{ 20, 4, 0. };
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    for (std::size_t i = 1; i < 20; ++i) {
+        victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ i } });
+    }
+    // Each sample draws 20 numbers, so consecutive samples start at different numbers
+    auto randoms = std::vector<double>{ .7, .2, .9 };
+    std::size_t next = 0;
+    auto number_of_ones = 0;
+    for (auto i = 0; i < 100; ++i) {
+        auto sample = victim.sample([&randoms, &next]() { return randoms[next++ % randoms.size()]; });
+        EXPECT_TRUE(sample.none() || sample.all());
+        number_of_ones += sample.all() ? 1 : 0;
+    }
+    EXPECT_GT(number_of_ones, 0);
+    EXPECT_LT(number_of_ones, 100);
+}
+
+TEST_F(MatrixProductStateTest, invalid_arguments) {
+    EXPECT_THROW((MatrixProductState{ 0, 4, 0. }), MatrixProductStateError);
+    EXPECT_THROW((MatrixProductState{ 2, 0, 0. }), MatrixProductStateError);
+    EXPECT_THROW((MatrixProductState{ 2, 4, -1. }), MatrixProductStateError);
+}
+
+}  // namespace qx::core
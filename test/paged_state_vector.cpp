@@ -0,0 +1,185 @@
+#include "qx/paged_state_vector.hpp"
+
+#include <gmock/gmock.h>  // ThrowsMessage
+#include <gtest/gtest.h>
+
+#include <cmath>  // abs
+#include <complex>
+#include <cstdint>  // size_t, uint64_t
+#include <filesystem>
+#include <vector>
+
+#include "qx/compile_time_configuration.hpp"  // CACHE_BLOCK_QUBITS
+#include "qx/core.hpp"
+#include "qx/gates.hpp"
+#include "qx/quantum_state.hpp"
+
+#include "amplitudes_helper.hpp"
+
+namespace qx::core {
+
+class PagedStateVectorTest : public ::testing::Test {
+protected:
+    static constexpr std::uint64_t page_bytes(std::size_t number_of_page_qubits) {
+        return sizeof(std::complex<double>) << number_of_page_qubits;
+    }
+};
+
+TEST_F(PagedStateVectorTest, same_amplitudes_as_state_vector) {
+    // Qubits 3 to 5 start at page-index bits, and gates on them swap them with page bits
+    auto victim = PagedStateVector{ 6, 3 };
+    EXPECT_EQ(victim.get_number_of_pages(), 8);
+    auto expected = QuantumState{ 6, 6 };
+    auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+        victim.apply(matrix, operands);
+        expected.apply(matrix, operands);
+    };
+    apply(gates::H, { QubitIndex{ 0 } });
+    apply(gates::RX(.3), { QubitIndex{ 5 } });
+    apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 3 } });
+    apply(gates::T, { QubitIndex{ 3 } });
+    apply(gates::CR(.7), { QubitIndex{ 4 }, QubitIndex{ 1 } });
+    apply(gates::H, { QubitIndex{ 2 } });
+    apply(gates::TOFFOLI, { QubitIndex{ 3 }, QubitIndex{ 0 }, QubitIndex{ 5 } });
+    apply(gates::RY(1.1), { QubitIndex{ 1 } });
+    apply(gates::SWAP, { QubitIndex{ 2 }, QubitIndex{ 4 } });
+    apply(gates::CZ, { QubitIndex{ 1 }, QubitIndex{ 3 } });
+    check_eq(victim, expected);
+    EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+}
+
+TEST_F(PagedStateVectorTest, gates_are_applied_by_cache_blocks) {
+    // Qubits c and c + 1 start at page bits above the block bits, and qubit c + 2 at a page-index bit,
+    // so gates on them are preceded by swaps with block bits, queued or not
+    constexpr auto c = config::CACHE_BLOCK_QUBITS;
+    auto victim = PagedStateVector{ c + 3, c + 2 };
+    auto expected = QuantumState{ c + 3, c + 3 };
+    auto apply = [&victim, &expected](const auto& matrix, const operands_t& operands) {
+        victim.apply(matrix, operands);
+        expected.apply(matrix, operands);
+    };
+    apply(gates::H, { QubitIndex{ 0 } });
+    apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ c + 1 } });
+    apply(gates::RY(.3), { QubitIndex{ c } });
+    apply(gates::H, { QubitIndex{ c + 2 } });
+    apply(gates::CR(.7), { QubitIndex{ c + 2 }, QubitIndex{ 1 } });
+    apply(gates::TOFFOLI, { QubitIndex{ c + 1 }, QubitIndex{ c }, QubitIndex{ c - 1 } });
+    apply(gates::T, { QubitIndex{ c - 1 } });
+    apply(gates::SWAP, { QubitIndex{ 1 }, QubitIndex{ c + 1 } });
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ c + 1 }),
+        expected.get_probability_of_measuring_one(QubitIndex{ c + 1 }),
+        1e-12);
+    apply(gates::RX(.2), { QubitIndex{ c } });
+    check_eq(victim, expected);
+    EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+}
+
+TEST_F(PagedStateVectorTest, single_page_is_never_paged) {
+    auto victim = PagedStateVector{ 3, 8 };
+    EXPECT_EQ(victim.get_number_of_pages(), 1);
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 2 } });
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(3, 5))), gates::SQRT_2 / 2, 1e-12);
+    EXPECT_EQ(victim.get_paging_statistics().bytes_read, 0);
+    EXPECT_EQ(victim.get_paging_statistics().bytes_written, 0);
+}
+
+TEST_F(PagedStateVectorTest, queued_gates_are_applied_in_a_single_pass) {
+    auto victim = PagedStateVector{ 4, 2 };
+    // Zero pages are neither read nor written
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::H, { QubitIndex{ 1 } });
+    EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+    EXPECT_EQ(victim.get_paging_statistics().bytes_read, 0);
+    EXPECT_EQ(victim.get_paging_statistics().bytes_written, 0);
+
+    // Spread the state over the 4 pages
+    victim.apply(gates::H, { QubitIndex{ 2 } }).apply(gates::H, { QubitIndex{ 3 } });
+    EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+
+    // Qubits 2 and 3 were swapped with the page bits used least recently, so they are now stored at page bits:
+    // whatever the number of gates on them, the batch reads and writes every page but the one in memory once,
+    // and so does the following pass to compute the norm, which only writes the page left in memory by the batch
+    auto paging = [&victim](auto&& apply_gates) {
+        auto before = victim.get_paging_statistics();
+        apply_gates();
+        EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+        const auto& after = victim.get_paging_statistics();
+        return std::vector<std::uint64_t>{ after.bytes_read - before.bytes_read,
+            after.bytes_written - before.bytes_written };
+    };
+    auto one_gate = paging([&victim]() { victim.apply(gates::T, { QubitIndex{ 2 } }); });
+    auto three_gates = paging([&victim]() {
+        victim.apply(gates::T, { QubitIndex{ 2 } })
+            .apply(gates::CNOT, { QubitIndex{ 2 }, QubitIndex{ 3 } })
+            .apply(gates::RZ(.4), { QubitIndex{ 3 } });
+    });
+    EXPECT_EQ(one_gate, (std::vector<std::uint64_t>{ 6 * page_bytes(2), 4 * page_bytes(2) }));
+    EXPECT_EQ(three_gates, one_gate);
+}
+
+TEST_F(PagedStateVectorTest, measurement) {
+    auto victim = PagedStateVector{ 4, 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 3 } });
+    auto probability_of_measuring_one = victim.get_probability_of_measuring_one(QubitIndex{ 3 });
+    EXPECT_NEAR(probability_of_measuring_one, .5, 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), .5, 1e-12);
+    // Qubit 0 is now stored at a page-index bit, so measuring it discards whole pages
+    victim.apply(gates::CNOT, { QubitIndex{ 2 }, QubitIndex{ 1 } });
+    victim.update_data_after_measurement(QubitIndex{ 0 }, true, probability_of_measuring_one);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(4, 9))), 1., 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 3 }), 1., 1e-12);
+    EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+    victim.apply(gates::H, { QubitIndex{ 2 } });
+    EXPECT_FALSE(victim.measure(QubitIndex{ 2 }, .9));
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(4, 9))), 1., 1e-12);
+}
+
+TEST_F(PagedStateVectorTest, reset) {
+    auto victim = PagedStateVector{ 3, 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 2 } });
+    // Qubit 0 is measured as one, which collapses qubit 2 to one too
+    victim.apply_reset(QubitIndex{ 0 }, .1);
+    EXPECT_NEAR(std::abs(victim.get_amplitude(basis_vector(3, 4))), 1., 1e-12);
+}
+
+TEST_F(PagedStateVectorTest, sample) {
+    auto victim = PagedStateVector{ 6, 2 };
+    victim.apply(gates::H, { QubitIndex{ 0 } });
+    for (std::size_t i = 1; i < 6; ++i) {
+        victim.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ i } });
+    }
+    auto randoms = std::vector<double>{ .7, .2, .9, .4 };
+    std::size_t next = 0;
+    auto samples = victim.sample(100, [&randoms, &next]() { return randoms[next++ % randoms.size()]; });
+    ASSERT_EQ(samples.size(), 100);
+    auto number_of_ones = 0;
+    for (const auto& sample : samples) {
+        EXPECT_TRUE(sample.none() || sample.all());
+        number_of_ones += sample.all() ? 1 : 0;
+    }
+    EXPECT_EQ(number_of_ones, 50);
+}
+
+TEST_F(PagedStateVectorTest, page_file_is_removed) {
+    auto directory = std::filesystem::temp_directory_path() / "qx_paged_state_vector_test";
+    std::filesystem::create_directories(directory);
+    {
+        auto victim = PagedStateVector{ 4, 2, directory };
+        victim.apply(gates::H, { QubitIndex{ 3 } });
+        EXPECT_NEAR(victim.get_norm(), 1., 1e-12);
+        EXPECT_FALSE(std::filesystem::is_empty(directory));
+    }
+    EXPECT_TRUE(std::filesystem::is_empty(directory));
+    std::filesystem::remove(directory);
+}
+
+TEST_F(PagedStateVectorTest, invalid_arguments) {
+    EXPECT_THROW(PagedStateVector(0, 2), PagedStateVectorError);
+    EXPECT_THROW(PagedStateVector(4, 0), PagedStateVectorError);
+    EXPECT_THROW(PagedStateVector(4, 2, "/non/existing/directory"), PagedStateVectorError);
+    auto victim = PagedStateVector{ 4, 2 };
+    EXPECT_THAT([&victim]() { victim.apply(gates::TOFFOLI, { QubitIndex{ 0 }, QubitIndex{ 1 }, QubitIndex{ 2 } }); },
+        ::testing::ThrowsMessage<PagedStateVectorError>(
+            "gate on 3 qubits needs at least as many qubits in a cache block: 2"));
+}
+
+}  // namespace qx::core
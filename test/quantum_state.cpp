@@ -3,7 +3,12 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>  // count_if
+#include <complex>  // abs, exp
+#include <cstdint>  // uint64_t
 #include <numbers>
+#include <numeric>  // iota
+#include <optional>
+#include <sstream>
 
 #include "qx/core.hpp"
 #include "qx/gates.hpp"
@@ -46,6 +51,20 @@ TEST_F(QuantumStateTest, apply_hadamard) {
     check_eq(victim, { 1 / std::numbers::sqrt2, 0, 1 / std::numbers::sqrt2, 0, 0, 0, 0, 0 });
 }
 
+TEST_F(QuantumStateTest, get_memory_size) {
+    for (auto layout : { SparseArrayLayout::hash_map, SparseArrayLayout::sorted_vector }) {
+        QuantumState victim{ 8, 8, layout };
+        auto basis_state_memory_size = victim.get_memory_size();
+        EXPECT_GT(basis_state_memory_size, 0);
+        for (std::size_t i = 0; i < 8; ++i) {
+            victim.apply(gates::H, { QubitIndex{ i } });
+        }
+        check_eq(victim, std::vector<std::complex<double>>(256, 1. / 16));
+        EXPECT_GT(victim.get_memory_size(), basis_state_memory_size);
+        EXPECT_GE(victim.get_memory_size(), 256 * sizeof(std::complex<double>));
+    }
+}
+
 TEST_F(QuantumStateTest, apply_cnot) {
     QuantumState victim{
         2, 2, { { "10", 0.123 }, { "11", std::sqrt(1 - std::pow(0.123, 2)) } }
@@ -67,7 +86,7 @@ TEST_F(QuantumStateTest, measure_on_non_superposed_state) {
     victim.apply_measure(
         QubitIndex{ 1 }, BitIndex{ 0 }, []() { return 0.045621; }, measurement_register, bit_measurement_register);
     check_eq(victim, { 0, 0, 0.123, std::sqrt(1 - std::pow(0.123, 2)) });
-    EXPECT_EQ(measurement_register, BasisVector{ std::string{ "10" } });
+    EXPECT_EQ(measurement_register, MeasurementRegister{ std::string{ "10" } });
 }
 
 TEST_F(QuantumStateTest, measure_on_superposed_state__measured_state_is_0) {
@@ -81,7 +100,7 @@ TEST_F(QuantumStateTest, measure_on_superposed_state__measured_state_is_0) {
     victim.apply_measure(
         QubitIndex{ 0 }, BitIndex{ 0 }, []() { return 0.994; }, measurement_register, bit_measurement_register);
     check_eq(victim, { 0, 0, 1, 0 });  // 10
-    EXPECT_EQ(measurement_register, BasisVector{ std::string{ "00" } });
+    EXPECT_EQ(measurement_register, MeasurementRegister{ std::string{ "00" } });
 }
 
 TEST_F(QuantumStateTest, measure_on_superposed_state__measured_state_is_1) {
@@ -95,7 +114,49 @@ TEST_F(QuantumStateTest, measure_on_superposed_state__measured_state_is_1) {
     victim.apply_measure(
         QubitIndex{ 0 }, BitIndex{ 0 }, []() { return 0.254; }, measurement_register, bit_measurement_register);
     check_eq(victim, { 0, 0, 0, 1 });  // 11
-    EXPECT_EQ(measurement_register, BasisVector{ std::string{ "01" } });
+    EXPECT_EQ(measurement_register, MeasurementRegister{ std::string{ "01" } });
+}
+
+TEST_F(QuantumStateTest, marginal_probabilities) {
+    QuantumState victim{
+        3, 3, { { "010", 0.6 }, { "111", 0.8i } }
+    };
+    const auto& marginals = victim.get_marginal_probabilities();
+    ASSERT_EQ(marginals.size(), 3);
+    EXPECT_NEAR(marginals[0], 0.64, 1e-12);
+    EXPECT_NEAR(marginals[1], 1., 1e-12);
+    EXPECT_NEAR(marginals[2], 0.64, 1e-12);
+    auto subset = victim.get_marginal_probabilities({ QubitIndex{ 2 }, QubitIndex{ 1 } });
+    EXPECT_NEAR(subset[0], 0.64, 1e-12);
+    EXPECT_NEAR(subset[1], 1., 1e-12);
+
+    // Marginal probabilities are computed again after a gate
+    victim.apply(gates::X, { QubitIndex{ 1 } });
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), 0., 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_zero(QubitIndex{ 0 }), 0.36, 1e-12);
+}
+
+TEST_F(QuantumStateTest, marginal_probabilities_after_measure_and_reset) {
+    auto measurement_register = core::MeasurementRegister{ 3 };
+    auto bit_measurement_register = core::BitMeasurementRegister{ 3 };
+    QuantumState victim{
+        3, 3, { { "000", 0.6 }, { "011", 0.48 }, { "110", 0.64 } }
+    };
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), 0.64, 1e-12);
+
+    // Measure qubit 1 as 1: 011 and 110 are left, with probabilities 0.36 and 0.64
+    victim.apply_measure(
+        QubitIndex{ 1 }, BitIndex{ 1 }, []() { return 0.5; }, measurement_register, bit_measurement_register);
+    const auto& marginals = victim.get_marginal_probabilities();
+    EXPECT_NEAR(marginals[0], 0.36, 1e-12);
+    EXPECT_NEAR(marginals[1], 1., 1e-12);
+    EXPECT_NEAR(marginals[2], 0.64, 1e-12);
+
+    victim.apply_reset(QubitIndex{ 1 });
+    check_eq(victim, { 0, 0.6, 0, 0, 0.8, 0, 0, 0 });  // 001 and 100
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), 0.36, 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 1 }), 0., 1e-12);
+    EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 2 }), 0.64, 1e-12);
 }
 
 TEST_F(QuantumStateTest, reset) {
@@ -106,4 +167,332 @@ TEST_F(QuantumStateTest, reset) {
     check_eq(victim, { 0.123, 0, std::sqrt(1 - std::pow(0.123, 2)), 0 });  // 00 and 10
 }
 
+TEST_F(QuantumStateTest, diagonal_gates_are_queued) {
+    auto phase = std::exp(1i * std::numbers::pi / 4.);
+    for (auto layout : { SparseArrayLayout::hash_map, SparseArrayLayout::sorted_vector }) {
+        QuantumState victim{ 2, 2, layout };
+        victim.apply(gates::H, { QubitIndex{ 0 } });
+        victim.apply(gates::H, { QubitIndex{ 1 } });
+        EXPECT_EQ(victim.get_number_of_queued_diagonal_gates(), 0);
+        victim.apply(gates::S, { QubitIndex{ 0 } });
+        victim.apply(gates::CZ, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+        victim.apply(gates::T, { QubitIndex{ 1 } });
+        victim.apply(gates::Z, { QubitIndex{ 0 } });
+        victim.apply(gates::SDAG, { QubitIndex{ 1 } });
+        victim.apply(gates::S, { QubitIndex{ 1 } });
+
+        // inv.S and S are merged into T, Z is kept in the Pauli frame, and the probabilities are not computed again
+        EXPECT_EQ(victim.get_number_of_queued_diagonal_gates(), 3);
+        EXPECT_DOUBLE_EQ(victim.get_probability_of_measuring_one(QubitIndex{ 0 }), .5);
+        auto expected = std::vector<std::complex<double>>{ .5, -.5i, .5 * phase, .5i * phase };
+        auto actual = victim.to_vector();
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(std::abs(actual[i] - expected[i]), 0., 1e-12);
+        }
+        EXPECT_EQ(victim.get_number_of_queued_diagonal_gates(), 3);
+
+        // The queued gates follow the qubits they act on, and are applied before the next non-diagonal gate
+        victim.set_qubit_positions({ 1, 0 });
+        victim.apply(gates::H, { QubitIndex{ 0 } });
+        EXPECT_EQ(victim.get_number_of_queued_diagonal_gates(), 0);
+        QuantumState reference{
+            2, 2, { { "00", expected[0] }, { "01", expected[1] }, { "10", expected[2] }, { "11", expected[3] } }
+        };
+        reference.apply(gates::H, { QubitIndex{ 0 } });
+        check_eq(victim, reference.to_vector());
+    }
+}
+
+TEST_F(QuantumStateTest, diagonal_gates_are_queued_through_measurements) {
+    QuantumState expected{ 2, 2 };
+    expected.apply(gates::H, { QubitIndex{ 0 } });
+    expected.apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+    QuantumState victim = expected;
+    expected.apply(gates::RZ(.7), { QubitIndex{ 1 } });
+    expected.apply(gates::H, { QubitIndex{ 1 } });
+    victim.apply(gates::RZ(.7), { QubitIndex{ 1 } });
+
+    auto measurement_register = core::MeasurementRegister{ 2 };
+    auto bit_measurement_register = core::BitMeasurementRegister{ 2 };
+    victim.apply_measure(
+        QubitIndex{ 0 }, BitIndex{ 0 }, []() { return 0.3; }, measurement_register, bit_measurement_register);
+    EXPECT_EQ(victim.get_number_of_queued_diagonal_gates(), 1);
+    victim.apply(gates::H, { QubitIndex{ 1 } });
+    expected.apply_measure(
+        QubitIndex{ 0 }, BitIndex{ 0 }, []() { return 0.3; }, measurement_register, bit_measurement_register);
+    check_eq(victim, expected.to_vector());
+
+    // A reset applies the queued gates first
+    victim.apply(gates::T, { QubitIndex{ 0 } });
+    victim.apply_reset(QubitIndex{ 0 });
+    expected.apply(gates::T, { QubitIndex{ 0 } });
+    expected.apply_reset(QubitIndex{ 0 });
+    EXPECT_EQ(victim.get_number_of_queued_diagonal_gates(), 0);
+    check_eq(victim, expected.to_vector());
+}
+
+TEST_F(QuantumStateTest, pauli_gates_are_kept_in_the_pauli_frame) {
+    for (auto layout : { SparseArrayLayout::hash_map, SparseArrayLayout::sorted_vector }) {
+        QuantumState expected{ 3, 3 };
+        QuantumState victim{ 3, 3, layout };
+        auto apply_both = [&expected, &victim](const matrix_t& matrix, const operands_t& operands) {
+            expected.apply(matrix, operands);
+            victim.apply(matrix, operands);
+        };
+        // The expected state gets the same Pauli gates, made of other gates: Z = S S, X = H Z H, and Y = S X inv.S
+        auto apply_pauli = [&expected, &victim](const matrix_t& matrix,
+                               const std::vector<const matrix_t*>& other_gates,
+                               QubitIndex qubit_index) {
+            for (const auto* other_gate : other_gates) {
+                expected.apply(*other_gate, { qubit_index });
+            }
+            victim.apply(matrix, { qubit_index });
+        };
+        auto apply_x = [&apply_pauli](QubitIndex qubit_index) {
+            apply_pauli(gates::X, { &gates::H, &gates::S, &gates::S, &gates::H }, qubit_index);
+        };
+        apply_both(gates::RY(.4), { QubitIndex{ 0 } });
+        apply_both(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+        apply_x(QubitIndex{ 1 });
+        EXPECT_TRUE(victim.has_pauli_frame());
+        apply_both(gates::CNOT, { QubitIndex{ 1 }, QubitIndex{ 2 } });
+        apply_both(gates::T, { QubitIndex{ 1 } });
+        apply_pauli(gates::Y,
+            { &gates::SDAG, &gates::H, &gates::S, &gates::S, &gates::H, &gates::S },
+            QubitIndex{ 0 });
+        apply_pauli(gates::Z, { &gates::S, &gates::S }, QubitIndex{ 2 });
+        apply_both(gates::RX(.3), { QubitIndex{ 0 } });
+        apply_both(gates::CZ, { QubitIndex{ 2 }, QubitIndex{ 0 } });
+        if (layout == SparseArrayLayout::sorted_vector) {
+            victim.set_qubit_positions({ 2, 0, 1 });
+        }
+
+        // The frame is only applied to a copy of the amplitudes, and to the probabilities of measuring one
+        auto expected_vector = expected.to_vector();
+        auto actual_vector = victim.to_vector();
+        for (std::size_t i = 0; i < expected_vector.size(); ++i) {
+            EXPECT_NEAR(std::abs(actual_vector[i] - expected_vector[i]), 0., 1e-12);
+        }
+        for (std::size_t i = 0; i < 3; ++i) {
+            EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ i }),
+                expected.get_probability_of_measuring_one(QubitIndex{ i }), 1e-12);
+        }
+        EXPECT_TRUE(victim.has_pauli_frame());
+
+        auto measurement_register = core::MeasurementRegister{ 3 };
+        auto bit_measurement_register = core::BitMeasurementRegister{ 3 };
+        auto expected_measurement_register = core::MeasurementRegister{ 3 };
+        for (auto* state : { &expected, &victim }) {
+            state->apply_measure(
+                QubitIndex{ 1 }, BitIndex{ 1 }, []() { return 0.3; }, measurement_register, bit_measurement_register);
+            if (state == &expected) {
+                expected_measurement_register = measurement_register;
+            }
+        }
+        EXPECT_EQ(measurement_register, expected_measurement_register);
+        EXPECT_TRUE(victim.has_pauli_frame());
+        check_eq(victim, expected.to_vector());
+        EXPECT_FALSE(victim.has_pauli_frame());
+
+        // A reset applies the frame first
+        apply_x(QubitIndex{ 2 });
+        victim.apply_reset(QubitIndex{ 2 });
+        expected.apply_reset(QubitIndex{ 2 });
+        EXPECT_FALSE(victim.has_pauli_frame());
+        check_eq(victim, expected.to_vector());
+    }
+}
+
+TEST_F(QuantumStateTest, sorted_vector_layout__apply_cnot) {
+    QuantumState victim{
+        2, 2, { { "11", std::sqrt(1 - std::pow(0.123, 2)) }, { "10", 0.123 } }, SparseArrayLayout::sorted_vector
+    };
+    check_eq(victim, { 0, 0, 0.123, std::sqrt(1 - std::pow(0.123, 2)) });
+    victim.apply(gates::CNOT, { QubitIndex{ 1 }, QubitIndex{ 0 } });
+    check_eq(victim, { 0, 0, std::sqrt(1 - std::pow(0.123, 2)), 0.123 });
+}
+
+TEST_F(QuantumStateTest, sorted_vector_layout__same_state_as_hash_map_layout) {
+    QuantumState expected{ 4, 4 };
+    QuantumState victim{ 4, 4, SparseArrayLayout::sorted_vector };
+    auto apply_both = [&expected, &victim](const matrix_t& matrix, const operands_t& operands) {
+        expected.apply(matrix, operands);
+        victim.apply(matrix, operands);
+    };
+    apply_both(gates::H, { QubitIndex{ 2 } });
+    apply_both(gates::H, { QubitIndex{ 0 } });
+    apply_both(gates::T, { QubitIndex{ 0 } });
+    apply_both(gates::CNOT, { QubitIndex{ 2 }, QubitIndex{ 3 } });
+    apply_both(gates::TOFFOLI, { QubitIndex{ 0 }, QubitIndex{ 3 }, QubitIndex{ 1 } });
+    apply_both(gates::SWAP, { QubitIndex{ 1 }, QubitIndex{ 0 } });
+    apply_both(gates::H, { QubitIndex{ 2 } });
+    expected.apply_reset(QubitIndex{ 3 });
+    victim.apply_reset(QubitIndex{ 3 });
+    check_eq(victim, expected.to_vector());
+
+    // Elements are visited in increasing order of basis vector
+    std::optional<std::uint64_t> previous;
+    victim.for_each([&previous](const auto& sparse_element) {
+        if (previous.has_value()) {
+            EXPECT_LT(*previous, sparse_element.first.to_ulong());
+        }
+        previous = sparse_element.first.to_ulong();
+    });
+}
+
+TEST_F(QuantumStateTest, sorted_vector_layout__reset) {
+    QuantumState victim{
+        2, 2, { { "00", 0.123 }, { "11", std::sqrt(1 - std::pow(0.123, 2)) } }, SparseArrayLayout::sorted_vector
+    };
+    victim.apply_reset(QubitIndex{ 0 });
+    check_eq(victim, { 0.123, 0, std::sqrt(1 - std::pow(0.123, 2)), 0 });  // 00 and 10
+}
+
+TEST_F(QuantumStateTest, sorted_vector_layout__qubit_positions) {
+    QuantumState expected{ 4, 4 };
+    QuantumState victim{ 4, 4, SparseArrayLayout::sorted_vector };
+    auto apply_both = [&expected, &victim](const matrix_t& matrix, const operands_t& operands) {
+        expected.apply(matrix, operands);
+        victim.apply(matrix, operands);
+    };
+    apply_both(gates::H, { QubitIndex{ 3 } });
+    apply_both(gates::CNOT, { QubitIndex{ 3 }, QubitIndex{ 1 } });
+    apply_both(gates::RY(.4), { QubitIndex{ 0 } });
+
+    // Moving qubits changes neither the amplitudes nor the order in which they are visited
+    victim.set_qubit_positions({ 2, 3, 1, 0 });
+    EXPECT_EQ(victim.get_qubit_positions(), (std::vector<std::size_t>{ 2, 3, 1, 0 }));
+    check_eq(victim, expected.to_vector());
+    apply_both(gates::T, { QubitIndex{ 3 } });
+    apply_both(gates::TOFFOLI, { QubitIndex{ 0 }, QubitIndex{ 3 }, QubitIndex{ 2 } });
+    victim.set_qubit_positions({ 1, 0, 3, 2 });
+    apply_both(gates::SWAP, { QubitIndex{ 1 }, QubitIndex{ 2 } });
+    check_eq(victim, expected.to_vector());
+    std::optional<std::uint64_t> previous;
+    victim.for_each([&previous](const auto& sparse_element) {
+        if (previous.has_value()) {
+            EXPECT_LT(*previous, sparse_element.first.to_ulong());
+        }
+        previous = sparse_element.first.to_ulong();
+    });
+    for (std::size_t i = 0; i < 4; ++i) {
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ i }),
+            expected.get_probability_of_measuring_one(QubitIndex{ i }), 1e-12);
+    }
+
+    auto measurement_register = core::MeasurementRegister{ 4 };
+    auto bit_measurement_register = core::BitMeasurementRegister{ 4 };
+    for (auto* state : { &expected, &victim }) {
+        state->apply_measure(
+            QubitIndex{ 2 }, BitIndex{ 2 }, []() { return 0.3; }, measurement_register, bit_measurement_register);
+        state->apply_reset(QubitIndex{ 0 });
+    }
+    check_eq(victim, expected.to_vector());
+
+    // Moving every qubit back to its own position
+    victim.set_qubit_positions({ 0, 1, 2, 3 });
+    check_eq(victim, expected.to_vector());
+    EXPECT_THROW(victim.set_qubit_positions({ 0, 0, 1, 2 }), QuantumStateError);
+}
+
+TEST_F(QuantumStateTest, wide_register) {
+    // GHZ state over qubits 0, 100 and 199, which only has two non-zero amplitudes
+    for (auto layout : { SparseArrayLayout::hash_map, SparseArrayLayout::sorted_vector }) {
+        QuantumState victim{ 200, 1, layout };
+        victim.apply(gates::H, { QubitIndex{ 0 } })
+            .apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 100 } })
+            .apply(gates::CNOT, { QubitIndex{ 100 }, QubitIndex{ 199 } });
+        auto elements = std::vector<std::string>{};
+        victim.for_each([&elements](const auto& sparse_element) {
+            const auto& [basis_vector, sparse_complex] = sparse_element;
+            EXPECT_NEAR(std::norm(sparse_complex.value), .5, 1e-12);
+            elements.push_back(basis_vector.to_string(200));
+        });
+        auto ones = std::string(200, '0');
+        ones[0] = ones[99] = ones[199] = '1';
+        EXPECT_EQ(elements, (std::vector<std::string>{ std::string(200, '0'), ones }));
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 199 }), .5, 1e-12);
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 150 }), 0., 1e-12);
+
+        victim.apply_reset(QubitIndex{ 100 });
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 100 }), 0., 1e-12);
+        victim.update_data_after_measurement(QubitIndex{ 0 }, true, .5);
+        EXPECT_NEAR(victim.get_probability_of_measuring_one(QubitIndex{ 199 }), 1., 1e-12);
+        EXPECT_THROW((void) victim.to_vector(), QuantumStateError);
+    }
+}
+
+TEST_F(QuantumStateTest, write_and_read) {
+    for (auto layout : { SparseArrayLayout::hash_map, SparseArrayLayout::sorted_vector }) {
+        QuantumState victim{ 100, 3, layout };
+        victim.apply(gates::H, { QubitIndex{ 0 } })
+            .apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 99 } })
+            .apply(gates::RX(.3), { QubitIndex{ 1 } })
+            .apply(gates::T, { QubitIndex{ 99 } });
+        if (layout == SparseArrayLayout::sorted_vector) {
+            auto positions = std::vector<std::size_t>(100);
+            std::iota(positions.rbegin(), positions.rend(), 0);
+            victim.set_qubit_positions(positions);
+        }
+        auto stream = std::stringstream{};
+        victim.write(stream);
+        auto read = QuantumState::read(stream);
+        EXPECT_EQ(read.get_number_of_qubits(), 100);
+        EXPECT_EQ(read.get_number_of_bits(), 3);
+        EXPECT_EQ(read.get_qubit_positions(), victim.get_qubit_positions());
+        auto elements = std::vector<std::pair<std::string, std::complex<double>>>{};
+        victim.for_each([&elements](const auto& sparse_element) {
+            elements.emplace_back(sparse_element.first.to_string(100), sparse_element.second.value);
+        });
+        auto read_elements = std::vector<std::pair<std::string, std::complex<double>>>{};
+        read.for_each([&read_elements](const auto& sparse_element) {
+            read_elements.emplace_back(sparse_element.first.to_string(100), sparse_element.second.value);
+        });
+        EXPECT_EQ(read_elements, elements);
+        // Reading the same data twice gives the same storage, so the same results, bit for bit
+        auto again = std::stringstream{ stream.str() };
+        auto read_again = QuantumState::read(again);
+        EXPECT_EQ(read_again.get_probability_of_measuring_one(QubitIndex{ 1 }),
+            read.get_probability_of_measuring_one(QubitIndex{ 1 }));
+    }
+}
+
+TEST_F(QuantumStateTest, read_invalid_data) {
+    QuantumState victim{ 3, 3 };
+    auto stream = std::stringstream{};
+    victim.write(stream);
+    auto data = stream.str();
+    auto truncated = std::stringstream{ data.substr(0, data.size() - 1) };
+    EXPECT_THROW((void) QuantumState::read(truncated), QuantumStateError);
+    auto empty = std::stringstream{};
+    EXPECT_THROW((void) QuantumState::read(empty), QuantumStateError);
+}
+
+TEST_F(QuantumStateTest, tensor_product_and_remove_qubit) {
+    for (auto layout : { SparseArrayLayout::hash_map, SparseArrayLayout::sorted_vector }) {
+        QuantumState lhs{ 2, 2, layout };
+        lhs.apply(gates::H, { QubitIndex{ 0 } }).apply(gates::CNOT, { QubitIndex{ 0 }, QubitIndex{ 1 } });
+        QuantumState rhs{ 1, 1, layout };
+        rhs.apply(gates::X, { QubitIndex{ 0 } }).apply(gates::S, { QubitIndex{ 0 } });
+        auto product = lhs.tensor_product(rhs);
+        EXPECT_EQ(product.get_number_of_qubits(), 3);
+        EXPECT_EQ(product.get_layout(), layout);
+        auto amplitude = std::complex<double>{ 0, 1 / std::numbers::sqrt2 };
+        check_eq(product, { 0, 0, 0, 0, amplitude, 0, 0, amplitude });
+        EXPECT_NEAR(product.get_probability_of_measuring_one(QubitIndex{ 2 }), 1., 1e-12);
+
+        product.update_data_after_measurement(QubitIndex{ 0 }, true, .5);
+        auto removed = product.remove_qubit(QubitIndex{ 0 });
+        EXPECT_EQ(removed.get_number_of_qubits(), 2);
+        check_eq(removed, { 0, 0, 0, { 0, 1 } });
+        EXPECT_THROW((void) lhs.remove_qubit(QubitIndex{ 1 }), QuantumStateError);
+        EXPECT_THROW((void) rhs.remove_qubit(QubitIndex{ 0 }), QuantumStateError);
+    }
+}
+
+TEST_F(QuantumStateTest, too_many_qubits) {
+    EXPECT_NO_THROW((QuantumState{ config::MAX_STATE_VECTOR_QUBIT_NUMBER, 1 }));
+    EXPECT_THROW((QuantumState{ config::MAX_STATE_VECTOR_QUBIT_NUMBER + 1, 1 }), QuantumStateError);
+}
+
 }  // namespace qx::core
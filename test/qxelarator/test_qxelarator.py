@@ -1,5 +1,6 @@
 import os
 import qxelarator
+import tempfile
 import unittest
 
 
@@ -64,6 +65,31 @@ b = measure q
         simulation_result = qxelarator.execute_string(cqasm_string, iterations=20, seed=123)
         self.assertEqual(simulation_result.results, {"0": 12, "1": 8})
 
+    def test_compile_string_and_execute_compiled_file(self):
+        cqasm_string = """\
+version 3.0
+
+qubit q
+bit b
+
+H q
+b = measure q
+"""
+        compiled_file_name = os.path.join(tempfile.gettempdir(), 'qxelarator_compiled_circuit_test.qxc')
+        self.assertIsNone(qxelarator.compile_string(cqasm_string, compiled_file_name))
+
+        simulation_result = qxelarator.execute_compiled_file(compiled_file_name, iterations=20, seed=123)
+        os.remove(compiled_file_name)
+        self.assertIsInstance(simulation_result, qxelarator.SimulationResult)
+        self.assertEqual(simulation_result.results, {"0": 12, "1": 8})
+
+    def test_execute_compiled_file_fails_returns_simulation_error(self):
+        cqasm_file_name = os.path.join(os.path.dirname(os.path.realpath(__file__)), 'bell_pair.cq')
+        simulation_error = qxelarator.execute_compiled_file(cqasm_file_name)
+
+        self.assertIsInstance(simulation_error, qxelarator.SimulationError)
+        self.assertTrue(simulation_error.message.startswith("invalid compiled circuit"))
+
 
 if __name__ == '__main__':
     unittest.main()
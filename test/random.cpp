@@ -3,7 +3,11 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cmath>  // floor, pow
+#include <limits>
 #include <map>
+#include <stdexcept>  // invalid_argument
+#include <vector>
 
 namespace qx::random {
 
@@ -158,4 +162,38 @@ TEST_F(RandomTestThirdSeedTest, kolmogorov_smirnov_test_for_random_integer) {
         samples, [&min, &max](double x) { return uniform_min_max_integer_distribution(min, max, x); });
 }
 
+TEST_F(RandomTestFirstSeedTest, kolmogorov_smirnov_test_for_random_index) {
+    // Weights 1, 2, 1, 4
+    std::size_t sample_size = 100000;
+    std::vector<double> samples(sample_size);
+    std::generate(samples.begin(), samples.end(), []() { return random_index({ 1., 3., 4., 8. }); });
+
+    check_kolmogorov_smirnov(samples, [](double x) {
+        return x < 0 ? 0. : x < 1 ? 1. / 8 : x < 2 ? 3. / 8 : x < 3 ? 4. / 8 : 1.;
+    });
+}
+
+TEST_F(RandomTestFirstSeedTest, kolmogorov_smirnov_test_for_random_geometric) {
+    auto p = .1;
+    std::size_t sample_size = 100000;
+    std::vector<double> samples(sample_size);
+    std::generate(samples.begin(), samples.end(), [p]() { return static_cast<double>(random_geometric(p)); });
+
+    check_kolmogorov_smirnov(samples, [p](double x) { return x < 0 ? 0. : 1 - std::pow(1 - p, std::floor(x) + 1); });
+}
+
+TEST_F(RandomTestFirstSeedTest, random_geometric__edge_cases) {
+    EXPECT_EQ(random_geometric(1.), 0);
+    EXPECT_EQ(random_geometric(0.), std::numeric_limits<std::size_t>::max());
+}
+
+TEST_F(RandomTestFirstSeedTest, get_state_and_set_state) {
+    auto state = get_state();
+    auto expected = std::vector<double>{ random_zero_one_double(), random_zero_one_double() };
+    set_state(state);
+    EXPECT_EQ(random_zero_one_double(), expected[0]);
+    EXPECT_EQ(random_zero_one_double(), expected[1]);
+    EXPECT_THROW(set_state("not a state"), std::invalid_argument);
+}
+
 }  // namespace qx::random
@@ -4,6 +4,7 @@
 #include <gmock/gmock.h>  // ThrowsMessage
 #include <gtest/gtest.h>
 
+#include <cstdint>  // SIZE_MAX
 #include <stdexcept>  // runtime_error
 
 #include "qx/compile_time_configuration.hpp"
@@ -52,6 +53,12 @@ TEST_F(RegisterManagerTest, bit_register_size_exceeds_maximum_allowed) {
             qx::config::MAX_BIT_NUMBER)));
 }
 
+TEST_F(RegisterManagerTest, register_size_overflows) {
+    auto variables = RegisterVariables{ { "q", SIZE_MAX }, { "r", 2 } };
+    EXPECT_THAT([&variables]() { [[maybe_unused]] auto qubit_register = QubitRegister{ variables }; },
+        ::testing::ThrowsMessage<std::runtime_error>("register size overflows"));
+}
+
 TEST_F(RegisterManagerTest, get_instance_before_create_instance) {
     EXPECT_THAT([]() { [[maybe_unused]] const auto& unused = RegisterManager::get_instance(); },
         ::testing::ThrowsMessage<std::runtime_error>("uninitialized register manager"));
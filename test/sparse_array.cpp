@@ -4,6 +4,8 @@
 #include <gtest/gtest.h>
 
 #include <complex>
+#include <cstdint>  // uint64_t
+#include <limits>  // numeric_limits
 #include <vector>
 
 namespace qx::core {
@@ -14,7 +16,7 @@ TEST(sparse_array, set) {
     auto victim = SparseArray{ 5 };
     EXPECT_EQ(victim.to_vector(), (std::vector<std::complex<double>>{ 0., 0., 0., 0., 0. }));
 
-    auto key = BasisVector{ 5 };
+    auto key = BasisVector{};
     key.set(2);
     victim[key] = SparseComplex{ 1i };
     EXPECT_EQ(victim.to_vector(), (std::vector<std::complex<double>>{ 0., 0., 0., 0., 1i }));
@@ -27,4 +29,27 @@ TEST(sparse_array, set) {
 #endif
 }
 
+TEST(sparse_array, sorted_vector_layout) {
+    auto victim = SparseArray{ 8, { { "110", 0.6 }, { "001", 0.8i } }, SparseArrayLayout::sorted_vector };
+    victim[BasisVector{ "011" }] = SparseComplex{ 0. };
+    EXPECT_EQ(victim.to_vector(), (std::vector<std::complex<double>>{ 0., 0.8i, 0., 0., 0., 0., 0.6, 0. }));
+
+    auto basis_vectors = std::vector<std::uint64_t>{};
+    victim.for_each_sorted([&basis_vectors](const auto& kv) { basis_vectors.push_back(kv.first.to_ulong()); });
+    EXPECT_EQ(basis_vectors, (std::vector<std::uint64_t>{ 1, 6 }));  // zeros are cleaned up before traversing
+}
+
+TEST(sparse_array, wide_basis_vectors) {
+    // Basis vectors are sorted as numbers, so bits in higher words come last
+    auto high = BasisVector128{};
+    high.set(64);
+    auto victim = BasicSparseArray<BasisVector128>{ std::numeric_limits<std::size_t>::max() };
+    victim[high] = SparseComplex{ 0.6 };
+    victim[BasisVector128{ 3 }] = SparseComplex{ 0.8 };
+    auto elements = std::vector<BasisVector128>{};
+    victim.for_each_sorted([&elements](const auto& kv) { elements.push_back(kv.first); });
+    EXPECT_EQ(elements, (std::vector<BasisVector128>{ BasisVector128{ 3 }, high }));
+    EXPECT_NEAR(victim.norm(), 1., 1e-12);
+}
+
 }  // namespace qx::core